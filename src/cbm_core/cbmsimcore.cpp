@@ -5,7 +5,11 @@
  *      Author: consciousness
  */
 
+#include <algorithm>
+#include <omp.h>
+
 #include "cbmsimcore.h"
+#include "tracepoints.h"
 
 //#define NO_ASYNC
 //#define DISP_CUDA_ERR
@@ -13,7 +17,7 @@
 CBMSimCore::CBMSimCore() {}
 
 CBMSimCore::CBMSimCore(CBMState *state,
-	int gpuIndStart, int numGPUP2)
+	int gpuIndStart, int numGPUP2) : sim_params(state->getParams())
 {
 	CRandomSFMT0 randGen(time(0));
 	int *mzoneRSeed = new int[state->getNumZones()];
@@ -38,6 +42,15 @@ CBMSimCore::~CBMSimCore()
 	delete[] zones;
 	delete inputNet;
 
+	for (int i = 0; i < numGPUs; i++)
+	{
+		cudaSetDevice(i + gpuIndStart);
+		cudaFree(delayMaskGRGPU[i]);
+		cudaFree(pfActGRGPU[i]);
+	}
+	delete[] delayMaskGRGPU;
+	delete[] pfActGRGPU;
+
 	for (int i = 0; i < numGPUs; i++)
 	{
 		// How could gpuIndStart ever not be 0,
@@ -65,7 +78,7 @@ void CBMSimCore::writeToState()
 	}
 }
 
-void CBMSimCore::writeState(std::fstream& outfile)
+void CBMSimCore::writeState(std::iostream &outfile)
 {
 	writeToState();
 	simState->writeState(outfile); // using internal cp
@@ -106,12 +119,41 @@ void CBMSimCore::initCUDAStreams()
 	}
 }
 
+void CBMSimCore::initPFActCUDA(MZoneConnectivityState *cs)
+{
+	int numGRPerGPU = num_gr / numGPUs;
+	updatePFActNumGRPerB = 512;
+	updatePFActNumBlocks = numGRPerGPU / updatePFActNumGRPerB;
+
+	delayMaskGRGPU = new uint32_t*[numGPUs];
+	pfActGRGPU     = new uint8_t*[numGPUs];
+	for (int i = 0; i < numGPUs; i++)
+	{
+		cudaSetDevice(i + gpuIndStart);
+		cudaMalloc((void **)&delayMaskGRGPU[i], numGRPerGPU * sizeof(uint32_t));
+		cudaMalloc((void **)&pfActGRGPU[i], numGRPerGPU * sizeof(uint8_t));
+		cudaMemcpy(delayMaskGRGPU[i], &(cs->pGRDelayMaskfromGRtoBSP[i * numGRPerGPU]),
+			numGRPerGPU * sizeof(uint32_t), cudaMemcpyHostToDevice);
+		cudaMemset(pfActGRGPU[i], 0, numGRPerGPU * sizeof(uint8_t));
+	}
+}
+
+void CBMSimCore::runUpdatePFActCUDA(cudaStream_t **sts, int streamN)
+{
+	for (int i = 0; i < numGPUs; i++)
+	{
+		cudaSetDevice(i + gpuIndStart);
+		callUpdatePFActKernel(sts[i][streamN], updatePFActNumBlocks, updatePFActNumGRPerB,
+			inputNet->getApBufGRGPUPointer()[i], delayMaskGRGPU[i], pfActGRGPU[i]);
+	}
+}
+
 void CBMSimCore::initAuxVars()
 {
 	curTime = 0;
 }
 
-void CBMSimCore::syncCUDA(std::string title)
+void CBMSimCore::syncCUDA(const char *title)
 {
 	cudaError_t error;
 	for (int i = 0; i < numGPUs; i++)
@@ -136,8 +178,19 @@ void CBMSimCore::calcActivity(float spillFrac, enum plasticity pf_pc_plast, enum
 	syncCUDA("1");
 
 	curTime++;
+	CBM_TRACE1(step__start, curTime);
+	if (phaseTimingOn)
+	{
+		phaseStart = omp_get_wtime();
+		std::fill(stepPhaseTimes, stepPhaseTimes + NUM_SIM_PHASES, 0.0);
+		numTimedSteps++;
+	}
 
 	inputNet->runGRActivitiesCUDA(streams, 0);
+	inputNet->runUpdateGRSpatialActCUDA(streams, 0); /* same stream: reads this step's GR output */
+	/* once for all zones: the GR spike buffer does not change again this step */
+	runUpdatePFActCUDA(streams, 0);
+	markPhase(PHASE_GR_UPDATE);
 
 #ifdef NO_ASYNC
 	syncCUDA("1a");
@@ -156,6 +209,7 @@ void CBMSimCore::calcActivity(float spillFrac, enum plasticity pf_pc_plast, enum
 		zones[i]->runSumPFBCCUDA(streams, 2);
 		zones[i]->runSumPFSCCUDA(streams, 3);
 	}
+	markPhase(PHASE_PF_SUMS);
 
 #ifdef NO_ASYNC
 	syncCUDA("1c");
@@ -166,6 +220,7 @@ void CBMSimCore::calcActivity(float spillFrac, enum plasticity pf_pc_plast, enum
 #endif
 
 	inputNet->runSumGRGOOutCUDA(streams, 4);
+	markPhase(PHASE_GR_GO);
 #ifdef NO_ASYNC
 	syncCUDA("1e");
 #endif
@@ -181,6 +236,14 @@ void CBMSimCore::calcActivity(float spillFrac, enum plasticity pf_pc_plast, enum
 			zones[i]->runPFPCPlastCUDA(streams, 1, curTime);
 		}
 	}
+	else if (pf_pc_plast == DUAL || pf_pc_plast == CASCADE)
+	{
+		for (int i = 0; i < numZones; i++)
+		{
+			zones[i]->runPFPCDiscretePlast(streams, 1, curTime, pf_pc_plast == CASCADE);
+		}
+	}
+	markPhase(PHASE_PFPC_PLAST);
 #ifdef NO_ASYNC
 	syncCUDA("1f");
 #endif
@@ -208,6 +271,7 @@ void CBMSimCore::calcActivity(float spillFrac, enum plasticity pf_pc_plast, enum
 #endif
 
 	inputNet->cpyAPGOHosttoGPUCUDA(streams, 7);
+	markPhase(PHASE_TRANSFERS);
 
 #ifdef NO_ASYNC
 	syncCUDA("1k");
@@ -227,6 +291,7 @@ void CBMSimCore::calcActivity(float spillFrac, enum plasticity pf_pc_plast, enum
 		zones[i]->calcSCActivities();
 		zones[i]->calcBCActivities();
 	}
+	markPhase(PHASE_MZONE_CELLS);
 
 	// TODO: put in macro def for num_gpus so we don't run this line if running on one GPU
 	//syncCUDA("2");
@@ -260,6 +325,7 @@ void CBMSimCore::calcActivity(float spillFrac, enum plasticity pf_pc_plast, enum
 #endif
 
 	inputNet->runUpdateGOInGRDynamicSpillCUDA(streams, 4);
+	markPhase(PHASE_GR_INPUT);
 
 	for (int i = 0; i < numZones; i++)
 	{
@@ -267,6 +333,7 @@ void CBMSimCore::calcActivity(float spillFrac, enum plasticity pf_pc_plast, enum
 		zones[i]->cpyPFPCSumCUDA(streams, i + 2);
 		zones[i]->runUpdatePFBCSCOutCUDA(streams, i + 4); // adding i might break things in future
 	}
+	markPhase(PHASE_PF_SUMS);
 #ifdef NO_ASYNC
 	syncCUDA("2g");
 #endif
@@ -276,6 +343,7 @@ void CBMSimCore::calcActivity(float spillFrac, enum plasticity pf_pc_plast, enum
 #endif
 
 	inputNet->runUpdateGROutGOCUDA(streams, 7);
+	markPhase(PHASE_GR_GO);
 #ifdef NO_ASYNC
 	syncCUDA("2i");
 #endif
@@ -299,6 +367,7 @@ void CBMSimCore::calcActivity(float spillFrac, enum plasticity pf_pc_plast, enum
 #endif
 
 	inputNet->cpyGRGOSumGPUtoHostCUDA(streams, 3);
+	markPhase(PHASE_TRANSFERS);
 #ifdef NO_ASYNC
 	syncCUDA("2ia");
 #endif
@@ -308,11 +377,13 @@ void CBMSimCore::calcActivity(float spillFrac, enum plasticity pf_pc_plast, enum
 #endif
 
 	inputNet->runUpdateGRHistoryCUDA(streams, 4, curTime);
+	markPhase(PHASE_GR_UPDATE);
 #ifdef NO_ASYNC
 	syncCUDA("2ib");
 #endif
 
 	inputNet->calcGOActivities(); 
+	inputNet->updateGOSpatialAct();
 #ifdef NO_ASYNC
 	syncCUDA("2ic");
 #endif
@@ -341,6 +412,7 @@ void CBMSimCore::calcActivity(float spillFrac, enum plasticity pf_pc_plast, enum
 #endif
 
 	inputNet->updateGOtoGROutParameters(spillFrac);
+	markPhase(PHASE_GO_CELLS);
 #ifdef NO_ASYNC
 	syncCUDA("2ii");
 #endif
@@ -402,15 +474,18 @@ void CBMSimCore::calcActivity(float spillFrac, enum plasticity pf_pc_plast, enum
 #endif
 		
 	}
+	markPhase(PHASE_MZONE_CELLS);
 
 #ifdef NO_ASYNC
 		syncCUDA("2iw");
 #endif
 
 	inputNet->resetMFHist(curTime);
+	markPhase(PHASE_GO_CELLS);
 #ifdef NO_ASYNC
 		syncCUDA("2ix");
 #endif
+	CBM_TRACE1(step__end, curTime);
 }
 
 void CBMSimCore::updateMFInput(const uint8_t *mfIn)
@@ -454,6 +529,84 @@ MZone** CBMSimCore::getMZoneList()
 	return (MZone **)zones;
 }
 
+const sim_params &CBMSimCore::getParams()
+{
+	return *this;
+}
+
+CBMState *CBMSimCore::getState()
+{
+	return simState;
+}
+
+void CBMSimCore::retuneActParams(const act_params &tuned)
+{
+	static_cast<act_params &>(*this) = tuned;
+	inputNet->retuneActParams(tuned);
+	for (int i = 0; i < numZones; i++)
+	{
+		zones[i]->retuneActParams(tuned);
+	}
+}
+
+bool CBMSimCore::actParamsInEffect(const act_params &tuned)
+{
+	if (!inputNet->actParamsInEffect(tuned)) return false;
+	for (int i = 0; i < numZones; i++)
+	{
+		if (!zones[i]->actParamsInEffect(tuned)) return false;
+	}
+	return true;
+}
+
+void CBMSimCore::setPhaseTiming(bool on)
+{
+	phaseTimingOn = on;
+	std::fill(phaseTimes, phaseTimes + NUM_SIM_PHASES, 0.0);
+	numTimedSteps = 0;
+}
+
+const double *CBMSimCore::getPhaseTimes()
+{
+	return phaseTimes;
+}
+
+const double *CBMSimCore::getStepPhaseTimes()
+{
+	return stepPhaseTimes;
+}
+
+uint64_t CBMSimCore::getNumTimedSteps()
+{
+	return numTimedSteps;
+}
+
+uint32_t CBMSimCore::getNumZones()
+{
+	return numZones;
+}
+
+int CBMSimCore::getNumGPUs()
+{
+	return numGPUs;
+}
+
+int CBMSimCore::getGPUIndStart()
+{
+	return gpuIndStart;
+}
+
+void CBMSimCore::markPhase(enum sim_phase phase)
+{
+	CBM_TRACE2(phase__end, curTime, (int)phase);
+	if (!phaseTimingOn) return;
+	syncCUDA("phase");
+	double now = omp_get_wtime();
+	phaseTimes[phase]     += now - phaseStart;
+	stepPhaseTimes[phase] += now - phaseStart;
+	phaseStart = now;
+}
+
 void CBMSimCore::construct(CBMState *state,
 	int *mzoneRSeed, int gpuIndStart, int numGPUP2)
 {
@@ -496,16 +649,21 @@ void CBMSimCore::construct(CBMState *state,
 	std::cout << "finished initialzing cuda streams." << std::endl;
 
 	// NOTE: inputNet has internal cp, no need to pass to constructor
-	inputNet = new InNet(state->getInnetConStateInternal(),
+	inputNet = new InNet(state->getParams(), state->getInnetConStateInternal(),
 		state->getInnetActStateInternal(), this->gpuIndStart, numGPUs);
 
+	initPFActCUDA(state->getMZoneConStateInternal(0));
+
 	zones = new MZone*[numZones];
 
+	// zones only read the shared GR buffers and otherwise share nothing, so they
+	// are built concurrently. each MZone selects its own devices before touching them
+	#pragma omp parallel for schedule(dynamic, 1) if(numZones > 1)
 	for (int i = 0; i < numZones; i++)
 	{
 		// same thing for zones as with innet
-		zones[i] = new MZone(state->getMZoneConStateInternal(i),
-			state->getMZoneActStateInternal(i), mzoneRSeed[i], inputNet->getApBufGRGPUPointer(),
+		zones[i] = new MZone(state->getParams(), state->getMZoneConStateInternal(i),
+			state->getMZoneActStateInternal(i), mzoneRSeed[i], pfActGRGPU,
 			inputNet->getHistGRGPUPointer(), this->gpuIndStart, numGPUs);
 	}
 	std::cout << "Mzone construction complete" << std::endl;
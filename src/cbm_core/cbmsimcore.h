@@ -25,13 +25,28 @@
 
 enum plasticity {OFF, GRADED, DUAL, CASCADE};
 
+/* the phases of calcActivity that phase timing attributes wall time to.
+ * calcActivity interleaves them, so a phase may be timed in several pieces */
+enum sim_phase
+{
+	PHASE_GR_UPDATE,   /* GR membrane and spike update, delayed PF activity, GR history */
+	PHASE_GR_INPUT,    /* MF and GO input to GR, incl. depression and spillover */
+	PHASE_GR_GO,       /* GR to GO output and its reduction */
+	PHASE_PF_SUMS,     /* PF outputs and their sums onto PC, BC and SC */
+	PHASE_PFPC_PLAST,  /* PF-PC plasticity */
+	PHASE_TRANSFERS,   /* host <-> GPU copies */
+	PHASE_GO_CELLS,    /* host GO update and MF, GO outputs */
+	PHASE_MZONE_CELLS, /* host PC, BC, SC, IO and NC updates and outputs */
+	NUM_SIM_PHASES
+};
+
 /* TODO: consider altering this code so that CBMSimCore does not keep local copies
  *       of the state classes. Consider whether transferring data between classes
  *       by using classes as arguments would be just as fast as we have things now.
  *       The advantage would be that we would use less memory and it would simplify the code.
  */
 
-class CBMSimCore
+class CBMSimCore : protected sim_params
 {
 public:
 	CBMSimCore();
@@ -45,16 +60,43 @@ public:
 	void updateErrDrive(unsigned int zoneN, float errDriveRelative);
 
 	void writeToState();
-	void writeState(std::fstream& outfile);
+	void writeState(std::iostream &outfile);
 
 	InNet* getInputNet();
 	MZone** getMZoneList();
+	const sim_params &getParams();
+	/* the activity states are current only after writeToState */
+	CBMState *getState();
+
+	/* copies new activity params into this simulation's context, e.g. from the
+	 * gui tuning window, and recomputes whatever the net and zones derive from
+	 * them. con params cannot change after construction */
+	void retuneActParams(const act_params &tuned);
+	/* whether the net and every zone run on tuned, e.g. after a retune */
+	bool actParamsInEffect(const act_params &tuned);
+
+	/* when on, calcActivity synchronizes every GPU at the end of each phase and
+	 * adds the phase's wall time (s) to getPhaseTimes(). the syncs serialize the
+	 * streams, so this is for profiling runs only. restarts the phase times */
+	void setPhaseTiming(bool on);
+	const double *getPhaseTimes();
+	/* the phase times (s) of the last step alone */
+	const double *getStepPhaseTimes();
+	uint64_t getNumTimedSteps();
+
+	uint32_t getNumZones();
+	int getNumGPUs();
+	int getGPUIndStart();
 
 protected:
 	void initCUDAStreams();
+	void initPFActCUDA(MZoneConnectivityState *cs);
 	void initAuxVars();
 
-	void syncCUDA(std::string title);
+	/* the delayed PF activity that every zone's PF outputs read */
+	void runUpdatePFActCUDA(cudaStream_t **sts, int streamN);
+
+	void syncCUDA(const char *title);
 
 	CBMState *simState;
 
@@ -67,6 +109,13 @@ protected:
 	int gpuIndStart;
 	int numGPUs;
 
+	/* GR to BC, PC and SC conduction delay masks. they depend only on GR
+	 * position, so are the same for every zone and are taken from zone 0 */
+	uint32_t **delayMaskGRGPU;
+	uint8_t **pfActGRGPU;
+	unsigned int updatePFActNumGRPerB;
+	unsigned int updatePFActNumBlocks;
+
 private:
 	bool isGRStim    =  false;
 	int numGRStim    =  0;
@@ -74,6 +123,15 @@ private:
 
 	unsigned long curTime;
 
+	bool phaseTimingOn = false;
+	double phaseStart  = 0.0;
+	double phaseTimes[NUM_SIM_PHASES] = {};
+	double stepPhaseTimes[NUM_SIM_PHASES] = {};
+	uint64_t numTimedSteps = 0;
+
+	/* attributes the time since the last mark to phase */
+	void markPhase(enum sim_phase phase);
+
 	void construct(CBMState *state, int *mzoneRSeed,
 		int gpuIndStart, int numGPUP2);
 };
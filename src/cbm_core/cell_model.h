@@ -0,0 +1,166 @@
+/*
+ * File: cell_model.h
+ *
+ * Description:
+ *     Compile-time framework for the host-side leaky integrate-and-fire cell
+ *     populations (GO in InNet; PC, BC, SC, IO and NC in MZone). A population
+ *     is described by its lif_cells (membrane, leak, threshold and spike
+ *     outputs) and an ordered list of channels, each contributing one term to
+ *     the membrane update:
+ *
+ *         syn_channel  - a synaptic conductance with its own kinetics, driven
+ *                        by a per-cell input array
+ *         cond_channel - a conductance computed elsewhere (e.g. summed over a
+ *                        cell's synapses beforehand)
+ *         bias_channel - a per-cell current, bias_const - one for every cell
+ *
+ *     update_lif_cells instantiates one fused loop per population from that
+ *     description. Each time step, every cell:
+ *
+ *         v    += gLeak * (eLeak - v) + term_0(v) + term_1(v) + ...
+ *         v     = min(v, v_max)
+ *         ap    = v > thresh  (thresh decayed before or after the test, see thresh_order)
+ *         thresh = ap ? threshMax : thresh
+ *         apBuf = (apBuf << 1) | ap
+ *
+ *     where every term sees the membrane potential from before the update. A
+ *     shunting conductance is a channel with e_rev 0. Channels are plain structs
+ *     passed by value and the loop is fully inlined, so the compiler vectorizes
+ *     it across cells.
+ */
+#ifndef CELL_MODEL_H_
+#define CELL_MODEL_H_
+
+#include <cstdint>
+#include <limits>
+
+/* populations at least this large are also split across threads */
+#define CELL_UPDATE_PARALLEL_MIN 2048
+
+#define NO_V_MAX std::numeric_limits<float>::infinity()
+
+enum syn_kinetics
+{
+	SYN_INC_DECAY, /* g = (g + in * inc * scale) * dec */
+	SYN_DECAY_INC  /* g = in * inc * scale + g * dec */
+};
+
+enum thresh_order
+{
+	THRESH_DECAY_FIRST, /* thresh decays, then the spike test uses the decayed value */
+	THRESH_TEST_FIRST   /* the spike test uses last step's thresh, which then decays */
+};
+
+/* per-cell factors for syn_channel increments. a scale functor may depend on
+ * the membrane potential from before the update */
+struct unit_scale
+{
+	float operator()(int i, float v) const { return 1.0f; }
+};
+
+struct cell_scale
+{
+	const float *s;
+	float operator()(int i, float v) const { return s[i]; }
+};
+
+template<typename InT, enum syn_kinetics Kinetics, typename Scale = unit_scale>
+struct syn_channel
+{
+	float *g;
+	const InT *in;
+	float inc;
+	float dec;
+	float e_rev;
+	Scale scale;
+
+	float term(int i, float v) const
+	{
+		float g_i = (Kinetics == SYN_INC_DECAY)
+				  ? (g[i] + in[i] * inc * scale(i, v)) * dec
+				  : in[i] * inc * scale(i, v) + g[i] * dec;
+		g[i] = g_i;
+		return g_i * (e_rev - v);
+	}
+};
+
+struct cond_channel
+{
+	const float *g;
+	float e_rev;
+
+	float term(int i, float v) const { return g[i] * (e_rev - v); }
+};
+
+struct bias_channel
+{
+	const float *b;
+
+	float term(int i, float v) const { return b[i]; }
+};
+
+struct bias_const
+{
+	float b;
+
+	float term(int i, float v) const { return b; }
+};
+
+template<typename BufT>
+struct lif_cells
+{
+	float *v;
+	float *thresh;
+	uint8_t *ap;
+	BufT *ap_buf;
+	float g_leak;
+	float e_leak;
+	float thresh_rest;
+	float thresh_dec;
+	float thresh_max;
+	float v_max;
+};
+
+inline float add_terms(int i, float v, float acc)
+{
+	return acc;
+}
+
+template<typename Channel, typename... Rest>
+inline float add_terms(int i, float v, float acc, const Channel &ch, const Rest&... rest)
+{
+	return add_terms(i, v, acc + ch.term(i, v), rest...);
+}
+
+/* advances n cells by one time step. returns the number that spiked */
+template<enum thresh_order Order, typename BufT, typename... Channels>
+uint32_t update_lif_cells(const lif_cells<BufT> &cells, int n, const Channels&... channels)
+{
+	uint32_t num_spikes = 0;
+	#pragma omp parallel for simd schedule(static) reduction(+:num_spikes) \
+		if(n >= CELL_UPDATE_PARALLEL_MIN)
+	for (int i = 0; i < n; i++)
+	{
+		float v  = cells.v[i];
+		float dv = add_terms(i, v, cells.g_leak * (cells.e_leak - v), channels...);
+		v += dv;
+		v  = (v > cells.v_max) ? cells.v_max : v;
+
+		float thresh = cells.thresh[i];
+		if (Order == THRESH_DECAY_FIRST)
+			thresh += cells.thresh_dec * (cells.thresh_rest - thresh);
+		uint8_t ap = v > thresh;
+		if (Order == THRESH_TEST_FIRST)
+			thresh += cells.thresh_dec * (cells.thresh_rest - thresh);
+
+		cells.v[i]      = v;
+		cells.thresh[i] = ap ? cells.thresh_max : thresh;
+		cells.ap[i]     = ap;
+		cells.ap_buf[i] = (cells.ap_buf[i] << 1) | ap;
+		num_spikes += ap;
+	}
+	return num_spikes;
+}
+
+#endif /* CELL_MODEL_H_ */
+
@@ -0,0 +1,155 @@
+/*
+ * File: discrete_syn.cpp
+ *
+ * Description:
+ *     This file implements the function prototypes in discrete_syn.h
+ *
+ * Implementation Notes:
+ *     bernoulli_word builds a word with bit probability k / 2^b out of b fair
+ *     random words, from the lowest bit of k up: or-ing in a fair word maps a
+ *     bit probability q to (1 + q) / 2, and-ing maps it to q / 2. Below the
+ *     lowest set bit of k the word stays 0, so those draws are skipped.
+ *
+ *     The event functions go through the planes in chunks of
+ *     DISCRETE_SYN_CHUNK words. The random masks of a chunk are drawn first,
+ *     serially and only for words with an eligible synapse, which with sparse
+ *     GR activity skips most of the draws; the transitions are then a
+ *     branch-free loop over the chunk that the compiler vectorizes. The cascade
+ *     draws p once per word and derives p * 2^-k by and-ing in k more fair
+ *     words, so the per-level masks of a word are nested, but every synapse is
+ *     at one level only and sees exactly one of them.
+ */
+#include <cmath>
+
+#include "discrete_syn.h"
+
+#define DISCRETE_SYN_CHUNK 64
+
+static_assert(DISCRETE_SYN_CASCADE_LEVELS == 4, "cascade levels are held in two bit planes");
+
+static inline uint64_t random_word(CRandomSFMT0 &randGen)
+{
+	uint64_t hi = randGen.BRandom();
+	return (hi << 32) | randGen.BRandom();
+}
+
+/* the bits of word w that fall in [begin, end) */
+static inline uint64_t range_mask(size_t w, size_t begin, size_t end)
+{
+	uint64_t mask = ~(uint64_t)0;
+	if (w == begin / 64) mask &= ~(uint64_t)0 << (begin % 64);
+	if (w == (end - 1) / 64 && end % 64 != 0) mask &= ~(uint64_t)0 >> (64 - end % 64);
+	return mask;
+}
+
+uint32_t quantize_syn_prob(float p)
+{
+	if (!(p > 0.0f)) return 0;
+	if (p >= 1.0f) return 1u << DISCRETE_SYN_P_BITS;
+	return (uint32_t)lrintf(p * (1u << DISCRETE_SYN_P_BITS));
+}
+
+uint64_t bernoulli_word(CRandomSFMT0 &randGen, uint32_t p_q)
+{
+	if (p_q == 0) return 0;
+	if (p_q >= (1u << DISCRETE_SYN_P_BITS)) return ~(uint64_t)0;
+	uint64_t word = 0;
+	for (int b = __builtin_ctz(p_q); b < DISCRETE_SYN_P_BITS; b++)
+	{
+		uint64_t r = random_word(randGen);
+		word = ((p_q >> b) & 1) ? (word | r) : (word & r);
+	}
+	return word;
+}
+
+void init_discrete_syns(uint64_t *eff, uint64_t *lvl_lo, uint64_t *lvl_hi,
+	const float *w, size_t n, CRandomSFMT0 &randGen)
+{
+	size_t num_words = discrete_syn_words(n);
+	for (size_t i = 0; i < num_words; i++)
+	{
+		eff[i] = 0;
+		if (lvl_lo) lvl_lo[i] = 0;
+		if (lvl_hi) lvl_hi[i] = 0;
+	}
+	for (size_t i = 0; i < n; i++)
+	{
+		if (randGen.Random() < w[i]) eff[i / 64] |= (uint64_t)1 << (i % 64);
+	}
+}
+
+void binary_syn_event(uint64_t *eff, const uint64_t *elig, size_t begin, size_t end,
+	bool ltp, uint32_t p_q, CRandomSFMT0 &randGen)
+{
+	if (begin >= end || p_q == 0) return;
+	uint64_t dir = ltp ? ~(uint64_t)0 : 0;
+	uint64_t e[DISCRETE_SYN_CHUNK], m[DISCRETE_SYN_CHUNK];
+	size_t w_end = (end - 1) / 64 + 1;
+	for (size_t w0 = begin / 64; w0 < w_end; w0 += DISCRETE_SYN_CHUNK)
+	{
+		size_t len = (w_end - w0 < DISCRETE_SYN_CHUNK) ? w_end - w0 : DISCRETE_SYN_CHUNK;
+		for (size_t c = 0; c < len; c++)
+		{
+			e[c] = elig[w0 + c] & range_mask(w0 + c, begin, end);
+			m[c] = e[c] ? bernoulli_word(randGen, p_q) : 0;
+		}
+		uint64_t *eff_c = eff + w0;
+		#pragma omp simd
+		for (size_t c = 0; c < len; c++)
+		{
+			/* synapses whose efficacy is against the event, i.e. that could switch */
+			uint64_t opp = eff_c[c] ^ dir;
+			eff_c[c] ^= e[c] & opp & m[c];
+		}
+	}
+}
+
+void cascade_syn_event(uint64_t *eff, uint64_t *lvl_lo, uint64_t *lvl_hi,
+	const uint64_t *elig, size_t begin, size_t end, bool ltp, uint32_t p_q,
+	CRandomSFMT0 &randGen)
+{
+	if (begin >= end || p_q == 0) return;
+	uint64_t dir = ltp ? ~(uint64_t)0 : 0;
+	/* m[k]: bits set with probability p * 2^-k */
+	uint64_t e[DISCRETE_SYN_CHUNK], m[DISCRETE_SYN_CASCADE_LEVELS][DISCRETE_SYN_CHUNK];
+	size_t w_end = (end - 1) / 64 + 1;
+	for (size_t w0 = begin / 64; w0 < w_end; w0 += DISCRETE_SYN_CHUNK)
+	{
+		size_t len = (w_end - w0 < DISCRETE_SYN_CHUNK) ? w_end - w0 : DISCRETE_SYN_CHUNK;
+		for (size_t c = 0; c < len; c++)
+		{
+			e[c] = elig[w0 + c] & range_mask(w0 + c, begin, end);
+			if (!e[c])
+			{
+				for (int k = 0; k < DISCRETE_SYN_CASCADE_LEVELS; k++) m[k][c] = 0;
+				continue;
+			}
+			m[0][c] = bernoulli_word(randGen, p_q);
+			for (int k = 1; k < DISCRETE_SYN_CASCADE_LEVELS; k++)
+			{
+				m[k][c] = m[k-1][c] & random_word(randGen);
+			}
+		}
+		uint64_t *eff_c = eff + w0;
+		uint64_t *lo_c  = lvl_lo + w0;
+		uint64_t *hi_c  = lvl_hi + w0;
+		#pragma omp simd
+		for (size_t c = 0; c < len; c++)
+		{
+			uint64_t lo = lo_c[c], hi = hi_c[c];
+			uint64_t lv0 = ~hi & ~lo, lv1 = ~hi & lo, lv2 = hi & ~lo, lv3 = hi & lo;
+			uint64_t p_flip = (lv0 & m[0][c]) | (lv1 & m[1][c]) | (lv2 & m[2][c]) | (lv3 & m[3][c]);
+			uint64_t p_deep = (lv0 & m[1][c]) | (lv1 & m[2][c]) | (lv2 & m[3][c]);
+
+			uint64_t opp  = eff_c[c] ^ dir;
+			uint64_t flip = e[c] & opp & p_flip;
+			uint64_t deep = e[c] & ~opp & p_deep;
+
+			eff_c[c] ^= flip;
+			/* deep: level + 1, flip: back to level 0 */
+			lo_c[c] = (lo ^ deep) & ~flip;
+			hi_c[c] = (hi ^ (deep & lo)) & ~flip;
+		}
+	}
+}
+
@@ -0,0 +1,64 @@
+/*
+ * File: discrete_syn.h
+ *
+ * Description:
+ *     Bit-packed state of discrete-weight synapses and the plasticity rules
+ *     that update it: the binary ('dual') model, in which every synapse is
+ *     either weak or strong, and the cascade model (Fusi, Drew and Abbott,
+ *     2005), in which every weak or strong synapse also sits at one of
+ *     DISCRETE_SYN_CASCADE_LEVELS metaplastic levels, each level switching half
+ *     as readily as the one above it.
+ *
+ *     State is held in bit planes of 64 synapses per word: the efficacy plane
+ *     (1 = strong) and, for the cascade, the low and high bit of the level.
+ *     One plasticity event updates all 64 synapses of a word with a handful of
+ *     bitwise operations, and the word loop vectorizes.
+ *
+ *     Transitions are stochastic. An eligible synapse that receives an event
+ *     against its efficacy switches with probability p * 2^-level and lands at
+ *     level 0; one that receives an event in its own direction moves one level
+ *     deeper with probability p * 2^-(level + 1). In the binary model every
+ *     synapse stays at level 0 and only ever switches. p is quantized to
+ *     DISCRETE_SYN_P_BITS bits.
+ */
+#ifndef DISCRETE_SYN_H_
+#define DISCRETE_SYN_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "sfmt.h"
+
+#define DISCRETE_SYN_P_BITS         8
+#define DISCRETE_SYN_CASCADE_LEVELS 4 /* two level planes */
+
+/* words per bit plane of n synapses */
+inline size_t discrete_syn_words(size_t n)
+{
+	return (n + 63) / 64;
+}
+
+/* p in units of 2^-DISCRETE_SYN_P_BITS, rounded to nearest and clamped to [0, 1] */
+uint32_t quantize_syn_prob(float p);
+
+/* a word whose bits are set independently, each with probability
+ * p_q * 2^-DISCRETE_SYN_P_BITS */
+uint64_t bernoulli_word(CRandomSFMT0 &randGen, uint32_t p_q);
+
+/* sets synapse i strong with probability w[i] (clamped to [0, 1]) and its
+ * level to 0. lvl_lo and lvl_hi may be NULL */
+void init_discrete_syns(uint64_t *eff, uint64_t *lvl_lo, uint64_t *lvl_hi,
+	const float *w, size_t n, CRandomSFMT0 &randGen);
+
+/* applies one plasticity event to synapses [begin, end): the eligible ones,
+ * those whose bit is set in elig, are pushed towards strong if ltp and
+ * towards weak otherwise */
+void binary_syn_event(uint64_t *eff, const uint64_t *elig, size_t begin, size_t end,
+	bool ltp, uint32_t p_q, CRandomSFMT0 &randGen);
+
+void cascade_syn_event(uint64_t *eff, uint64_t *lvl_lo, uint64_t *lvl_hi,
+	const uint64_t *elig, size_t begin, size_t end, bool ltp, uint32_t p_q,
+	CRandomSFMT0 &randGen);
+
+#endif /* DISCRETE_SYN_H_ */
+
@@ -12,12 +12,21 @@
 #include "connectivityparams.h" 
 #include "activityparams.h"
 #include "dynamic2darray.h"
+#include "cell_model.h"
 #include "innet.h"
 
+/* MF and GO input to GR is pushed (scattered from the active cells) rather than
+ * pulled (gathered by every GR) in steps where the scatter makes at most this
+ * many increments per granule on a GPU. pulling always visits every granule's
+ * full input list, pushing only the targets of cells that spiked; atomics make
+ * an increment dearer than a gathered read, hence the margin below 1 */
+#define PUSH_MAX_INCS_PER_GR 0.5
+#define PUSH_NUM_THREADS_PER_IN 128
+
 InNet::InNet() {}
 
-InNet::InNet(InNetConnectivityState *cs,
-	InNetActivityState *as, int gpuIndStart, int numGPUs)
+InNet::InNet(const sim_params &params, InNetConnectivityState *cs,
+	InNetActivityState *as, int gpuIndStart, int numGPUs) : sim_params(params)
 {
 	// all of below are shallow-copying the pointers
 	// thus we don't necessarily have ownership over
@@ -31,19 +40,17 @@ InNet::InNet(InNetConnectivityState *cs,
 	this->numGPUs     = numGPUs;
 
 	// why do we allocate these here???
-	gGOGRT = allocate2DArray<float>(max_num_p_gr_from_go_to_gr, num_gr);
-	gMFGRT = allocate2DArray<float>(max_num_p_gr_from_mf_to_gr, num_gr);
-
 	pGRDelayfromGRtoGOT = allocate2DArray<uint32_t>(max_num_p_gr_from_gr_to_go, num_gr);
 	pGRfromMFtoGRT = allocate2DArray<uint32_t>(max_num_p_gr_from_mf_to_gr, num_gr);
 	pGRfromGOtoGRT = allocate2DArray<uint32_t>(max_num_p_gr_from_go_to_gr, num_gr);
 	pGRfromGRtoGOT = allocate2DArray<uint32_t>(max_num_p_gr_from_gr_to_go, num_gr);
 
-	apBufGRHistMask = (1 << (int)tsPerHistBinGR) - 1;
+	initDerivedActParams();
 
 	sumGRInputGO           = new uint32_t[num_go];
 	sumInputGOGABASynDepGO = new float[num_go];
 
+	initUBC();
 	initCUDA();
 }
 
@@ -52,9 +59,6 @@ InNet::~InNet()
 	std::cout << "[INFO]: Deleting innet gpu arrays." << std::endl;
 
 	//gr external to initCUDA
-	delete2DArray<float>(gGOGRT);
-	delete2DArray<float>(gMFGRT);
-
 	delete2DArray<uint32_t>(pGRDelayfromGRtoGOT);
 	delete2DArray<uint32_t>(pGRfromMFtoGRT);
 	delete2DArray<uint32_t>(pGRfromGOtoGRT);
@@ -64,6 +68,12 @@ InNet::~InNet()
 	delete[] sumGRInputGO;
 	delete[] sumInputGOGABASynDepGO;
 
+	// ubc
+	delete[] brushDriverUBC;
+	delete[] inputMFUBC;
+	delete[] inputGOUBC;
+	delete[] apInFibreH;
+
 	// MF CUDA
 	for (int i = 0; i < numGPUs; i++)
 	{
@@ -95,7 +105,6 @@ InNet::~InNet()
 		cudaFree(gLeakGRGPU[i]);
 		cudaFree(gNMDAGRGPU[i]);
 		cudaFree(gNMDAIncGRGPU[i]);
-		cudaFree(gEGRGPU[i]);
 		cudaFree(gEGRSumGPU[i]);
 		cudaFree(gEDirectGPU[i]);
 		cudaFree(gESpilloverGPU[i]);
@@ -104,7 +113,6 @@ InNet::~InNet()
 		cudaFree(depAmpMFGRGPU[i]);
 		cudaFree(depAmpGOGRGPU[i]);
 		cudaFree(dynamicAmpGOGRGPU[i]); 
-		cudaFree(gIGRGPU[i]);
 		cudaFree(gIGRSumGPU[i]);
 		cudaFree(gIDirectGPU[i]);
 		cudaFree(gISpilloverGPU[i]);
@@ -124,8 +132,6 @@ InNet::~InNet()
 	}
 
 	// GR CUDA
-	delete[] gEGRGPU;
-	delete[] gEGRGPUP;
 	delete[] gEGRSumGPU;
 	delete[] gEDirectGPU;
 	delete[] gESpilloverGPU;
@@ -135,8 +141,6 @@ InNet::~InNet()
 	delete[] depAmpGOGRGPU;
 	delete[] dynamicAmpGOGRGPU;
 
-	delete[] gIGRGPU;
-	delete[] gIGRGPUP;
 	delete[] gIGRSumGPU;
 	delete[] gIDirectGPU;
 	delete[] gISpilloverGPU;
@@ -168,9 +172,49 @@ InNet::~InNet()
 	delete[] grConMFOutGRGPU;
 	delete[] grConMFOutGRGPUP;
 
+	// input push delivery
+	for (int i = 0; i < numGPUs; i++)
+	{
+		cudaSetDevice(i + gpuIndStart);
+
+		cudaFree(activeMFGPU[i]);
+		cudaFree(activeGOGPU[i]);
+		cudaFree(numGRPerMFGPU[i]);
+		cudaFree(mfConMFOutGRGPU[i]);
+		cudaFree(numGRPerGOGPU[i]);
+		cudaFree(goConGOOutGRGPU[i]);
+		cudaFree(mfInCountGRGPU[i]);
+		cudaFree(goInCountGRGPU[i]);
+
+		cudaDeviceSynchronize();
+	}
+	cudaFreeHost(activeMFH);
+	cudaFreeHost(activeGOH);
+
+	delete[] activeMFGPU;
+	delete[] activeGOGPU;
+	delete[] numGRPerMFGPU;
+	delete[] mfConMFOutGRGPU;
+	delete[] numGRPerGOGPU;
+	delete[] goConGOOutGRGPU;
+	delete[] mfInCountGRGPU;
+	delete[] goInCountGRGPU;
+
 	delete[] outputGRH;
 	//cudaFreeHost(outputGRH);
 
+	if (spatialActGRGPU)
+	{
+		for (int i = 0; i < numGPUs; i++)
+		{
+			cudaSetDevice(i + gpuIndStart);
+			cudaFree(spatialActGRGPU[i]);
+		}
+		delete[] spatialActGRGPU;
+		delete[] spatialActGRH;
+		delete[] spatialActGO;
+	}
+
 	// GO CUDA
 	for (int i = 0; i < numGPUs; i++)
 	{
@@ -206,9 +250,26 @@ InNet::~InNet()
 	std::cout << "[INFO]: Finished deleting innet gpu arrays." << std::endl;
 }
 
+void InNet::retuneActParams(const act_params &tuned)
+{
+	static_cast<act_params &>(*this) = tuned;
+	initDerivedActParams();
+}
+
+bool InNet::actParamsInEffect(const act_params &tuned)
+{
+	/* act_params holds only floats, so there is no padding to compare */
+	return memcmp((const act_params *)this, &tuned, sizeof(act_params)) == 0
+		&& apBufGRHistMask == (uint32_t)(1 << (int)tuned.tsPerHistBinGR) - 1;
+}
+
+void InNet::initDerivedActParams()
+{
+	apBufGRHistMask = (1 << (int)tsPerHistBinGR) - 1;
+}
+
 void InNet::writeToState()
 {
-	cudaError_t error;
 	//GR variables
 	// WARNING THIS IS A HORRIBLE IDEA. IF YOU GET BUGS CONSIDER THIS!
 	// Reason: the apGR is a unique_ptr. it should only be modifed in the scope
@@ -217,50 +278,15 @@ void InNet::writeToState()
 	getGRGPUData<uint32_t>(apBufGRGPU, as->apBufGR.get());
 	getGRGPUData<float>(gEGRSumGPU, as->gMFSumGR.get());
 	getGRGPUData<float>(gIGRSumGPU, as->gGOSumGR.get());
+	getGRGPUData<float>(gEDirectGPU, as->gMFDirectGR.get());
+	getGRGPUData<float>(gESpilloverGPU, as->gMFSpilloverGR.get());
+	getGRGPUData<float>(gIDirectGPU, as->gGODirectGR.get());
+	getGRGPUData<float>(gISpilloverGPU, as->gGOSpilloverGR.get());
 
 	getGRGPUData<float>(threshGRGPU, as->threshGR.get());
 	getGRGPUData<float>(vGRGPU, as->vGR.get());
 	getGRGPUData<float>(gKCaGRGPU, as->gKCaGR.get());
 	getGRGPUData<uint64_t>(historyGRGPU, as->historyGR.get());
-	for (int i = 0; i < numGPUs; i++)
-	{
-		int cpyStartInd;
-		int cpySize;
-
-		cpyStartInd = numGRPerGPU*i;
-		cpySize     = numGRPerGPU;
-
-		cudaSetDevice(i + gpuIndStart);
-
-		for (int j = 0; j < max_num_p_gr_from_mf_to_gr; j++)
-		{
-			error = cudaMemcpy(&gMFGRT[j][cpyStartInd], (void *)((char *)gEGRGPU[i]+j*gEGRGPUP[i]),
-					cpySize*sizeof(float), cudaMemcpyDeviceToHost);
-		}
-
-		for (int j = 0; j < max_num_p_gr_from_go_to_gr; j++)
-		{
-			error = cudaMemcpy(&gGOGRT[j][cpyStartInd], (void *)((char *)gIGRGPU[i] + j * gIGRGPUP[i]),
-					cpySize*sizeof(float), cudaMemcpyDeviceToHost);
-		}
-	}
-
-	for (int i = 0; i < max_num_p_gr_from_mf_to_gr; i++)
-	{
-		for (int j = 0; j < num_gr; j++)
-		{
-			// NOTE: gMFGR now 1D array.
-			as->gMFGR[j * max_num_p_gr_from_mf_to_gr + i] = gMFGRT[i][j];
-		}
-	}
-
-	for (int i = 0; i < max_num_p_gr_from_go_to_gr; i++)
-	{
-		for (int j = 0; j < num_gr; j++)
-		{
-			as->gGOGR[j * max_num_p_gr_from_go_to_gr + i] = gGOGRT[i][j];
-		}
-	}
 }
 
 //void InNet::grStim(int startGRStim, int numGRStim)
@@ -303,6 +329,16 @@ const uint8_t* InNet::exportAPMF()
 	return (const uint8_t *)apMFOut;
 }
 
+const uint8_t* InNet::exportAPUBC()
+{
+	return (const uint8_t *)as->apUBC.get();
+}
+
+uint32_t InNet::getNumUBC()
+{
+	return cs->numUBC;
+}
+
 const uint8_t* InNet::exportAPGR()
 {
 	cudaError_t error = getGRGPUData<uint8_t>(outputGRGPU, outputGRH);
@@ -348,6 +384,17 @@ const float* InNet::exportGISumGR()
 	return (const float *)as->gGOSumGR.get();
 }
 
+const float* InNet::exportVmGO()
+{
+	return (const float *)as->vGO.get();
+}
+
+const float* InNet::exportVmGR()
+{
+	getGRGPUData<float>(vGRGPU, as->vGR.get());
+	return (const float *)as->vGR.get();
+}
+
 const float* InNet::exportgSum_MFGO()
 {
 	return (const float *)as->gSum_MFGO.get();
@@ -360,6 +407,7 @@ const float* InNet::exportgSum_GRGO()
 
 void InNet::updateMFActivties(const uint8_t *actInMF)
 {
+	if (cs->numUBC > 0) actInMF = calcUBCActivities(actInMF);
 	apMFOut = actInMF;
 	for (int i = 0; i < num_mf; i++)
 	{
@@ -372,69 +420,109 @@ void InNet::updateMFActivties(const uint8_t *actInMF)
 	}
 }
 
-void InNet::calcGOActivities()
+const uint8_t* InNet::calcUBCActivities(const uint8_t *actInMF)
 {
-#pragma omp parallel for
-	for (int i = 0; i < num_go; i++)
+	// gather each brush's input before any UBC spikes anew
+	for (uint32_t i = 0; i < cs->numUBC; i++)
 	{
-		sumGRInputGO[i] = 0;
-		for (int j = 0; j < numGPUs; j++)
+		int driver = brushDriverUBC[i];
+		inputMFUBC[i] = (driver < 0)
+					  ? gIncMFtoUBC * (actInMF[cs->pUBCfromMFtoUBC[i]] > 0)
+					  : gIncUBCtoUBC * as->apUBC[driver];
+
+		int glInd = cs->pUBCfromGLtoUBC[i];
+		uint32_t numGOIn = 0;
+		for (int j = 0; j < cs->numpGLfromGOtoGL[glInd]; j++)
 		{
-			sumGRInputGO[i] += grInputGOSumH[j][i];
+			numGOIn += as->apGO[cs->pGLfromGOtoGL[glInd][j]];
 		}
+		inputGOUBC[i] = numGOIn;
+	}
 
-		float tempVGO = as->vGO[i];
-
-		//NMDA Low
-		float gNMDAIncGRGO = (0.00000082263 * tempVGO * tempVGO * tempVGO)
-						   + (0.00021653 * tempVGO * tempVGO)
-						   + (0.0195 * tempVGO)
-						   + 0.6117; 
+	// the K conductance is driven by each UBC's own spike of the last step,
+	// which its term reads before the update overwrites it
+	lif_cells<uint32_t> ubcs{as->vUBC.get(), as->threshUBC.get(), as->apUBC.get(), as->apBufUBC.get(),
+		gConstUBC, eLeakGR, threshRestGR, threshDecUBC, threshMaxGR, NO_V_MAX};
+
+	update_lif_cells<THRESH_DECAY_FIRST>(ubcs, cs->numUBC,
+		syn_channel<float, SYN_INC_DECAY>{as->gMFUBC.get(), inputMFUBC,
+			1.0f, gDecMFtoUBC, eMFGR, {}},
+		syn_channel<uint32_t, SYN_INC_DECAY>{as->gGOUBC.get(), inputGOUBC,
+			gIncGOtoUBC, gDirectDecGOtoGR, eGOGR, {}},
+		syn_channel<uint8_t, SYN_DECAY_INC>{as->gKUBC.get(), as->apUBC.get(),
+			gKIncUBC, gKDecUBC, eKUBC, {}});
+
+	memcpy(apInFibreH, actInMF, num_mf * sizeof(uint8_t));
+	for (uint32_t i = 0; i < cs->numUBC; i++)
+	{
+		apInFibreH[cs->pUBCfromUBCtoMF[i]] = as->apUBC[i];
+	}
+	return apInFibreH;
+}
 
+/* voltage-dependent increments of the GO NMDA conductances, evaluated on the
+ * membrane potential from before the update */
+struct go_nmda_mf_scale
+{
+	float *gNMDAIncMFGO;
+	float operator()(int i, float v) const
+	{
 		//NMDA High
-		as->gNMDAIncMFGO[i] = (0.00000011969 * tempVGO * tempVGO * tempVGO)
-							+ (0.000089369 * tempVGO * tempVGO)
-							+ (0.0151 * tempVGO)
-							+ 0.7713; 
-
-		as->gSum_MFGO[i] = (as->inputMFGO[i] * mfgoW)
-						 + as->gSum_MFGO[i] * gDecMFtoGO;
-		as->gSum_GOGO[i] = (as->inputGOGO[i] * gogoW * as->synWscalerGOtoGO[i])
-						 +  as->gSum_GOGO[i] * gGABADecGOtoGO;
-		as->gNMDAMFGO[i] = as->inputMFGO[i] * (mfgoW * NMDA_AMPAratioMFGO * as->gNMDAIncMFGO[i])
-						 + as->gNMDAMFGO[i] * gDecayMFtoGONMDA;
-		
-		as->gGRGO[i] = (sumGRInputGO[i] * grgoW * as->synWscalerGRtoGO[i])
-					 + as->gGRGO[i] * gDecGRtoGO;
-		as->gGRGO_NMDA[i] = sumGRInputGO[i] * ((grgoW * as->synWscalerGRtoGO[i]) * 0.6 * gNMDAIncGRGO)
-						  + as->gGRGO_NMDA[i] * gDecayMFtoGONMDA;
-		
-		as->threshCurGO[i] += (threshRestGO - as->threshCurGO[i]) * threshDecGO;
-		
-		tempVGO += (gLeakGO * (eLeakGO - tempVGO))
-				+ (as->gSum_GOGO[i] * (eGABAGO - tempVGO))
-				- (as->gSum_MFGO[i] + as->gGRGO[i] + as->gNMDAMFGO[i]
-					+ as->gGRGO_NMDA[i]) * tempVGO
-				- (as->vCoupleGO[i] * tempVGO);
-
-		//tempVGO = threshMaxGO * (tempVGO > threshMaxGO) + tempVGO * (threshMaxGO > tempVGO); /* TODO: test whether gives same results as branched case */
-		if (tempVGO > threshMaxGO) tempVGO = threshMaxGO;
-		
-		as->apGO[i]    = tempVGO > as->threshCurGO[i];
-		as->apBufGO[i] = (as->apBufGO[i] << 1) | (as->apGO[i] * 0x00000001);
-
-		as->threshCurGO[i] = as->apGO[i] * threshMaxGO
-						   + (1 - as->apGO[i]) * as->threshCurGO[i];
+		gNMDAIncMFGO[i] = (0.00000011969 * v * v * v)
+						+ (0.000089369 * v * v)
+						+ (0.0151 * v)
+						+ 0.7713;
+		return gNMDAIncMFGO[i];
+	}
+};
 
-		as->inputMFGO[i]  = 0;
-		as->inputGOGO[i]  = 0;
-		as->vGO[i]        = tempVGO;
+struct go_nmda_gr_scale
+{
+	const float *synWscalerGRtoGO;
+	float operator()(int i, float v) const
+	{
+		//NMDA Low
+		float gNMDAIncGRGO = (0.00000082263 * v * v * v)
+						   + (0.00021653 * v * v)
+						   + (0.0195 * v)
+						   + 0.6117;
+		return synWscalerGRtoGO[i] * 0.6 * gNMDAIncGRGO;
+	}
+};
 
+void InNet::calcGOActivities()
+{
+	for (int i = 0; i < num_go; i++)
+	{
+		sumGRInputGO[i] = 0;
 		for (int j = 0; j < numGPUs; j++)
 		{
-			apGOH[j][i] = as->apGO[i];
+			sumGRInputGO[i] += grInputGOSumH[j][i];
 		}
 	}
+
+	lif_cells<uint32_t> gos{as->vGO.get(), as->threshCurGO.get(), as->apGO.get(), as->apBufGO.get(),
+		gLeakGO, eLeakGO, threshRestGO, threshDecGO, threshMaxGO, threshMaxGO};
+
+	update_lif_cells<THRESH_DECAY_FIRST>(gos, num_go,
+		syn_channel<float, SYN_DECAY_INC, cell_scale>{as->gSum_GOGO.get(), as->inputGOGO.get(),
+			gogoW, gGABADecGOtoGO, eGABAGO, {as->synWscalerGOtoGO.get()}},
+		syn_channel<uint32_t, SYN_DECAY_INC>{as->gSum_MFGO.get(), as->inputMFGO.get(),
+			mfgoW, gDecMFtoGO, 0.0f, {}},
+		syn_channel<uint32_t, SYN_DECAY_INC, cell_scale>{as->gGRGO.get(), sumGRInputGO,
+			grgoW, gDecGRtoGO, 0.0f, {as->synWscalerGRtoGO.get()}},
+		syn_channel<uint32_t, SYN_DECAY_INC, go_nmda_mf_scale>{as->gNMDAMFGO.get(), as->inputMFGO.get(),
+			mfgoW * NMDA_AMPAratioMFGO, gDecayMFtoGONMDA, 0.0f, {as->gNMDAIncMFGO.get()}},
+		syn_channel<uint32_t, SYN_DECAY_INC, go_nmda_gr_scale>{as->gGRGO_NMDA.get(), sumGRInputGO,
+			grgoW, gDecayMFtoGONMDA, 0.0f, {as->synWscalerGRtoGO.get()}},
+		cond_channel{as->vCoupleGO.get(), 0.0f});
+
+	memset(as->inputMFGO.get(), 0, num_go * sizeof(uint32_t));
+	memset(as->inputGOGO.get(), 0, num_go * sizeof(float));
+	for (int j = 0; j < numGPUs; j++)
+	{
+		std::copy(as->apGO.get(), as->apGO.get() + num_go, apGOH[j]);
+	}
 }
 
 void InNet::updateMFtoGROut()
@@ -610,11 +698,6 @@ void InNet::cpyAPMFHosttoGPUCUDA(cudaStream_t **sts, int streamN)
 	}
 }
 
-void InNet::cpyDepAmpUBCHosttoGPUCUDA(cudaStream_t **sts, int streamN) {}
-
-
-void InNet::cpyAPUBCHosttoGPUCUDA(cudaStream_t **sts, int streamN) {}
-
 void InNet::cpyDepAmpGOGRHosttoGPUCUDA(cudaStream_t **sts, int streamN) {}
 
 void InNet::cpyDynamicAmpGOGRHosttoGPUCUDA(cudaStream_t **sts, int streamN)
@@ -647,18 +730,52 @@ void InNet::cpyAPGOHosttoGPUCUDA(cudaStream_t **sts, int streamN)
 	}
 }
 
+uint32_t InNet::compactActiveInputs(const uint32_t *apInH, int numInCells, const int *numGRPerIn,
+	uint32_t *activeInH, uint64_t &numGRIncs)
+{
+	uint32_t numActive = 0;
+	numGRIncs = 0;
+	for (int i = 0; i < numInCells; i++)
+	{
+		activeInH[numActive] = i;
+		numActive += (apInH[i] > 0);
+		numGRIncs += (apInH[i] > 0) * numGRPerIn[i];
+	}
+	return numActive;
+}
+
 void InNet::runUpdateMFInGRCUDA(cudaStream_t **sts, int streamN)
 {
 	cudaError_t error;
+	uint64_t numGRIncs;
+	uint32_t numActive = compactActiveInputs(apMFH[0], num_mf, cs->numpMFfromMFtoGR,
+		activeMFH, numGRIncs);
+	bool push = numGRIncs <= PUSH_MAX_INCS_PER_GR * numGRPerGPU;
 	for(int i=0; i<numGPUs; i++)
 	{
 		error=cudaSetDevice(i+gpuIndStart);
-		callUpdateMFInGROPKernel(sts[i][streamN], updateMFInGRNumBlocks, updateMFInGRNumGRPerB,
-				num_mf, apMFGPU[i], depAmpMFGRGPU[i] ,gEGRGPU[i], gEGRGPUP[i],   
-				grConMFOutGRGPU[i], grConMFOutGRGPUP[i],
-				numMFInPerGRGPU[i], apMFtoGRGPU[i], gEGRSumGPU[i], gEDirectGPU[i], gESpilloverGPU[i], 
-				gDirectDecMFtoGR, gIncDirectMFtoGR, gSpilloverDecMFtoGR,
-				gIncFracSpilloverMFtoGR);
+		if (push)
+		{
+			error=cudaMemcpyAsync(activeMFGPU[i], activeMFH, numActive*sizeof(uint32_t),
+				cudaMemcpyHostToDevice, sts[i][streamN]);
+			callScatterInGRKernel(sts[i][streamN], numActive, PUSH_NUM_THREADS_PER_IN,
+					activeMFGPU[i], mfConMFOutGRGPU[i], numGRPerMFGPU[i], max_num_p_mf_from_mf_to_gr,
+					i * numGRPerGPU, numGRPerGPU, mfInCountGRGPU[i]);
+			callUpdateMFInGRPushKernel(sts[i][streamN], updateMFInGRNumBlocks, updateMFInGRNumGRPerB,
+					mfInCountGRGPU[i], depAmpMFGRGPU[i], apMFtoGRGPU[i],
+					gEGRSumGPU[i], gEDirectGPU[i], gESpilloverGPU[i],
+					gDirectDecMFtoGR, gIncDirectMFtoGR, gSpilloverDecMFtoGR,
+					gIncFracSpilloverMFtoGR);
+		}
+		else
+		{
+			callUpdateMFInGROPKernel(sts[i][streamN], updateMFInGRNumBlocks, updateMFInGRNumGRPerB,
+					num_mf, apMFGPU[i], depAmpMFGRGPU[i],
+					grConMFOutGRGPU[i], grConMFOutGRGPUP[i],
+					numMFInPerGRGPU[i], apMFtoGRGPU[i], gEGRSumGPU[i], gEDirectGPU[i], gESpilloverGPU[i], 
+					gDirectDecMFtoGR, gIncDirectMFtoGR, gSpilloverDecMFtoGR,
+					gIncFracSpilloverMFtoGR);
+		}
 #ifdef DEBUGOUT
 		error=cudaGetLastError();
 		cerr<<"runUpdateMFInGRCUDA: kernel launch for gpu #"<<i<<
@@ -684,22 +801,35 @@ void InNet::runUpdateMFInGRDepressionCUDA(cudaStream_t **sts, int streamN)
 	}
 }
 
-void InNet::runUpdateUBCInGRCUDA(cudaStream_t **sts, int streamN) {}
-
-
-void InNet::runUpdateUBCInGRDepressionCUDA(cudaStream_t **sts, int streamN) {}
-
 void InNet::runUpdateGOInGRCUDA(cudaStream_t **sts, int streamN)
 {
 	cudaError_t error;
+	uint64_t numGRIncs;
+	uint32_t numActive = compactActiveInputs(apGOH[0], num_go, cs->numpGOfromGOtoGR,
+		activeGOH, numGRIncs);
+	bool push = numGRIncs <= PUSH_MAX_INCS_PER_GR * numGRPerGPU;
 	for(int i=0; i<numGPUs; i++)
 	{
 		error=cudaSetDevice(i+gpuIndStart);
-		callUpdateInGROPKernel(sts[i][streamN], updateGOInGRNumBlocks, updateGOInGRNumGRPerB,
-				num_go, apGOGPU[i], dynamicAmpGOGRGPU[i], gIGRGPU[i], gIGRGPUP[i],
-				grConGOOutGRGPU[i], grConGOOutGRGPUP[i],
-				numGOInPerGRGPU[i], gIGRSumGPU[i], gIDirectGPU[i], gISpilloverGPU[i], 
-				gDirectDecGOtoGR, gogrW, gIncFracSpilloverGOtoGR, gSpilloverDecGOtoGR);
+		if (push)
+		{
+			error=cudaMemcpyAsync(activeGOGPU[i], activeGOH, numActive*sizeof(uint32_t),
+				cudaMemcpyHostToDevice, sts[i][streamN]);
+			callScatterInGRKernel(sts[i][streamN], numActive, PUSH_NUM_THREADS_PER_IN,
+					activeGOGPU[i], goConGOOutGRGPU[i], numGRPerGOGPU[i], max_num_p_go_from_go_to_gr,
+					i * numGRPerGPU, numGRPerGPU, goInCountGRGPU[i]);
+			callUpdateInGRPushKernel(sts[i][streamN], updateGOInGRNumBlocks, updateGOInGRNumGRPerB,
+					goInCountGRGPU[i], dynamicAmpGOGRGPU[i],
+					gIGRSumGPU[i], gIDirectGPU[i], gISpilloverGPU[i], gDirectDecGOtoGR, gogrW);
+		}
+		else
+		{
+			callUpdateInGROPKernel(sts[i][streamN], updateGOInGRNumBlocks, updateGOInGRNumGRPerB,
+					num_go, apGOGPU[i], dynamicAmpGOGRGPU[i],
+					grConGOOutGRGPU[i], grConGOOutGRGPUP[i],
+					numGOInPerGRGPU[i], gIGRSumGPU[i], gIDirectGPU[i], gISpilloverGPU[i], 
+					gDirectDecGOtoGR, gogrW, gIncFracSpilloverGOtoGR, gSpilloverDecGOtoGR);
+		}
 #ifdef DEBUGOUT
 		error=cudaGetLastError();
 		cerr<<"runUpdateGOInGRCUDA: kernel launch for gpu #"<<i<<
@@ -776,6 +906,81 @@ void InNet::cpyGRGOSumGPUtoHostCUDA(cudaStream_t **sts, int streamN, uint32_t **
 	}
 }
 
+void InNet::setSpatialActivity(bool on, float decayTau)
+{
+	if (on)
+	{
+		if (!spatialActGRGPU)
+		{
+			spatialActGRGPU = new float*[numGPUs];
+			for (int i = 0; i < numGPUs; i++)
+			{
+				cudaSetDevice(i + gpuIndStart);
+				cudaMalloc((void **)&spatialActGRGPU[i], num_go * sizeof(float));
+			}
+			spatialActGRH = new float[num_go];
+			spatialActGO  = new float[num_go];
+		}
+		for (int i = 0; i < numGPUs; i++)
+		{
+			cudaSetDevice(i + gpuIndStart);
+			cudaMemset(spatialActGRGPU[i], 0, num_go * sizeof(float));
+		}
+		memset(spatialActGO, 0, num_go * sizeof(float));
+		spatialActDecay = exp(-msPerTimeStep / decayTau);
+	}
+	spatialActOn = on;
+}
+
+bool InNet::spatialActivityOn()
+{
+	return spatialActOn;
+}
+
+void InNet::exportSpatialAct(float *grSpatialAct, float *goSpatialAct)
+{
+	memset(grSpatialAct, 0, num_go * sizeof(float));
+	if (!spatialActGRGPU)
+	{
+		memset(goSpatialAct, 0, num_go * sizeof(float));
+		return;
+	}
+	/* each gpu only bins its own slice of granules, so the maps add */
+	for (int i = 0; i < numGPUs; i++)
+	{
+		cudaSetDevice(i + gpuIndStart);
+		cudaMemcpy(spatialActGRH, spatialActGRGPU[i], num_go * sizeof(float), cudaMemcpyDeviceToHost);
+		for (int j = 0; j < num_go; j++) grSpatialAct[j] += spatialActGRH[j];
+	}
+	memcpy(goSpatialAct, spatialActGO, num_go * sizeof(float));
+}
+
+void InNet::runUpdateGRSpatialActCUDA(cudaStream_t **sts, int streamN)
+{
+	if (!spatialActOn) return;
+	cudaError_t error;
+	for (int i = 0; i < numGPUs; i++)
+	{
+		error=cudaSetDevice(i + gpuIndStart);
+		callUpdateGRSpatialActKernel(sts[i][streamN], updateGRHistNumBlocks, updateGRHistNumGRPerB,
+				outputGRGPU[i], spatialActGRGPU[i], i * numGRPerGPU, gr_x, gr_y, go_x, go_y,
+				spatialActDecay);
+	}
+}
+
+void InNet::updateGOSpatialAct()
+{
+	if (!spatialActOn) return;
+	float *__restrict__ goAct     = spatialActGO;
+	const uint8_t *__restrict__ ap = as->apGO.get();
+	const float decay             = spatialActDecay;
+#pragma omp simd
+	for (int i = 0; i < num_go; i++)
+	{
+		goAct[i] = goAct[i] * decay + ap[i];
+	}
+}
+
 void InNet::runUpdateGRHistoryCUDA(cudaStream_t **sts, int streamN, unsigned long t)
 {
 	cudaError_t error;
@@ -814,9 +1019,6 @@ void InNet::initCUDA()
 	updateMFInGRNumGRPerB = 1024 * (num_mf > 1024) + (num_mf <= 1024) * num_mf;
 	updateMFInGRNumBlocks = numGRPerGPU / updateMFInGRNumGRPerB;
 
-	updateUBCInGRNumGRPerB = 1024 * (num_ubc > 1024) + (num_ubc <= 1024) * num_ubc;
-	updateUBCInGRNumBlocks = numGRPerGPU / updateUBCInGRNumGRPerB;
-
 	updateGOInGRNumGRPerB = 1024 * (num_go >= 1024) + (num_go < 1024) * num_go;
 	updateGOInGRNumBlocks = numGRPerGPU / updateGOInGRNumGRPerB;
 
@@ -834,9 +1036,30 @@ void InNet::initCUDA()
 	initGOCUDA();
 	std::cerr << "[INFO]: Initialized GO CUDA - Last error: "
 	    	  << cudaGetErrorString(cudaGetLastError()) << std::endl;
+	initInputPushCUDA();
+	std::cerr << "[INFO]: Initialized input push CUDA - Last error: "
+	    	  << cudaGetErrorString(cudaGetLastError()) << std::endl;
 	std::cout << "[INFO]: Finished initializing per-cell cuda vars." << std::endl;
 }
 
+void InNet::initUBC()
+{
+	if (cs->numUBC == 0) return;
+	brushDriverUBC = new int[cs->numUBC];
+	inputMFUBC     = new float[cs->numUBC];
+	inputGOUBC     = new uint32_t[cs->numUBC];
+	apInFibreH     = new uint8_t[num_mf];
+
+	// a brush on another UBC's axon is driven by that UBC
+	std::fill(brushDriverUBC, brushDriverUBC + cs->numUBC, -1);
+	int *axonUBC = new int[num_mf];
+	std::fill(axonUBC, axonUBC + num_mf, -1);
+	for (uint32_t i = 0; i < cs->numUBC; i++) axonUBC[cs->pUBCfromUBCtoMF[i]] = i;
+	for (uint32_t i = 0; i < cs->numUBC; i++) brushDriverUBC[i] = axonUBC[cs->pUBCfromMFtoUBC[i]];
+	delete[] axonUBC;
+	std::cout << "[INFO]: Initialized " << cs->numUBC << " UBCs." << std::endl;
+}
+
 void InNet::initMFCUDA()
 {
 	apMFH		= new uint32_t*[numGPUs];
@@ -874,8 +1097,6 @@ void InNet::initMFCUDA()
 
 void InNet::initGRCUDA()
 {
-	gEGRGPU			  = new float*[numGPUs];
-	gEGRGPUP		  = new size_t[numGPUs];
 	gEGRSumGPU		  = new float*[numGPUs];
 	gEDirectGPU		  = new float*[numGPUs];
 	gESpilloverGPU	  = new float*[numGPUs];
@@ -885,8 +1106,6 @@ void InNet::initGRCUDA()
 	depAmpGOGRGPU	  = new float*[numGPUs];
 	dynamicAmpGOGRGPU = new float*[numGPUs];
 
-	gIGRGPU		   = new float*[numGPUs];
-	gIGRGPUP	   = new size_t[numGPUs];
 	gIGRSumGPU     = new float*[numGPUs];
 	gIDirectGPU	   = new float*[numGPUs];
 	gISpilloverGPU = new float*[numGPUs];
@@ -930,8 +1149,6 @@ void InNet::initGRCUDA()
 	for( int i = 0; i < numGPUs; i++)
 	{
 		cudaSetDevice(i+gpuIndStart);
-		cudaMallocPitch((void **)&gEGRGPU[i], (size_t *)&gEGRGPUP[i],
-			numGRPerGPU * sizeof(float), max_num_p_gr_from_mf_to_gr);
 		cudaMalloc((void **)&gEGRSumGPU[i], numGRPerGPU*sizeof(float));
 		cudaMalloc((void **)&gEDirectGPU[i], numGRPerGPU*sizeof(float));
 		cudaMalloc((void **)&gESpilloverGPU[i], numGRPerGPU*sizeof(float));
@@ -941,8 +1158,6 @@ void InNet::initGRCUDA()
 		cudaMalloc((void **)&depAmpGOGRGPU[i], numGRPerGPU*sizeof(float));
 		cudaMalloc((void **)&dynamicAmpGOGRGPU[i], numGRPerGPU*sizeof(float));
 
-		cudaMallocPitch((void **)&gIGRGPU[i], (size_t *)&gIGRGPUP[i],
-			numGRPerGPU*sizeof(float), max_num_p_gr_from_go_to_gr);
 		cudaMalloc((void **)&gIGRSumGPU[i], numGRPerGPU*sizeof(float));
 		cudaMalloc((void **)&gIDirectGPU[i], numGRPerGPU*sizeof(float));
 		cudaMalloc((void **)&gISpilloverGPU[i], numGRPerGPU*sizeof(float));
@@ -985,28 +1200,22 @@ void InNet::initGRCUDA()
 
 	std::cout << "[INFO]: Initializing transposed copies of act state and con state vars..." << std::endl;
 
-	// create a transposed copy of the matrices from activity state and connectivity
-	for (int i = 0; i < max_num_p_gr_from_go_to_gr; i++)
+	// create a transposed copy of the matrices from activity state and connectivity.
+	// each thread transposes a contiguous block of granules: it reads whole rows of
+	// the connectivity and is the first to touch its slice of every (calloc'd) row
+	// of the transposes, so those pages are placed on its node
+	#pragma omp parallel for schedule(static)
+	for (int j = 0; j < num_gr; j++)
 	{
-		for (int j = 0; j < num_gr; j++)
+		for (int i = 0; i < max_num_p_gr_from_go_to_gr; i++)
 		{
-			gGOGRT[i][j]         = as->gGOGR[j * max_num_p_gr_from_go_to_gr + i];
 			pGRfromGOtoGRT[i][j] = cs->pGRfromGOtoGR[j][i];
 		}
-	}
-
-	for (int i = 0; i < max_num_p_gr_from_mf_to_gr; i++)
-	{
-		for (int j = 0; j < num_gr; j++)
+		for (int i = 0; i < max_num_p_gr_from_mf_to_gr; i++)
 		{
-			gMFGRT[i][j]         = as->gMFGR[j * max_num_p_gr_from_mf_to_gr + i];
 			pGRfromMFtoGRT[i][j] = cs->pGRfromMFtoGR[j][i];
 		}
-	}
-	
-	for (int i = 0; i < max_num_p_gr_from_gr_to_go; i++)
-	{
-		for (int j = 0; j < num_gr; j++)
+		for (int i = 0; i < max_num_p_gr_from_gr_to_go; i++)
 		{
 			pGRDelayfromGRtoGOT[i][j] = cs->pGRDelayMaskfromGRtoGO[j][i];
 			pGRfromGRtoGOT[i][j]      = cs->pGRfromGRtoGO[j][i];
@@ -1029,8 +1238,6 @@ void InNet::initGRCUDA()
 
 		for(int j = 0; j < max_num_p_gr_from_mf_to_gr; j++)
 		{
-			cudaMemcpy((void *)((char *)gEGRGPU[i] + j * gEGRGPUP[i]), &gMFGRT[j][cpyStartInd],
-				cpySize * sizeof(float), cudaMemcpyHostToDevice);	
 			cudaMemcpy((void *)((char *)grConMFOutGRGPU[i]+ j * grConMFOutGRGPUP[i]),
 				&pGRfromMFtoGRT[j][cpyStartInd], cpySize * sizeof(uint32_t), cudaMemcpyHostToDevice);
 		}
@@ -1038,8 +1245,10 @@ void InNet::initGRCUDA()
 		cudaMemcpy(vGRGPU[i], &(as->vGR[cpyStartInd]), cpySize * sizeof(float), cudaMemcpyHostToDevice);	
 		cudaMemcpy(gEGRSumGPU[i], &(as->gMFSumGR[cpyStartInd]), cpySize * sizeof(float),
 			cudaMemcpyHostToDevice);	
-		cudaMemset(gEDirectGPU[i], 0.0, cpySize * sizeof(float));
-		cudaMemset(gESpilloverGPU[i], 0.0, cpySize * sizeof(float));
+		cudaMemcpy(gEDirectGPU[i], &(as->gMFDirectGR[cpyStartInd]), cpySize * sizeof(float),
+			cudaMemcpyHostToDevice);
+		cudaMemcpy(gESpilloverGPU[i], &(as->gMFSpilloverGR[cpyStartInd]), cpySize * sizeof(float),
+			cudaMemcpyHostToDevice);
 		cudaMemcpy(apMFtoGRGPU[i], &(as->apMFtoGR[cpyStartInd]), cpySize * sizeof(int), cudaMemcpyHostToDevice);
 		cudaMemcpy(numMFperGR[i], &(cs->numpGRfromMFtoGR[cpyStartInd]), cpySize * sizeof(int),
 			cudaMemcpyHostToDevice);	
@@ -1049,15 +1258,15 @@ void InNet::initGRCUDA()
 		
 		for (int j = 0; j < max_num_p_gr_from_go_to_gr; j++)
 		{
-			cudaMemcpy((void *)((char *)gIGRGPU[i] + j * gIGRGPUP[i]), &gGOGRT[j][cpyStartInd],
-				cpySize * sizeof(float), cudaMemcpyHostToDevice);
 			cudaMemcpy((void *)((char *)grConGOOutGRGPU[i]+j*grConGOOutGRGPUP[i]),
 					&pGRfromGOtoGRT[j][cpyStartInd], cpySize * sizeof(uint32_t), cudaMemcpyHostToDevice);
 		}
 
 		cudaMemcpy(gIGRSumGPU[i], &(as->gGOSumGR[cpyStartInd]), cpySize * sizeof(float), cudaMemcpyHostToDevice);
-		cudaMemset(gIDirectGPU[i], 0.0, cpySize * sizeof(float));	
-		cudaMemset(gISpilloverGPU[i], 0.0, cpySize * sizeof(float));
+		cudaMemcpy(gIDirectGPU[i], &(as->gGODirectGR[cpyStartInd]), cpySize * sizeof(float),
+			cudaMemcpyHostToDevice);
+		cudaMemcpy(gISpilloverGPU[i], &(as->gGOSpilloverGR[cpyStartInd]), cpySize * sizeof(float),
+			cudaMemcpyHostToDevice);
 
 		cudaMemcpy(apBufGRGPU[i], &(as->apBufGR[cpyStartInd]), cpySize * sizeof(uint32_t),
 			cudaMemcpyHostToDevice);
@@ -1100,6 +1309,57 @@ void InNet::initGRCUDA()
 	std::cout << "[INFO]: Finished initializing GR cuda variables..." << std::endl;
 }
 
+/*
+ * the push path scatters from each active MF or GO cell to the granules it
+ * contacts, so it needs the input-to-GR adjacency (pMFfromMFtoGR and
+ * pGOfromGOtoGR) rather than the transposed GR-from-input matrices the gather
+ * kernels use. each GPU gets all of it, as any input cell may contact granules
+ * on any GPU, and keeps counts only for its own slice of granules.
+ */
+void InNet::initInputPushCUDA()
+{
+	activeMFGPU     = new uint32_t*[numGPUs];
+	activeGOGPU     = new uint32_t*[numGPUs];
+	numGRPerMFGPU   = new int32_t*[numGPUs];
+	mfConMFOutGRGPU = new uint32_t*[numGPUs];
+	numGRPerGOGPU   = new int32_t*[numGPUs];
+	goConGOOutGRGPU = new uint32_t*[numGPUs];
+	mfInCountGRGPU  = new uint32_t*[numGPUs];
+	goInCountGRGPU  = new uint32_t*[numGPUs];
+
+	cudaMallocHost((void **)&activeMFH, num_mf * sizeof(uint32_t));
+	cudaMallocHost((void **)&activeGOH, num_go * sizeof(uint32_t));
+
+	std::cout << "[INFO]: Allocating input push cuda variables..." << std::endl;
+	for (int i = 0; i < numGPUs; i++)
+	{
+		cudaSetDevice(i + gpuIndStart);
+		cudaMalloc((void **)&activeMFGPU[i], num_mf * sizeof(uint32_t));
+		cudaMalloc((void **)&activeGOGPU[i], num_go * sizeof(uint32_t));
+		cudaMalloc((void **)&numGRPerMFGPU[i], num_mf * sizeof(int32_t));
+		cudaMalloc((void **)&mfConMFOutGRGPU[i], num_mf * max_num_p_mf_from_mf_to_gr * sizeof(uint32_t));
+		cudaMalloc((void **)&numGRPerGOGPU[i], num_go * sizeof(int32_t));
+		cudaMalloc((void **)&goConGOOutGRGPU[i], num_go * max_num_p_go_from_go_to_gr * sizeof(uint32_t));
+		cudaMalloc((void **)&mfInCountGRGPU[i], numGRPerGPU * sizeof(uint32_t));
+		cudaMalloc((void **)&goInCountGRGPU[i], numGRPerGPU * sizeof(uint32_t));
+
+		// the adjacency holds non-negative GR indices, so the int rows copy as is
+		cudaMemcpy(numGRPerMFGPU[i], cs->numpMFfromMFtoGR, num_mf * sizeof(int32_t),
+			cudaMemcpyHostToDevice);
+		cudaMemcpy(mfConMFOutGRGPU[i], cs->pMFfromMFtoGR[0],
+			num_mf * max_num_p_mf_from_mf_to_gr * sizeof(uint32_t), cudaMemcpyHostToDevice);
+		cudaMemcpy(numGRPerGOGPU[i], cs->numpGOfromGOtoGR, num_go * sizeof(int32_t),
+			cudaMemcpyHostToDevice);
+		cudaMemcpy(goConGOOutGRGPU[i], cs->pGOfromGOtoGR[0],
+			num_go * max_num_p_go_from_go_to_gr * sizeof(uint32_t), cudaMemcpyHostToDevice);
+		cudaMemset(mfInCountGRGPU[i], 0, numGRPerGPU * sizeof(uint32_t));
+		cudaMemset(goInCountGRGPU[i], 0, numGRPerGPU * sizeof(uint32_t));
+
+		cudaDeviceSynchronize();
+	}
+	std::cout << "[INFO]: Finished initializing input push cuda variables." << std::endl;
+}
+
 void InNet::initGOCUDA()
 {
 	//FIXME: change the types of some of these arrays (see joe's biasManip sim)
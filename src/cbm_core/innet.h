@@ -16,17 +16,26 @@
 #include "innetactivitystate.h"
 #include "kernels.h"
 
-class InNet
+class InNet : protected sim_params
 {
 public:
 	InNet();
-	InNet(InNetConnectivityState *cs, InNetActivityState *as, int gpuIndStart, int numGPUs);
+	InNet(const sim_params &params, InNetConnectivityState *cs, InNetActivityState *as,
+		int gpuIndStart, int numGPUs);
 	~InNet();
 
 	void writeToState();
+	/* also recomputes the members derived from act params */
+	void retuneActParams(const act_params &tuned);
+	/* whether this net runs on tuned, derived members included */
+	bool actParamsInEffect(const act_params &tuned);
 
 	const uint8_t* exportAPGO();
+	/* MF spikes as seen by GR and GO: with UBCs, their axons' input fibres carry
+	 * UBC spikes */
 	const uint8_t* exportAPMF();
+	const uint8_t* exportAPUBC();
+	uint32_t getNumUBC();
 	const uint8_t* exportAPGR();
 
 	const uint32_t* exportSumGRInputGO();
@@ -42,8 +51,22 @@ public:
 	const float* exportGISumGR();
 	const float* exportgSum_MFGO();
 	const float* exportgSum_GRGO();
+	const float* exportVmGO();
+	const float* exportVmGR();
+
+	/* spatial activity maps: GR and GO spikes, exponentially decaying with time
+	 * constant decayTau (ms), binned on the go_x by go_y golgi grid. maps are
+	 * zeroed when enabled and cost nothing while disabled */
+	void setSpatialActivity(bool on, float decayTau);
+	bool spatialActivityOn();
+	void exportSpatialAct(float *grSpatialAct, float *goSpatialAct);
+	void runUpdateGRSpatialActCUDA(cudaStream_t **sts, int streamN);
+	void updateGOSpatialAct();
 
 	void updateMFActivties(const uint8_t *actInMF);
+	/* advances the UBCs by one step on this step's MF and last step's GO and UBC
+	 * spikes. returns actInMF with the UBC axons' spikes in place */
+	const uint8_t* calcUBCActivities(const uint8_t *actInMF);
 	void calcGOActivities();
 
 	void updateMFtoGROut();
@@ -57,18 +80,12 @@ public:
 	void cpyDepAmpMFHosttoGPUCUDA(cudaStream_t **sts, int streamN);
 	void cpyAPMFHosttoGPUCUDA(cudaStream_t **sts, int streamN);
 	
-	void cpyDepAmpUBCHosttoGPUCUDA(cudaStream_t **sts, int streamN);
-	void cpyAPUBCHosttoGPUCUDA(cudaStream_t **sts, int streamN);
-	
 	void cpyDepAmpGOGRHosttoGPUCUDA(cudaStream_t **sts, int streamN);
 	void cpyDynamicAmpGOGRHosttoGPUCUDA(cudaStream_t **sts, int streamN);
 	void cpyAPGOHosttoGPUCUDA(cudaStream_t **sts, int streamN);
 	void runUpdateMFInGRCUDA(cudaStream_t **sts, int streamN);
 	void runUpdateMFInGRDepressionCUDA(cudaStream_t **sts, int streamN);
 	
-	void runUpdateUBCInGRDepressionCUDA(cudaStream_t **sts, int streamN);
-	void runUpdateUBCInGRCUDA(cudaStream_t **sts, int streamN);
-	
 	void runUpdateGOInGRCUDA(cudaStream_t **sts, int streamN);
 	void runUpdateGOInGRDepressionCUDA(cudaStream_t **sts, int streamN);
 	void runUpdateGOInGRDynamicSpillCUDA(cudaStream_t **sts, int streamN);
@@ -100,9 +117,6 @@ protected:
 	
 	unsigned int updateMFInGRNumGRPerB;
 	unsigned int updateMFInGRNumBlocks;
-	
-	unsigned int updateUBCInGRNumGRPerB;
-	unsigned int updateUBCInGRNumBlocks;
 
 	unsigned int updateGOInGRNumGRPerB;
 	unsigned int updateGOInGRNumBlocks;
@@ -110,13 +124,11 @@ protected:
 	unsigned int updateGRHistNumGRPerB;
 	unsigned int updateGRHistNumBlocks;
 
-	//UBC
-	uint32_t **apUBCH;
-	uint32_t **apUBCGPU;
-
-	float **depAmpUBCH;
-	float **depAmpUBCGPU;
-	float **depAmpUBCGRGPU;
+	//unipolar brush cells, updated on the host. all NULL without UBCs
+	int *brushDriverUBC     = NULL; // UBC whose axon drives each brush, -1 for an MF
+	float *inputMFUBC      = NULL;
+	uint32_t *inputGOUBC   = NULL;
+	uint8_t *apInFibreH    = NULL; // this step's MF spikes with the UBC axons in place
 
 	//mossy fibers
 	const uint8_t *apMFOut;
@@ -130,7 +142,6 @@ protected:
 	float **depAmpMFGRGPU;
 
 	int **numMFperGR;
-	int **numUBCperGR;
 	//end gpu related variables
 
 	//golgi cell variables
@@ -163,39 +174,31 @@ protected:
 	//end golgi cell variables
 
 	//granule cell variables
-	float **gMFGRT;
-	float **gUBCGRT;
-	float **gGOGRT;
-
 	uint32_t **pGRDelayfromGRtoGOT;
 	uint32_t **pGRfromMFtoGRT;
-	uint32_t **pGRfromUBCtoGRT;
 	uint32_t **pGRfromGOtoGRT;
 	uint32_t **pGRfromGRtoGOT;
 
-	uint32_t apBufGRHistMask;
+	uint32_t apBufGRHistMask; /* derived from tsPerHistBinGR */
+
+	//spatial activity maps, num_go bins each
+	bool spatialActOn     = false;
+	float spatialActDecay = 0.0;
+	float **spatialActGRGPU = NULL;
+	float *spatialActGRH    = NULL;
+	float *spatialActGO     = NULL;
 	//gpu related variables
 	//host variables
 	uint8_t *outputGRH;
 	//end host variables
 
-	float **gEGRGPU;
-	size_t *gEGRGPUP;
 	float **gEGRSumGPU;
 	float **gEDirectGPU;
 	float **gESpilloverGPU;
 	float **gIDirectGPU;
 	float **gISpilloverGPU;
 	int   **apMFtoGRGPU;
-	int   **apUBCtoGRGPU;
-	float **gUBC_EGRGPU;
-	size_t *gUBC_EGRGPUP;
-	float **gUBC_EGRSumGPU;
-	float **gUBC_EDirectGPU;
-	float **gUBC_ESpilloverGPU;
-
-	float **gIGRGPU;
-	size_t *gIGRGPUP;
+
 	float **gIGRSumGPU;
 
 	uint32_t **apBufGRGPU;
@@ -234,11 +237,21 @@ protected:
 	int32_t  **numMFInPerGRGPU;
 	uint32_t **grConMFOutGRGPU;
 	size_t *grConMFOutGRGPUP;
-	
-	
-	int32_t **numUBCInPerGRGPU;
-	uint32_t **grConUBCOutGRGPU;
-	size_t *grConUBCOutGRGPUP;
+
+	//push delivery of MF and GO input: indices of this step's active cells,
+	//the reverse (input to GR) adjacency and per-GR spike counts
+	uint32_t *activeMFH;
+	uint32_t *activeGOH;
+	uint32_t **activeMFGPU;
+	uint32_t **activeGOGPU;
+
+	int32_t  **numGRPerMFGPU;
+	uint32_t **mfConMFOutGRGPU;
+	int32_t  **numGRPerGOGPU;
+	uint32_t **goConGOOutGRGPU;
+
+	uint32_t **mfInCountGRGPU;
+	uint32_t **goInCountGRGPU;
 	
 	//end gpu variables
 	//end granule cell variables
@@ -248,6 +261,12 @@ protected:
 	void initGRCUDA();
 	void initGOCUDA();
 	void initSCCUDA();
+	void initInputPushCUDA();
+	void initUBC();
+	void initDerivedActParams();
+
+	uint32_t compactActiveInputs(const uint32_t *apInH, int numInCells, const int *numGRPerIn,
+		uint32_t *activeInH, uint64_t &numGRIncs);
 
 private:
 	template<typename Type>
@@ -16,6 +16,22 @@ __global__ void testKernel(float *a, float *b, float *c)
  	c[i] = a[i] + b[i];
  }
 
+/* independent FMA chains, so that every thread keeps the FMA pipes busy.
+ * each thread does iters * PEAK_FLOPS_CHAINS * 2 flops */
+__global__ void peakFlopsKernel(float *out, unsigned int iters)
+{
+	float acc[PEAK_FLOPS_CHAINS];
+	for (int j = 0; j < PEAK_FLOPS_CHAINS; j++) acc[j] = threadIdx.x + j;
+	for (unsigned int i = 0; i < iters; i++)
+	{
+#pragma unroll
+		for (int j = 0; j < PEAK_FLOPS_CHAINS; j++) acc[j] = acc[j] * 0.9999f + 0.0001f;
+	}
+	float sum = 0.0f;
+	for (int j = 0; j < PEAK_FLOPS_CHAINS; j++) sum += acc[j];
+	out[blockIdx.x * blockDim.x + threadIdx.x] = sum;
+}
+
 
 //**-----------------GR Kernels------------------**
 
@@ -182,7 +198,7 @@ __global__ void sumGRBCOutGPU(unsigned int nRows, uint32_t *bcOut, size_t bcOutP
 }
 
 __global__ void updateGRInOPGPU(unsigned int inNLoads, uint32_t *apIn, float *dynamicSpillAmp,
-		float *g, size_t gPitch, uint32_t *conFromIn, size_t conFromInPitch, int32_t *numInPerGR,
+		uint32_t *conFromIn, size_t conFromInPitch, int32_t *numInPerGR,
 		float *gSum, float *gDirect, float *gSpillover,  float gDecayD, float gIncD, float gDecayS,
 		float gIncFracS)
 {
@@ -295,7 +311,6 @@ __global__ void updateGOGRDynamicSpillInOPGPU(unsigned int inNLoads, float *dyna
 
 
 __global__ void updateUBCGRInOPGPU(unsigned int inNLoads, uint32_t *apIn, float *depAmp,
-		float *g, size_t gPitch,
 		uint32_t *conFromIn, size_t conFromInPitch,
 		int32_t *numInPerGR, int *apUBCtoGRp, float *gSum, float *gDirect, float *gSpillover, 
 		float gDecayD, float gIncD, float gDecayS, float gIncFracS)
@@ -343,7 +358,7 @@ __global__ void updateUBCGRInOPGPU(unsigned int inNLoads, uint32_t *apIn, float
 
 
 __global__ void updateMFGRInOPGPU(unsigned int inNLoads, uint32_t *apIn, float*depAmp,
-		float *g, size_t gPitch, uint32_t *conFromIn, size_t conFromInPitch,
+		uint32_t *conFromIn, size_t conFromInPitch,
 		int32_t *numInPerGR, int *apMFtoGR, float *gSum, float *gDirect, float *gSpillover, 
 		float gDecayD, float gIncD, float gDecayS, float gIncFracS)
 {
@@ -375,6 +390,57 @@ __global__ void updateMFGRInOPGPU(unsigned int inNLoads, uint32_t *apIn, float*d
 	apMFtoGR[index] = tempApInSum;
 }
 
+/* push delivery: one block per active input cell, whose threads stride over
+ * that cell's granule targets and count the spike into inCount. targets are
+ * global GR indices; those outside this GPU's slice are skipped */
+__global__ void scatterInGRGPU(uint32_t *activeIn, uint32_t *conInToGR,
+		int32_t *numGRPerIn, unsigned int maxGRPerIn, unsigned int grOffset,
+		unsigned int numGR, uint32_t *inCount)
+{
+	uint32_t in = activeIn[blockIdx.x];
+	int numTargets = numGRPerIn[in];
+	uint32_t *conRow = conInToGR + in * maxGRPerIn;
+
+	for (int i = threadIdx.x; i < numTargets; i += blockDim.x)
+	{
+		unsigned int grIndex = conRow[i] - grOffset;
+		if (grIndex < numGR) atomicAdd(&inCount[grIndex], 1u);
+	}
+}
+
+/* push delivery epilogues: identical updates to updateGRInOPGPU and
+ * updateMFGRInOPGPU, with the summed input read from (and reset in) the
+ * counts left by scatterInGRGPU instead of gathered */
+__global__ void updateGRInPushGPU(uint32_t *inCount, float *dynamicSpillAmp,
+		float *gSum, float *gDirect, float *gSpillover, float gDecayD, float gIncD)
+{
+	int index = blockIdx.x * blockDim.x + threadIdx.x;
+
+	int tempApInSum = inCount[index];
+	inCount[index] = 0;
+
+	gDirect[index] = gDirect[index] * gDecayD + gIncD * tempApInSum;
+	gSpillover[index] = gSpillover[index] * 0.99 + dynamicSpillAmp[index] * tempApInSum;
+
+	gSum[index] = gDirect[index] + gSpillover[index]; 
+}
+
+__global__ void updateMFGRInPushGPU(uint32_t *inCount, float *depAmp, int *apMFtoGR,
+		float *gSum, float *gDirect, float *gSpillover,
+		float gDecayD, float gIncD, float gDecayS, float gIncFracS)
+{
+	int index = blockIdx.x * blockDim.x + threadIdx.x;
+
+	int tempApInSum = inCount[index];
+	inCount[index] = 0;
+
+	gDirect[index] = gDirect[index] * gDecayD + gIncD * tempApInSum * depAmp[index];
+	gSpillover[index] = gSpillover[index] * gDecayS + gIncD * gIncFracS * tempApInSum * depAmp[index];
+
+	gSum[index] = gDirect[index] + gSpillover[index];
+	apMFtoGR[index] = tempApInSum;
+}
+
 __global__ void updateGRHistory(uint32_t *apBuf, uint64_t *apHist, uint32_t bufTestMask)
 {
 	int i=blockIdx.x*blockDim.x+threadIdx.x;
@@ -382,7 +448,33 @@ __global__ void updateGRHistory(uint32_t *apBuf, uint64_t *apHist, uint32_t bufT
 	apHist[i]=tempHist|((apBuf[i]&bufTestMask)>0)*0x00000001; 
 }
 
-__global__ void updatePFBCSCOutGPU(uint32_t *apBuf, uint32_t *delay,
+__global__ void decaySpatialActGPU(float *spatialAct, unsigned int numBins, float decay)
+{
+	int i=blockIdx.x*blockDim.x+threadIdx.x;
+	if (i < numBins) spatialAct[i] *= decay;
+}
+
+__global__ void updateGRSpatialActGPU(uint8_t *apGR, float *spatialAct, unsigned int grOffset,
+		unsigned int grX, unsigned int grY, unsigned int binsX, unsigned int binsY)
+{
+	int i=blockIdx.x*blockDim.x+threadIdx.x;
+	if (apGR[i])
+	{
+		unsigned int grInd = grOffset + i;
+		unsigned int binX  = (grInd % grX) * binsX / grX;
+		unsigned int binY  = (grInd / grX) * binsY / grY;
+		atomicAdd(&spatialAct[binY * binsX + binX], 1.0f);
+	}
+}
+
+/* whether each GR's spike from its PF delay ago arrives this step */
+__global__ void updatePFActGPU(uint32_t *apBuf, uint32_t *delay, uint8_t *pfAct)
+{
+	int index=blockIdx.x*blockDim.x+threadIdx.x;
+	pfAct[index]=(apBuf[index]&delay[index])>0;
+}
+
+__global__ void updatePFBCSCOutGPU(uint8_t *pfAct,
 		uint32_t *pfBC, size_t pfBCPitch, unsigned int numPFInPerBC, unsigned int numPFInPerBCP2,
 		uint32_t *pfSC, size_t pfSCPitch, unsigned int numPFInPerSC, unsigned int numPFInPerSCP2)
 {
@@ -391,20 +483,20 @@ __global__ void updatePFBCSCOutGPU(uint32_t *apBuf, uint32_t *delay,
 	unsigned int *pfBCRow=(uint32_t *)((char *)pfBC+(index>>numPFInPerBCP2)*pfBCPitch);
 	unsigned int *pfSCRow=(uint32_t *)((char *)pfSC+(index>>numPFInPerSCP2)*pfSCPitch);
 
-	tempOut=(apBuf[index]&delay[index])>0;
+	tempOut=pfAct[index];
 
 	pfBCRow[index&(numPFInPerBC-1)]=tempOut;
 	pfSCRow[index&(numPFInPerSC-1)]=tempOut;
 }
 
-__global__ void updatePFPCOutGPU(uint32_t *apBuf, uint32_t *delay,
+__global__ void updatePFPCOutGPU(uint8_t *pfAct,
 		float *synWeight, float *pfPC, size_t pfPCPitch, unsigned int numPFInPerPC, unsigned int numPFInPerPCP2)
 {
 	int index=blockIdx.x*blockDim.x+threadIdx.x;
 	unsigned int tempOut;
 	float *pfPCRow=(float *)((char *)pfPC+(index>>numPFInPerPCP2)*pfPCPitch);
 
-	tempOut=(apBuf[index]&delay[index])>0;
+	tempOut=pfAct[index];
 
 	pfPCRow[index&(numPFInPerPC-1)]=synWeight[index]*tempOut;
 }
@@ -424,6 +516,21 @@ __global__ void updatePFPCSynIO(float *synWPFPC, uint64_t *historyGR, uint64_t p
 	synWPFPC[i]=(synWPFPC[i]>1)+(synWPFPC[i]<=1)*synWPFPC[i];
 }
 
+/* one bit per GR, set if the GR spiked in the checked history bin. a warp
+ * packs its 32 GRs into one word */
+__global__ void packHistoryBinGR(uint64_t *historyGR, uint32_t *packedGR, uint64_t plastCheckMask)
+{
+	int i=blockIdx.x*blockDim.x+threadIdx.x;
+	uint32_t bits=__ballot_sync(0xffffffff, (historyGR[i]&plastCheckMask)>0);
+	if ((threadIdx.x&31)==0) packedGR[i>>5]=bits;
+}
+
+__global__ void expandPFPCBinarySyn(uint32_t *effBits, float *synWPFPC, float wWeak, float wStrong)
+{
+	int i=blockIdx.x*blockDim.x+threadIdx.x;
+	synWPFPC[i]=((effBits[i>>5]>>(i&31))&1) ? wStrong : wWeak;
+}
+
 //**---------------end IO kernels-------------**
 
 
@@ -531,6 +638,12 @@ void callTestKernel(cudaStream_t &st, float *a, float *b, float *c)
 	testKernel<<<1, 128>>>(a, b, c);
 }
 
+void callPeakFlopsKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numThreads,
+		float *outGPU, unsigned int iters)
+{
+	peakFlopsKernel<<<numBlocks, numThreads, 0, st>>>(outGPU, iters);
+}
+
 void callGRActKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
 		float *vGPU, float *gKCaGPU, float *gLeakGPU, float *gNMDAGRGPU, float *gNMDAIncGRGPU,
 		float *threshGPU, uint32_t *apBufGPU, uint8_t *apOutGRGPU, uint32_t *apGRGPU,
@@ -597,14 +710,14 @@ void callSumGRBCOutKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int
 }
 
 void callUpdateInGROPKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
-		unsigned int numInCells, uint32_t *apInGPU, float *dynamicAmpGPU, float *gGPU, size_t gGPUP,
+		unsigned int numInCells, uint32_t *apInGPU, float *dynamicAmpGPU,
 		uint32_t *conInGRGPU, size_t conInGRGPUP,
 		int32_t *numInPerGRGPU, float *gSumGPU, float *gDirectGPU, float *gSpilloverGPU, 
 		float gDecayD, float gIncD, float gDecayS, float gIncFracS)
 {
 	updateGRInOPGPU<<<numBlocks, numGRPerBlock, numInCells*sizeof(uint32_t), st>>>
 			(numInCells/numGRPerBlock, apInGPU, dynamicAmpGPU, 
-			gGPU, gGPUP, conInGRGPU, conInGRGPUP, numInPerGRGPU,
+			conInGRGPU, conInGRGPUP, numInPerGRGPU,
 			gSumGPU, gDirectGPU, gSpilloverGPU, 
 			gDecayD, gIncD, gDecayS, gIncFracS);
 }
@@ -635,45 +748,77 @@ void callUpdateGOInGRDynamicSpillOPKernel(cudaStream_t &st, unsigned int numBloc
 }
 
 void callUpdateUBCInGROPKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
-		unsigned int numInCells, uint32_t *apInGPU, float *depAmpGPU, float *gGPU, size_t gGPUP,
+		unsigned int numInCells, uint32_t *apInGPU, float *depAmpGPU,
 		uint32_t *conInGRGPU, size_t conInGRGPUP,
 		int32_t *numInPerGRGPU, int *apUBCtoGRGPU, float *gSumGPU, float *gDirectGPU, float *gSpilloverGPU,  
 		float gDecayDirect, float gIncDirect, float gDecaySpill, float gIncFracSpill)
 {
 	updateUBCGRInOPGPU<<<numBlocks, numGRPerBlock, numInCells*sizeof(uint32_t), st>>>
-			(numInCells/numGRPerBlock, apInGPU, depAmpGPU,  gGPU, gGPUP, conInGRGPU, conInGRGPUP, numInPerGRGPU,
+			(numInCells/numGRPerBlock, apInGPU, depAmpGPU, conInGRGPU, conInGRGPUP, numInPerGRGPU,
 			apUBCtoGRGPU, gSumGPU, gDirectGPU, gSpilloverGPU, 
 			gDecayDirect, gIncDirect, gDecaySpill, gIncFracSpill);
 }
 
 void callUpdateMFInGROPKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
-		unsigned int numInCells, uint32_t *apInGPU, float *depAmp, float *gGPU, size_t gGPUP,
+		unsigned int numInCells, uint32_t *apInGPU, float *depAmp,
 		uint32_t *conInGRGPU, size_t conInGRGPUP,
 		int32_t *numInPerGRGPU, int *apMFtoGRGPU, float *gSumGPU, float *gDirectGPU, float *gSpilloverGPU,  
 		float gDecayDirect, float gIncDirect, float gDecaySpill, float gIncFracSpill)
 {
 	updateMFGRInOPGPU<<<numBlocks, numGRPerBlock, numInCells*sizeof(uint32_t), st>>>
-			(numInCells/numGRPerBlock, apInGPU, depAmp, gGPU, gGPUP, conInGRGPU, conInGRGPUP, numInPerGRGPU,
+			(numInCells/numGRPerBlock, apInGPU, depAmp, conInGRGPU, conInGRGPUP, numInPerGRGPU,
 			apMFtoGRGPU, gSumGPU, gDirectGPU, gSpilloverGPU, 
 			gDecayDirect, gIncDirect, gDecaySpill, gIncFracSpill);
 }
 
+void callScatterInGRKernel(cudaStream_t &st, unsigned int numActive, unsigned int numThreadsPerIn,
+		uint32_t *activeInGPU, uint32_t *conInToGRGPU, int32_t *numGRPerInGPU,
+		unsigned int maxGRPerIn, unsigned int grOffset, unsigned int numGR, uint32_t *inCountGPU)
+{
+	if (numActive == 0) return;
+	scatterInGRGPU<<<numActive, numThreadsPerIn, 0, st>>>(activeInGPU, conInToGRGPU,
+			numGRPerInGPU, maxGRPerIn, grOffset, numGR, inCountGPU);
+}
+
+void callUpdateInGRPushKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
+		uint32_t *inCountGPU, float *dynamicAmpGPU, float *gSumGPU, float *gDirectGPU,
+		float *gSpilloverGPU, float gDecayD, float gIncD)
+{
+	updateGRInPushGPU<<<numBlocks, numGRPerBlock, 0, st>>>(inCountGPU, dynamicAmpGPU,
+			gSumGPU, gDirectGPU, gSpilloverGPU, gDecayD, gIncD);
+}
+
+void callUpdateMFInGRPushKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
+		uint32_t *inCountGPU, float *depAmp, int *apMFtoGRGPU, float *gSumGPU, float *gDirectGPU,
+		float *gSpilloverGPU, float gDecayDirect, float gIncDirect, float gDecaySpill, float gIncFracSpill)
+{
+	updateMFGRInPushGPU<<<numBlocks, numGRPerBlock, 0, st>>>(inCountGPU, depAmp, apMFtoGRGPU,
+			gSumGPU, gDirectGPU, gSpilloverGPU,
+			gDecayDirect, gIncDirect, gDecaySpill, gIncFracSpill);
+}
+
+
+void callUpdatePFActKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
+		uint32_t *apBufGPU, uint32_t *delayMaskGPU, uint8_t *pfActGPU)
+{
+	updatePFActGPU<<<numBlocks, numGRPerBlock, 0, st>>>(apBufGPU, delayMaskGPU, pfActGPU);
+}
 
 void callUpdatePFBCSCOutKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
-		uint32_t *apBufGPU, uint32_t *delayMaskGPU,
+		uint8_t *pfActGPU,
 		uint32_t *inPFBCGPU, size_t inPFBCGPUPitch, unsigned int numPFInPerBCP2,
 		uint32_t *inPFSCGPU, size_t inPFSCGPUPitch, unsigned int numPFInPerSCP2)
 {
-	updatePFBCSCOutGPU<<<numBlocks, numGRPerBlock, 0, st>>>(apBufGPU, delayMaskGPU,
+	updatePFBCSCOutGPU<<<numBlocks, numGRPerBlock, 0, st>>>(pfActGPU,
 			inPFBCGPU, inPFBCGPUPitch, 1<<numPFInPerBCP2, numPFInPerBCP2,
 			inPFSCGPU, inPFSCGPUPitch, 1<<numPFInPerSCP2, numPFInPerSCP2);
 }
 
 void callUpdatePFPCOutKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
-		uint32_t *apBufGPU, uint32_t *delayMaskGPU,
+		uint8_t *pfActGPU,
 		float *pfPCSynWGPU, float *inPFPCGPU, size_t inPFPCGPUPitch, unsigned int numPFInPerPCP2)
 {
-	updatePFPCOutGPU<<<numBlocks, numGRPerBlock, 0, st>>>(apBufGPU, delayMaskGPU, pfPCSynWGPU,
+	updatePFPCOutGPU<<<numBlocks, numGRPerBlock, 0, st>>>(pfActGPU, pfPCSynWGPU,
 			inPFPCGPU, inPFPCGPUPitch, 1<<numPFInPerPCP2, numPFInPerPCP2);
 }
 
@@ -703,6 +848,16 @@ void callUpdateGRHistKernel(cudaStream_t &st, unsigned int numBlocks, unsigned i
 		updateGRHistory<<<numBlocks, numGRPerBlock, 0, st>>>(apBufGPU, historyGPU, apBufGRHistMask);
 }
 
+void callUpdateGRSpatialActKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
+		uint8_t *apGRGPU, float *spatialActGPU, unsigned int grOffset, unsigned int grX, unsigned int grY,
+		unsigned int binsX, unsigned int binsY, float decay)
+{
+	unsigned int numBins = binsX * binsY;
+	decaySpatialActGPU<<<(numBins + 255) / 256, 256, 0, st>>>(spatialActGPU, numBins, decay);
+	updateGRSpatialActGPU<<<numBlocks, numGRPerBlock, 0, st>>>(apGRGPU, spatialActGPU, grOffset,
+			grX, grY, binsX, binsY);
+}
+
 void callUpdatePFPCPlasticityIOKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
 		float *synWeightGPU, uint64_t *historyGPU, unsigned int pastBinNToCheck,
 		int offSet, float pfPCPlastStep)
@@ -712,6 +867,19 @@ void callUpdatePFPCPlasticityIOKernel(cudaStream_t &st, unsigned int numBlocks,
 				mask, offSet, pfPCPlastStep);
 }
 
+void callPackHistoryBinKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
+		uint64_t *historyGPU, uint32_t *packedGPU, unsigned int pastBinNToCheck)
+{
+	uint64_t mask = ((uint64_t)1)<<(pastBinNToCheck-1);
+	packHistoryBinGR<<<numBlocks, numGRPerBlock, 0, st>>>(historyGPU, packedGPU, mask);
+}
+
+void callExpandPFPCBinarySynKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
+		uint32_t *effBitsGPU, float *synWeightGPU, float wWeak, float wStrong)
+{
+	expandPFPCBinarySyn<<<numBlocks, numGRPerBlock, 0, st>>>(effBitsGPU, synWeightGPU, wWeak, wStrong);
+}
+
 //**---------------end kernel calls------------**
 
 // template initializations
@@ -16,6 +16,12 @@
 
 void callTestKernel(cudaStream_t &st, float *a, float *b, float *c);
 
+#define PEAK_FLOPS_CHAINS 8
+
+/* FMA throughput probe for the roofline report. outGPU holds numBlocks * numThreads floats */
+void callPeakFlopsKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numThreads,
+		float *outGPU, unsigned int iters);
+
 void callGRActKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
 		float *vGPU, float *gKCaGPU, float *gLeakGRPGU, float *gNMDAGRGPU, float*gNMDAIncGRGPU,
 		float *threshGPU, uint32_t *apBufGPU, uint8_t *apOutGRGPU, uint32_t *apGRGPU,
@@ -60,38 +66,71 @@ void callUpdateGOInGRDynamicSpillOPKernel(cudaStream_t &st, unsigned int numBloc
 		int32_t *numInPerGRGPU, float *dynamicAmpGOGRGPU);
 
 void callUpdateInGROPKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
-		unsigned int numInCells, uint32_t *apInGPU, float *dynamicAmpGPU, float *gGPU, size_t gGPUP,
+		unsigned int numInCells, uint32_t *apInGPU, float *dynamicAmpGPU,
 		uint32_t *conInGRGPU, size_t conInGRGPUP,
 		int32_t *numInPerGRGPU, float *gSumGPU, float *gDirectGPU, float *gSpilloverGPU, 
 		float gDecayD, float gIncD, float gDecayS, float gIncFracS);
 
 void callUpdateUBCInGROPKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
-		unsigned int numInCells, uint32_t *apInGPU, float *depAmpGPU, float *gGPU, size_t gGPUP,
+		unsigned int numInCells, uint32_t *apInGPU, float *depAmpGPU,
 		uint32_t *conInGRGPU, size_t conInGRGPUP,
 		int32_t *numInPerGRGPU, int *apUBCtoGRGPU, float *gSumGPU, float *gDirectGPU, float *gSpilloverGPU,
 		float gDecayDirect, float gIncDirect, float gDecaySpill, float gIncFracSpill);
 
 void callUpdateMFInGROPKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
-		unsigned int numInCells, uint32_t *apInGPU, float *depAmp, float *gGPU, size_t gGPUP,
+		unsigned int numInCells, uint32_t *apInGPU, float *depAmp,
 		uint32_t *conInGRGPU, size_t conInGRGPUP,
 		int32_t *numInPerGRGPU, int *apMFtoGRGPU, float *gSumGPU, float *gDirectGPU, float *gSpilloverGPU,
 		float gDecayDirect, float gIncDirect, float gDecaySpill, float gIncFracSpill);
 
+/* push delivery of MF and GO input to GR: the scatter kernel counts the spikes
+ * of the numActive cells listed in activeInGPU into inCountGPU, then the push
+ * kernels apply the same conductance updates as their gather (OP) counterparts
+ * from those counts and zero them for the next step */
+void callScatterInGRKernel(cudaStream_t &st, unsigned int numActive, unsigned int numThreadsPerIn,
+		uint32_t *activeInGPU, uint32_t *conInToGRGPU, int32_t *numGRPerInGPU,
+		unsigned int maxGRPerIn, unsigned int grOffset, unsigned int numGR, uint32_t *inCountGPU);
+
+void callUpdateInGRPushKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
+		uint32_t *inCountGPU, float *dynamicAmpGPU, float *gSumGPU, float *gDirectGPU,
+		float *gSpilloverGPU, float gDecayD, float gIncD);
+
+void callUpdateMFInGRPushKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
+		uint32_t *inCountGPU, float *depAmp, int *apMFtoGRGPU, float *gSumGPU, float *gDirectGPU,
+		float *gSpilloverGPU, float gDecayDirect, float gIncDirect, float gDecaySpill, float gIncFracSpill);
+
+void callUpdatePFActKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
+		uint32_t *apBufGPU, uint32_t *delayMaskGPU, uint8_t *pfActGPU);
+
 void callUpdatePFBCSCOutKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
-		uint32_t *apBufGPU, uint32_t *delayMaskGPU,
+		uint8_t *pfActGPU,
 		uint32_t *inPFBCGPU, size_t inPFBCGPUPitch, unsigned int numPFInPerBCP2,
 		uint32_t *inPFSCGPU, size_t inPFSCGPUPitch, unsigned int numPFInPerSCP2);
 
 void callUpdatePFPCOutKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
-		uint32_t *apBufGPU, uint32_t *delayMaskGPU,
+		uint8_t *pfActGPU,
 		float *pfPCSynWGPU, float *inPFPCGPU, size_t inPFPCGPUPitch, unsigned int numPFInPerPCP2);
 
 void callUpdateGRHistKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
 		uint32_t *apBufGPU, uint64_t *historyGPU, uint32_t apBufGRHistMask);
 
+/* decays the binned GR activity map by decay, then adds this step's spikes to it */
+void callUpdateGRSpatialActKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
+		uint8_t *apGRGPU, float *spatialActGPU, unsigned int grOffset, unsigned int grX, unsigned int grY,
+		unsigned int binsX, unsigned int binsY, float decay);
+
 void callUpdatePFPCPlasticityIOKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
 		float *synWeightGPU, uint64_t *historyGPU, unsigned int pastBinNToCheck,
 		int offSet, float pfPCPlastStep);
 
+/* bit-packs the checked history bin of every GR, 32 GRs per word. numGRPerBlock
+ * must be a multiple of 32 */
+void callPackHistoryBinKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
+		uint64_t *historyGPU, uint32_t *packedGPU, unsigned int pastBinNToCheck);
+
+/* PF-PC weights from bit-packed efficacies: wStrong where the bit is set, wWeak elsewhere */
+void callExpandPFPCBinarySynKernel(cudaStream_t &st, unsigned int numBlocks, unsigned int numGRPerBlock,
+		uint32_t *effBitsGPU, float *synWeightGPU, float wWeak, float wStrong);
+
 #endif /* KERNELS_H_ */
 
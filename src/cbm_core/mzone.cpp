@@ -8,20 +8,25 @@
 #include <math.h>
 #include <iostream>
 #include <fstream>
+#include <climits>
 
 #include "connectivityparams.h"
 #include "activityparams.h"
 #include "dynamic2darray.h"
 #include "sfmt.h"
 #include "file_utility.h"
+#include "parallel_init.h"
+#include "cell_model.h"
+#include "tracepoints.h"
 #include "mzone.h"
 
 MZone::MZone() {}
 
-MZone::MZone(MZoneConnectivityState *cs, MZoneActivityState *as, int randSeed, uint32_t **apBufGRGPU,
-			 uint64_t **histGRGPU, int gpuIndStart, int numGPUs)
+MZone::MZone(const sim_params &params, MZoneConnectivityState *cs, MZoneActivityState *as, int randSeed,
+			 uint8_t **pfActGRGPU, uint64_t **histGRGPU, int gpuIndStart, int numGPUs) : sim_params(params)
 {
-	randGen = new CRandomSFMT0(randSeed);
+	randGen    = new CRandomSFMT0(randSeed);
+	ioNoiseGen = new CRandomSFMT0(randGen->IRandom(0, INT_MAX));
 
 	// shallow copies. caller owns the data.
 	this->cs = cs; 
@@ -32,16 +37,16 @@ MZone::MZone(MZoneConnectivityState *cs, MZoneActivityState *as, int randSeed, u
 	// innet and mzone (so within cbmsimcore) and fed in as const args to the respective
 	// functions that call update kernels (06/16/2022)
 
-	this->apBufGRGPU     = apBufGRGPU;
+	this->pfActGRGPU     = pfActGRGPU;
 	this->histGRGPU      = histGRGPU;
 
-	delayMaskGRGPU = new uint32_t*[numGPUs];
-
 	pfSynWeightPCLinear = new float[num_gr];
 	pfPCPlastStepIO     = new float[num_io];
+	gNCSumIO            = new float[num_io];
+	gMFSumNC            = new float[num_nc];
+	gPCSumNC            = new float[num_nc];
 
-	tempGRPCLTDStep = synLTDStepSizeGRtoPC;
-	tempGRPCLTPStep = synLTPStepSizeGRtoPC;
+	resetGRPCPlastSteps();
 
 	this->numGPUs     = numGPUs;
 	this->gpuIndStart = gpuIndStart;
@@ -55,9 +60,13 @@ MZone::~MZone()
 	std::cout << "[INFO]: Deleting mzone gpu arrays..." << std::endl;
 
 	delete randGen;
+	delete ioNoiseGen;
 
 	delete[] pfSynWeightPCLinear;
 	delete[] pfPCPlastStepIO;
+	delete[] gNCSumIO;
+	delete[] gMFSumNC;
+	delete[] gPCSumNC;
 
 	//free cuda host memory
 	cudaSetDevice(0 + gpuIndStart);
@@ -68,14 +77,12 @@ MZone::~MZone()
 	{
 		cudaSetDevice(i + gpuIndStart);
 		//free cuda device memory
-		cudaFree(delayMaskGRGPU[i]);
 		cudaFree(pfSynWeightPCGPU[i]);
 		cudaFree(inputPFPCGPU[i]);
 		cudaFree(inputSumPFPCMZGPU[i]);
 		cudaDeviceSynchronize();
 	}
 
-	delete[] delayMaskGRGPU;
 	delete[] pfSynWeightPCGPU;
 	delete[] inputPFPCGPU;
 	delete[] inputPFPCGPUPitch;
@@ -120,6 +127,23 @@ MZone::~MZone()
 	delete[] inputPFBCGPUP;
 	delete[] inputSumPFBCGPU;
 
+	//discrete pfpc synapses
+	cudaSetDevice(gpuIndStart);
+	cudaFreeHost(pfPCEffBits);
+	cudaFreeHost(grEligBits);
+	delete[] pfPCLvlLoBits;
+	delete[] pfPCLvlHiBits;
+
+	for (int i = 0; i < numGPUs; i++)
+	{
+		cudaSetDevice(i + gpuIndStart);
+		cudaFree(pfPCEffBitsGPU[i]);
+		cudaFree(grEligBitsGPU[i]);
+	}
+
+	delete[] pfPCEffBitsGPU;
+	delete[] grEligBitsGPU;
+
 	std::cout << "[INFO]: Finished deleting mzone gpu arrays." << std::endl;
 }
 
@@ -161,14 +185,8 @@ void MZone::initCUDA()
 
 	
 
-	for (int i = 0; i < num_pc; i++)
-	{
-		for (int j = 0; j < num_p_pc_from_gr_to_pc; j++)
-		{
-			// TODO: get rid of pfSynWeightLinear and use our linearized version directly
-			pfSynWeightPCLinear[i * num_p_pc_from_gr_to_pc + j] = as->pfSynWeightPC[i * num_p_pc_from_gr_to_pc + j];
-		}
-	}
+	// TODO: get rid of pfSynWeightLinear and use our linearized version directly
+	parallel_copy(pfSynWeightPCLinear, as->pfSynWeightPC.get(), num_pc * num_p_pc_from_gr_to_pc);
 
 	pfSynWeightPCGPU = new float*[numGPUs];
 	inputPFPCGPU = new float*[numGPUs];
@@ -178,15 +196,8 @@ void MZone::initCUDA()
 	for (int i = 0; i < numGPUs; i++)
 	{
 		int cpyStartInd = i * numGRPerGPU;
-		int cpySize     = numGRPerGPU;
 		cudaSetDevice(i + gpuIndStart);
 
-		// conduction delay variables
-		cudaMalloc((void **)&delayMaskGRGPU[i], numGRPerGPU * sizeof(uint32_t));
-		// TODO: put the delay mask info into mzoneconnectivitystate
-		cudaMemcpy(delayMaskGRGPU[i], &(cs->pGRDelayMaskfromGRtoBSP[cpyStartInd]),
-			cpySize * sizeof(uint32_t), cudaMemcpyHostToDevice);
-
 		//allocate device cuda memory
 		cudaMalloc((void **)&pfSynWeightPCGPU[i], numGRPerGPU * sizeof(float));
 		cudaMallocPitch((void **)&inputPFPCGPU[i], (size_t *)&inputPFPCGPUPitch[i],
@@ -213,6 +224,7 @@ void MZone::initCUDA()
 	initSCCUDA();
 	std::cerr << "[INFO]: Initialized SC CUDA - Last error: "
 	    	  << cudaGetErrorString(cudaGetLastError()) << std::endl;
+	initPFPCDiscreteCUDA();
 	
 	testReduction();
 	std::cout << "Finished Test." << std::endl;
@@ -305,6 +317,41 @@ void MZone::initSCCUDA()
 	std::cout << "[INFO]: Finished initializing SC cuda variables..." << std::endl;
 }
 
+void MZone::initPFPCDiscreteCUDA()
+{
+	size_t numWords = discrete_syn_words(num_gr);
+
+	/* the state itself is filled in on first use, see runPFPCDiscretePlast */
+	cudaSetDevice(gpuIndStart);
+	cudaHostAlloc((void **)&pfPCEffBits, numWords * sizeof(uint64_t), cudaHostAllocPortable);
+	cudaHostAlloc((void **)&grEligBits, numWords * sizeof(uint64_t), cudaHostAllocPortable);
+	pfPCLvlLoBits = new uint64_t[numWords];
+	pfPCLvlHiBits = new uint64_t[numWords];
+
+	pfPCEffBitsGPU = new uint32_t*[numGPUs];
+	grEligBitsGPU  = new uint32_t*[numGPUs];
+	for (int i = 0; i < numGPUs; i++)
+	{
+		cudaSetDevice(i + gpuIndStart);
+		cudaMalloc((void **)&pfPCEffBitsGPU[i], numGRPerGPU / 8);
+		cudaMalloc((void **)&grEligBitsGPU[i], numGRPerGPU / 8);
+	}
+}
+
+void MZone::retuneActParams(const act_params &tuned)
+{
+	static_cast<act_params &>(*this) = tuned;
+	resetGRPCPlastSteps();
+}
+
+bool MZone::actParamsInEffect(const act_params &tuned)
+{
+	/* act_params holds only floats, so there is no padding to compare */
+	return memcmp((const act_params *)this, &tuned, sizeof(act_params)) == 0
+		&& tempGRPCLTDStep == tuned.synLTDStepSizeGRtoPC
+		&& tempGRPCLTPStep == tuned.synLTPStepSizeGRtoPC;
+}
+
 void MZone::writeToState()
 {
 	// TODO: write everything to state...only doing weights and pfpc input sums :/
@@ -351,78 +398,49 @@ void MZone::updateTrueMFs(bool *trueMF)
 
 void MZone::calcPCActivities()
 {
-	for (int i = 0; i < num_pc; i++)
-	{
-		as->gPFPC[i] += inputSumPFPCMZH[i] * gIncGRtoPC;
-		as->gPFPC[i] *= gDecGRtoPC;
-		as->gBCPC[i] += as->inputBCPC[i] * gIncBCtoPC;
-		as->gBCPC[i] *= gDecBCtoPC;
-		as->gSCPC[i] += as->inputSCPC[i] * gIncSCtoPC;
-		as->gSCPC[i] *= gDecSCtoPC;
-
-		as->vPC[i] += (gLeakPC * (eLeakPC - as->vPC[i]))
-					- (as->gPFPC[i] * as->vPC[i])
-					+ (as->gBCPC[i] * (eBCtoPC - as->vPC[i]))
-					+ (as->gSCPC[i] * (eSCtoPC - as->vPC[i]));
-
-		as->threshPC[i] += threshDecPC * (threshRestPC - as->threshPC[i]);
-
-		as->apPC[i]    = as->vPC[i] > as->threshPC[i];
-		as->apBufPC[i] = (as->apBufPC[i] << 1) | (as->apPC[i] * 0x00000001);
-
-		as->threshPC[i] = as->apPC[i] * threshMaxPC + (!as->apPC[i]) * as->threshPC[i];
-		as->pcPopAct   += as->apPC[i];
-	}
+	lif_cells<uint32_t> pcs{as->vPC.get(), as->threshPC.get(), as->apPC.get(), as->apBufPC.get(),
+		gLeakPC, eLeakPC, threshRestPC, threshDecPC, threshMaxPC, NO_V_MAX};
+
+	as->pcPopAct += update_lif_cells<THRESH_DECAY_FIRST>(pcs, num_pc,
+		syn_channel<float, SYN_INC_DECAY>{as->gPFPC.get(), inputSumPFPCMZH,
+			gIncGRtoPC, gDecGRtoPC, 0.0f, {}},
+		syn_channel<uint32_t, SYN_INC_DECAY>{as->gBCPC.get(), as->inputBCPC.get(),
+			gIncBCtoPC, gDecBCtoPC, eBCtoPC, {}},
+		syn_channel<uint32_t, SYN_INC_DECAY>{as->gSCPC.get(), as->inputSCPC.get(),
+			gIncSCtoPC, gDecSCtoPC, eSCtoPC, {}});
 }
 
 void MZone::calcSCActivities()
 {
-	for (int i = 0; i < num_sc; i++)
-	{
-		as->gPFSC[i] = as->gPFSC[i] + inputSumPFSCH[i] * gIncGRtoSC;
-		as->gPFSC[i] = as->gPFSC[i] * gDecGRtoSC;
+	lif_cells<uint32_t> scs{as->vSC.get(), as->threshSC.get(), as->apSC.get(), as->apBufSC.get(),
+		gLeakSC, eLeakSC, threshRestSC, threshDecSC, threshMaxSC, NO_V_MAX};
 
-		as->vSC[i] = as->vSC[i] + gLeakSC * (eLeakSC - as->vSC[i]) - as->gPFSC[i] * as->vSC[i];
-
-		as->apSC[i] = (as->vSC[i] > as->threshSC[i]);
-		as->apBufSC[i] = (as->apBufSC[i] << 1) | (as->apSC[i] * 0x00000001);
-
-		as->threshSC[i] = as->threshSC[i] + threshDecSC * (threshRestSC - as->threshSC[i]);
-		as->threshSC[i] = as->apSC[i] * threshMaxSC + (!as->apSC[i]) * as->threshSC[i];
-	}
+	update_lif_cells<THRESH_TEST_FIRST>(scs, num_sc,
+		syn_channel<uint32_t, SYN_INC_DECAY>{as->gPFSC.get(), inputSumPFSCH,
+			gIncGRtoSC, gDecGRtoSC, 0.0f, {}});
 }
 
 void MZone::calcBCActivities()
 {
-	for (int i = 0; i < num_bc; i++)
-	{
-		as->gPFBC[i] = as->gPFBC[i] + inputSumPFBCH[i] * gIncGRtoBC;
-		as->gPFBC[i] = as->gPFBC[i] * gDecGRtoBC;
-		as->gPCBC[i] = as->gPCBC[i] + as->inputPCBC[i] * gIncPCtoBC;
-		as->gPCBC[i] = as->gPCBC[i] * gDecPCtoBC;
-
-		as->vBC[i] = as->vBC[i] +
-				(gLeakBC * (eLeakBC - as->vBC[i])) -
-				(as->gPFBC[i] * as->vBC[i]) +
-				(as->gPCBC[i] * (ePCtoBC - as->vBC[i]));
-
-		as->threshBC[i] = as->threshBC[i] + threshDecBC * (threshRestBC - as->threshBC[i]);
-		as->apBC[i] = as->vBC[i] > as->threshBC[i];
-		as->apBufBC[i] = (as->apBufBC[i] << 1) | (as->apBC[i] * 0x00000001);
-
-		as->threshBC[i] = as->apBC[i] * threshMaxBC + (!as->apBC[i]) * (as->threshBC[i]);
-	}
+	lif_cells<uint32_t> bcs{as->vBC.get(), as->threshBC.get(), as->apBC.get(), as->apBufBC.get(),
+		gLeakBC, eLeakBC, threshRestBC, threshDecBC, threshMaxBC, NO_V_MAX};
+
+	update_lif_cells<THRESH_DECAY_FIRST>(bcs, num_bc,
+		syn_channel<uint32_t, SYN_INC_DECAY>{as->gPFBC.get(), inputSumPFBCH,
+			gIncGRtoBC, gDecGRtoBC, 0.0f, {}},
+		syn_channel<uint32_t, SYN_INC_DECAY>{as->gPCBC.get(), as->inputPCBC.get(),
+			gIncPCtoBC, gDecPCtoBC, ePCtoBC, {}});
 }
 
 void MZone::calcIOActivities()
 {
-	clock_t t;
-	t = clock();
-	srand(t);
-	
-	float r = static_cast<float> (rand()) / static_cast<float> (RAND_MAX);
+	/* drawn from this zone's own generator: the process-wide rand is shared
+	 * with every other simulation running in this process */
+	float r = (float)ioNoiseGen->Random();
 	float gNoise = (r - 0.5) * 2.0;
 
+	/* NC-IO synapses have voltage-independent but state-dependent kinetics,
+	 * so they are stepped here and enter the cell update as one summed conductance */
 	for (int i = 0; i < num_io; i++)
 	{
 		float gNCSum;
@@ -442,79 +460,64 @@ void MZone::calcIOActivities()
 			as->inputNCIO[i * num_p_io_from_nc_to_io + j] = 0;
 		}
 
-		gNCSum = 1.5 * gNCSum / 3.1;
+		gNCSumIO[i] = 1.5 * gNCSum / 3.1;
+	}
 
-		as->vIO[i] = as->vIO[i] + gLeakIO * (eLeakIO - as->vIO[i]) +
-				gNCSum * (eNCtoIO - as->vIO[i]) + as->vCoupleIO[i] +
-				as->errDrive + gNoise;
+	lif_cells<uint8_t> ios{as->vIO.get(), as->threshIO.get(), as->apIO.get(), as->apBufIO.get(),
+		gLeakIO, eLeakIO, threshRestIO, threshDecIO, threshMaxIO, NO_V_MAX};
 
-		as->apIO[i] = as->vIO[i] > as->threshIO[i];
-		as->apBufIO[i] = (as->apBufIO[i] << 1) | (as->apIO[i] * 0x00000001);
+	update_lif_cells<THRESH_TEST_FIRST>(ios, num_io,
+		cond_channel{gNCSumIO, eNCtoIO},
+		bias_channel{as->vCoupleIO.get()},
+		bias_const{as->errDrive},
+		bias_const{gNoise});
 
-		as->threshIO[i] = threshMaxIO * as->apIO[i] +
-				(!as->apIO[i]) * (as->threshIO[i] + threshDecIO * (threshRestIO - as->threshIO[i]));
-	}
 	as->errDrive = 0;
 }
 
 void MZone::calcNCActivities()
 {
-//TODO: make function calcActivities which takes in the parameters which vary dep
-//		on the type of activity that is being calculated. Else this is redundant  
 float gDecay = exp(-1.0 / 20.0); 
 // 1) my value of gAMPAIncMFtoNC is 0.283, Joe's is 2.35.
 // std::cout << "[DEBUG]: gAMPAIncMFtoNC: " << gAMPAIncMFtoNC << "\n"; 
 
+	/* per-synapse MF and PC conductances, summed per cell. MF NMDA is left
+	 * out: it was always zero (dont use: ask Joe about) */
 	for (int i = 0; i < num_nc; i++)
 	{
-		float gMFNMDASum;
 		float gMFAMPASum;
 		float gPCNCSum;
 
-		int inputPCNCSum;
-		int inputMFNCSum;
-
-		gMFNMDASum   = 0; /* dont use: ask Joe about */
 		gMFAMPASum   = 0;
-		inputMFNCSum = 0;
 
 		for (int j = 0; j < num_p_nc_from_mf_to_nc; j++)
 		{
-			inputMFNCSum += as->inputMFNC[i * num_p_nc_from_mf_to_nc + j]; /* dont use */
-
 			as->gMFAMPANC[i * num_p_nc_from_mf_to_nc + j] = as->gMFAMPANC[i * num_p_nc_from_mf_to_nc + j]
 			   * gDecay + (gAMPAIncMFtoNC * as->inputMFNC[i * num_p_nc_from_mf_to_nc + j]
 				 * as->mfSynWeightNC[i * num_p_nc_from_mf_to_nc + j]);
 			gMFAMPASum += as->gMFAMPANC[i * num_p_nc_from_mf_to_nc + j];
 		}
 
-		gMFNMDASum = gMFNMDASum * msPerTimeStep / ((float)num_p_nc_from_mf_to_nc);
-		gMFAMPASum = gMFAMPASum * msPerTimeStep / ((float)num_p_nc_from_mf_to_nc);
-		gMFNMDASum = gMFNMDASum * -as->vNC[i] / 80.0f; 
+		gMFSumNC[i] = gMFAMPASum * msPerTimeStep / ((float)num_p_nc_from_mf_to_nc);
 		gPCNCSum = 0;
-		inputPCNCSum = 0;
 
 		for (int j = 0; j < num_p_nc_from_pc_to_nc; j++)
 		{
-			inputPCNCSum += as->inputPCNC[i * num_p_nc_from_pc_to_nc + j];
-
 			as->gPCNC[i * num_p_nc_from_pc_to_nc + j] = as->gPCNC[i * num_p_nc_from_pc_to_nc + j] * gDecPCtoNC + 
 				as->inputPCNC[i * num_p_nc_from_pc_to_nc + j] * gIncAvgPCtoNC
 				* (1 - as->gPCNC[i * num_p_nc_from_pc_to_nc + j]);
 			gPCNCSum += as->gPCNC[i * num_p_nc_from_pc_to_nc + j];
-
 		}
 
-		gPCNCSum = gPCNCSum * msPerTimeStep / ((float)num_p_nc_from_pc_to_nc);
-		as->vNC[i] = as->vNC[i] + gLeakNC * (eLeakNC - as->vNC[i])
-				   - (gMFNMDASum + gMFAMPASum) * as->vNC[i] + gPCNCSum * (ePCtoNC - as->vNC[i]);
-		
-		as->threshNC[i] = as->threshNC[i] + threshDecNC * (threshRestNC - as->threshNC[i]);
-		as->apNC[i] = as->vNC[i] > as->threshNC[i];
-		as->apBufNC[i] = (as->apBufNC[i] << 1) | (as->apNC[i] * 0x00000001);
-
-		as->threshNC[i] = as->apNC[i] * threshMaxNC + (!as->apNC[i]) * as->threshNC[i];
+		gPCSumNC[i] = gPCNCSum * msPerTimeStep / ((float)num_p_nc_from_pc_to_nc);
 	}
+
+	lif_cells<uint32_t> ncs{as->vNC.get(), as->threshNC.get(), as->apNC.get(), as->apBufNC.get(),
+		gLeakNC, eLeakNC, threshRestNC, threshDecNC, threshMaxNC, NO_V_MAX};
+
+	update_lif_cells<THRESH_DECAY_FIRST>(ncs, num_nc,
+		cond_channel{gMFSumNC, 0.0f},
+		cond_channel{gPCSumNC, ePCtoNC});
 }
 
 void MZone::updatePCOut()
@@ -721,7 +724,7 @@ void MZone::runPFPCOutCUDA(cudaStream_t **sts, int streamN)
 	{
 		cudaSetDevice(i + gpuIndStart);
 		callUpdatePFPCOutKernel(sts[i][streamN], updatePFPCNumBlocks, updatePFPCNumGRPerB,
-				apBufGRGPU[i], delayMaskGRGPU[i], pfSynWeightPCGPU[i], inputPFPCGPU[i],
+				pfActGRGPU[i], pfSynWeightPCGPU[i], inputPFPCGPU[i],
 				inputPFPCGPUPitch[i], num_p_pc_from_gr_to_pc_p2);
 	}
 }
@@ -746,6 +749,27 @@ void MZone::cpyPFPCSumCUDA(cudaStream_t **sts, int streamN)
 	}
 }
 
+void MZone::calcPFPCPlastStepIO()
+{
+	for (int i = 0; i < num_io; i++)
+	{
+		if (as->pfPCPlastTimerIO[i] < (tsLTDstartAPIO + (int)tsLTDDurationIO) &&
+				as->pfPCPlastTimerIO[i] >= tsLTDstartAPIO)
+		{
+			pfPCPlastStepIO[i] = tempGRPCLTDStep;
+		}
+		else if (as->pfPCPlastTimerIO[i] >= tsLTPstartAPIO ||
+				as->pfPCPlastTimerIO[i] < tsLTPEndAPIO)
+		{
+			pfPCPlastStepIO[i] = tempGRPCLTPStep;
+		}
+		else
+		{
+			pfPCPlastStepIO[i] = 0;
+		}
+	}
+}
+
 void MZone::runPFPCPlastCUDA(cudaStream_t **sts, int streamN, unsigned long t)
 {
 	cudaError_t error;
@@ -763,23 +787,10 @@ void MZone::runPFPCPlastCUDA(cudaStream_t **sts, int streamN, unsigned long t)
 
 		numGRPerIO = num_gr / num_io;
 
-		for (int i = 0; i < num_io; i++)
-		{
-			if (as->pfPCPlastTimerIO[i] < (tsLTDstartAPIO + (int)tsLTDDurationIO) &&
-					as->pfPCPlastTimerIO[i] >= tsLTDstartAPIO)
-			{
-				pfPCPlastStepIO[i] = tempGRPCLTDStep;
-			}
-			else if (as->pfPCPlastTimerIO[i] >= tsLTPstartAPIO ||
-					as->pfPCPlastTimerIO[i] < tsLTPEndAPIO)
-			{
-				pfPCPlastStepIO[i] = tempGRPCLTPStep;
-			}
-			else
-			{
-				pfPCPlastStepIO[i] = 0;
-			}
-		}
+		CBM_TRACE1(pfpc__plast__start, t);
+		/* the float weights are about to move off the discrete state */
+		pfPCDiscreteValid = false;
+		calcPFPCPlastStepIO();
 
 #ifdef DEBUGOUT
 		std::cout << "pfPCPlastStepiO[0]: " << pfPCPlastStepIO[0] << " as->pfPCPlastTimerIO[0: ]" <<
@@ -804,7 +815,71 @@ void MZone::runPFPCPlastCUDA(cudaStream_t **sts, int streamN, unsigned long t)
 
 			curGROffset += num_p_pc_from_gr_to_pc;
 		}
+		CBM_TRACE1(pfpc__plast__end, t);
+	}
+}
+
+void MZone::runPFPCDiscretePlast(cudaStream_t **sts, int streamN, unsigned long t, bool cascade)
+{
+	if (t % (unsigned long)tsPerHistBinGR != 0) return;
+	CBM_TRACE1(pfpc__plast__start, t);
+
+	size_t wordsPerGPU = numGRPerGPU / 64;
+	int numGRPerIO = num_gr / num_io;
+
+	if (!pfPCDiscreteValid)
+	{
+		/* each synapse starts out strong with probability equal to its weight,
+		 * which keeps the expected weight of every PC's inputs */
+		cpyPFPCSynWCUDA();
+		init_discrete_syns(pfPCEffBits, pfPCLvlLoBits, pfPCLvlHiBits,
+			pfSynWeightPCLinear, num_gr, *randGen);
+		pfPCDiscreteValid = true;
+	}
+	calcPFPCPlastStepIO();
+
+	for (int i = 0; i < numGPUs; i++)
+	{
+		cudaSetDevice(i + gpuIndStart);
+		callPackHistoryBinKernel(sts[i][streamN], updatePFPCNumBlocks, updatePFPCNumGRPerB,
+				histGRGPU[i], grEligBitsGPU[i], grPCHistCheckBinIO);
+		cudaMemcpyAsync(&grEligBits[i * wordsPerGPU], grEligBitsGPU[i], numGRPerGPU / 8,
+				cudaMemcpyDeviceToHost, sts[i][streamN]);
+	}
+	for (int i = 0; i < numGPUs; i++)
+	{
+		cudaSetDevice(i + gpuIndStart);
+		cudaStreamSynchronize(sts[i][streamN]);
+	}
+
+	/* a graded step of size s becomes a transition with probability s over the
+	 * weight range, so that the expected weight change stays the same */
+	for (int i = 0; i < num_io; i++)
+	{
+		if (pfPCPlastStepIO[i] == 0) continue;
+		uint32_t p_q = quantize_syn_prob(fabs(pfPCPlastStepIO[i]) / (PFPC_W_STRONG - PFPC_W_WEAK));
+		bool ltp = pfPCPlastStepIO[i] > 0;
+		if (cascade)
+		{
+			cascade_syn_event(pfPCEffBits, pfPCLvlLoBits, pfPCLvlHiBits, grEligBits,
+				i * numGRPerIO, (i + 1) * numGRPerIO, ltp, p_q, *randGen);
+		}
+		else
+		{
+			binary_syn_event(pfPCEffBits, grEligBits, i * numGRPerIO, (i + 1) * numGRPerIO,
+				ltp, p_q, *randGen);
+		}
+	}
+
+	for (int i = 0; i < numGPUs; i++)
+	{
+		cudaSetDevice(i + gpuIndStart);
+		cudaMemcpyAsync(pfPCEffBitsGPU[i], &pfPCEffBits[i * wordsPerGPU], numGRPerGPU / 8,
+				cudaMemcpyHostToDevice, sts[i][streamN]);
+		callExpandPFPCBinarySynKernel(sts[i][streamN], updatePFPCNumBlocks, updatePFPCNumGRPerB,
+				pfPCEffBitsGPU[i], pfSynWeightPCGPU[i], PFPC_W_WEAK, PFPC_W_STRONG);
 	}
+	CBM_TRACE1(pfpc__plast__end, t);
 }
 
 void MZone::runSumPFSCCUDA(cudaStream_t **sts, int streamN)
@@ -847,7 +922,7 @@ void MZone::runUpdatePFBCSCOutCUDA(cudaStream_t **sts, int streamN)
 	{
 		error=cudaSetDevice(i+gpuIndStart);
 		callUpdatePFBCSCOutKernel(sts[i][streamN], updatePFBCSCNumBlocks, updatePFBCSCNumGRPerB,
-				apBufGRGPU[i], delayMaskGRGPU[i],
+				pfActGRGPU[i],
 				inputPFBCGPU[i], inputPFBCGPUP[i], num_p_bc_from_gr_to_bc_p2, 
 				inputPFSCGPU[i], inputPFSCGPUP[i], num_p_sc_from_gr_to_sc_p2); 
 #ifdef DEBUGOUT
@@ -916,6 +991,7 @@ const float* MZone::exportMFDCNWeights()
 
 void MZone::load_pfpc_weights_from_file(std::fstream &in_file_buf)
 {
+	pfPCDiscreteValid = false;
 	rawBytesRW((char *)pfSynWeightPCLinear,
 				num_gr * sizeof(float),
 				true,
@@ -12,16 +12,27 @@
 #include "mzoneconnectivitystate.h"
 #include "mzoneactivitystate.h"
 #include "kernels.h"
+#include "discrete_syn.h"
 
-class MZone
+/* the two weights of a binary or cascade PF-PC synapse: the bounds graded
+ * weights are clamped to */
+#define PFPC_W_WEAK   0.0f
+#define PFPC_W_STRONG 1.0f
+
+class MZone : protected sim_params
 {
 public:
 	MZone();
-	MZone(MZoneConnectivityState *cs, MZoneActivityState *as, int randSeed, uint32_t **apBufGRGPU,
-			uint64_t **histGRGPU, int gpuIndStart, int numGPUs);
+	MZone(const sim_params &params, MZoneConnectivityState *cs, MZoneActivityState *as, int randSeed,
+			uint8_t **pfActGRGPU, uint64_t **histGRGPU, int gpuIndStart, int numGPUs);
 	~MZone();
 
 	void writeToState();
+	/* also recomputes the members derived from act params, which resets the
+	 * PF-PC plasticity steps to the tuned ones */
+	void retuneActParams(const act_params &tuned);
+	/* whether this zone runs on tuned, derived members included */
+	bool actParamsInEffect(const act_params &tuned);
 	void cpyPFPCSynWCUDA();
 
 	void setErrDrive(float errDriveRelative);
@@ -46,6 +57,11 @@ public:
 	void runPFPCSumCUDA(cudaStream_t **sts, int streamN);
 	void cpyPFPCSumCUDA(cudaStream_t **sts, int streamN);
 	void runPFPCPlastCUDA(cudaStream_t **sts, int streamN, unsigned long t);
+	/* binary (cascade == false) or cascade PF-PC plasticity, on the host, on
+	 * bit-packed synapse state (see discrete_syn.h). the state is derived from
+	 * the float weights on first use, and again after anything else has changed
+	 * them; cascade levels are not saved with the weights and start over at 0 */
+	void runPFPCDiscretePlast(cudaStream_t **sts, int streamN, unsigned long t, bool cascade);
 
 	void runSumPFSCCUDA(cudaStream_t **sts, int streamN);
 	void cpyPFSCSumGPUtoHostCUDA(cudaStream_t **sts, int streamN);
@@ -86,6 +102,8 @@ private:
 	MZoneActivityState *as;
 
 	CRandomSFMT0 *randGen;
+	/* draws the IO noise, one per step */
+	CRandomSFMT0 *ioNoiseGen;
 
 	int gpuIndStart;
 	int numGPUs;
@@ -144,16 +162,32 @@ private:
 	float **inputSumPFPCMZGPU;
 	float *inputSumPFPCMZH;
 
-	uint32_t **apBufGRGPU;
-	uint32_t **delayMaskGRGPU;
+	uint8_t **pfActGRGPU; /* delayed PF activity, shared by all zones (CBMSimCore) */
 	uint64_t **histGRGPU;
 
+	//discrete PF-PC synapse variables
+	bool pfPCDiscreteValid = false;
+	uint64_t *pfPCEffBits;   /* pinned */
+	uint64_t *pfPCLvlLoBits;
+	uint64_t *pfPCLvlHiBits;
+	uint64_t *grEligBits;    /* pinned, GRs that spiked in the checked history bin */
+	uint32_t **pfPCEffBitsGPU;
+	uint32_t **grEligBitsGPU;
+
 	//IO cell variables
 	float *pfPCPlastStepIO;
-	float tempGRPCLTDStep;
-	float tempGRPCLTPStep;
+	float *gNCSumIO; /* per-synapse conductances summed per cell, each step */
+
+	//nucleus cell variables
+	float *gMFSumNC;
+	float *gPCSumNC;
+	float tempGRPCLTDStep; /* synLTDStepSizeGRtoPC unless set otherwise */
+	float tempGRPCLTPStep; /* synLTPStepSizeGRtoPC unless set otherwise */
+
+	void calcPFPCPlastStepIO();
 
 	void initCUDA();
+	void initPFPCDiscreteCUDA();
 	void initBCCUDA();
 	void initSCCUDA();
 	void testReduction();
@@ -10,179 +10,17 @@
 #include <assert.h>
 
 #include "file_utility.h"
-#include "connectivityparams.h"
-#include "activityparams.h"
+#include "simparams.h"
 
-bool act_params_populated = false;
-
-float coupleRiRjRatioGO          = 0.0; 
-float coupleRiRjRatioIO          = 0.0;
-float eBCtoPC                    = 0.0;
-float eGABAGO                    = 0.0;
-float eGOGR                      = 0.0;
-float eMFGR                      = 0.0;
-float eMGluRGO                   = 0.0;
-float eNCtoIO                    = 0.0;
-float ePCtoBC                    = 0.0;
-float ePCtoNC                    = 0.0;
-float eSCtoPC                    = 0.0;
-float gDecTauBCtoPC              = 0.0;
-float gIncBCtoPC                 = 0.0;
-float gGABADecTauGOtoGO          = 0.0;
-float gIncDirectGOtoGR           = 0.0;
-float gDirectTauGOtoGR           = 0.0;
-float gIncFracSpilloverGOtoGR    = 0.0; 
-float gSpilloverTauGOtoGR        = 0.0;
-float gGABAIncGOtoGO             = 0.0;
-float gDecTauGRtoGO              = 0.0;
-float gIncGRtoGO                 = 0.0;
-float gDecTauMFtoGO              = 0.0;
-float gIncMFtoGO                 = 0.0;
-float gConstGO                   = 0.0;
-float NMDA_AMPAratioMFGO         = 0.0;
-float gDecTauMFtoGONMDA          = 0.0;
-float gIncDirectMFtoGR           = 0.0;
-float gDirectTauMFtoGR           = 0.0;
-float gIncFracSpilloverMFtoGR    = 0.0; 
-float gSpilloverTauMFtoGR        = 0.0;
-float recoveryTauMF              = 0.0;
-float fracDepMF                  = 0.0;
-float recoveryTauGO              = 0.0;
-float fracDepGO                  = 0.0;
-float gIncMFtoUBC                = 0.0;
-float gIncGOtoUBC                = 0.0;
-float gIncUBCtoUBC               = 0.0;
-float gIncUBCtoGO                = 0.0;
-float gIncUBCtoGR                = 0.0;
-float gKIncUBC                   = 0.0;
-float gKTauUBC                   = 0.0;
-float gConstUBC                  = 0.0;
-float threshTauUBC               = 0.0;
-float gMGluRDecGRtoGO            = 0.0;
-float gMGluRIncDecayGO           = 0.0;
-float gMGluRIncScaleGO           = 0.0;
-float gMGluRScaleGRtoGO          = 0.0;
-float gDecT0ofNCtoIO             = 0.0;
-float gDecTSofNCtoIO             = 0.0;
-float gDecTTofNCtoIO             = 0.0;
-float gIncNCtoIO                 = 0.0;
-float gIncTauNCtoIO              = 0.0;
-float gDecTauPCtoBC              = 0.0;
-float gDecTauPCtoNC              = 0.0;
-float gIncAvgPCtoNC              = 0.0;
-float gDecTauGRtoBC              = 0.0;
-float gDecTauGRtoPC              = 0.0;
-float gDecTauGRtoSC              = 0.0;
-float gIncGRtoPC                 = 0.0;
-float gDecTauSCtoPC              = 0.0;
-float gIncSCtoPC                 = 0.0;
-float gluDecayGO                 = 0.0;
-float gluScaleGO                 = 0.0;
-float goGABAGOGOSynDepF          = 0.0;
-float goGABAGOGOSynRecTau        = 0.0;
-float synLTDStepSizeGRtoPC       = 0.0; 
-float synLTPStepSizeGRtoPC       = 0.0; 
-float mGluRDecayGO               = 0.0;
-float mGluRScaleGO               = 0.0;
-float maxExtIncVIO               = 0.0;
-float gmaxAMPADecTauMFtoNC       = 0.0; 
-float synLTDStepSizeMFtoNC       = 0.0; 
-float synLTDPCPopActThreshMFtoNC = 0.0; 
-float synLTPStepSizeMFtoNC       = 0.0; 
-float synLTPPCPopActThreshMFtoNC = 0.0; 
-float gmaxNMDADecTauMFtoNC       = 0.0; 
-float msLTDDurationIO            = 0.0;
-float msLTDStartAPIO             = 0.0;
-float msLTPEndAPIO               = 0.0;
-float msLTPStartAPIO             = 0.0;
-float msPerHistBinGR             = 0.0;
-float msPerHistBinMF             = 0.0;
-float relPDecT0ofNCtoIO          = 0.0;
-float relPDecTSofNCtoIO          = 0.0; 
-float relPDecTTofNCtoIO          = 0.0; 
-float relPIncNCtoIO              = 0.0;
-float relPIncTauNCtoIO           = 0.0; 
-float gIncPCtoBC                 = 0.0;
-float gIncGRtoBC                 = 0.0;
-float gIncGRtoSC                 = 0.0;
-float rawGLeakBC                 = 0.0;
-float rawGLeakGO                 = 0.0;
-float rawGLeakGR                 = 0.0;
-float rawGLeakIO                 = 0.0;
-float rawGLeakNC                 = 0.0;
-float rawGLeakPC                 = 0.0;
-float rawGLeakSC                 = 0.0;
-float rawGMFAMPAIncNC            = 0.0;
-float rawGMFNMDAIncNC            = 0.0;
-float threshDecTauBC             = 0.0;
-float threshDecTauGO             = 0.0;
-float threshDecTauUBC            = 0.0;
-float threshDecTauGR             = 0.0;
-float threshDecTauIO             = 0.0;
-float threshDecTauNC             = 0.0;
-float threshDecTauPC             = 0.0;
-float threshDecTauSC             = 0.0;
-float threshMaxBC                = 0.0;
-float threshMaxGO                = 0.0;
-float threshMaxGR                = 0.0;
-float threshMaxIO                = 0.0;
-float threshMaxNC                = 0.0;
-float threshMaxPC                = 0.0;
-float threshMaxSC                = 0.0;
-float weightScale                = 0.0; 
-float rawGRGOW                   = 0.0;
-float rawMFGOW                   = 0.0;
-float gogrW                      = 0.0;
-float gogoW                      = 0.0;
-
-/* derived act params */
-float numTSinMFHist       = 0.0; 
-float gLeakGO             = 0.0; 
-float gDecMFtoGO          = 0.0; 
-float gDecayMFtoGONMDA    = 0.0; 
-float gDecGRtoGO          = 0.0; 
-float gGABADecGOtoGO      = 0.0; 
-float goGABAGOGOSynRec    = 0.0; 
-float threshDecGO         = 0.0; 
-float gDirectDecMFtoGR    = 0.0; 
-float gSpilloverDecMFtoGR = 0.0; 
-float gDirectDecGOtoGR    = 0.0; 
-float gSpilloverDecGOtoGR = 0.0; 
-float threshDecGR         = 0.0; 
-float tsPerHistBinGR      = 0.0; 
-float gLeakSC             = 0.0; 
-float gDecGRtoSC          = 0.0; 
-float threshDecSC         = 0.0; 
-float gDecGRtoBC          = 0.0; 
-float gDecPCtoBC          = 0.0; 
-float threshDecBC         = 0.0; 
-float threshDecPC         = 0.0; 
-float gLeakPC             = 0.0; 
-float gDecGRtoPC          = 0.0; 
-float gDecBCtoPC          = 0.0; 
-float gDecSCtoPC          = 0.0; 
-float tsPopHistPC         = 0.0; 
-float tsPerPopHistBinPC   = 0.0; 
-//float numPopHistBinsPC    = 0.0; 
-float gLeakIO             = 0.0; 
-float threshDecIO         = 0.0; 
-float tsLTDDurationIO     = 0.0; 
-float tsLTDstartAPIO      = 0.0; 
-float tsLTPstartAPIO      = 0.0; 
-float tsLTPEndAPIO        = 0.0; 
-float grPCHistCheckBinIO  = 0.0; 
-float gmaxNMDADecMFtoNC   = 0.0; 
-float gmaxAMPADecMFtoNC   = 0.0;
-float gNMDAIncMFtoNC      = 0.0; 
-float gAMPAIncMFtoNC      = 0.0; 
-float gDecPCtoNC          = 0.0; 
-float gLeakNC             = 0.0; 
-float threshDecNC         = 0.0; 
-float gLeakBC             = 0.0; 
-float grgoW               = 0.0;
-float mfgoW               = 0.0;
+static float optional_act_param(parsed_sess_file &s_file, std::string name, float default_val)
+{
+	auto &param_map = s_file.parsed_var_sections["activity"].param_map;
+	auto entry = param_map.find(name);
+	if (entry == param_map.end()) return default_val;
+	return std::stof(entry->second.value);
+}
 
-void populate_act_params(parsed_sess_file &s_file)
+void sim_params::populate_act_params(parsed_sess_file &s_file)
 {
 	coupleRiRjRatioGO          = std::stof(s_file.parsed_var_sections["activity"].param_map["coupleRiRjRatioGO"].value); 
 	coupleRiRjRatioIO          = std::stof(s_file.parsed_var_sections["activity"].param_map["coupleRiRjRatioIO"].value); 
@@ -227,6 +65,9 @@ void populate_act_params(parsed_sess_file &s_file)
 	gKTauUBC                   = std::stof(s_file.parsed_var_sections["activity"].param_map["gKTauUBC"].value); 
 	gConstUBC                  = std::stof(s_file.parsed_var_sections["activity"].param_map["gConstUBC"].value); 
 	threshTauUBC               = std::stof(s_file.parsed_var_sections["activity"].param_map["threshTauUBC"].value); 
+	/* UBC params added with the UBC population, optional so older sessions still parse */
+	gDecTauMFtoUBC             = optional_act_param(s_file, "gDecTauMFtoUBC", 100.0);
+	eKUBC                      = optional_act_param(s_file, "eKUBC", -80.0);
 	gMGluRDecGRtoGO            = std::stof(s_file.parsed_var_sections["activity"].param_map["gMGluRDecGRtoGO"].value); 
 	gMGluRIncDecayGO           = std::stof(s_file.parsed_var_sections["activity"].param_map["gMGluRIncDecayGO"].value); 
 	gMGluRIncScaleGO           = std::stof(s_file.parsed_var_sections["activity"].param_map["gMGluRIncScaleGO"].value); 
@@ -319,6 +160,9 @@ void populate_act_params(parsed_sess_file &s_file)
 	gDirectDecGOtoGR    = exp(-msPerTimeStep / gDirectTauGOtoGR);
 	gSpilloverDecGOtoGR = exp(-msPerTimeStep / gSpilloverTauGOtoGR);
 	threshDecGR         = 1 - exp(-msPerTimeStep / threshDecTauGR);
+	gDecMFtoUBC         = exp(-msPerTimeStep / gDecTauMFtoUBC);
+	gKDecUBC            = exp(-msPerTimeStep / gKTauUBC);
+	threshDecUBC        = 1 - exp(-msPerTimeStep / threshDecTauUBC);
 	tsPerHistBinGR      = msPerHistBinGR / msPerTimeStep;
 	gLeakSC             = rawGLeakSC / (6 - msPerTimeStep);
 	gDecGRtoSC          = exp(-msPerTimeStep / gDecTauGRtoSC);
@@ -355,7 +199,7 @@ void populate_act_params(parsed_sess_file &s_file)
 	act_params_populated = true;
 }
 
-void read_act_params(std::fstream &in_param_buf)
+void sim_params::read_act_params(std::iostream &in_param_buf)
 {
 	in_param_buf.read((char *)&coupleRiRjRatioGO, sizeof(float));
 	in_param_buf.read((char *)&coupleRiRjRatioIO, sizeof(float));
@@ -400,6 +244,8 @@ void read_act_params(std::fstream &in_param_buf)
 	in_param_buf.read((char *)&gKTauUBC, sizeof(float));
 	in_param_buf.read((char *)&gConstUBC, sizeof(float));
 	in_param_buf.read((char *)&threshTauUBC, sizeof(float));
+	in_param_buf.read((char *)&gDecTauMFtoUBC, sizeof(float));
+	in_param_buf.read((char *)&eKUBC, sizeof(float));
 	in_param_buf.read((char *)&gMGluRDecGRtoGO, sizeof(float));
 	in_param_buf.read((char *)&gMGluRIncDecayGO, sizeof(float));
 	in_param_buf.read((char *)&gMGluRIncScaleGO, sizeof(float));
@@ -491,6 +337,9 @@ void read_act_params(std::fstream &in_param_buf)
 	in_param_buf.read((char *)&gDirectDecGOtoGR, sizeof(float)); 
 	in_param_buf.read((char *)&gSpilloverDecGOtoGR, sizeof(float));
 	in_param_buf.read((char *)&threshDecGR, sizeof(float));
+	in_param_buf.read((char *)&gDecMFtoUBC, sizeof(float));
+	in_param_buf.read((char *)&gKDecUBC, sizeof(float));
+	in_param_buf.read((char *)&threshDecUBC, sizeof(float));
 	in_param_buf.read((char *)&tsPerHistBinGR, sizeof(float));
 	in_param_buf.read((char *)&gLeakSC, sizeof(float));
 	in_param_buf.read((char *)&gDecGRtoSC, sizeof(float));
@@ -527,7 +376,7 @@ void read_act_params(std::fstream &in_param_buf)
 	act_params_populated = true;
 }
 
-void write_act_params(std::fstream &out_param_buf)
+void sim_params::write_act_params(std::iostream &out_param_buf) const
 {
 	out_param_buf.write((char *)&coupleRiRjRatioGO, sizeof(float));
 	out_param_buf.write((char *)&coupleRiRjRatioIO, sizeof(float));
@@ -572,6 +421,8 @@ void write_act_params(std::fstream &out_param_buf)
 	out_param_buf.write((char *)&gKTauUBC, sizeof(float));
 	out_param_buf.write((char *)&gConstUBC, sizeof(float));
 	out_param_buf.write((char *)&threshTauUBC, sizeof(float));
+	out_param_buf.write((char *)&gDecTauMFtoUBC, sizeof(float));
+	out_param_buf.write((char *)&eKUBC, sizeof(float));
 	out_param_buf.write((char *)&gMGluRDecGRtoGO, sizeof(float));
 	out_param_buf.write((char *)&gMGluRIncDecayGO, sizeof(float));
 	out_param_buf.write((char *)&gMGluRIncScaleGO, sizeof(float));
@@ -663,6 +514,9 @@ void write_act_params(std::fstream &out_param_buf)
 	out_param_buf.write((char *)&gDirectDecGOtoGR, sizeof(float)); 
 	out_param_buf.write((char *)&gSpilloverDecGOtoGR, sizeof(float));
 	out_param_buf.write((char *)&threshDecGR, sizeof(float));
+	out_param_buf.write((char *)&gDecMFtoUBC, sizeof(float));
+	out_param_buf.write((char *)&gKDecUBC, sizeof(float));
+	out_param_buf.write((char *)&threshDecUBC, sizeof(float));
 	out_param_buf.write((char *)&tsPerHistBinGR, sizeof(float));
 	out_param_buf.write((char *)&gLeakSC, sizeof(float));
 	out_param_buf.write((char *)&gDecGRtoSC, sizeof(float));
@@ -16,181 +16,185 @@
 #include "file_parse.h"
 #include "stdint.h"
 
-#define NUM_ACT_PARAMS 174
+#define NUM_ACT_PARAMS 179
 
-extern bool act_params_populated;
+/* activity params of one simulation. populated, read and written through
+ * sim_params (simparams.h), as the derived params depend on msPerTimeStep */
+struct act_params
+{
+	/* raw params */
+	float coupleRiRjRatioGO = 0.0;
+	float coupleRiRjRatioIO = 0.0;
+	float eBCtoPC = 0.0;
+	float eGABAGO = 0.0;
+	float eGOGR = 0.0;
+	float eMFGR = 0.0;
+	float eMGluRGO = 0.0;
+	float eNCtoIO = 0.0;
+	float ePCtoBC = 0.0;
+	float ePCtoNC = 0.0;
+	float eSCtoPC = 0.0;
+	float gDecTauBCtoPC = 0.0;
+	float gIncBCtoPC = 0.0;
+	float gGABADecTauGOtoGO = 0.0;
+	float gIncDirectGOtoGR = 0.0;
+	float gDirectTauGOtoGR = 0.0;
+	float gIncFracSpilloverGOtoGR = 0.0;
+	float gSpilloverTauGOtoGR = 0.0;
+	float gGABAIncGOtoGO = 0.0;
+	float gDecTauGRtoGO = 0.0;
+	float gIncGRtoGO = 0.0;
+	float gDecTauMFtoGO = 0.0;
+	float gIncMFtoGO = 0.0;
+	float gConstGO = 0.0;
+	float NMDA_AMPAratioMFGO = 0.0;
+	float gDecTauMFtoGONMDA = 0.0;
+	float gIncDirectMFtoGR = 0.0;
+	float gDirectTauMFtoGR = 0.0;
+	float gIncFracSpilloverMFtoGR = 0.0;
+	float gSpilloverTauMFtoGR = 0.0;
+	float recoveryTauMF = 0.0;
+	float fracDepMF = 0.0;
+	float recoveryTauGO = 0.0;
+	float fracDepGO = 0.0;
+	float gIncMFtoUBC = 0.0;
+	float gIncGOtoUBC = 0.0;
+	float gIncUBCtoUBC = 0.0;
+	float gIncUBCtoGO = 0.0;
+	float gIncUBCtoGR = 0.0;
+	float gKIncUBC = 0.0;
+	float gKTauUBC = 0.0;
+	float gConstUBC = 0.0;
+	float threshTauUBC = 0.0;
+	float gDecTauMFtoUBC = 0.0; /* optional, see populate_act_params */
+	float eKUBC = 0.0; /* optional */
+	float gMGluRDecGRtoGO = 0.0;
+	float gMGluRIncDecayGO = 0.0;
+	float gMGluRIncScaleGO = 0.0;
+	float gMGluRScaleGRtoGO = 0.0;
+	float gDecT0ofNCtoIO = 0.0;
+	float gDecTSofNCtoIO = 0.0;
+	float gDecTTofNCtoIO = 0.0;
+	float gIncNCtoIO = 0.0;
+	float gIncTauNCtoIO = 0.0;
+	float gDecTauPCtoBC = 0.0;
+	float gDecTauPCtoNC = 0.0;
+	float gIncAvgPCtoNC = 0.0;
+	float gDecTauGRtoBC = 0.0;
+	float gDecTauGRtoPC = 0.0;
+	float gDecTauGRtoSC = 0.0;
+	float gIncGRtoPC = 0.0;
+	float gDecTauSCtoPC = 0.0;
+	float gIncSCtoPC = 0.0;
+	float gluDecayGO = 0.0;
+	float gluScaleGO = 0.0;
+	float goGABAGOGOSynDepF = 0.0;
+	float goGABAGOGOSynRecTau = 0.0;
+	float synLTDStepSizeGRtoPC = 0.0;
+	float synLTPStepSizeGRtoPC = 0.0;
+	float mGluRDecayGO = 0.0;
+	float mGluRScaleGO = 0.0;
+	float maxExtIncVIO = 0.0;
+	float gmaxAMPADecTauMFtoNC = 0.0;
+	float synLTDStepSizeMFtoNC = 0.0;
+	float synLTDPCPopActThreshMFtoNC = 0.0;
+	float synLTPStepSizeMFtoNC = 0.0;
+	float synLTPPCPopActThreshMFtoNC = 0.0;
+	float gmaxNMDADecTauMFtoNC = 0.0;
+	float msLTDDurationIO = 0.0;
+	float msLTDStartAPIO = 0.0;
+	float msLTPEndAPIO = 0.0;
+	float msLTPStartAPIO = 0.0;
+	float msPerHistBinGR = 0.0;
+	float msPerHistBinMF = 0.0;
+	float relPDecT0ofNCtoIO = 0.0;
+	float relPDecTSofNCtoIO = 0.0;
+	float relPDecTTofNCtoIO = 0.0;
+	float relPIncNCtoIO = 0.0;
+	float relPIncTauNCtoIO = 0.0;
+	float gIncPCtoBC = 0.0;
+	float gIncGRtoBC = 0.0;
+	float gIncGRtoSC = 0.0;
+	float rawGLeakBC = 0.0;
+	float rawGLeakGO = 0.0;
+	float rawGLeakGR = 0.0;
+	float rawGLeakIO = 0.0;
+	float rawGLeakNC = 0.0;
+	float rawGLeakPC = 0.0;
+	float rawGLeakSC = 0.0;
+	float rawGMFAMPAIncNC = 0.0;
+	float rawGMFNMDAIncNC = 0.0;
+	float threshDecTauBC = 0.0;
+	float threshDecTauGO = 0.0;
+	float threshDecTauUBC = 0.0;
+	float threshDecTauGR = 0.0;
+	float threshDecTauIO = 0.0;
+	float threshDecTauNC = 0.0;
+	float threshDecTauPC = 0.0;
+	float threshDecTauSC = 0.0;
+	float threshMaxBC = 0.0;
+	float threshMaxGO = 0.0;
+	float threshMaxGR = 0.0;
+	float threshMaxIO = 0.0;
+	float threshMaxNC = 0.0;
+	float threshMaxPC = 0.0;
+	float threshMaxSC = 0.0;
+	float weightScale = 0.0;
+	float rawGRGOW = 0.0;
+	float rawMFGOW = 0.0;
+	float gogrW = 0.0;
+	float gogoW = 0.0;
 
-/* raw params */
-extern float coupleRiRjRatioGO;
-extern float coupleRiRjRatioIO;
-extern float eBCtoPC;
-extern float eGABAGO;
-extern float eGOGR;
-extern float eMFGR;
-extern float eMGluRGO;
-extern float eNCtoIO; 
-extern float ePCtoBC;
-extern float ePCtoNC;
-extern float eSCtoPC;
-extern float gDecTauBCtoPC;
-extern float gIncBCtoPC;
-extern float gGABADecTauGOtoGO;
-extern float gIncDirectGOtoGR;
-extern float gDirectTauGOtoGR;
-extern float gIncFracSpilloverGOtoGR;
-extern float gSpilloverTauGOtoGR;
-extern float gGABAIncGOtoGO;
-extern float gDecTauGRtoGO;
-extern float gIncGRtoGO;
-extern float gDecTauMFtoGO;
-extern float gIncMFtoGO;
-extern float gConstGO;
-extern float NMDA_AMPAratioMFGO;
-extern float gDecTauMFtoGONMDA;
-extern float gIncDirectMFtoGR;
-extern float gDirectTauMFtoGR;
-extern float gIncFracSpilloverMFtoGR;
-extern float gSpilloverTauMFtoGR;
-extern float recoveryTauMF;
-extern float fracDepMF;
-extern float recoveryTauGO;
-extern float fracDepGO;
-extern float gIncMFtoUBC;
-extern float gIncGOtoUBC;
-extern float gIncUBCtoUBC;
-extern float gIncUBCtoGO;
-extern float gIncUBCtoGR;
-extern float gKIncUBC;
-extern float gKTauUBC;
-extern float gConstUBC;
-extern float threshTauUBC;
-extern float gMGluRDecGRtoGO;
-extern float gMGluRIncDecayGO;
-extern float gMGluRIncScaleGO;
-extern float gMGluRScaleGRtoGO;
-extern float gDecT0ofNCtoIO;
-extern float gDecTSofNCtoIO;
-extern float gDecTTofNCtoIO;
-extern float gIncNCtoIO;
-extern float gIncTauNCtoIO;
-extern float gDecTauPCtoBC;
-extern float gDecTauPCtoNC;
-extern float gIncAvgPCtoNC;
-extern float gDecTauGRtoBC;
-extern float gDecTauGRtoPC;
-extern float gDecTauGRtoSC;
-extern float gIncGRtoPC;
-extern float gDecTauSCtoPC;
-extern float gIncSCtoPC;
-extern float gluDecayGO;
-extern float gluScaleGO;
-extern float goGABAGOGOSynDepF;
-extern float goGABAGOGOSynRecTau;
-extern float synLTDStepSizeGRtoPC;
-extern float synLTPStepSizeGRtoPC;
-extern float mGluRDecayGO;
-extern float mGluRScaleGO;
-extern float maxExtIncVIO;
-extern float gmaxAMPADecTauMFtoNC;
-extern float synLTDStepSizeMFtoNC;
-extern float synLTDPCPopActThreshMFtoNC;
-extern float synLTPStepSizeMFtoNC;
-extern float synLTPPCPopActThreshMFtoNC;
-extern float gmaxNMDADecTauMFtoNC;
-extern float msLTDDurationIO;
-extern float msLTDStartAPIO;
-extern float msLTPEndAPIO;
-extern float msLTPStartAPIO;
-extern float msPerHistBinGR;
-extern float msPerHistBinMF;
-extern float relPDecT0ofNCtoIO;
-extern float relPDecTSofNCtoIO;
-extern float relPDecTTofNCtoIO;
-extern float relPIncNCtoIO;
-extern float relPIncTauNCtoIO;
-extern float gIncPCtoBC;
-extern float gIncGRtoBC;
-extern float gIncGRtoSC;
-extern float rawGLeakBC;
-extern float rawGLeakGO;
-extern float rawGLeakGR;
-extern float rawGLeakIO;
-extern float rawGLeakNC;
-extern float rawGLeakPC;
-extern float rawGLeakSC;
-extern float rawGMFAMPAIncNC;
-extern float rawGMFNMDAIncNC;
-extern float threshDecTauBC;
-extern float threshDecTauGO;
-extern float threshDecTauUBC;
-extern float threshDecTauGR;
-extern float threshDecTauIO;
-extern float threshDecTauNC;
-extern float threshDecTauPC;
-extern float threshDecTauSC;
-extern float threshMaxBC;
-extern float threshMaxGO;
-extern float threshMaxGR;
-extern float threshMaxIO;
-extern float threshMaxNC;
-extern float threshMaxPC;
-extern float threshMaxSC;
-extern float weightScale;
-extern float rawGRGOW;
-extern float rawMFGOW;
-extern float gogrW;
-extern float gogoW;
-
-/* derived act params */
-extern float numTSinMFHist;
-extern float gLeakGO;
-extern float gDecMFtoGO;
-extern float gDecayMFtoGONMDA;
-extern float gDecGRtoGO;
-extern float gGABADecGOtoGO;
-extern float goGABAGOGOSynRec;
-extern float threshDecGO;
-extern float gDirectDecMFtoGR;
-extern float gSpilloverDecMFtoGR;
-extern float gDirectDecGOtoGR; 
-extern float gSpilloverDecGOtoGR;
-extern float threshDecGR;
-extern float tsPerHistBinGR;
-extern float gLeakSC;
-extern float gDecGRtoSC;
-extern float threshDecSC;
-extern float gDecGRtoBC;
-extern float gDecPCtoBC;
-extern float threshDecBC;
-extern float threshDecPC;
-extern float gLeakPC;
-extern float gDecGRtoPC;
-extern float gDecBCtoPC;
-extern float gDecSCtoPC;
-extern float tsPopHistPC; /* used for updating MFNC syn plasticity */
-extern float tsPerPopHistBinPC; /* used for updating MFNC syn plasticity */ 
-// extern float numPopHistBinsPC; /* used for updating MFNC syn plasticity */ 
-extern float gLeakIO;
-extern float threshDecIO;
-extern float tsLTDDurationIO;
-extern float tsLTDstartAPIO;
-extern float tsLTPstartAPIO;
-extern float tsLTPEndAPIO; 
-extern float grPCHistCheckBinIO; /* used in PFPC syn plasticity */
-extern float gmaxNMDADecMFtoNC;
-extern float gmaxAMPADecMFtoNC;
-extern float gNMDAIncMFtoNC;
-extern float gAMPAIncMFtoNC;
-extern float gDecPCtoNC;
-extern float gLeakNC;
-extern float threshDecNC;
-extern float gLeakBC;
-extern float grgoW;
-extern float mfgoW;
-
-void populate_act_params(parsed_sess_file &s_file);
-void read_act_params(std::fstream &in_param_buf);
-void write_act_params(std::fstream &out_param_buf);
+	/* derived act params */
+	float numTSinMFHist = 0.0;
+	float gLeakGO = 0.0;
+	float gDecMFtoGO = 0.0;
+	float gDecayMFtoGONMDA = 0.0;
+	float gDecGRtoGO = 0.0;
+	float gGABADecGOtoGO = 0.0;
+	float goGABAGOGOSynRec = 0.0;
+	float threshDecGO = 0.0;
+	float gDirectDecMFtoGR = 0.0;
+	float gSpilloverDecMFtoGR = 0.0;
+	float gDirectDecGOtoGR = 0.0;
+	float gSpilloverDecGOtoGR = 0.0;
+	float threshDecGR = 0.0;
+	float gDecMFtoUBC = 0.0;
+	float gKDecUBC = 0.0;
+	float threshDecUBC = 0.0;
+	float tsPerHistBinGR = 0.0;
+	float gLeakSC = 0.0;
+	float gDecGRtoSC = 0.0;
+	float threshDecSC = 0.0;
+	float gDecGRtoBC = 0.0;
+	float gDecPCtoBC = 0.0;
+	float threshDecBC = 0.0;
+	float threshDecPC = 0.0;
+	float gLeakPC = 0.0;
+	float gDecGRtoPC = 0.0;
+	float gDecBCtoPC = 0.0;
+	float gDecSCtoPC = 0.0;
+	float tsPopHistPC = 0.0; /* used for updating MFNC syn plasticity */
+	float tsPerPopHistBinPC = 0.0; /* used for updating MFNC syn plasticity */
+	// float numPopHistBinsPC; /* used for updating MFNC syn plasticity */ 
+	float gLeakIO = 0.0;
+	float threshDecIO = 0.0;
+	float tsLTDDurationIO = 0.0;
+	float tsLTDstartAPIO = 0.0;
+	float tsLTPstartAPIO = 0.0;
+	float tsLTPEndAPIO = 0.0;
+	float grPCHistCheckBinIO = 0.0; /* used in PFPC syn plasticity */
+	float gmaxNMDADecMFtoNC = 0.0;
+	float gmaxAMPADecMFtoNC = 0.0;
+	float gNMDAIncMFtoNC = 0.0;
+	float gAMPAIncMFtoNC = 0.0;
+	float gDecPCtoNC = 0.0;
+	float gLeakNC = 0.0;
+	float threshDecNC = 0.0;
+	float gLeakBC = 0.0;
+	float grgoW = 0.0;
+	float mfgoW = 0.0;
+};
 
 #endif /* ACTIVITYPARAMS_H_ */
 
@@ -5,11 +5,15 @@
  *      Author: consciousness
  */
 
+#include <cstring>
+
+#include "file_utility.h"
 #include "cbmstate.h"
 
 CBMState::CBMState() {}
 
-CBMState::CBMState(unsigned int nZones) : numZones(nZones)
+CBMState::CBMState(const sim_params &params, unsigned int nZones)
+	: sim_params(params), numZones(nZones)
 {
 	CRandomSFMT randGen(time(0));
 
@@ -17,8 +21,8 @@ CBMState::CBMState(unsigned int nZones) : numZones(nZones)
 	int *mzoneCRSeed = new int[nZones];
 	int *mzoneARSeed = new int[nZones];
 
-	innetConState  = new InNetConnectivityState(innetCRSeed);
-	innetActState  = new InNetActivityState();
+	innetConState  = new InNetConnectivityState(params, innetCRSeed);
+	innetActState  = new InNetActivityState(params, innetConState->numUBC);
 
 	mzoneConStates = new MZoneConnectivityState*[nZones];
 	mzoneActStates = new MZoneActivityState*[nZones];
@@ -26,25 +30,45 @@ CBMState::CBMState(unsigned int nZones) : numZones(nZones)
 	{
 		mzoneCRSeed[i] = randGen.IRandom(0, INT_MAX);
 		mzoneARSeed[i] = randGen.IRandom(0, INT_MAX);
-		mzoneConStates[i] = new MZoneConnectivityState(mzoneCRSeed[i]);
-		mzoneActStates[i] = new MZoneActivityState(mzoneARSeed[i]);
+		mzoneConStates[i] = new MZoneConnectivityState(params, mzoneCRSeed[i]);
+		mzoneActStates[i] = new MZoneActivityState(params, mzoneARSeed[i]);
 	}
+	shareConTables();
 	delete[] mzoneCRSeed;
 	delete[] mzoneARSeed;
 }
 
-CBMState::CBMState(unsigned int nZones, std::fstream &sim_file_buf) : numZones(nZones)
+CBMState::CBMState(const sim_params &params, unsigned int nZones, std::iostream &sim_file_buf)
+	: sim_params(params), numZones(nZones)
 {
-	innetConState  = new InNetConnectivityState(sim_file_buf);
-	innetActState  = new InNetActivityState(sim_file_buf);
+	innetConState  = new InNetConnectivityState(params, sim_file_buf);
+	innetActState  = new InNetActivityState(params, sim_file_buf);
 
 	mzoneConStates = new MZoneConnectivityState*[nZones];
 	mzoneActStates = new MZoneActivityState*[nZones];
 
+	MZoneConnectivityState *owners[NUM_MZONE_CON_TABLES] = {};
 	for (int i = 0; i < nZones; i++)
 	{
-		mzoneConStates[i] = new MZoneConnectivityState(sim_file_buf);
-		mzoneActStates[i] = new MZoneActivityState(sim_file_buf);
+		if (i > 0) readConTableOwners(sim_file_buf, i, owners);
+		mzoneConStates[i] = new MZoneConnectivityState(params, sim_file_buf, owners);
+		mzoneActStates[i] = new MZoneActivityState(params, sim_file_buf);
+	}
+}
+
+CBMState::CBMState(const sim_params &params, CBMState &con_state, std::iostream &act_file_buf)
+	: sim_params(params), numZones(con_state.numZones), ownsConStates(false)
+{
+	innetConState  = con_state.innetConState;
+	innetActState  = new InNetActivityState(params, act_file_buf);
+
+	mzoneConStates = new MZoneConnectivityState*[numZones];
+	mzoneActStates = new MZoneActivityState*[numZones];
+
+	for (int i = 0; i < numZones; i++)
+	{
+		mzoneConStates[i] = con_state.mzoneConStates[i];
+		mzoneActStates[i] = new MZoneActivityState(params, act_file_buf);
 	}
 }
 
@@ -68,45 +92,140 @@ CBMState::CBMState(unsigned int nZones, std::fstream &sim_file_buf) : numZones(n
 
 CBMState::~CBMState()
 {
-	delete innetConState;
+	if (ownsConStates) delete innetConState;
 	delete innetActState;
 	for (int i = 0; i < numZones; i++) 
 	{
-		delete mzoneConStates[i];
+		if (ownsConStates) delete mzoneConStates[i];
 		delete mzoneActStates[i];
 	}
 	delete[] mzoneConStates;
 	delete[] mzoneActStates;
 }
 
-void CBMState::readState(std::fstream &infile)
+void CBMState::readState(std::iostream &infile)
 {
 	innetConState->readState(infile);
 	innetActState->readState(infile);
 
+	/* the file may share differently. unsharing from the last zone down
+	 * leaves every owner in place until its sharers have their own copy */
+	for (int i = numZones - 1; i > 0; i--)
+	{
+		for (int t = 0; t < NUM_MZONE_CON_TABLES; t++)
+			mzoneConStates[i]->shareTable(t, mzoneConStates[i]);
+	}
+	MZoneConnectivityState *owners[NUM_MZONE_CON_TABLES];
 	for (int i = 0; i < numZones; i++)
 	{
+		if (i > 0)
+		{
+			readConTableOwners(infile, i, owners);
+			for (int t = 0; t < NUM_MZONE_CON_TABLES; t++)
+			{
+				if (owners[t]) mzoneConStates[i]->shareTable(t, owners[t]);
+			}
+		}
 		mzoneConStates[i]->readState(infile);
 		mzoneActStates[i]->readState(infile);
 	}
 }
 
-void CBMState::writeState(std::fstream &outfile)
+void CBMState::writeState(std::iostream &outfile)
 {
 	innetConState->writeState(outfile);
 	innetActState->writeState(outfile);
 	for (int i = 0; i < numZones; i++)
 	{
+		if (i > 0) writeConTableOwners(outfile, i);
 		mzoneConStates[i]->writeState(outfile);
 		mzoneActStates[i]->writeState(outfile);
 	}
 }
 
+void CBMState::writeActState(std::iostream &outfile)
+{
+	innetActState->writeState(outfile);
+	for (int i = 0; i < numZones; i++)
+	{
+		mzoneActStates[i]->writeState(outfile);
+	}
+}
+
+void CBMState::shareConTables()
+{
+	size_t shared_bytes = 0;
+	for (int i = 1; i < numZones; i++)
+	{
+		for (int t = 0; t < NUM_MZONE_CON_TABLES; t++)
+		{
+			size_t bytes = mzoneConStates[i]->tableBytes(t);
+			for (int k = 0; k < i; k++)
+			{
+				if (mzoneConStates[k]->sharesTable(t)) continue;
+				if (memcmp(mzoneConStates[k]->tableData(t), mzoneConStates[i]->tableData(t), bytes) == 0)
+				{
+					mzoneConStates[i]->shareTable(t, mzoneConStates[k]);
+					shared_bytes += bytes;
+					break;
+				}
+			}
+		}
+	}
+	if (numZones > 1)
+	{
+		std::cout << "[INFO]: Sharing " << shared_bytes
+				  << " bytes of identical mzone connectivity between zones.\n";
+	}
+}
+
+uint32_t CBMState::conTableOwner(unsigned int zoneN, int table)
+{
+	uint32_t *data = mzoneConStates[zoneN]->tableData(table);
+	for (uint32_t k = 0; k < zoneN; k++)
+	{
+		if (!mzoneConStates[k]->sharesTable(table) && mzoneConStates[k]->tableData(table) == data)
+			return k;
+	}
+	return zoneN;
+}
+
+void CBMState::readConTableOwners(std::iostream &infile, unsigned int zoneN,
+	MZoneConnectivityState **owners)
+{
+	uint32_t owner_zones[NUM_MZONE_CON_TABLES];
+	rawBytesRW((char *)owner_zones, sizeof(owner_zones), true, infile);
+	for (int t = 0; t < NUM_MZONE_CON_TABLES; t++)
+	{
+		if (owner_zones[t] > zoneN)
+		{
+			std::cerr << "[ERROR]: zone " << zoneN << " connectivity table " << t
+					  << " names zone " << owner_zones[t] << " as its owner.\n";
+			std::cerr << "[ERROR]: (Hint: was the file written with a different number of zones?)\n";
+			owner_zones[t] = zoneN;
+		}
+		owners[t] = (owner_zones[t] == zoneN) ? NULL : mzoneConStates[owner_zones[t]];
+	}
+}
+
+void CBMState::writeConTableOwners(std::iostream &outfile, unsigned int zoneN)
+{
+	uint32_t owner_zones[NUM_MZONE_CON_TABLES];
+	for (int t = 0; t < NUM_MZONE_CON_TABLES; t++)
+		owner_zones[t] = conTableOwner(zoneN, t);
+	rawBytesRW((char *)owner_zones, sizeof(owner_zones), false, outfile);
+}
+
 uint32_t CBMState::getNumZones()
 {
 	return numZones;
 }
 
+const sim_params &CBMState::getParams()
+{
+	return *this;
+}
+
 InNetActivityState* CBMState::getInnetActStateInternal()
 {
 	return innetActState;
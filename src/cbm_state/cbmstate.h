@@ -18,23 +18,29 @@
 #include "mzoneconnectivitystate.h"
 #include "innetactivitystate.h"
 #include "mzoneactivitystate.h"
-#include "connectivityparams.h" // <-- added in 06/01/2022
-#include "activityparams.h"
+#include "simparams.h"
 
-class CBMState
+class CBMState : protected sim_params
 {
 	public:
 		CBMState();
-		CBMState(unsigned int nZones);
+		CBMState(const sim_params &params, unsigned int nZones);
 		// TODO: make a choice which of two below constructors want to keep
-		CBMState(unsigned int nZones, std::fstream &sim_file_buf);
+		CBMState(const sim_params &params, unsigned int nZones, std::iostream &sim_file_buf);
+		/* shares the connectivity of con_state, which must outlive this state, and
+		 * reads only the activity states from act_file_buf, as written by
+		 * writeActState. used by parameter sweeps, where every point starts
+		 * from one rabbit and only activity params differ */
+		CBMState(const sim_params &params, CBMState &con_state, std::iostream &act_file_buf);
 		//CBMState(unsigned int nZones, std::string inFile);
 		~CBMState();
 
-		void readState(std::fstream &infile);
-		void writeState(std::fstream &outfile);
+		void readState(std::iostream &infile);
+		void writeState(std::iostream &outfile);
+		void writeActState(std::iostream &outfile);
 
 		uint32_t getNumZones();
+		const sim_params &getParams();
 
 		InNetActivityState* getInnetActStateInternal();
 		MZoneActivityState* getMZoneActStateInternal(unsigned int zoneN);
@@ -43,7 +49,18 @@ class CBMState
 		MZoneConnectivityState* getMZoneConStateInternal(unsigned int zoneN);
 
 	private:
+		/* shares every connectivity table of a zone that is identical to one of
+		 * an earlier zone. in the .sim, each zone after the first is preceded by
+		 * the index of the zone owning each of its tables, and only the tables
+		 * it owns are stored */
+		void shareConTables();
+		uint32_t conTableOwner(unsigned int zoneN, int table);
+		void readConTableOwners(std::iostream &infile, unsigned int zoneN,
+			MZoneConnectivityState **owners);
+		void writeConTableOwners(std::iostream &outfile, unsigned int zoneN);
+
 		uint32_t numZones;
+		bool ownsConStates = true;
 
 		InNetConnectivityState *innetConState;
 		MZoneConnectivityState **mzoneConStates;
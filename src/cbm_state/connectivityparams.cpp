@@ -5,140 +5,9 @@
  *      Author: varicella
  */
 
-#include "connectivityparams.h"
+#include "simparams.h"
 
-bool con_params_populated = false;
-
-int mf_x                         = 0; 
-int mf_y                         = 0; 
-int num_mf                       = 0; 
-int gl_x                         = 0; 
-int gl_y                         = 0; 
-int num_gl                       = 0; 
-int gr_x                         = 0; 
-int gr_y                         = 0; 
-int num_gr                       = 0; 
-int go_x                         = 0; 
-int go_y                         = 0; 
-int num_go                       = 0; 
-int ubc_x                        = 0; 
-int ubc_y                        = 0; 
-int num_ubc                      = 0; 
-int num_bc                       = 0; 
-int num_sc                       = 0; 
-int num_pc                       = 0; 
-int num_nc                       = 0; 
-int num_io                       = 0; 
-int span_mf_to_gl_x              = 0; 
-int span_mf_to_gl_y              = 0; 
-int num_p_mf_to_gl               = 0; 
-int max_num_p_mf_from_mf_to_gl   = 0;  
-int initial_mf_output            = 0; 
-int max_mf_to_gl_attempts        = 0; 
-int span_gl_to_gr_x              = 0; 
-int span_gl_to_gr_y              = 0; 
-int num_p_gl_to_gr               = 0; 
-int low_num_p_gl_from_gl_to_gr   = 0;  
-int max_num_p_gr_from_gl_to_gr   = 0; 
-int max_num_p_gl_from_gl_to_gr   = 0; 
-int low_gl_to_gr_attempts        = 0; 
-int max_gl_to_gr_attempts        = 0; 
-int span_pf_to_go_x              = 0; 
-int span_pf_to_go_y              = 0; 
-int num_p_pf_to_go               = 0; 
-int max_num_p_go_from_gr_to_go   = 0; 
-int max_num_p_gr_from_gr_to_go   = 0; 
-int max_pf_to_go_input           = 0; 
-int max_pf_to_go_attempts        = 0; 
-int span_aa_to_go_x              = 0; 
-int span_aa_to_go_y              = 0; 
-int num_p_aa_to_go               = 0; 
-int max_aa_to_go_input           = 0; 
-int max_aa_to_go_attempts        = 0; 
-int span_go_to_go_x              = 0; 
-int span_go_to_go_y              = 0; 
-int num_p_go_to_go               = 0; 
-int num_con_go_to_go             = 0; 
-int go_go_recip_cons             = 0; 
-int reduce_base_recip_go_go      = 0; 
-int max_go_to_go_attempts        = 0; 
-int span_go_to_go_gj_x           = 0; 
-int span_go_to_go_gj_y           = 0; 
-int num_p_go_to_go_gj            = 0; 
-int span_go_to_gl_x              = 0; 
-int span_go_to_gl_y              = 0; 
-int num_p_go_to_gl               = 0; 
-int max_num_p_gl_from_go_to_gl   = 0; 
-int max_num_p_go_from_go_to_gl   = 0; 
-int max_go_to_gl_attempts        = 0; 
-int span_gl_to_go_x              = 0; 
-int span_gl_to_go_y              = 0; 
-int num_p_gl_to_go               = 0; 
-int low_num_p_gl_from_gl_to_go   = 0; 
-int max_num_p_gl_from_gl_to_go   = 0; 
-int max_num_p_go_from_gl_to_go   = 0; 
-int initial_go_input             = 0; 
-int low_gl_to_go_attempts        = 0; 
-int max_gl_to_go_attempts        = 0; 
-int max_num_p_go_from_go_to_gr   = 0; 
-int max_num_p_gr_from_go_to_gr   = 0; 
-int max_num_p_gr_from_mf_to_gr   = 0; 
-int max_num_p_mf_from_mf_to_gr   = 0; 
-int max_num_p_go_from_mf_to_go   = 0; 
-int max_num_p_mf_from_mf_to_go   = 0; 
-int gr_pf_vel_in_gr_x_per_t_step = 0; 
-int gr_af_delay_in_t_step        = 0; 
-int num_p_bc_from_bc_to_pc       = 0; 
-int num_p_pc_from_bc_to_pc       = 0; 
-int num_p_bc_from_gr_to_bc       = 0; 
-int num_p_bc_from_gr_to_bc_p2    = 0; 
-int num_p_pc_from_pc_to_bc       = 0; 
-int num_p_bc_from_pc_to_bc       = 0; 
-int num_p_sc_from_sc_to_pc       = 0; 
-int num_p_pc_from_sc_to_pc       = 0; 
-int num_p_sc_from_gr_to_sc       = 0; 
-int num_p_sc_from_gr_to_sc_p2    = 0; 
-int num_p_pc_from_pc_to_nc       = 0; 
-int num_p_nc_from_pc_to_nc       = 0; 
-int num_p_pc_from_gr_to_pc       = 0; 
-int num_p_pc_from_gr_to_pc_p2    = 0; 
-int num_p_mf_from_mf_to_nc       = 0; 
-int num_p_nc_from_mf_to_nc       = 0; 
-int num_p_nc_from_nc_to_io       = 0; 
-int num_p_io_from_nc_to_io       = 0; 
-int num_p_io_from_io_to_pc       = 0; 
-int num_p_io_in_io_to_io         = 0; 
-int num_p_io_out_io_to_io        = 0; 
-
-float msPerTimeStep            = 0.0;
-float numPopHistBinsPC         = 0.0; 
-float ampl_go_to_go            = 0.0; 
-float std_dev_go_to_go         = 0.0; 
-float p_recip_go_go            = 0.0; 
-float p_recip_lower_base_go_go = 0.0;  
-float ampl_go_to_gl            = 0.0; 
-float std_dev_go_to_gl_ml      = 0.0; 
-float std_dev_go_to_gl_s       = 0.0; 
-
-float eLeakGO      = 0.0;
-float threshRestGO = 0.0;
-float eLeakGR      = 0.0; 
-float threshRestGR = 0.0;
-
-float eLeakSC          = 0.0;
-float threshRestSC     = 0.0;
-float eLeakBC          = 0.0;
-float threshRestBC     = 0.0;
-float eLeakPC          = 0.0;
-float threshRestPC     = 0.0;
-float initSynWofGRtoPC = 0.0;
-float eLeakIO          = 0.0;
-float threshRestIO     = 0.0;
-float eLeakNC          = 0.0;
-float threshRestNC     = 0.0;
-float initSynWofMFtoNC = 0.0;
-
-void populate_con_params(parsed_build_file &p_file)
+void sim_params::populate_con_params(parsed_build_file &p_file)
 {
 	/* int con params */
 	mf_x                         = std::stoi(p_file.parsed_var_sections["connectivity"].param_map["mf_x"].value); 
@@ -156,6 +25,11 @@ void populate_con_params(parsed_build_file &p_file)
 	ubc_x                        = std::stoi(p_file.parsed_var_sections["connectivity"].param_map["ubc_x"].value); 
 	ubc_y                        = std::stoi(p_file.parsed_var_sections["connectivity"].param_map["ubc_y"].value); 
 	num_ubc                      = std::stoi(p_file.parsed_var_sections["connectivity"].param_map["num_ubc"].value); 
+	/* UBCs are opt-in with 'int use_ubc 1': earlier build files set num_ubc although
+	 * no UBCs were simulated */
+	auto use_ubc = p_file.parsed_var_sections["connectivity"].param_map.find("use_ubc");
+	if (use_ubc == p_file.parsed_var_sections["connectivity"].param_map.end()
+		  || std::stoi(use_ubc->second.value) == 0) num_ubc = 0;
 	num_bc                       = std::stoi(p_file.parsed_var_sections["connectivity"].param_map["num_bc"].value); 
 	num_sc                       = std::stoi(p_file.parsed_var_sections["connectivity"].param_map["num_sc"].value);
 	num_pc                       = std::stoi(p_file.parsed_var_sections["connectivity"].param_map["num_pc"].value); 
@@ -275,7 +149,7 @@ void populate_con_params(parsed_build_file &p_file)
 	con_params_populated = true;
 }
 
-void read_con_params(std::fstream &in_param_buf)
+void sim_params::read_con_params(std::iostream &in_param_buf)
 {
 	/* not checking whether these things are zeros or not... */
 	in_param_buf.read((char *)&mf_x, sizeof(int));
@@ -411,7 +285,7 @@ void read_con_params(std::fstream &in_param_buf)
 	con_params_populated = true;
 }
 
-void write_con_params(std::fstream &out_param_buf)
+void sim_params::write_con_params(std::iostream &out_param_buf) const
 {
 	/* not checking whether these things are zeros or not... */
 	out_param_buf.write((char *)&mf_x, sizeof(int));
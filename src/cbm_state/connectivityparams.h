@@ -19,141 +19,139 @@
 
 #define NUM_CON_PARAMS 107
 
-extern bool con_params_populated;
+/* connectivity params of one simulation, see sim_params (simparams.h) */
+struct con_params
+{
+	int mf_x = 0;
+	int mf_y = 0;
+	int num_mf = 0;
+	int gl_x = 0;
+	int gl_y = 0;
+	int num_gl = 0;
+	int gr_x = 0;
+	int gr_y = 0;
+	int num_gr = 0;
+	int go_x = 0;
+	int go_y = 0;
+	int num_go = 0;
+	int ubc_x = 0;
+	int ubc_y = 0;
+	int num_ubc = 0;
+	int num_bc = 0;
+	int num_sc = 0;
+	int num_pc = 0;
+	int num_nc = 0;
+	int num_io = 0;
+	int span_mf_to_gl_x = 0;
+	int span_mf_to_gl_y = 0;
+	int num_p_mf_to_gl = 0;
+	int max_num_p_mf_from_mf_to_gl = 0;
+	int initial_mf_output = 0;
+	int max_mf_to_gl_attempts = 0;
+	int span_gl_to_gr_x = 0;
+	int span_gl_to_gr_y = 0;
+	int num_p_gl_to_gr = 0;
+	int low_num_p_gl_from_gl_to_gr = 0;
+	int max_num_p_gr_from_gl_to_gr = 0;
+	int max_num_p_gl_from_gl_to_gr = 0;
+	int low_gl_to_gr_attempts = 0;
+	int max_gl_to_gr_attempts = 0;
+	int span_pf_to_go_x = 0;
+	int span_pf_to_go_y = 0;
+	int num_p_pf_to_go = 0;
+	int max_num_p_go_from_gr_to_go = 0;
+	int max_num_p_gr_from_gr_to_go = 0;
+	int max_pf_to_go_input = 0;
+	int max_pf_to_go_attempts = 0;
+	int span_aa_to_go_x = 0;
+	int span_aa_to_go_y = 0;
+	int num_p_aa_to_go = 0;
+	int max_aa_to_go_input = 0;
+	int max_aa_to_go_attempts = 0;
+	int span_go_to_go_x = 0;
+	int span_go_to_go_y = 0;
+	int num_p_go_to_go = 0;
+	int num_con_go_to_go = 0;
+	int go_go_recip_cons = 0;
+	int reduce_base_recip_go_go = 0;
+	int max_go_to_go_attempts = 0;
+	int span_go_to_go_gj_x = 0;
+	int span_go_to_go_gj_y = 0;
+	int num_p_go_to_go_gj = 0;
+	int span_go_to_gl_x = 0;
+	int span_go_to_gl_y = 0;
+	int num_p_go_to_gl = 0;
+	int max_num_p_gl_from_go_to_gl = 0;
+	int max_num_p_go_from_go_to_gl = 0;
+	int max_go_to_gl_attempts = 0;
+	int span_gl_to_go_x = 0;
+	int span_gl_to_go_y = 0;
+	int num_p_gl_to_go = 0;
+	int low_num_p_gl_from_gl_to_go = 0;
+	int max_num_p_gl_from_gl_to_go = 0;
+	int max_num_p_go_from_gl_to_go = 0;
+	int initial_go_input = 0;
+	int low_gl_to_go_attempts = 0;
+	int max_gl_to_go_attempts = 0;
+	int max_num_p_go_from_go_to_gr = 0;
+	int max_num_p_gr_from_go_to_gr = 0;
+	int max_num_p_gr_from_mf_to_gr = 0;
+	int max_num_p_mf_from_mf_to_gr = 0;
+	int max_num_p_go_from_mf_to_go = 0;
+	int max_num_p_mf_from_mf_to_go = 0;
+	int gr_pf_vel_in_gr_x_per_t_step = 0;
+	int gr_af_delay_in_t_step = 0;
+	int num_p_bc_from_bc_to_pc = 0;
+	int num_p_pc_from_bc_to_pc = 0;
+	int num_p_bc_from_gr_to_bc = 0;
+	int num_p_bc_from_gr_to_bc_p2 = 0;
+	int num_p_pc_from_pc_to_bc = 0;
+	int num_p_bc_from_pc_to_bc = 0;
+	int num_p_sc_from_sc_to_pc = 0;
+	int num_p_pc_from_sc_to_pc = 0;
+	int num_p_sc_from_gr_to_sc = 0;
+	int num_p_sc_from_gr_to_sc_p2 = 0;
+	int num_p_pc_from_pc_to_nc = 0;
+	int num_p_nc_from_pc_to_nc = 0;
+	int num_p_pc_from_gr_to_pc = 0;
+	int num_p_pc_from_gr_to_pc_p2 = 0;
+	int num_p_mf_from_mf_to_nc = 0;
+	int num_p_nc_from_mf_to_nc = 0;
+	int num_p_nc_from_nc_to_io = 0;
+	int num_p_io_from_nc_to_io = 0;
+	int num_p_io_from_io_to_pc = 0;
+	int num_p_io_in_io_to_io = 0;
+	int num_p_io_out_io_to_io = 0;
 
-extern int mf_x;
-extern int mf_y;
-extern int num_mf;
-extern int gl_x;
-extern int gl_y;
-extern int num_gl;
-extern int gr_x;
-extern int gr_y;
-extern int num_gr;
-extern int go_x;
-extern int go_y;
-extern int num_go;
-extern int ubc_x;
-extern int ubc_y;
-extern int num_ubc;
-extern int num_bc;
-extern int num_sc;
-extern int num_pc;
-extern int num_nc;
-extern int num_io;
-extern int span_mf_to_gl_x;
-extern int span_mf_to_gl_y;
-extern int num_p_mf_to_gl;
-extern int max_num_p_mf_from_mf_to_gl;
-extern int initial_mf_output;
-extern int max_mf_to_gl_attempts;
-extern int span_gl_to_gr_x;
-extern int span_gl_to_gr_y;
-extern int num_p_gl_to_gr;
-extern int low_num_p_gl_from_gl_to_gr;
-extern int max_num_p_gr_from_gl_to_gr;
-extern int max_num_p_gl_from_gl_to_gr;
-extern int low_gl_to_gr_attempts;
-extern int max_gl_to_gr_attempts;
-extern int span_pf_to_go_x;
-extern int span_pf_to_go_y;
-extern int num_p_pf_to_go;
-extern int max_num_p_go_from_gr_to_go;
-extern int max_num_p_gr_from_gr_to_go;
-extern int max_pf_to_go_input;
-extern int max_pf_to_go_attempts;
-extern int span_aa_to_go_x;
-extern int span_aa_to_go_y;
-extern int num_p_aa_to_go;
-extern int max_aa_to_go_input;
-extern int max_aa_to_go_attempts;
-extern int span_go_to_go_x;
-extern int span_go_to_go_y;
-extern int num_p_go_to_go;
-extern int num_con_go_to_go;
-extern int go_go_recip_cons;
-extern int reduce_base_recip_go_go;
-extern int max_go_to_go_attempts;
-extern int span_go_to_go_gj_x;
-extern int span_go_to_go_gj_y;
-extern int num_p_go_to_go_gj;
-extern int span_go_to_gl_x;
-extern int span_go_to_gl_y;
-extern int num_p_go_to_gl;
-extern int max_num_p_gl_from_go_to_gl;
-extern int max_num_p_go_from_go_to_gl;
-extern int max_go_to_gl_attempts;
-extern int span_gl_to_go_x;
-extern int span_gl_to_go_y;
-extern int num_p_gl_to_go;
-extern int low_num_p_gl_from_gl_to_go;
-extern int max_num_p_gl_from_gl_to_go;
-extern int max_num_p_go_from_gl_to_go;
-extern int initial_go_input;
-extern int low_gl_to_go_attempts;
-extern int max_gl_to_go_attempts;
-extern int max_num_p_go_from_go_to_gr;
-extern int max_num_p_gr_from_go_to_gr;
-extern int max_num_p_gr_from_mf_to_gr;
-extern int max_num_p_mf_from_mf_to_gr;
-extern int max_num_p_go_from_mf_to_go;
-extern int max_num_p_mf_from_mf_to_go;
-extern int gr_pf_vel_in_gr_x_per_t_step;
-extern int gr_af_delay_in_t_step;
-extern int num_p_bc_from_bc_to_pc;
-extern int num_p_pc_from_bc_to_pc;
-extern int num_p_bc_from_gr_to_bc;
-extern int num_p_bc_from_gr_to_bc_p2;
-extern int num_p_pc_from_pc_to_bc;
-extern int num_p_bc_from_pc_to_bc;
-extern int num_p_sc_from_sc_to_pc;
-extern int num_p_pc_from_sc_to_pc;
-extern int num_p_sc_from_gr_to_sc;
-extern int num_p_sc_from_gr_to_sc_p2;
-extern int num_p_pc_from_pc_to_nc;
-extern int num_p_nc_from_pc_to_nc;
-extern int num_p_pc_from_gr_to_pc;
-extern int num_p_pc_from_gr_to_pc_p2;
-extern int num_p_mf_from_mf_to_nc;
-extern int num_p_nc_from_mf_to_nc;
-extern int num_p_nc_from_nc_to_io;
-extern int num_p_io_from_nc_to_io;
-extern int num_p_io_from_io_to_pc;
-extern int num_p_io_in_io_to_io;
-extern int num_p_io_out_io_to_io;
+	float msPerTimeStep = 0.0;
+	float numPopHistBinsPC = 0.0; /* used for updating MFNC syn plasticity */
 
-extern float msPerTimeStep;
-extern float numPopHistBinsPC; /* used for updating MFNC syn plasticity */ 
+	float ampl_go_to_go = 0.0;
+	float std_dev_go_to_go = 0.0;
+	float p_recip_go_go = 0.0;
+	float p_recip_lower_base_go_go = 0.0;
+	float ampl_go_to_gl = 0.0;
+	float std_dev_go_to_gl_ml = 0.0;
+	float std_dev_go_to_gl_s = 0.0;
 
-extern float ampl_go_to_go;
-extern float std_dev_go_to_go;
-extern float p_recip_go_go;
-extern float p_recip_lower_base_go_go;
-extern float ampl_go_to_gl;
-extern float std_dev_go_to_gl_ml;
-extern float std_dev_go_to_gl_s;
+	float eLeakGO = 0.0;
+	float threshRestGO = 0.0;
+	float eLeakGR = 0.0;
+	float threshRestGR = 0.0;
 
-extern float eLeakGO;
-extern float threshRestGO;
-extern float eLeakGR; 
-extern float threshRestGR;
-
-extern float eLeakSC;
-extern float threshRestSC;
-extern float eLeakBC;
-extern float threshRestBC;
-extern float eLeakPC;
-extern float threshRestPC;
-extern float initSynWofGRtoPC;
-extern float eLeakIO;
-extern float threshRestIO;
-extern float eLeakNC;
-extern float threshRestNC;
-extern float initSynWofMFtoNC;
-
-void populate_con_params(parsed_build_file &p_file);
-void read_con_params(std::fstream &in_param_buf);
-void write_con_params(std::fstream &out_param_buf);
+	float eLeakSC = 0.0;
+	float threshRestSC = 0.0;
+	float eLeakBC = 0.0;
+	float threshRestBC = 0.0;
+	float eLeakPC = 0.0;
+	float threshRestPC = 0.0;
+	float initSynWofGRtoPC = 0.0;
+	float eLeakIO = 0.0;
+	float threshRestIO = 0.0;
+	float eLeakNC = 0.0;
+	float threshRestNC = 0.0;
+	float initSynWofMFtoNC = 0.0;
+};
 
 #endif /* CONNECTIVITYPARAMS_H_ */
 
@@ -302,6 +302,11 @@ bool *ECMFPopulation::getPhasicMFInd()
 	return isCSPhasic;
 }
 
+bool *ECMFPopulation::getImportMFInd()
+{
+	return isImport;
+}
+
 float *ECMFPopulation::getMFBG()
 {
 	return mfFreqBG;
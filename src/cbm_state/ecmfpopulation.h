@@ -40,6 +40,7 @@ public:
 	bool *getTonicMFInd();
 	bool *getTonicMFIndOverlap();
 	bool *getPhasicMFInd();
+	bool *getImportMFInd();
 	
 private:
 	void setMFs(int numTypeMF, int numMF, CRandomSFMT0 &randGen, bool *isAny, bool *isType);
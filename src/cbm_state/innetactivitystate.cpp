@@ -7,9 +7,20 @@
  *      Author: the gallogly
  */ 
 
+#include <algorithm>
+#include <cstring>
+#include "parallel_init.h"
 #include "innetactivitystate.h"
 
-InNetActivityState::InNetActivityState()
+/* written where the per-synapse gMFGR matrix used to start. as a float it is a
+ * NaN, which no saved conductance can be, so files without it are legacy ones */
+static const uint32_t AGG_COND_TAG = 0x7FC0A66C;
+
+/* written after the rest when there are UBCs, see UBC_CON_TAG */
+static const uint32_t UBC_ACT_TAG = 0x7FC0BC02;
+
+InNetActivityState::InNetActivityState(const sim_params &params, uint32_t numUBC)
+	: sim_params(params), numUBC(numUBC)
 {
 	std::cout << "[INFO]: Allocating and initializing innet activity state..." << std::endl;
 	allocateMemory();
@@ -17,7 +28,8 @@ InNetActivityState::InNetActivityState()
 	std::cout << "[INFO]: Finished allocating and initializing innet activity state." << std::endl;
 }
 
-InNetActivityState::InNetActivityState(std::fstream &infile)
+InNetActivityState::InNetActivityState(const sim_params &params, std::iostream &infile)
+	: sim_params(params)
 {
 	allocateMemory();
 	stateRW(true, infile);
@@ -25,12 +37,12 @@ InNetActivityState::InNetActivityState(std::fstream &infile)
 
 InNetActivityState::~InNetActivityState() {}
 
-void InNetActivityState::readState(std::fstream &infile)
+void InNetActivityState::readState(std::iostream &infile)
 {
 	stateRW(true, infile);
 }
 
-void InNetActivityState::writeState(std::fstream &outfile)
+void InNetActivityState::writeState(std::iostream &outfile)
 {
 	stateRW(false, outfile);
 }
@@ -40,51 +52,166 @@ void InNetActivityState::resetState()
 	initializeVals();
 }
 
-void InNetActivityState::stateRW(bool read, std::fstream &file)
+void InNetActivityState::stateRW(bool read, std::iostream &file)
+{
+	/* reads or writes the section tags, too */
+	class InNetStateRWVisitor : public StateRWVisitor
+	{
+		public:
+			InNetStateRWVisitor(InNetActivityState &state, bool read, std::iostream &file)
+				: StateRWVisitor(read, file), state(state) {}
+			bool section(int section_id) override
+			{
+				if (section_id == INNET_STATE_GR_COND) return state.grCondHeaderRW(read, file);
+				return state.ubcHeaderRW(read, file);
+			}
+		private:
+			InNetActivityState &state;
+	};
+	InNetStateRWVisitor rw(*this, read, file);
+	visitState(rw);
+}
+
+void InNetActivityState::visitState(StateVisitor &visitor)
 {
-	// TODO: implement better function for handling underlying pointer
-	rawBytesRW((char *)histMF.get(), num_mf * sizeof(uint8_t), read, file);
-	rawBytesRW((char *)apBufMF.get(), num_mf * sizeof(uint32_t), read, file);
-
-	rawBytesRW((char *)synWscalerGOtoGO.get(), num_go * sizeof(float), read, file);
-	rawBytesRW((char *)synWscalerGRtoGO.get(), num_go * sizeof(float), read, file);
-	rawBytesRW((char *)apGO.get(), num_go * sizeof(uint8_t), read, file);
-	rawBytesRW((char *)apBufGO.get(), num_go * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)vGO.get(), num_go * sizeof(float), read, file);
-	rawBytesRW((char *)vCoupleGO.get(), num_go * sizeof(float), read, file);
-	rawBytesRW((char *)threshCurGO.get(), num_go * sizeof(float), read, file);
-
-	rawBytesRW((char *)inputMFGO.get(), num_go * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)depAmpMFGO.get(), num_mf * sizeof(float), read, file);
-	rawBytesRW((char *)gi_MFtoGO.get(), num_mf * sizeof(float), read, file);
-	rawBytesRW((char *)gSum_MFGO.get(), num_go * sizeof(float), read, file);
-	rawBytesRW((char *)inputGOGO.get(), num_go * sizeof(float), read, file);
-
-	rawBytesRW((char *)gi_GOtoGO.get(), num_go * sizeof(float), read, file);
-	rawBytesRW((char *)depAmpGOGO.get(), num_go * sizeof(float), read, file);
-	rawBytesRW((char *)gSum_GOGO.get(), num_go * sizeof(float), read, file);
-	rawBytesRW((char *)depAmpGOGR.get(), num_go * sizeof(float), read, file);
-	rawBytesRW((char *)dynamicAmpGOGR.get(), num_go * sizeof(float), read, file);
+	visitor.visit("histMF", histMF.get(), num_mf);
+	visitor.visit("apBufMF", apBufMF.get(), num_mf);
+
+	visitor.visit("synWscalerGOtoGO", synWscalerGOtoGO.get(), num_go);
+	visitor.visit("synWscalerGRtoGO", synWscalerGRtoGO.get(), num_go);
+	visitor.visit("apGO", apGO.get(), num_go);
+	visitor.visit("apBufGO", apBufGO.get(), num_go);
+	visitor.visit("vGO", vGO.get(), num_go);
+	visitor.visit("vCoupleGO", vCoupleGO.get(), num_go);
+	visitor.visit("threshCurGO", threshCurGO.get(), num_go);
+
+	visitor.visit("inputMFGO", inputMFGO.get(), num_go);
+	visitor.visit("depAmpMFGO", depAmpMFGO.get(), num_mf);
+	visitor.visit("gi_MFtoGO", gi_MFtoGO.get(), num_mf);
+	visitor.visit("gSum_MFGO", gSum_MFGO.get(), num_go);
+	visitor.visit("inputGOGO", inputGOGO.get(), num_go);
+
+	visitor.visit("gi_GOtoGO", gi_GOtoGO.get(), num_go);
+	visitor.visit("depAmpGOGO", depAmpGOGO.get(), num_go);
+	visitor.visit("gSum_GOGO", gSum_GOGO.get(), num_go);
+	visitor.visit("depAmpGOGR", depAmpGOGR.get(), num_go);
+	visitor.visit("dynamicAmpGOGR", dynamicAmpGOGR.get(), num_go);
 	
-	rawBytesRW((char *)gNMDAMFGO.get(), num_go * sizeof(float), read, file);
-	rawBytesRW((char *)gNMDAIncMFGO.get(), num_go * sizeof(float), read, file);
-	rawBytesRW((char *)gGRGO.get(), num_go * sizeof(float), read, file);
-	rawBytesRW((char *)gGRGO_NMDA.get(), num_go * sizeof(float), read, file);
-
-	rawBytesRW((char *)depAmpMFGR.get(), num_mf * sizeof(float), read, file);
-	rawBytesRW((char *)apGR.get(), num_gr * sizeof(uint8_t), read, file);
-	rawBytesRW((char *)apBufGR.get(), num_gr * sizeof(uint32_t), read, file);
-
-	rawBytesRW((char *)gMFGR.get(), num_gr * max_num_p_gr_from_mf_to_gr * sizeof(float), read, file);
-	rawBytesRW((char *)gMFSumGR.get(), num_gr * sizeof(float), read, file);
-	rawBytesRW((char *)apMFtoGR.get(), num_gr * sizeof(float), read, file);
-
-	rawBytesRW((char *)gGOGR.get(), num_gr * max_num_p_gr_from_go_to_gr * sizeof(float), read, file);
-	rawBytesRW((char *)gGOSumGR.get(), num_gr * sizeof(float), read, file);
-	rawBytesRW((char *)threshGR.get(), num_gr * sizeof(float), read, file);
-	rawBytesRW((char *)vGR.get(), num_gr * sizeof(float), read, file);
-	rawBytesRW((char *)gKCaGR.get(), num_gr * sizeof(float), read, file);
-	rawBytesRW((char *)historyGR.get(), num_gr * sizeof(uint64_t), read, file);
+	visitor.visit("gNMDAMFGO", gNMDAMFGO.get(), num_go);
+	visitor.visit("gNMDAIncMFGO", gNMDAIncMFGO.get(), num_go);
+	visitor.visit("gGRGO", gGRGO.get(), num_go);
+	visitor.visit("gGRGO_NMDA", gGRGO_NMDA.get(), num_go);
+
+	visitor.visit("depAmpMFGR", depAmpMFGR.get(), num_mf);
+	visitor.visit("apGR", apGR.get(), num_gr);
+	visitor.visit("apBufGR", apBufGR.get(), num_gr);
+
+	if (visitor.section(INNET_STATE_GR_COND))
+	{
+		visitor.visit("gMFDirectGR", gMFDirectGR.get(), num_gr);
+		visitor.visit("gMFSpilloverGR", gMFSpilloverGR.get(), num_gr);
+		visitor.visit("gMFSumGR", gMFSumGR.get(), num_gr);
+		visitor.visit("apMFtoGR", apMFtoGR.get(), num_gr);
+
+		visitor.visit("gGODirectGR", gGODirectGR.get(), num_gr);
+		visitor.visit("gGOSpilloverGR", gGOSpilloverGR.get(), num_gr);
+		visitor.visit("gGOSumGR", gGOSumGR.get(), num_gr);
+	}
+	visitor.visit("threshGR", threshGR.get(), num_gr);
+	visitor.visit("vGR", vGR.get(), num_gr);
+	visitor.visit("gKCaGR", gKCaGR.get(), num_gr);
+	visitor.visit("historyGR", historyGR.get(), num_gr);
+
+	if (visitor.section(INNET_STATE_UBC) && numUBC > 0)
+	{
+		visitor.visit("apUBC", apUBC.get(), numUBC);
+		visitor.visit("apBufUBC", apBufUBC.get(), numUBC);
+		visitor.visit("vUBC", vUBC.get(), numUBC);
+		visitor.visit("threshUBC", threshUBC.get(), numUBC);
+		visitor.visit("gMFUBC", gMFUBC.get(), numUBC);
+		visitor.visit("gGOUBC", gGOUBC.get(), numUBC);
+		visitor.visit("gKUBC", gKUBC.get(), numUBC);
+	}
+}
+
+bool InNetActivityState::grCondHeaderRW(bool read, std::iostream &file)
+{
+	if (read) return !legacyConductancesRW(file);
+	rawBytesRW((char *)&AGG_COND_TAG, sizeof(uint32_t), read, file);
+	return true;
+}
+
+bool InNetActivityState::ubcHeaderRW(bool read, std::iostream &file)
+{
+	uint32_t tag = UBC_ACT_TAG;
+	if (read)
+	{
+		std::streampos start = file.tellg();
+		uint32_t fileNumUBC = 0;
+		rawBytesRW((char *)&tag, sizeof(uint32_t), read, file);
+		if (file && tag == UBC_ACT_TAG)
+		{
+			rawBytesRW((char *)&fileNumUBC, sizeof(uint32_t), read, file);
+		}
+		else
+		{
+			file.clear();
+			file.seekg(start);
+		}
+		if (fileNumUBC != numUBC)
+		{
+			numUBC = fileNumUBC;
+			allocateUBCMemory();
+		}
+	}
+	else if (numUBC > 0)
+	{
+		rawBytesRW((char *)&tag, sizeof(uint32_t), read, file);
+		rawBytesRW((char *)&numUBC, sizeof(uint32_t), read, file);
+	}
+	return numUBC > 0;
+}
+
+bool InNetActivityState::legacyConductancesRW(std::iostream &file)
+{
+	uint32_t tag;
+	rawBytesRW((char *)&tag, sizeof(uint32_t), true, file);
+	if (tag == AGG_COND_TAG) return false;
+
+	std::cout << "[INFO]: Collapsing legacy per-synapse GR conductances into per-cell totals..." << std::endl;
+	// the tag we just consumed was the first float of gMFGR
+	uint64_t numMFSyn = (uint64_t)num_gr * max_num_p_gr_from_mf_to_gr;
+	uint64_t numGOSyn = (uint64_t)num_gr * max_num_p_gr_from_go_to_gr;
+	std::unique_ptr<float[]> gSynGR = std::make_unique<float[]>(std::max(numMFSyn, numGOSyn));
+
+	memcpy(gSynGR.get(), &tag, sizeof(uint32_t));
+	rawBytesRW((char *)(gSynGR.get() + 1), (numMFSyn - 1) * sizeof(float), true, file);
+	for (int i = 0; i < num_gr; i++)
+	{
+		float gSum = 0.0;
+		for (int j = 0; j < max_num_p_gr_from_mf_to_gr; j++)
+		{
+			gSum += gSynGR[i * max_num_p_gr_from_mf_to_gr + j];
+		}
+		gMFDirectGR[i]    = gSum;
+		gMFSpilloverGR[i] = 0.0;
+	}
+	rawBytesRW((char *)gMFSumGR.get(), num_gr * sizeof(float), true, file);
+	rawBytesRW((char *)apMFtoGR.get(), num_gr * sizeof(float), true, file);
+
+	rawBytesRW((char *)gSynGR.get(), numGOSyn * sizeof(float), true, file);
+	for (int i = 0; i < num_gr; i++)
+	{
+		float gSum = 0.0;
+		for (int j = 0; j < max_num_p_gr_from_go_to_gr; j++)
+		{
+			gSum += gSynGR[i * max_num_p_gr_from_go_to_gr + j];
+		}
+		gGODirectGR[i]    = gSum;
+		gGOSpilloverGR[i] = 0.0;
+	}
+	rawBytesRW((char *)gGOSumGR.get(), num_gr * sizeof(float), true, file);
+	return true;
 }
 
 void InNetActivityState::allocateMemory()
@@ -120,19 +247,36 @@ void InNetActivityState::allocateMemory()
 	gGRGO_NMDA     = std::make_unique<float[]>(num_go);
 
 	depAmpMFGR     = std::make_unique<float[]>(num_mf);
-	apGR           = std::make_unique<uint8_t[]>(num_gr);
-	apBufGR        = std::make_unique<uint32_t[]>(num_gr);
-
-	gMFGR          = std::make_unique<float[]>(num_gr * max_num_p_gr_from_mf_to_gr);
-	gMFSumGR       = std::make_unique<float[]>(num_gr);
-	apMFtoGR       = std::make_unique<float[]>(num_gr);
-
-	gGOGR          = std::make_unique<float[]>(num_gr * max_num_p_gr_from_go_to_gr);
-	gGOSumGR       = std::make_unique<float[]>(num_gr);
-	threshGR       = std::make_unique<float[]>(num_gr);
-	vGR            = std::make_unique<float[]>(num_gr);
-	gKCaGR         = std::make_unique<float[]>(num_gr);
-	historyGR      = std::make_unique<uint64_t[]>(num_gr);
+	// gr arrays are filled in parallel so their pages are placed where they are first touched
+	apGR           = make_placed_array<uint8_t>(num_gr);
+	apBufGR        = make_placed_array<uint32_t>(num_gr);
+
+	gMFDirectGR    = make_placed_array<float>(num_gr);
+	gMFSpilloverGR = make_placed_array<float>(num_gr);
+	gMFSumGR       = make_placed_array<float>(num_gr);
+	apMFtoGR       = make_placed_array<float>(num_gr);
+
+	gGODirectGR    = make_placed_array<float>(num_gr);
+	gGOSpilloverGR = make_placed_array<float>(num_gr);
+	gGOSumGR       = make_placed_array<float>(num_gr);
+	threshGR       = make_placed_array<float>(num_gr);
+	vGR            = make_placed_array<float>(num_gr);
+	gKCaGR         = make_placed_array<float>(num_gr);
+	historyGR      = make_placed_array<uint64_t>(num_gr);
+
+	allocateUBCMemory();
+}
+
+void InNetActivityState::allocateUBCMemory()
+{
+	// a count of 0 frees them
+	apUBC     = numUBC ? std::make_unique<uint8_t[]>(numUBC) : nullptr;
+	apBufUBC  = numUBC ? std::make_unique<uint32_t[]>(numUBC) : nullptr;
+	vUBC      = numUBC ? std::make_unique<float[]>(numUBC) : nullptr;
+	threshUBC = numUBC ? std::make_unique<float[]>(numUBC) : nullptr;
+	gMFUBC    = numUBC ? std::make_unique<float[]>(numUBC) : nullptr;
+	gGOUBC    = numUBC ? std::make_unique<float[]>(numUBC) : nullptr;
+	gKUBC     = numUBC ? std::make_unique<float[]>(numUBC) : nullptr;
 }
 
 void InNetActivityState::initializeVals()
@@ -152,7 +296,21 @@ void InNetActivityState::initializeVals()
 	std::fill(threshCurGO.get(), threshCurGO.get() + num_go, threshRestGO);
 
 	// gr
-	std::fill(vGR.get(), vGR.get() + num_gr, eLeakGR);
-	std::fill(threshGR.get(), threshGR.get() + num_gr, threshRestGR);
+	parallel_fill(vGR.get(), num_gr, eLeakGR);
+	parallel_fill(threshGR.get(), num_gr, threshRestGR);
+
+	initializeUBCVals();
+}
+
+void InNetActivityState::initializeUBCVals()
+{
+	// ubc, which share the granule's membrane constants
+	std::fill(apUBC.get(), apUBC.get() + numUBC, 0);
+	std::fill(apBufUBC.get(), apBufUBC.get() + numUBC, 0);
+	std::fill(vUBC.get(), vUBC.get() + numUBC, eLeakGR);
+	std::fill(threshUBC.get(), threshUBC.get() + numUBC, threshRestGR);
+	std::fill(gMFUBC.get(), gMFUBC.get() + numUBC, 0.0);
+	std::fill(gGOUBC.get(), gGOUBC.get() + numUBC, 0.0);
+	std::fill(gKUBC.get(), gKUBC.get() + numUBC, 0.0);
 }
 
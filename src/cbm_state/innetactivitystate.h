@@ -12,20 +12,26 @@
 #include <fstream>
 #include <cstdint>
 #include "file_utility.h"
-#include "connectivityparams.h"
-#include "activityparams.h"
+#include "simparams.h"
+#include "state_visitor.h"
 
-class InNetActivityState
+/* tagged sections of the saved layout, see visitState */
+enum innet_state_section {INNET_STATE_GR_COND, INNET_STATE_UBC};
+
+class InNetActivityState : protected sim_params
 {
 public:
-	InNetActivityState();
-	InNetActivityState(std::fstream &infile);
+	InNetActivityState(const sim_params &params, uint32_t numUBC = 0);
+	InNetActivityState(const sim_params &params, std::iostream &infile);
 
 	~InNetActivityState();
 
-	void readState(std::fstream &infile);
-	void writeState(std::fstream &outfile);
+	void readState(std::iostream &infile);
+	void writeState(std::iostream &outfile);
 	void resetState();
+	/* visits every array stateRW reads and writes, in file order. the GR
+	 * conductances and the UBCs are sections, as their layout is tagged */
+	void visitState(StateVisitor &visitor);
 
 	//mossy fiber
 	std::unique_ptr<uint8_t[]> histMF{nullptr};
@@ -62,28 +68,49 @@ public:
 	std::unique_ptr<float[]> depAmpMFGR{nullptr};
 	std::unique_ptr<uint8_t[]> apGR{nullptr}; // <- pulled via getGPUData
 	std::unique_ptr<uint32_t[]> apBufGR{nullptr};
-	// NOTE: gMFGR was 2D array, now 1D for smart ptr
-	// access using indices 0 <= i < NUM_GR, 0 <= j < MAX_NUM_P_GR_FROM_MF_TO_GR like so:
-	// i * NUM_GR + j
-	std::unique_ptr<float[]> gMFGR{nullptr};
+	// NOTE: the per-synapse gMFGR (NUM_GR x MAX_NUM_P_GR_FROM_MF_TO_GR) and gGOGR
+	// matrices were replaced by per-cell totals split into their direct and
+	// spillover components, which is all the GR kernels integrate. older files
+	// are collapsed on read, see legacyConductancesRW
+	std::unique_ptr<float[]> gMFDirectGR{nullptr};
+	std::unique_ptr<float[]> gMFSpilloverGR{nullptr};
 	std::unique_ptr<float[]> gMFSumGR{nullptr};
-	// NOTE: removed gMFDirectGR and gMFSpilloverGR as we only used to 
-	// initialize GPU vars of :similar: name
-	// also removed gGODirectGR and gGOSpillover
 	std::unique_ptr<float[]> apMFtoGR{nullptr};
 	// removed gNMDA, gNMDAIncGR, gLeakGR, depAmpMFtoGR, dynamicAmpGOtoGR as were
 	// only used to initialize gpu vars
 
-	// NOTE: gGOGR used to be 2D array with dims NUM_GR and MAX_NUM_P_GR_FROM_GO_TO_GR
-	std::unique_ptr<float[]> gGOGR{nullptr};
+	std::unique_ptr<float[]> gGODirectGR{nullptr};
+	std::unique_ptr<float[]> gGOSpilloverGR{nullptr};
 	std::unique_ptr<float[]> gGOSumGR{nullptr};
 	std::unique_ptr<float[]> threshGR{nullptr};
 	std::unique_ptr<float[]> vGR{nullptr};
 	std::unique_ptr<float[]> gKCaGR{nullptr};
 	std::unique_ptr<uint64_t[]> historyGR{nullptr};
 
+	//unipolar brush cells, as many as the connectivity has
+	uint32_t numUBC = 0;
+	std::unique_ptr<uint8_t[]> apUBC{nullptr};
+	std::unique_ptr<uint32_t[]> apBufUBC{nullptr};
+	std::unique_ptr<float[]> vUBC{nullptr};
+	std::unique_ptr<float[]> threshUBC{nullptr};
+	std::unique_ptr<float[]> gMFUBC{nullptr};
+	std::unique_ptr<float[]> gGOUBC{nullptr};
+	std::unique_ptr<float[]> gKUBC{nullptr};
+
 private:
-	void stateRW(bool read, std::fstream &file);
+	void stateRW(bool read, std::iostream &file);
+	/* the tag before the GR conductances. returns false if they were read
+	 * from a legacy file instead, see legacyConductancesRW */
+	bool grCondHeaderRW(bool read, std::iostream &file);
+	/* the UBC block follows the rest, tagged, only when there are UBCs. on
+	 * read, reallocates the UBC arrays to the file's count. returns whether
+	 * there are UBCs to read or write */
+	bool ubcHeaderRW(bool read, std::iostream &file);
+	void allocateUBCMemory();
+	void initializeUBCVals();
+	/* reads the GR conductance block of a file written before the per-cell
+	 * layout. returns false, having consumed only the layout tag, for new files */
+	bool legacyConductancesRW(std::iostream &file);
 	void allocateMemory();
 	void initializeVals();
 };
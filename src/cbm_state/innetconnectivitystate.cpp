@@ -4,11 +4,19 @@
  *  Created on: Nov 6, 2012
  *      Author: consciousness
  */
-#include "connectivityparams.h"
+#include <vector>
+
+#include "simparams.h"
 #include "innetconnectivitystate.h"
 
+/* written after the other tables when there are UBCs. as an int it is no cell
+ * index, and the activity state that follows starts with 0/1 bytes, so a file
+ * without it has no UBCs */
+static const uint32_t UBC_CON_TAG = 0x7FC0BC01;
+
 
-InNetConnectivityState::InNetConnectivityState(int randSeed)
+InNetConnectivityState::InNetConnectivityState(const sim_params &params, int randSeed)
+	: sim_params(params)
 {
 	CRandomSFMT0 randGen(randSeed);
 
@@ -45,10 +53,17 @@ InNetConnectivityState::InNetConnectivityState(int randSeed)
 	std::cout << "[INFO]: Assigning GR delays" << std::endl;
 	assignGRDelays();
 
+	if (num_ubc > 0)
+	{
+		std::cout << "[INFO]: Connecting MF, UBC and GL" << std::endl;
+		connectMFUBCGL(randGen);
+	}
+
 	std::cout << "[INFO]: Finished making innet connections." << std::endl;
 }
 
-InNetConnectivityState::InNetConnectivityState(std::fstream &infile)
+InNetConnectivityState::InNetConnectivityState(const sim_params &params, std::iostream &infile)
+	: sim_params(params)
 {
 	allocateMemory();
 	stateRW(true, infile);
@@ -56,12 +71,12 @@ InNetConnectivityState::InNetConnectivityState(std::fstream &infile)
 
 InNetConnectivityState::~InNetConnectivityState() {deallocMemory();}
 
-void InNetConnectivityState::readState(std::fstream &infile)
+void InNetConnectivityState::readState(std::iostream &infile)
 {
 	stateRW(true, infile);
 }
 
-void InNetConnectivityState::writeState(std::fstream &outfile)
+void InNetConnectivityState::writeState(std::iostream &outfile)
 {
 	stateRW(false, outfile);
 }
@@ -284,9 +299,36 @@ void InNetConnectivityState::deallocMemory()
 	delete2DArray<int>(pGRfromGOtoGR);
 	delete[] numpGRfromMFtoGR;
 	delete2DArray<int>(pGRfromMFtoGR);
+
+	deallocUBCMemory();
+}
+
+void InNetConnectivityState::allocateUBCMemory()
+{
+	if (numUBC == 0) return;
+	pUBCfromMFtoUBC    = new int[numUBC];
+	pUBCfromGLtoUBC    = new int[numUBC];
+	pUBCfromUBCtoMF    = new int[numUBC];
+	numpUBCfromUBCtoGL = new int[numUBC]();
+	pUBCfromUBCtoGL    = allocate2DArray<int>(numUBC, max_num_p_mf_from_mf_to_gl);
+}
+
+void InNetConnectivityState::deallocUBCMemory()
+{
+	if (numUBC == 0) return;
+	delete[] pUBCfromMFtoUBC;
+	delete[] pUBCfromGLtoUBC;
+	delete[] pUBCfromUBCtoMF;
+	delete[] numpUBCfromUBCtoGL;
+	delete2DArray<int>(pUBCfromUBCtoGL);
+	pUBCfromMFtoUBC    = NULL;
+	pUBCfromGLtoUBC    = NULL;
+	pUBCfromUBCtoMF    = NULL;
+	numpUBCfromUBCtoGL = NULL;
+	pUBCfromUBCtoGL    = NULL;
 }
 
-void InNetConnectivityState::stateRW(bool read, std::fstream &file)
+void InNetConnectivityState::stateRW(bool read, std::iostream &file)
 {
 	//glomerulus
 	rawBytesRW((char *)haspGLfromMFtoGL, num_gl * sizeof(bool), read, file);
@@ -373,6 +415,46 @@ void InNetConnectivityState::stateRW(bool read, std::fstream &file)
 	rawBytesRW((char *)numpGRfromMFtoGR, num_gr * sizeof(int), read, file);
 	rawBytesRW((char *)pGRfromMFtoGR[0],
 		num_gr * max_num_p_gr_from_mf_to_gr * sizeof(int), read, file);
+
+	ubcStateRW(read, file);
+}
+
+void InNetConnectivityState::ubcStateRW(bool read, std::iostream &file)
+{
+	uint32_t tag = UBC_CON_TAG;
+	if (read)
+	{
+		std::streampos start = file.tellg();
+		uint32_t fileNumUBC = 0;
+		rawBytesRW((char *)&tag, sizeof(uint32_t), read, file);
+		if (file && tag == UBC_CON_TAG)
+		{
+			rawBytesRW((char *)&fileNumUBC, sizeof(uint32_t), read, file);
+		}
+		else
+		{
+			file.clear();
+			file.seekg(start);
+		}
+		if (fileNumUBC != numUBC)
+		{
+			deallocUBCMemory();
+			numUBC = fileNumUBC;
+			allocateUBCMemory();
+		}
+	}
+	if (numUBC == 0) return;
+	if (!read)
+	{
+		rawBytesRW((char *)&tag, sizeof(uint32_t), read, file);
+		rawBytesRW((char *)&numUBC, sizeof(uint32_t), read, file);
+	}
+	rawBytesRW((char *)pUBCfromMFtoUBC, numUBC * sizeof(int), read, file);
+	rawBytesRW((char *)pUBCfromGLtoUBC, numUBC * sizeof(int), read, file);
+	rawBytesRW((char *)pUBCfromUBCtoMF, numUBC * sizeof(int), read, file);
+	rawBytesRW((char *)numpUBCfromUBCtoGL, numUBC * sizeof(int), read, file);
+	rawBytesRW((char *)pUBCfromUBCtoGL[0],
+		numUBC * max_num_p_mf_from_mf_to_gl * sizeof(int), read, file);
 }
 
 
@@ -472,6 +554,75 @@ void InNetConnectivityState::connectMFGL_noUBC()
 	std::cout << "[INFO]: Correct number: " << num_gl << std::endl;
 }
 
+/*
+ * UBCs lie on the ubc_x by ubc_y grid. A UBC's axon stands in for one input
+ * fibre: it takes over that fibre's glomeruli, so everything wired to them
+ * downstream (GR, GO) is driven by the UBC instead, and the fibre's own
+ * activity only reaches the nuclei. Its brush sits in a glomerulus near it of
+ * any other fibre, which may itself be a UBC axon, chaining the two.
+ */
+void InNetConnectivityState::connectMFUBCGL(CRandomSFMT &randGen)
+{
+	if (ubc_x * ubc_y != num_ubc || num_ubc > num_mf / 2)
+	{
+		std::cerr << "[ERROR]: UBCs need ubc_x * ubc_y == num_ubc and at most half as many UBCs as MFs. "
+				  << "Building without UBCs." << std::endl;
+		return;
+	}
+	numUBC = num_ubc;
+	allocateUBCMemory();
+
+	// each axon takes over the fibre at the UBC's position, or the next free one
+	std::vector<bool> isUBCAxon(num_mf, false);
+	for (int i = 0; i < num_ubc; i++)
+	{
+		int mfPosX = (int)((i % ubc_x) * (float)mf_x / (float)ubc_x);
+		int mfPosY = (int)((i / ubc_x) * (float)mf_y / (float)ubc_y);
+		int mfInd  = mfPosY * mf_x + mfPosX;
+		while (isUBCAxon[mfInd]) mfInd = (mfInd + 1) % num_mf;
+		isUBCAxon[mfInd] = true;
+
+		pUBCfromUBCtoMF[i]    = mfInd;
+		numpUBCfromUBCtoGL[i] = numpMFfromMFtoGL[mfInd];
+		for (int j = 0; j < numpMFfromMFtoGL[mfInd]; j++)
+		{
+			pUBCfromUBCtoGL[i][j] = pMFfromMFtoGL[mfInd][j];
+		}
+	}
+
+	int numChained = 0;
+	for (int i = 0; i < num_ubc; i++)
+	{
+		int glPosX = (int)((i % ubc_x) * (float)gl_x / (float)ubc_x);
+		int glPosY = (int)((i / ubc_x) * (float)gl_y / (float)ubc_y);
+		int glInd  = -1;
+		for (int attempt = 0; attempt < max_mf_to_gl_attempts && glInd < 0; attempt++)
+		{
+			int destPosX = glPosX + randGen.IRandom(-span_mf_to_gl_x / 2, span_mf_to_gl_x / 2);
+			int destPosY = glPosY + randGen.IRandom(-span_mf_to_gl_y / 2, span_mf_to_gl_y / 2);
+			destPosX = (destPosX % gl_x + gl_x) % gl_x;
+			destPosY = (destPosY % gl_y + gl_y) % gl_y;
+
+			int destIndex = destPosY * gl_x + destPosX;
+			if (haspGLfromMFtoGL[destIndex] && pGLfromMFtoGL[destIndex] != pUBCfromUBCtoMF[i])
+				glInd = destIndex;
+		}
+		// crowded spans fall back to the next suitable glomerulus
+		for (int j = 0; glInd < 0 && j < num_gl; j++)
+		{
+			int destIndex = (glPosY * gl_x + glPosX + j) % num_gl;
+			if (haspGLfromMFtoGL[destIndex] && pGLfromMFtoGL[destIndex] != pUBCfromUBCtoMF[i])
+				glInd = destIndex;
+		}
+		pUBCfromGLtoUBC[i] = glInd;
+		pUBCfromMFtoUBC[i] = pGLfromMFtoGL[glInd];
+		numChained += isUBCAxon[pUBCfromMFtoUBC[i]];
+	}
+
+	std::cout << "[INFO]: Connected " << num_ubc << " UBCs, " << numChained
+			  << " of them driven by another UBC." << std::endl;
+}
+
 void InNetConnectivityState::connectGLGR(CRandomSFMT &randGen)
 {
 	float gridXScaleStoD = (float)gr_x / (float)gl_x;
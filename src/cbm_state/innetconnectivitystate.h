@@ -20,17 +20,18 @@
 #include <cstdint>
 #include "dynamic2darray.h"
 #include "sfmt.h"
+#include "simparams.h"
 
-class InNetConnectivityState
+class InNetConnectivityState : protected sim_params
 {
 public:
 	InNetConnectivityState();
-	InNetConnectivityState(int randSeed);
-	InNetConnectivityState(std::fstream &infile);
+	InNetConnectivityState(const sim_params &params, int randSeed);
+	InNetConnectivityState(const sim_params &params, std::iostream &infile);
 	~InNetConnectivityState();
 
-	void readState(std::fstream &infile);
-	void writeState(std::fstream &outfile);
+	void readState(std::iostream &infile);
+	void writeState(std::iostream &outfile);
 
 	//glomerulus
 	bool *haspGLfromMFtoGL;
@@ -85,13 +86,27 @@ public:
 	int *numpGRfromMFtoGR;
 	int **pGRfromMFtoGR;
 
+	//unipolar brush cells, see connectMFUBCGL. numUBC is 0 unless the build
+	//file turned them on, and the arrays below only exist while it is not
+	uint32_t numUBC = 0;
+	int *pUBCfromMFtoUBC = NULL; // input fibre of the brush: an MF, or another UBC's axon
+	int *pUBCfromGLtoUBC = NULL; // glomerulus the brush sits in
+	int *pUBCfromUBCtoMF = NULL; // input fibre whose glomeruli the axon takes over
+	int *numpUBCfromUBCtoGL = NULL;
+	int **pUBCfromUBCtoGL = NULL;
+
 protected:
 	void allocateMemory();
 	void initializeVals();
 	void deallocMemory();
-	void stateRW(bool read, std::fstream &file);
+	void stateRW(bool read, std::iostream &file);
+	void allocateUBCMemory();
+	void deallocUBCMemory();
+	/* the UBC tables follow the others, tagged, only when there are UBCs */
+	void ubcStateRW(bool read, std::iostream &file);
 
 	void connectMFGL_noUBC();
+	void connectMFUBCGL(CRandomSFMT &randGen);
 	void connectGLGR(CRandomSFMT &randGen);
 	void connectGRGO();
 	void connectGOGL(CRandomSFMT &randGen);
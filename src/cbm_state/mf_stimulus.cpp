@@ -0,0 +1,229 @@
+/*
+ * File: mf_stimulus.cpp
+ *
+ * Description:
+ *     This file implements the function prototypes in mf_stimulus.h
+ *
+ * Implementation Notes:
+ *     Timelines are built once per distinct trial name, as trials of the same
+ *     name have the same channel timing. Tables live in a std::map keyed by
+ *     channel mask, whose nodes never move, so segments can keep pointers to
+ *     them. The legacy channel is the set of MFs whose tonic A rate differs from
+ *     their background rate, so its table is ECMFPopulation's tonic A array,
+ *     value for value.
+ */
+#include <iostream>
+#include <algorithm>
+
+#include "sfmt.h"
+#include "mf_stimulus.h"
+
+static float section_float(parsed_var_section &section, std::string name, float default_val)
+{
+	auto entry = section.param_map.find(name);
+	if (entry == section.param_map.end()) return default_val;
+	return std::stof(entry->second.value);
+}
+
+static int trial_int(std::map<std::string, variable> &trial_vars, std::string name, int default_val)
+{
+	auto entry = trial_vars.find(name);
+	if (entry == trial_vars.end()) return default_val;
+	return std::stoi(entry->second.value);
+}
+
+MFStimulus::MFStimulus(parsed_sess_file &s_file, trials_data &td, uint32_t trial_ts,
+	uint32_t onset_offset, int seed) : seed(seed)
+{
+	auto section = s_file.parsed_var_sections.find("stimulus");
+	from_section = (section != s_file.parsed_var_sections.end());
+	if (from_section)
+	{
+		parsed_var_section &sec = section->second;
+		uint32_t num_channels = (uint32_t)section_float(sec, "num_channels", 0);
+		if (num_channels > MAX_STIM_CHANNELS)
+		{
+			std::cerr << "[ERROR]: " << num_channels << " stimulus channels declared, using the first "
+					  << MAX_STIM_CHANNELS << ".\n";
+			num_channels = MAX_STIM_CHANNELS;
+		}
+		this->seed = (int)section_float(sec, "seed", seed);
+		channels.resize(num_channels);
+		for (uint32_t k = 0; k < num_channels; k++)
+		{
+			std::string ch = "ch" + std::to_string(k);
+			channels[k].frac         = section_float(sec, ch + "_frac", 0.0);
+			channels[k].freq_min     = section_float(sec, ch + "_freq_min", 100.0);
+			channels[k].freq_max     = section_float(sec, ch + "_freq_max", 110.0);
+			channels[k].overlap_with = (int)section_float(sec, ch + "_overlap_with", -1);
+			channels[k].overlap_frac = section_float(sec, ch + "_overlap_frac", 0.0);
+		}
+	}
+	else channels.resize(1);
+
+	std::map<std::string, uint32_t> timeline_of;
+	trial_timeline.resize(td.num_trials);
+	for (uint32_t t = 0; t < td.num_trials; t++)
+	{
+		auto known = timeline_of.find(td.trial_names[t]);
+		if (known != timeline_of.end())
+		{
+			trial_timeline[t] = known->second;
+			continue;
+		}
+		auto &trial_vars = s_file.parsed_trial_info.trial_map[td.trial_names[t]];
+		uint32_t on[MAX_STIM_CHANNELS] = {}, off[MAX_STIM_CHANNELS] = {};
+		std::vector<uint32_t> bounds = {0, trial_ts};
+		for (uint32_t k = 0; k < channels.size(); k++)
+		{
+			std::string use_name   = "use_ch" + std::to_string(k);
+			std::string onset_name = "ch" + std::to_string(k) + "_onset";
+			std::string len_name   = "ch" + std::to_string(k) + "_len";
+			if (k == 0 && trial_vars.find(use_name) == trial_vars.end())
+			{
+				use_name   = "use_cs";
+				onset_name = "cs_onset";
+				len_name   = "cs_len";
+			}
+			if (trial_int(trial_vars, use_name, 0) != 1) continue;
+			on[k]  = std::min(onset_offset + trial_int(trial_vars, onset_name, 0), trial_ts);
+			off[k] = std::min(on[k] + trial_int(trial_vars, len_name, 0), trial_ts);
+			bounds.push_back(on[k]);
+			bounds.push_back(off[k]);
+		}
+		std::sort(bounds.begin(), bounds.end());
+		bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+		std::vector<struct mf_segment> timeline;
+		for (uint32_t b = 0; b + 1 < bounds.size(); b++)
+		{
+			uint32_t mask = 0;
+			for (uint32_t k = 0; k < channels.size(); k++)
+			{
+				if (bounds[b] >= on[k] && bounds[b] < off[k]) mask |= 1u << k;
+			}
+			if (!timeline.empty() && timeline.back().channels == mask) timeline.back().end_ts = bounds[b + 1];
+			else timeline.push_back({ bounds[b + 1], mask, NULL });
+		}
+		timeline_of[td.trial_names[t]] = timelines.size();
+		trial_timeline[t] = timelines.size();
+		timelines.push_back(timeline);
+	}
+}
+
+void MFStimulus::legacy_channel(ECMFPopulation &mf_pop, uint32_t num_mf)
+{
+	const float *bg    = mf_pop.getMFBG();
+	const float *tonic = mf_pop.getMFInCSTonicA();
+	for (uint32_t i = 0; i < num_mf; i++)
+	{
+		if (tonic[i] != bg[i])
+		{
+			channels[0].mfs.push_back(i);
+			channels[0].freqs.push_back(tonic[i]);
+		}
+	}
+}
+
+void MFStimulus::draw_channels(ECMFPopulation &mf_pop, uint32_t num_mf)
+{
+	CRandomSFMT0 randGen(seed);
+	const float *bg = mf_pop.getMFBG();
+	const bool *isContext = mf_pop.getContextMFInd();
+	const bool *isPhasic  = mf_pop.getPhasicMFInd();
+	const bool *isImport  = mf_pop.getImportMFInd();
+
+	std::vector<bool> taken(num_mf);
+	uint32_t num_free = 0;
+	for (uint32_t i = 0; i < num_mf; i++)
+	{
+		taken[i] = bg[i] < 0 || isContext[i] || isPhasic[i] || isImport[i];
+		num_free += !taken[i];
+	}
+
+	for (uint32_t k = 0; k < channels.size(); k++)
+	{
+		struct stim_channel &ch = channels[k];
+		uint32_t num_ch_mf = ch.frac * num_mf;
+		uint32_t num_shared = 0;
+		if (ch.overlap_with >= (int)k)
+		{
+			std::cerr << "[ERROR]: Stimulus channel " << k << " can only overlap an earlier channel. Ignoring its overlap.\n";
+		}
+		else if (ch.overlap_with >= 0)
+		{
+			/* a partial shuffle of the other channel's MFs picks the shared ones */
+			std::vector<uint32_t> pool = channels[ch.overlap_with].mfs;
+			num_shared = std::min((uint32_t)(ch.overlap_frac * num_ch_mf), (uint32_t)pool.size());
+			for (uint32_t j = 0; j < num_shared; j++)
+			{
+				std::swap(pool[j], pool[randGen.IRandom(j, pool.size() - 1)]);
+				ch.mfs.push_back(pool[j]);
+			}
+		}
+		uint32_t num_own = num_ch_mf - num_shared;
+		if (num_own > num_free)
+		{
+			std::cerr << "[ERROR]: Stimulus channel " << k << " needs " << num_own << " MFs of its own but only "
+					  << num_free << " are left. Using those.\n";
+			num_own = num_free;
+		}
+		for (uint32_t j = 0; j < num_own; j++)
+		{
+			while (true)
+			{
+				int mfInd = randGen.IRandom(0, num_mf - 1);
+				if (taken[mfInd]) continue;
+				taken[mfInd] = true;
+				ch.mfs.push_back(mfInd);
+				break;
+			}
+		}
+		num_free -= num_own;
+		for (uint32_t j = 0; j < ch.mfs.size(); j++)
+		{
+			ch.freqs.push_back(randGen.Random() * (ch.freq_max - ch.freq_min) + ch.freq_min);
+		}
+	}
+}
+
+void MFStimulus::compile(ECMFPopulation &mf_pop, uint32_t num_mf)
+{
+	if (from_section) draw_channels(mf_pop, num_mf);
+	else legacy_channel(mf_pop, num_mf);
+
+	const float *bg = mf_pop.getMFBG();
+	for (auto &timeline : timelines)
+	{
+		for (auto &seg : timeline)
+		{
+			auto table = tables.find(seg.channels);
+			if (table == tables.end())
+			{
+				std::vector<float> freqs(bg, bg + num_mf);
+				for (uint32_t k = 0; k < channels.size(); k++)
+				{
+					if (!(seg.channels & (1u << k))) continue;
+					for (uint32_t j = 0; j < channels[k].mfs.size(); j++)
+					{
+						freqs[channels[k].mfs[j]] = channels[k].freqs[j];
+					}
+				}
+				table = tables.emplace(seg.channels, std::move(freqs)).first;
+			}
+			seg.freqs = table->second.data();
+		}
+	}
+	std::cout << "[INFO]: Compiled " << channels.size() << " stimulus channel(s) into "
+			  << tables.size() << " MF frequency table(s).\n";
+}
+
+uint32_t MFStimulus::getNumChannels()
+{
+	return channels.size();
+}
+
+const struct mf_segment *MFStimulus::trialSegments(uint32_t trial)
+{
+	return timelines[trial_timeline[trial]].data();
+}
@@ -0,0 +1,101 @@
+/*
+ * File: mf_stimulus.h
+ *
+ * Description:
+ *     Interface for the mossy fiber stimulus model. A session drives the MFs
+ *     through any number of input channels, each a subset of the MFs that fire
+ *     at their own elevated rates while the channel is on. Without a stimulus
+ *     section the session has one channel, its CS, which drives the tonic A MFs
+ *     of ECMFPopulation exactly as before. Otherwise the section declares the
+ *     channels. Every variable but the channel count is optional:
+ *
+ *         begin section stimulus
+ *             int num_channels 2
+ *             int seed 7                // default: the MF seed (-S)
+ *             float ch0_frac 0.05       // fraction of all MFs in channel 0
+ *             float ch0_freq_min 100.0  // its MFs' rates while it is on, Hz
+ *             float ch0_freq_max 110.0
+ *             float ch1_frac 0.05
+ *             float ch1_freq_min 100.0
+ *             float ch1_freq_max 110.0
+ *             int ch1_overlap_with 0    // an earlier channel to share MFs with
+ *             float ch1_overlap_frac 0.2 // the fraction of channel 1's MFs shared
+ *         end
+ *
+ *     Channel MFs are drawn from the MFs that are neither context, phasic,
+ *     import nor active collateral MFs, and channels do not share MFs except
+ *     through overlaps. An MF in two channels that are on together fires at the
+ *     rate of the higher numbered channel.
+ *
+ *     A trial turns channel k on with 'int use_ch<k> 1', 'int ch<k>_onset' and
+ *     'int ch<k>_len', in steps as for the CS. Channel 0 falls back to the
+ *     trial's use_cs, cs_onset and cs_len, so existing sessions need no edits.
+ *
+ *     Each trial is cut into segments at every channel onset and offset. Every
+ *     distinct set of channels that is on together is compiled into one MF
+ *     frequency table when the simulation is initialized, and each segment
+ *     points at the table of the channels on during it. The step loop only
+ *     moves on to the next segment when the current one ends, and hands its
+ *     table to the Poisson generator as is.
+ */
+#ifndef MF_STIMULUS_H_
+#define MF_STIMULUS_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+#include "file_parse.h"
+#include "ecmfpopulation.h"
+
+/* channels that are on together are keyed by a bit mask */
+#define MAX_STIM_CHANNELS 32
+
+struct stim_channel
+{
+	float frac;
+	float freq_min;
+	float freq_max;
+	int overlap_with; /* -1 for none */
+	float overlap_frac;
+	std::vector<uint32_t> mfs;
+	std::vector<float> freqs; /* one per entry of mfs */
+};
+
+struct mf_segment
+{
+	uint32_t end_ts;    /* the segment covers the steps up to end_ts, exclusive */
+	uint32_t channels;  /* mask of the channels on during the segment */
+	const float *freqs; /* set by MFStimulus::compile */
+};
+
+class MFStimulus
+{
+	public:
+		/* reads the channels and every trial's timeline from s_file. onset_offset
+		 * is added to all onsets, as for the CS. seed is the default seed */
+		MFStimulus(parsed_sess_file &s_file, trials_data &td, uint32_t trial_ts,
+			uint32_t onset_offset, int seed);
+
+		/* draws the channels' MFs and rates and builds the frequency tables */
+		void compile(ECMFPopulation &mf_pop, uint32_t num_mf);
+
+		uint32_t getNumChannels();
+		/* the segments of trial, in order. the last ends at the trial's end */
+		const struct mf_segment *trialSegments(uint32_t trial);
+
+	private:
+		bool from_section;
+		int seed;
+		std::vector<struct stim_channel> channels;
+		/* segments of each distinct trial, and the index of each trial's */
+		std::vector<std::vector<struct mf_segment>> timelines;
+		std::vector<uint32_t> trial_timeline;
+		std::map<uint32_t, std::vector<float>> tables;
+
+		void legacy_channel(ECMFPopulation &mf_pop, uint32_t num_mf);
+		void draw_channels(ECMFPopulation &mf_pop, uint32_t num_mf);
+};
+
+#endif /* MF_STIMULUS_H_ */
@@ -9,20 +9,22 @@
 #include <algorithm> /* std::fill */
 
 #include "file_utility.h"
+#include "parallel_init.h"
 #include "sfmt.h"
-#include "connectivityparams.h"
-#include "activityparams.h"
+#include "simparams.h"
 #include "mzoneactivitystate.h"
 
 MZoneActivityState::MZoneActivityState() {}
 
-MZoneActivityState::MZoneActivityState(int randSeed)
+MZoneActivityState::MZoneActivityState(const sim_params &params, int randSeed)
+	: sim_params(params)
 {
 	allocateMemory();
 	initializeVals(randSeed);
 }
 
-MZoneActivityState::MZoneActivityState(std::fstream &infile)
+MZoneActivityState::MZoneActivityState(const sim_params &params, std::iostream &infile)
+	: sim_params(params)
 {
 	allocateMemory();
 	stateRW(true, infile);
@@ -30,12 +32,12 @@ MZoneActivityState::MZoneActivityState(std::fstream &infile)
 
 MZoneActivityState::~MZoneActivityState() {}
 
-void MZoneActivityState::readState(std::fstream &infile)
+void MZoneActivityState::readState(std::iostream &infile)
 {
 	stateRW(true, infile);
 }
 
-void MZoneActivityState::writeState(std::fstream &outfile)
+void MZoneActivityState::writeState(std::iostream &outfile)
 {
 	stateRW(false, outfile);
 }
@@ -63,7 +65,7 @@ void MZoneActivityState::allocateMemory()
 	apBufPC       = std::make_unique<uint32_t[]>(num_pc);
 	inputBCPC     = std::make_unique<uint32_t[]>(num_pc);
 	inputSCPC     = std::make_unique<uint32_t[]>(num_pc);
-	pfSynWeightPC = std::make_unique<float[]>(num_pc * num_p_pc_from_gr_to_pc);
+	pfSynWeightPC = make_placed_array<float>(num_pc * num_p_pc_from_gr_to_pc);
 	inputSumPFPC  = std::make_unique<float[]>(num_pc);
 	gPFPC         = std::make_unique<float[]>(num_pc);
 	gBCPC         = std::make_unique<float[]>(num_pc);
@@ -112,8 +114,7 @@ void MZoneActivityState::initializeVals(int randSeed)
 	std::fill(vPC.get(), vPC.get() + num_pc, eLeakPC);
 	std::fill(threshPC.get(), threshPC.get() + num_pc, threshRestPC);
 
-	std::fill(pfSynWeightPC.get(), pfSynWeightPC.get()
-		+ num_pc * num_p_pc_from_gr_to_pc, initSynWofGRtoPC);
+	parallel_fill(pfSynWeightPC.get(), num_pc * num_p_pc_from_gr_to_pc, initSynWofGRtoPC);
 
 	std::fill(histPCPopAct.get(), histPCPopAct.get() + (int)numPopHistBinsPC, 0);
 
@@ -138,75 +139,73 @@ void MZoneActivityState::initializeVals(int randSeed)
 		+ num_nc * num_p_nc_from_mf_to_nc, initSynWofMFtoNC);
 }
 
-void MZoneActivityState::stateRW(bool read, std::fstream &file)
+void MZoneActivityState::stateRW(bool read, std::iostream &file)
+{
+	StateRWVisitor rw(read, file);
+	visitState(rw);
+}
+
+void MZoneActivityState::visitState(StateVisitor &visitor)
 {
 	// stellate cells
-	rawBytesRW((char *)apSC.get(), num_sc * sizeof(uint8_t), read, file);
-	rawBytesRW((char *)apBufSC.get(), num_sc * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)gPFSC.get(), num_sc * sizeof(float), read, file);
-	rawBytesRW((char *)threshSC.get(), num_sc * sizeof(float), read, file);
-	rawBytesRW((char *)vSC.get(), num_sc * sizeof(float), read, file);
+	visitor.visit("apSC", apSC.get(), num_sc);
+	visitor.visit("apBufSC", apBufSC.get(), num_sc);
+	visitor.visit("gPFSC", gPFSC.get(), num_sc);
+	visitor.visit("threshSC", threshSC.get(), num_sc);
+	visitor.visit("vSC", vSC.get(), num_sc);
 
 	// basket cells
-	rawBytesRW((char *)apBC.get(), num_bc * sizeof(uint8_t), read, file);
-	rawBytesRW((char *)apBufBC.get(), num_bc * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)inputPCBC.get(), num_bc * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)gPFBC.get(), num_bc * sizeof(float), read, file);
-	rawBytesRW((char *)gPCBC.get(), num_bc * sizeof(float), read, file);
-	rawBytesRW((char *)vBC.get(), num_bc * sizeof(float), read, file);
-	rawBytesRW((char *)threshBC.get(), num_bc * sizeof(float), read, file);
+	visitor.visit("apBC", apBC.get(), num_bc);
+	visitor.visit("apBufBC", apBufBC.get(), num_bc);
+	visitor.visit("inputPCBC", inputPCBC.get(), num_bc);
+	visitor.visit("gPFBC", gPFBC.get(), num_bc);
+	visitor.visit("gPCBC", gPCBC.get(), num_bc);
+	visitor.visit("vBC", vBC.get(), num_bc);
+	visitor.visit("threshBC", threshBC.get(), num_bc);
 
 	// purkinje cells
-	rawBytesRW((char *)apPC.get(), num_pc * sizeof(uint8_t), read, file);
-	rawBytesRW((char *)apBufPC.get(), num_pc * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)inputBCPC.get(), num_pc * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)inputSCPC.get(), num_pc * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)pfSynWeightPC.get(),
-		num_pc * num_p_pc_from_gr_to_pc * sizeof(float), read, file);
-	rawBytesRW((char *)inputSumPFPC.get(), num_pc * sizeof(float), read, file);
-	rawBytesRW((char *)gPFPC.get(), num_pc * sizeof(float), read, file);
-	rawBytesRW((char *)gBCPC.get(), num_pc * sizeof(float), read, file);
-	rawBytesRW((char *)gSCPC.get(), num_pc * sizeof(float), read, file);
-	rawBytesRW((char *)vPC.get(), num_pc * sizeof(float), read, file);
-	rawBytesRW((char *)threshPC.get(), num_pc * sizeof(float), read, file);
-	rawBytesRW((char *)histPCPopAct.get(), numPopHistBinsPC * sizeof(uint32_t), read, file);
-
-	rawBytesRW((char *)&histPCPopActSum, sizeof(uint32_t), read, file);
-	rawBytesRW((char *)&histPCPopActCurBinN, sizeof(uint32_t), read, file);
-	rawBytesRW((char *)&pcPopAct, sizeof(uint32_t), read, file);
+	visitor.visit("apPC", apPC.get(), num_pc);
+	visitor.visit("apBufPC", apBufPC.get(), num_pc);
+	visitor.visit("inputBCPC", inputBCPC.get(), num_pc);
+	visitor.visit("inputSCPC", inputSCPC.get(), num_pc);
+	visitor.visit("pfSynWeightPC", pfSynWeightPC.get(), num_pc * num_p_pc_from_gr_to_pc);
+	visitor.visit("inputSumPFPC", inputSumPFPC.get(), num_pc);
+	visitor.visit("gPFPC", gPFPC.get(), num_pc);
+	visitor.visit("gBCPC", gBCPC.get(), num_pc);
+	visitor.visit("gSCPC", gSCPC.get(), num_pc);
+	visitor.visit("vPC", vPC.get(), num_pc);
+	visitor.visit("threshPC", threshPC.get(), num_pc);
+	visitor.visit("histPCPopAct", histPCPopAct.get(), (uint64_t)numPopHistBinsPC);
+
+	visitor.visit("histPCPopActSum", &histPCPopActSum, 1);
+	visitor.visit("histPCPopActCurBinN", &histPCPopActCurBinN, 1);
+	visitor.visit("pcPopAct", &pcPopAct, 1);
 	
 	// inferior olivary cells
-	rawBytesRW((char *)apIO.get(), num_io * sizeof(uint8_t), read, file);
-	rawBytesRW((char *)apBufIO.get(), num_io * sizeof(uint8_t), read, file);
-	rawBytesRW((char *)inputNCIO.get(),
-		num_io * num_p_io_from_nc_to_io * sizeof(uint8_t), read, file);
-	rawBytesRW((char *)gNCIO.get(),
-		num_io * num_p_io_from_nc_to_io * sizeof(float), read, file);
-	rawBytesRW((char *)threshIO.get(), num_io * sizeof(float), read, file);
-	rawBytesRW((char *)vIO.get(), num_io * sizeof(float), read, file);
-	rawBytesRW((char *)vCoupleIO.get(), num_io * sizeof(float), read, file);
-	rawBytesRW((char *)pfPCPlastTimerIO.get(), num_io * sizeof(int32_t), read, file);
-
-	rawBytesRW((char *)&errDrive, sizeof(float), read, file);
+	visitor.visit("apIO", apIO.get(), num_io);
+	visitor.visit("apBufIO", apBufIO.get(), num_io);
+	visitor.visit("inputNCIO", inputNCIO.get(), num_io * num_p_io_from_nc_to_io);
+	visitor.visit("gNCIO", gNCIO.get(), num_io * num_p_io_from_nc_to_io);
+	visitor.visit("threshIO", threshIO.get(), num_io);
+	visitor.visit("vIO", vIO.get(), num_io);
+	visitor.visit("vCoupleIO", vCoupleIO.get(), num_io);
+	visitor.visit("pfPCPlastTimerIO", pfPCPlastTimerIO.get(), num_io);
+
+	visitor.visit("errDrive", &errDrive, 1);
 
 	// nucleus cells
-	rawBytesRW((char *)apNC.get(), num_nc * sizeof(uint8_t), read, file);
-	rawBytesRW((char *)apBufNC.get(), num_nc * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)inputPCNC.get(),
-		num_nc * num_p_nc_from_pc_to_nc * sizeof(uint8_t), read, file);
-	rawBytesRW((char *)inputMFNC.get(),
-		num_nc * num_p_nc_from_mf_to_nc * sizeof(uint8_t), read, file);
-	rawBytesRW((char *)gPCNC.get(),
-		num_nc * num_p_nc_from_pc_to_nc * sizeof(float), read, file);
-	rawBytesRW((char *)mfSynWeightNC.get(),
-		num_nc * num_p_nc_from_mf_to_nc * sizeof(float), read, file);
-	rawBytesRW((char *)gMFAMPANC.get(),
-		num_nc * num_p_nc_from_mf_to_nc * sizeof(float), read, file);
-	rawBytesRW((char *)threshNC.get(), num_nc * sizeof(float), read, file);
-	rawBytesRW((char *)vNC.get(), num_nc * sizeof(float), read, file);
-	rawBytesRW((char *)synIOPReleaseNC.get(), num_nc * sizeof(float), read, file);
-
-	rawBytesRW((char *)&noLTPMFNC, sizeof(uint8_t), read, file);
-	rawBytesRW((char *)&noLTDMFNC, sizeof(uint8_t), read, file);
+	visitor.visit("apNC", apNC.get(), num_nc);
+	visitor.visit("apBufNC", apBufNC.get(), num_nc);
+	visitor.visit("inputPCNC", inputPCNC.get(), num_nc * num_p_nc_from_pc_to_nc);
+	visitor.visit("inputMFNC", inputMFNC.get(), num_nc * num_p_nc_from_mf_to_nc);
+	visitor.visit("gPCNC", gPCNC.get(), num_nc * num_p_nc_from_pc_to_nc);
+	visitor.visit("mfSynWeightNC", mfSynWeightNC.get(), num_nc * num_p_nc_from_mf_to_nc);
+	visitor.visit("gMFAMPANC", gMFAMPANC.get(), num_nc * num_p_nc_from_mf_to_nc);
+	visitor.visit("threshNC", threshNC.get(), num_nc);
+	visitor.visit("vNC", vNC.get(), num_nc);
+	visitor.visit("synIOPReleaseNC", synIOPReleaseNC.get(), num_nc);
+
+	visitor.visit("noLTPMFNC", &noLTPMFNC, 1);
+	visitor.visit("noLTDMFNC", &noLTDMFNC, 1);
 }
 
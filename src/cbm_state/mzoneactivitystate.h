@@ -11,18 +11,22 @@
 #include <fstream>
 #include <memory> /* unique_ptr, make_unique */
 #include <cstdint>
+#include "simparams.h"
+#include "state_visitor.h"
 
-class MZoneActivityState
+class MZoneActivityState : protected sim_params
 {
 public:
 	MZoneActivityState();
-	MZoneActivityState(int randSeed);
-	MZoneActivityState(std::fstream &infile);
+	MZoneActivityState(const sim_params &params, int randSeed);
+	MZoneActivityState(const sim_params &params, std::iostream &infile);
 
 	~MZoneActivityState();
 	
-	void readState(std::fstream &infile);
-	void writeState(std::fstream &outfile);
+	void readState(std::iostream &infile);
+	void writeState(std::iostream &outfile);
+	/* visits every array stateRW reads and writes, in file order */
+	void visitState(StateVisitor &visitor);
 
 	//stellate cells
 	std::unique_ptr<uint8_t[]> apSC{nullptr};
@@ -88,7 +92,7 @@ public:
 private:
 	void allocateMemory();
 	void initializeVals(int randSeed);
-	void stateRW(bool read, std::fstream &file);
+	void stateRW(bool read, std::iostream &file);
 };
 
 #endif /* MZONEACTIVITYSTATE_H_ */
@@ -12,10 +12,43 @@
 #include "file_utility.h"
 #include "dynamic2darray.h"
 #include "sfmt.h"
-#include "connectivityparams.h"
+#include "simparams.h"
 #include "mzoneconnectivitystate.h"
 
-MZoneConnectivityState::MZoneConnectivityState(int randSeed)
+/* in the order of the .sim file */
+const MZoneConnectivityState::con_table MZoneConnectivityState::conTables[NUM_MZONE_CON_TABLES] =
+{
+	// granule cells
+	{ &MZoneConnectivityState::pGRDelayMaskfromGRtoBSP, NULL, &con_params::num_gr, NULL },
+
+	// basket cells
+	{ NULL, &MZoneConnectivityState::pBCfromBCtoPC, &con_params::num_bc, &con_params::num_p_bc_from_bc_to_pc },
+	{ NULL, &MZoneConnectivityState::pBCfromPCtoBC, &con_params::num_bc, &con_params::num_p_bc_from_pc_to_bc },
+
+	// stellate cells
+	{ NULL, &MZoneConnectivityState::pSCfromSCtoPC, &con_params::num_sc, &con_params::num_p_sc_from_sc_to_pc },
+
+	// purkinje cells
+	{ NULL, &MZoneConnectivityState::pPCfromBCtoPC, &con_params::num_pc, &con_params::num_p_pc_from_bc_to_pc },
+	{ NULL, &MZoneConnectivityState::pPCfromPCtoBC, &con_params::num_pc, &con_params::num_p_pc_from_pc_to_bc },
+	{ NULL, &MZoneConnectivityState::pPCfromSCtoPC, &con_params::num_pc, &con_params::num_p_pc_from_sc_to_pc },
+	{ NULL, &MZoneConnectivityState::pPCfromPCtoNC, &con_params::num_pc, &con_params::num_p_pc_from_pc_to_nc },
+	{ &MZoneConnectivityState::pPCfromIOtoPC, NULL, &con_params::num_pc, NULL },
+
+	// nucleus cells
+	{ NULL, &MZoneConnectivityState::pNCfromPCtoNC, &con_params::num_nc, &con_params::num_p_nc_from_pc_to_nc },
+	{ NULL, &MZoneConnectivityState::pNCfromNCtoIO, &con_params::num_nc, &con_params::num_p_nc_from_nc_to_io },
+	{ NULL, &MZoneConnectivityState::pNCfromMFtoNC, &con_params::num_nc, &con_params::num_p_nc_from_mf_to_nc },
+
+	// inferior olivary cells
+	{ NULL, &MZoneConnectivityState::pIOfromIOtoPC, &con_params::num_io, &con_params::num_p_io_from_io_to_pc },
+	{ NULL, &MZoneConnectivityState::pIOfromNCtoIO, &con_params::num_io, &con_params::num_p_io_from_nc_to_io },
+	{ NULL, &MZoneConnectivityState::pIOInIOIO, &con_params::num_io, &con_params::num_p_io_in_io_to_io },
+	{ NULL, &MZoneConnectivityState::pIOOutIOIO, &con_params::num_io, &con_params::num_p_io_out_io_to_io }
+};
+
+MZoneConnectivityState::MZoneConnectivityState(const sim_params &params, int randSeed)
+	: sim_params(params)
 {
 	std::cout << "[INFO]: Allocating and initializing mzone connectivity arrays..." << std::endl;
 	allocateMemory();
@@ -42,20 +75,29 @@ MZoneConnectivityState::MZoneConnectivityState(int randSeed)
 	std::cout << "[INFO]: Finished making mzone connections." << std::endl;
 }
 
-MZoneConnectivityState::MZoneConnectivityState(std::fstream &infile)
+MZoneConnectivityState::MZoneConnectivityState(const sim_params &params, std::iostream &infile,
+	MZoneConnectivityState *const *tableOwners)
+	: sim_params(params)
 {
 	allocateMemory();
+	if (tableOwners)
+	{
+		for (int t = 0; t < NUM_MZONE_CON_TABLES; t++)
+		{
+			if (tableOwners[t]) shareTable(t, tableOwners[t]);
+		}
+	}
 	stateRW(true, infile);
 }
 
 MZoneConnectivityState::~MZoneConnectivityState() {deallocMemory();}
 
-void MZoneConnectivityState::readState(std::fstream &infile)
+void MZoneConnectivityState::readState(std::iostream &infile)
 {
 	stateRW(true, infile);
 }
 
-void MZoneConnectivityState::writeState(std::fstream &outfile)
+void MZoneConnectivityState::writeState(std::iostream &outfile)
 {
 	stateRW(false, outfile);
 }
@@ -137,64 +179,65 @@ void MZoneConnectivityState::initializeVals()
 
 void MZoneConnectivityState::deallocMemory()
 {
-	// granule cells
-	delete[] pGRDelayMaskfromGRtoBSP;
-
-	// basket cells
-	delete2DArray<uint32_t>(pBCfromBCtoPC);
-	delete2DArray<uint32_t>(pBCfromPCtoBC);
-
-	// stellate cells
-	delete2DArray<uint32_t>(pSCfromSCtoPC);
-
-	// purkinje cells
-	delete2DArray<uint32_t>(pPCfromBCtoPC);
-	delete2DArray<uint32_t>(pPCfromPCtoBC);
-	delete2DArray<uint32_t>(pPCfromSCtoPC);
-	delete2DArray<uint32_t>(pPCfromPCtoNC);
-	delete[] pPCfromIOtoPC;
-
-	// nucleus cells
-	delete2DArray<uint32_t>(pNCfromPCtoNC);
-	delete2DArray<uint32_t>(pNCfromNCtoIO);
-	delete2DArray<uint32_t>(pNCfromMFtoNC);
-
-	// inferior olivary cells
-	delete2DArray<uint32_t>(pIOfromIOtoPC);
-	delete2DArray<uint32_t>(pIOfromNCtoIO);
-	delete2DArray<uint32_t>(pIOInIOIO);
-	delete2DArray<uint32_t>(pIOOutIOIO);
+	for (int t = 0; t < NUM_MZONE_CON_TABLES; t++)
+	{
+		if (shared[t]) continue;
+		if (conTables[t].rows) delete2DArray<uint32_t>(this->*conTables[t].rows);
+		else delete[] (this->*conTables[t].flat);
+	}
 }
 
-void MZoneConnectivityState::stateRW(bool read, std::fstream &file)
+void MZoneConnectivityState::stateRW(bool read, std::iostream &file)
 {
-	// granule cells
-	rawBytesRW((char *)pGRDelayMaskfromGRtoBSP, num_gr * sizeof(uint32_t), read, file);
-
-	// basket cells
-	rawBytesRW((char *)pBCfromBCtoPC[0], num_bc * num_p_bc_from_bc_to_pc * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)pBCfromPCtoBC[0], num_bc * num_p_bc_from_pc_to_bc * sizeof(uint32_t), read, file);
+	for (int t = 0; t < NUM_MZONE_CON_TABLES; t++)
+	{
+		if (!shared[t]) rawBytesRW((char *)tableData(t), tableBytes(t), read, file);
+	}
+}
 
-	// stellate cells
-	rawBytesRW((char *)pSCfromSCtoPC[0], num_sc * num_p_sc_from_sc_to_pc * sizeof(uint32_t), read, file);
+uint32_t *MZoneConnectivityState::tableData(int table)
+{
+	const con_table &ct = conTables[table];
+	return ct.rows ? (this->*ct.rows)[0] : this->*ct.flat;
+}
 
-	// purkinje cells
-	rawBytesRW((char *)pPCfromBCtoPC[0], num_pc * num_p_pc_from_bc_to_pc * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)pPCfromPCtoBC[0], num_pc * num_p_pc_from_pc_to_bc * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)pPCfromSCtoPC[0], num_pc * num_p_pc_from_sc_to_pc * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)pPCfromPCtoNC[0], num_pc * num_p_pc_from_pc_to_nc * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)pPCfromIOtoPC, num_pc * sizeof(uint32_t), read, file);
+size_t MZoneConnectivityState::tableBytes(int table)
+{
+	const con_table &ct = conTables[table];
+	const con_params &cp = *this;
+	size_t num_cols = ct.num_cols ? cp.*ct.num_cols : 1;
+	return cp.*ct.num_cells * num_cols * sizeof(uint32_t);
+}
 
-	// nucleus cells
-	rawBytesRW((char *)pNCfromPCtoNC[0], num_nc * num_p_nc_from_pc_to_nc * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)pNCfromNCtoIO[0], num_nc * num_p_nc_from_nc_to_io * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)pNCfromMFtoNC[0], num_nc * num_p_nc_from_mf_to_nc * sizeof(uint32_t), read, file);
+bool MZoneConnectivityState::sharesTable(int table)
+{
+	return shared[table];
+}
 
-	// inferior olivary cells
-	rawBytesRW((char *)pIOfromIOtoPC[0], num_io * num_p_io_from_io_to_pc * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)pIOfromNCtoIO[0], num_io * num_p_io_from_nc_to_io * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)pIOInIOIO[0], num_io * num_p_io_in_io_to_io * sizeof(uint32_t), read, file);
-	rawBytesRW((char *)pIOOutIOIO[0], num_io * num_p_io_out_io_to_io * sizeof(uint32_t), read, file);
+void MZoneConnectivityState::shareTable(int table, MZoneConnectivityState *owner)
+{
+	const con_table &ct = conTables[table];
+	const con_params &cp = *this;
+	if (owner == this)
+	{
+		if (!shared[table]) return;
+		uint32_t *src = tableData(table);
+		if (ct.rows)
+			this->*ct.rows = allocate2DArray<uint32_t>(cp.*ct.num_cells, cp.*ct.num_cols);
+		else
+			this->*ct.flat = new uint32_t[cp.*ct.num_cells];
+		std::copy(src, src + tableBytes(table) / sizeof(uint32_t), tableData(table));
+		shared[table] = false;
+		return;
+	}
+	if (!shared[table])
+	{
+		if (ct.rows) delete2DArray<uint32_t>(this->*ct.rows);
+		else delete[] (this->*ct.flat);
+	}
+	if (ct.rows) this->*ct.rows = owner->*ct.rows;
+	else this->*ct.flat = owner->*ct.flat;
+	shared[table] = true;
 }
 
 void MZoneConnectivityState::assignGRDelays()
@@ -10,17 +10,34 @@
 
 #include <fstream>
 #include <cstdint>
+#include "simparams.h"
 
-class MZoneConnectivityState
+/* number of connectivity tables in a zone's state, see conTables */
+#define NUM_MZONE_CON_TABLES 16
+
+class MZoneConnectivityState : protected sim_params
 {
 public:
 	MZoneConnectivityState();
-	MZoneConnectivityState(int randSeed);
-	MZoneConnectivityState(std::fstream &infile);
+	MZoneConnectivityState(const sim_params &params, int randSeed);
+	/* tableOwners, if given, has for each table the state to share it with, or
+	 * NULL to read it from infile */
+	MZoneConnectivityState(const sim_params &params, std::iostream &infile,
+		MZoneConnectivityState *const *tableOwners = NULL);
 	~MZoneConnectivityState();
 
-	void readState(std::fstream &infile);
-	void writeState(std::fstream &outfile);
+	void readState(std::iostream &infile);
+	void writeState(std::iostream &outfile);
+
+	/* tables are numbered in the order they are serialised. a table may be
+	 * shared with the identical table of another zone's state, which then owns
+	 * it and must outlive this one. a shared table is neither freed nor read
+	 * nor written by this state */
+	uint32_t *tableData(int table);
+	size_t tableBytes(int table);
+	bool sharesTable(int table);
+	/* shares table with owner, or with owner == this takes back a private copy */
+	void shareTable(int table, MZoneConnectivityState *owner);
 
 	//granule cells
 	uint32_t *pGRDelayMaskfromGRtoBSP;
@@ -51,10 +68,21 @@ public:
 	uint32_t **pIOOutIOIO;
 
 private:
+	struct con_table
+	{
+		uint32_t *MZoneConnectivityState::*flat;  /* 1D tables */
+		uint32_t **MZoneConnectivityState::*rows; /* tables from allocate2DArray */
+		int con_params::*num_cells;
+		int con_params::*num_cols; /* NULL for 1D tables */
+	};
+	static const con_table conTables[NUM_MZONE_CON_TABLES];
+
+	bool shared[NUM_MZONE_CON_TABLES] = {};
+
 	void allocateMemory();
 	void initializeVals();
 	void deallocMemory();
-	void stateRW(bool read, std::fstream &file);
+	void stateRW(bool read, std::iostream &file);
 
 	void assignGRDelays();
 	void connectBCtoPC();
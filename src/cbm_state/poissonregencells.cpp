@@ -8,8 +8,10 @@
  */
 
 #include "poissonregencells.h"
+#include "tracepoints.h"
 
-PoissonRegenCells::PoissonRegenCells(int randSeed, float threshDecayTau, unsigned int numZones, float sigma)
+PoissonRegenCells::PoissonRegenCells(const sim_params &params, int randSeed, float threshDecayTau, unsigned int numZones, float sigma)
+	: sim_params(params)
 {
 	randSeedGen = new CRandomSFMT0(randSeed);
 	noiseRandGen = new std::mt19937(randSeed);
@@ -70,10 +72,13 @@ void PoissonRegenCells::prepCollaterals(int rSeed)
 			}
 		}
 	}
-	std::srand(rSeed);
-	std::random_shuffle(tempNCs, tempNCs + repeats*numZones*num_nc);
-	std::srand(rSeed);
-	std::random_shuffle(tempMZs, tempMZs + repeats*numZones*num_nc);
+	/* both shuffles must make the same permutation, so each gets its own
+	 * generator on rSeed rather than the process-wide rand, which other
+	 * simulations in this process may be drawing from meanwhile */
+	std::mt19937 ncShuffleGen(rSeed);
+	std::shuffle(tempNCs, tempNCs + repeats*numZones*num_nc, ncShuffleGen);
+	std::mt19937 mzShuffleGen(rSeed);
+	std::shuffle(tempMZs, tempMZs + repeats*numZones*num_nc, mzShuffleGen);
 	std::copy(tempNCs, tempNCs + num_mf, dnCellIndex);
 	std::copy(tempMZs, tempMZs + num_mf, mZoneIndex);
 
@@ -86,6 +91,7 @@ const uint8_t* PoissonRegenCells::calcPoissActivity(const float *frequencies, MZ
 	int countColls = 0;
 	const uint8_t *holdNCs;
 	float noise;
+	CBM_TRACE(mf__gen__start);
 	spikeTimer++;
 	for (uint32_t i = 0; i < num_mf; i++)
 	{
@@ -107,6 +113,7 @@ const uint8_t* PoissonRegenCells::calcPoissActivity(const float *frequencies, MZ
 		}
 	}
 	if (spikeTimer == ispikei) spikeTimer = 0;
+	CBM_TRACE1(mf__gen__end, num_mf);
 	return (const uint8_t *)aps;
 }
 
@@ -9,8 +9,7 @@
 #define POISSONREGENCELLS_H_
 
 #include <iostream>
-#include <algorithm> // for random_shuffle
-#include <cstdlib> // for srand and rand, sorry Wen
+#include <algorithm> // for shuffle
 #include <random>
 #include <math.h>
 #include <limits.h>
@@ -18,14 +17,13 @@
 #include <cstdint>
 #include "sfmt.h"
 #include "mzone.h"
-#include "connectivityparams.h"
-#include "activityparams.h"
+#include "simparams.h"
 
-class PoissonRegenCells
+class PoissonRegenCells : protected sim_params
 {
 public:
 	PoissonRegenCells();
-	PoissonRegenCells(int randSeed, float threshDecayTau, unsigned int numZones, float sigma=0);
+	PoissonRegenCells(const sim_params &params, int randSeed, float threshDecayTau, unsigned int numZones, float sigma=0);
 	~PoissonRegenCells();
 
 	const uint8_t* calcPoissActivity(const float *freqencies, MZone **mZoneList, int ispikei = 18); 
@@ -0,0 +1,43 @@
+/*
+ * File: simparams.h
+ *
+ * Description:
+ *     The parameter context of one simulation: every connectivity and activity
+ *     parameter, populated from a build or session file or read from a .sim
+ *     file. Each of CBMSimCore, InNet, MZone and the state classes is handed a
+ *     context at construction and keeps its own copy, so two simulations with
+ *     different parameters can live (and run) in the same process.
+ *
+ *     Those classes, and Control, inherit the context non-publicly, which keeps
+ *     the parameter names that their member functions refer to unqualified,
+ *     just as they did when the parameters were globals. Other code reads a
+ *     context through getParams, which hands it out const. A context does not
+ *     change once the objects using it are built, except through
+ *     retuneActParams (Control's, which passes the activity params on to
+ *     CBMSimCore::retuneActParams).
+ */
+#ifndef SIMPARAMS_H_
+#define SIMPARAMS_H_
+
+#include <iostream>
+#include "file_parse.h"
+#include "connectivityparams.h"
+#include "activityparams.h"
+
+struct sim_params : public con_params, public act_params
+{
+	bool con_params_populated = false;
+	bool act_params_populated = false;
+
+	void populate_con_params(parsed_build_file &p_file);
+	void read_con_params(std::iostream &in_param_buf);
+	void write_con_params(std::iostream &out_param_buf) const;
+
+	/* the derived act params need the con params to be populated first */
+	void populate_act_params(parsed_sess_file &s_file);
+	void read_act_params(std::iostream &in_param_buf);
+	void write_act_params(std::iostream &out_param_buf) const;
+};
+
+#endif /* SIMPARAMS_H_ */
+
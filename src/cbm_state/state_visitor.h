@@ -0,0 +1,54 @@
+/*
+ * File: state_visitor.h
+ *
+ * Description:
+ *     Interface for walking the arrays of an activity state in the order they
+ *     are saved in. Each activity state lists its arrays once, in visitState,
+ *     and both its stateRW and the state digests (see state_digest.h) go
+ *     through that list, so a digest covers exactly what a saved simulation
+ *     holds. Scalars are visited as arrays of one.
+ */
+#ifndef STATE_VISITOR_H_
+#define STATE_VISITOR_H_
+
+#include <fstream>
+#include <cstdint>
+#include "file_utility.h"
+
+class StateVisitor
+{
+	public:
+		virtual ~StateVisitor() {}
+
+		/* called where a state's saved layout starts a tagged section, before
+		 * the section's arrays are visited. returning false skips them */
+		virtual bool section(int section_id) { return true; }
+
+		virtual void visit(const char *name, uint8_t *arr, uint64_t n) = 0;
+		virtual void visit(const char *name, uint32_t *arr, uint64_t n) = 0;
+		virtual void visit(const char *name, int32_t *arr, uint64_t n) = 0;
+		virtual void visit(const char *name, uint64_t *arr, uint64_t n) = 0;
+		virtual void visit(const char *name, float *arr, uint64_t n) = 0;
+};
+
+/* reads or writes the raw bytes of every array it visits */
+class StateRWVisitor : public StateVisitor
+{
+	public:
+		StateRWVisitor(bool read, std::iostream &file) : read(read), file(file) {}
+
+		void visit(const char *name, uint8_t *arr, uint64_t n) override { rw(arr, n * sizeof(uint8_t)); }
+		void visit(const char *name, uint32_t *arr, uint64_t n) override { rw(arr, n * sizeof(uint32_t)); }
+		void visit(const char *name, int32_t *arr, uint64_t n) override { rw(arr, n * sizeof(int32_t)); }
+		void visit(const char *name, uint64_t *arr, uint64_t n) override { rw(arr, n * sizeof(uint64_t)); }
+		void visit(const char *name, float *arr, uint64_t n) override { rw(arr, n * sizeof(float)); }
+
+	protected:
+		bool read;
+		std::iostream &file;
+
+	private:
+		void rw(void *arr, uint64_t num_bytes) { rawBytesRW((char *)arr, num_bytes, read, file); }
+};
+
+#endif /* STATE_VISITOR_H_ */
@@ -248,20 +248,26 @@ static void on_firing_rates_window(GtkWidget *widget, struct gui *gui)
 	gtk_widget_show_all(gui->frw.window);
 }
 
+/* weight points into the gui's copy of the activity params, which the control
+ * and its running simulation only pick up once they are retuned with it */
 static void on_update_weight(GtkWidget *spin_button, float *weight)
 {
 	*weight = gtk_spin_button_get_value(GTK_SPIN_BUTTON(spin_button));
+	Control *control = (Control *)g_object_get_data(G_OBJECT(spin_button), "control");
+	act_params *tuned = (act_params *)g_object_get_data(G_OBJECT(spin_button), "tuned_params");
+	control->retuneActParams(*tuned);
 }
 
 
 static void on_tuning_window(GtkWidget *widget, struct gui *gui)
 {
+	gui->tuned_params = gui->ctrl_ptr->getParams();
 	struct tuning_window tw = {
 		.window = gtk_window_new(GTK_WINDOW_TOPLEVEL),
 		.grid = gtk_grid_new(),
 		.tuning_buttons = {
 			{
-				gtk_adjustment_new(gIncDirectMFtoGR, 0.0, 1.0, 0.0001, 0.1, 0.0),
+				gtk_adjustment_new(gui->tuned_params.gIncDirectMFtoGR, 0.0, 1.0, 0.0001, 0.1, 0.0),
 				NULL, 1, 0, 4,
 				{
 					NULL, "MF-GR", 0, 0
@@ -269,12 +275,12 @@ static void on_tuning_window(GtkWidget *widget, struct gui *gui)
 				{
 					"activate",
 					G_CALLBACK(on_update_weight),
-					&gIncDirectMFtoGR,
+					&gui->tuned_params.gIncDirectMFtoGR,
 					false
 				}
 			},
 			{
-				gtk_adjustment_new(gIncMFtoGO, 0.0, 1.0, 0.0001, 0.1, 0.0),
+				gtk_adjustment_new(gui->tuned_params.gIncMFtoGO, 0.0, 1.0, 0.0001, 0.1, 0.0),
 				NULL, 1, 1, 4, 
 				{
 					NULL, "MF-GO", 0, 1
@@ -282,12 +288,12 @@ static void on_tuning_window(GtkWidget *widget, struct gui *gui)
 				{
 					"activate",
 					G_CALLBACK(on_update_weight),
-					&gIncMFtoGO,
+					&gui->tuned_params.gIncMFtoGO,
 					false
 				}
 			},
 			{
-				gtk_adjustment_new(gIncGRtoGO, 0.0, 1.0, 0.0001, 0.1, 0.0),
+				gtk_adjustment_new(gui->tuned_params.gIncGRtoGO, 0.0, 1.0, 0.0001, 0.1, 0.0),
 				NULL, 1, 2, 4,
 				{
 					NULL, "GR-GO", 0, 2
@@ -295,12 +301,12 @@ static void on_tuning_window(GtkWidget *widget, struct gui *gui)
 				{
 					"activate",
 					G_CALLBACK(on_update_weight),
-					&gIncGRtoGO,
+					&gui->tuned_params.gIncGRtoGO,
 					false
 				}
 			},
 			{
-				gtk_adjustment_new(gIncDirectGOtoGR, 0.0, 1.0, 0.01, 0.1, 0.0),
+				gtk_adjustment_new(gui->tuned_params.gIncDirectGOtoGR, 0.0, 1.0, 0.01, 0.1, 0.0),
 				NULL, 1, 3, 2, 
 				{
 					NULL, "GO-GR", 0, 3
@@ -308,12 +314,12 @@ static void on_tuning_window(GtkWidget *widget, struct gui *gui)
 				{
 					"activate",
 					G_CALLBACK(on_update_weight),
-					&gIncDirectGOtoGR,
+					&gui->tuned_params.gIncDirectGOtoGR,
 					false
 				}
 			},
 			{
-				gtk_adjustment_new(gGABAIncGOtoGO, 0.0, 1.0, 0.01, 0.1, 0.0),
+				gtk_adjustment_new(gui->tuned_params.gGABAIncGOtoGO, 0.0, 1.0, 0.01, 0.1, 0.0),
 				NULL, 3, 0, 2,
 				{
 					NULL, "GO-GO", 2, 0
@@ -321,12 +327,12 @@ static void on_tuning_window(GtkWidget *widget, struct gui *gui)
 				{
 					"activate",
 					G_CALLBACK(on_update_weight),
-					&gGABAIncGOtoGO,
+					&gui->tuned_params.gGABAIncGOtoGO,
 					false
 				}
 			},
 			{
-				gtk_adjustment_new(gIncGRtoPC, 0.0, 1.0, 0.000001, 0.1, 0.0),
+				gtk_adjustment_new(gui->tuned_params.gIncGRtoPC, 0.0, 1.0, 0.000001, 0.1, 0.0),
 				NULL, 3, 1, 6,
 				{
 					NULL, "GR-PC", 2, 1
@@ -334,12 +340,12 @@ static void on_tuning_window(GtkWidget *widget, struct gui *gui)
 				{
 					"activate",
 					G_CALLBACK(on_update_weight),
-					&gIncGRtoPC,
+					&gui->tuned_params.gIncGRtoPC,
 					false
 				}
 			},
 			{
-				gtk_adjustment_new(gIncGRtoSC, 0.0, 1.0, 0.001, 0.1, 0.0),
+				gtk_adjustment_new(gui->tuned_params.gIncGRtoSC, 0.0, 1.0, 0.001, 0.1, 0.0),
 				NULL, 3, 2, 3,
 				{
 					NULL, "GR-SC", 2, 2
@@ -347,12 +353,12 @@ static void on_tuning_window(GtkWidget *widget, struct gui *gui)
 				{
 					"activate",
 					G_CALLBACK(on_update_weight),
-					&gIncGRtoSC,
+					&gui->tuned_params.gIncGRtoSC,
 					false
 				}
 			},
 			{
-				gtk_adjustment_new(gIncGRtoBC, 0.0, 1.0, 0.001, 0.1, 0.0),
+				gtk_adjustment_new(gui->tuned_params.gIncGRtoBC, 0.0, 1.0, 0.001, 0.1, 0.0),
 				NULL, 3, 3, 3,
 				{
 					NULL, "GR-BC", 2, 3
@@ -360,12 +366,12 @@ static void on_tuning_window(GtkWidget *widget, struct gui *gui)
 				{
 					"activate",
 					G_CALLBACK(on_update_weight),
-					&gIncGRtoBC,
+					&gui->tuned_params.gIncGRtoBC,
 					false
 				}
 			},
 			{
-				gtk_adjustment_new(gIncSCtoPC, 0.0, 1.0, 0.00001, 0.1, 0.0),
+				gtk_adjustment_new(gui->tuned_params.gIncSCtoPC, 0.0, 1.0, 0.00001, 0.1, 0.0),
 				NULL, 5, 0, 5,
 				{
 					NULL, "SC-PC", 4, 0
@@ -373,12 +379,12 @@ static void on_tuning_window(GtkWidget *widget, struct gui *gui)
 				{
 					"activate",
 					G_CALLBACK(on_update_weight),
-					&gIncSCtoPC,
+					&gui->tuned_params.gIncSCtoPC,
 					false
 				}
 			},
 			{
-				gtk_adjustment_new(gIncBCtoPC, 0.0, 1.0, 0.00001, 0.1, 0.0),
+				gtk_adjustment_new(gui->tuned_params.gIncBCtoPC, 0.0, 1.0, 0.00001, 0.1, 0.0),
 				NULL, 5, 1, 5,
 				{
 					NULL, "BC-PC", 4, 1
@@ -386,12 +392,12 @@ static void on_tuning_window(GtkWidget *widget, struct gui *gui)
 				{
 					"activate",
 					G_CALLBACK(on_update_weight),
-					&gIncBCtoPC,
+					&gui->tuned_params.gIncBCtoPC,
 					false
 				}
 			},
 			{
-				gtk_adjustment_new(gIncPCtoBC, 0.0, 1.0, 0.01, 0.1, 0.0),
+				gtk_adjustment_new(gui->tuned_params.gIncPCtoBC, 0.0, 1.0, 0.01, 0.1, 0.0),
 				NULL, 5, 2, 2,
 				{
 					NULL, "PC-BC", 4, 2
@@ -399,12 +405,12 @@ static void on_tuning_window(GtkWidget *widget, struct gui *gui)
 				{
 					"activate",
 					G_CALLBACK(on_update_weight),
-					&gIncPCtoBC,
+					&gui->tuned_params.gIncPCtoBC,
 					false
 				}
 			},
 			{
-				gtk_adjustment_new(gIncAvgPCtoNC, 0.0, 1.0, 0.001, 0.1, 0.0),
+				gtk_adjustment_new(gui->tuned_params.gIncAvgPCtoNC, 0.0, 1.0, 0.001, 0.1, 0.0),
 				NULL, 5, 3, 3,
 				{
 					NULL, "PC-DCN", 4, 3
@@ -412,12 +418,12 @@ static void on_tuning_window(GtkWidget *widget, struct gui *gui)
 				{
 					"activate",
 					G_CALLBACK(on_update_weight),
-					&gIncAvgPCtoNC,
+					&gui->tuned_params.gIncAvgPCtoNC,
 					false
 				}
 			},
 			{
-				gtk_adjustment_new(gAMPAIncMFtoNC, 0.0, 1.0, 0.001, 0.1, 0.0),
+				gtk_adjustment_new(gui->tuned_params.gAMPAIncMFtoNC, 0.0, 1.0, 0.001, 0.1, 0.0),
 				NULL, 7, 0, 3,
 				{
 					NULL, "MF-DCN", 6, 0
@@ -425,12 +431,12 @@ static void on_tuning_window(GtkWidget *widget, struct gui *gui)
 				{
 					"activate",
 					G_CALLBACK(on_update_weight),
-					&gAMPAIncMFtoNC,
+					&gui->tuned_params.gAMPAIncMFtoNC,
 					false
 				}
 			},
 			{
-				gtk_adjustment_new(gIncNCtoIO, 0.0, 1.0, 0.0001, 0.1, 0.0),
+				gtk_adjustment_new(gui->tuned_params.gIncNCtoIO, 0.0, 1.0, 0.0001, 0.1, 0.0),
 				NULL, 7, 1, 4,
 				{
 					NULL, "DCN-IO", 6, 1
@@ -438,7 +444,7 @@ static void on_tuning_window(GtkWidget *widget, struct gui *gui)
 				{
 					"activate",
 					G_CALLBACK(on_update_weight),
-					&gIncNCtoIO,
+					&gui->tuned_params.gIncNCtoIO,
 					false
 				}
 			}
@@ -473,6 +479,8 @@ static void on_tuning_window(GtkWidget *widget, struct gui *gui)
 		gtk_widget_set_hexpand(b->widget, true);
 		gtk_widget_set_vexpand(b->widget, true);
 		gtk_grid_attach(GTK_GRID(tw.grid), b->widget, b->col, b->row, 1, 1);
+		g_object_set_data(G_OBJECT(b->widget), "control", gui->ctrl_ptr);
+		g_object_set_data(G_OBJECT(b->widget), "tuned_params", &gui->tuned_params);
 		g_signal_connect(b->widget, b->signal.signal, b->signal.handler, b->signal.data);
 	}
 
@@ -561,20 +569,52 @@ static void draw_raster(GtkWidget *drawing_area, cairo_t *cr, uint32_t trial, ui
 	}
 } 
 
+/*
+ * draws the decaying spatial activity maps kept by InNet, GR spikes on top (green)
+ * and GO spikes below (red), one pixel per bin of the golgi grid. each map is
+ * scaled to its own maximum, so a bin that just fired is bright and fades out as
+ * its activity decays. the maps are copied once per frame, so the cost to the
+ * simulation is the per step update only, not a draw of every cell.
+ */
 static void draw_spatial_activity(GtkWidget *drawing_area, cairo_t *cr, Control *control)
 {
-	/*
-	 * the plan: 
-	 *     for cell coordinates x and y (in the square: [0, num_cell) x [0, num_cell)), if cell at (x, y)
-	 *     fires at time step t_i, draw a dot with alpha 1. for each time step after a spike, decrease alpha
-	 *     by a fixed amount.
-	 *
-	 *     for now, call either g_threads_add_idle or directly emit signal to re-draw every time step during a run.
-	 *     this allows for the view to animate at a reasonable pace (e.g. 60 fps) when it is up, and then run the 
-	 *     simulation at full speed when it is not. Useful for when you want to check network activity after a 
-	 *     certain number of training or forgetting trials
-	 *
-	 */
+	cairo_set_source_rgb(cr, 0, 0, 0);
+	cairo_paint(cr);
+	if (!control->sim_initialized) return;
+
+	const sim_params &p = control->getParams();
+	std::vector<float> gr_act(p.num_go), go_act(p.num_go);
+	control->simCore->getInputNet()->exportSpatialAct(gr_act.data(), go_act.data());
+	float gr_max = *std::max_element(gr_act.begin(), gr_act.end());
+	float go_max = *std::max_element(go_act.begin(), go_act.end());
+	float gr_scale = (gr_max > 0) ? 255.0 / gr_max : 0.0;
+	float go_scale = (go_max > 0) ? 255.0 / go_max : 0.0;
+
+	cairo_surface_t *image = cairo_image_surface_create(CAIRO_FORMAT_RGB24, p.go_x, 2 * p.go_y);
+	cairo_surface_flush(image);
+	unsigned char *pixels = cairo_image_surface_get_data(image);
+	int stride = cairo_image_surface_get_stride(image);
+	for (int y = 0; y < p.go_y; y++)
+	{
+		uint32_t *gr_row = (uint32_t *)(pixels + y * stride);
+		uint32_t *go_row = (uint32_t *)(pixels + (y + p.go_y) * stride);
+		for (int x = 0; x < p.go_x; x++)
+		{
+			gr_row[x] = (uint32_t)(gr_act[y * p.go_x + x] * gr_scale) << 8;
+			go_row[x] = (uint32_t)(go_act[y * p.go_x + x] * go_scale) << 16;
+		}
+	}
+	cairo_surface_mark_dirty(image);
+
+	GdkRectangle da;
+	GdkWindow *window = gtk_widget_get_window(GTK_WIDGET(drawing_area));
+	gdk_window_get_geometry(window, &da.x, &da.y, &da.width, &da.height);
+
+	cairo_scale(cr, da.width / (float)p.go_x, da.height / (float)(2 * p.go_y));
+	cairo_set_source_surface(cr, image, 0, 0);
+	cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_NEAREST);
+	cairo_paint(cr);
+	cairo_surface_destroy(image);
 }
 
 static void draw_gr_raster(GtkWidget *drawing_area, cairo_t *cr, Control *control)
@@ -585,7 +625,7 @@ static void draw_gr_raster(GtkWidget *drawing_area, cairo_t *cr, Control *contro
 
 static void draw_go_raster(GtkWidget *drawing_area, cairo_t *cr, Control *control)
 {
-	draw_raster(drawing_area, cr, control->trial, num_go, control->PSTHColSize, control->rasters[GO]);
+	draw_raster(drawing_area, cr, control->trial, control->getParams().num_go, control->PSTHColSize, control->rasters[GO]);
 }
 
 /* weights plot */
@@ -646,7 +686,8 @@ static void draw_pc_plot(GtkWidget *drawing_area, cairo_t *cr, Control *control)
 	        &da.width,
 	        &da.height);
 
-	float len_scale_y = threshRestPC - threshMaxPC;
+	const sim_params &p = control->getParams();
+	float len_scale_y = p.threshRestPC - p.threshMaxPC;
 	float pc_w_to_pixel_scale_y = -da.height / (9.5 * len_scale_y);
 	float pc_w_to_pixel_scale_x = da.width / (float)control->PSTHColSize;
 
@@ -666,7 +707,7 @@ static void draw_pc_plot(GtkWidget *drawing_area, cairo_t *cr, Control *control)
 	for (int i = 0; i < control->PSTHColSize; i++)
 	{
 		int alternator = 1;
-		for (int j = 0; j < num_pc; j++)
+		for (int j = 0; j < p.num_pc; j++)
 		{
 			float vm_ij = control->pc_vm_raster[j][i] + alternator * 0.2 * ceil(j/2.0) * len_scale_y; 
 			cairo_rectangle(cr, i, vm_ij, 1.0, 0.05);
@@ -688,7 +729,7 @@ static void draw_pc_plot(GtkWidget *drawing_area, cairo_t *cr, Control *control)
 	for (int i = 0; i < control->PSTHColSize; i++)
 	{
 		int alternator = 1;
-		for (int j = 0; j < num_nc; j++)
+		for (int j = 0; j < p.num_nc; j++)
 		{
 			float vm_ij = nc_scale * control->nc_vm_raster[j][i] + nc_offset + alternator * 0.2 * ceil(j/2.0) * len_scale_y; 
 			cairo_rectangle(cr, i, vm_ij, 1.0, 0.05);
@@ -710,7 +751,7 @@ static void draw_pc_plot(GtkWidget *drawing_area, cairo_t *cr, Control *control)
 	for (int i = 0; i < control->PSTHColSize; i++)
 	{
 		int alternator = 1;
-		for (int j = 0; j < num_io; j++)
+		for (int j = 0; j < p.num_io; j++)
 		{
 			float vm_ij = io_scale * control->io_vm_raster[j][i] + io_offset + alternator * 0.2 * ceil(j/2.0) * len_scale_y; 
 			cairo_rectangle(cr, i, vm_ij, 1.0, 0.05);
@@ -784,6 +825,46 @@ static void generate_pc_plot(GtkWidget *widget,
 	gtk_widget_show_all(child_window);
 }
 
+static gboolean queue_spatial_activity_draw(GtkWidget *drawing_area)
+{
+	gtk_widget_queue_draw(drawing_area);
+	return G_SOURCE_CONTINUE;
+}
+
+static void on_spatial_activity_destroy(GtkWidget *drawing_area, Control *control)
+{
+	g_source_remove(GPOINTER_TO_UINT(g_object_get_data(G_OBJECT(drawing_area), "frame_timeout")));
+	if (control->sim_initialized)
+	{
+		control->simCore->getInputNet()->setSpatialActivity(false, SPATIAL_ACT_DECAY_TAU);
+	}
+}
+
+static void on_spatial_activity_window(GtkWidget *widget, Control *control)
+{
+	if (!assert(control->sim_initialized, "Load a simulation first", __func__)) return;
+	control->simCore->getInputNet()->setSpatialActivity(true, SPATIAL_ACT_DECAY_TAU);
+
+	GtkWidget *child_window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+	gtk_window_set_title(GTK_WINDOW(child_window), "Spatial Activity");
+	gtk_window_set_default_size(GTK_WINDOW(child_window),
+								DEFAULT_SPATIAL_ACT_WINDOW_WIDTH,
+								DEFAULT_SPATIAL_ACT_WINDOW_HEIGHT);
+
+	GtkWidget *drawing_area = gtk_drawing_area_new();
+	gtk_widget_set_size_request(drawing_area,
+								DEFAULT_SPATIAL_ACT_WINDOW_WIDTH,
+								DEFAULT_SPATIAL_ACT_WINDOW_HEIGHT);
+	gtk_container_add(GTK_CONTAINER(child_window), drawing_area);
+	g_signal_connect(G_OBJECT(drawing_area), "draw", G_CALLBACK(draw_spatial_activity), control);
+
+	/* runSession pumps gtk events every time step, so this fires at frame rate during runs */
+	guint frame_timeout = g_timeout_add(SPATIAL_ACT_FRAME_MS, (GSourceFunc)queue_spatial_activity_draw, drawing_area);
+	g_object_set_data(G_OBJECT(drawing_area), "frame_timeout", GUINT_TO_POINTER(frame_timeout));
+	g_signal_connect(G_OBJECT(drawing_area), "destroy", G_CALLBACK(on_spatial_activity_destroy), control);
+	gtk_widget_show_all(child_window);
+}
+
 static void on_quit(GtkWidget *widget, Control *control)
 {
 	control->run_state = NOT_IN_RUN;
@@ -1207,6 +1288,15 @@ int gui_init_and_run(int *argc, char ***argv, Control *control)
 								},
 								{}
 							},
+							{"Spatial Activity", gtk_menu_item_new(),
+								{
+									"activate",
+									G_CALLBACK(on_spatial_activity_window),
+									control,
+									false
+								},
+								{}
+							},
 						}
 					}
 				},
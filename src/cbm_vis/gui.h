@@ -17,7 +17,7 @@
 #define NUM_FILE_MENU_ITEMS 4
 #define NUM_WEIGHTS_MENU_ITEMS 4
 #define NUM_RASTER_MENU_ITEMS 8
-#define NUM_ANALYSIS_MENU_ITEMS 1
+#define NUM_ANALYSIS_MENU_ITEMS 2
 #define NUM_TUNING_MENU_ITEMS 1
 #define NUM_FILE_SUB_MENU_ITEMS 2
 
@@ -45,6 +45,12 @@
 #define DEFAULT_PC_WINDOW_WIDTH 1024 
 #define DEFAULT_PC_WINDOW_HEIGHT 1000 
 
+/* spatial activity window constants */
+#define DEFAULT_SPATIAL_ACT_WINDOW_WIDTH 1024
+#define DEFAULT_SPATIAL_ACT_WINDOW_HEIGHT 540
+#define SPATIAL_ACT_FRAME_MS 16 /* ~60 fps */
+#define SPATIAL_ACT_DECAY_TAU 20.0 /* ms */
+
 /* file dialog constants */
 #define DEFAULT_STATE_FILE_NAME "cbm_state.bin"
 #define DEFAULT_SIM_FILE_NAME "cbm_sim.sim"
@@ -145,6 +151,7 @@ struct gui
 	struct menu menu_bar;
 	struct firing_rate_window frw;
 	Control *ctrl_ptr;
+	act_params tuned_params; /* edited by the tuning window, see on_update_weight */
 };
 
 gboolean firing_rates_win_visible(struct gui *gui);
@@ -5,12 +5,15 @@
 #include "file_parse.h"
 #include "tty.h"
 #include "array_util.h"
+#include "alloc_audit.h"
+#include "tracepoints.h"
+#include "roofline.h"
 #include "gui.h" /* tenuous inclide at best :pogO: */
 
 const std::string BIN_EXT = "bin";
 const std::string CELL_IDS[NUM_CELL_TYPES] = {"MF", "GR", "GO", "BC", "SC", "PC", "IO", "NC"}; 
 
-Control::Control(parsed_commandline &p_cl)
+Control::Control(parsed_commandline &p_cl, std::string out_tag) : out_tag(out_tag)
 {
 	tokenized_file t_file;
 	lexed_file l_file;
@@ -28,32 +31,26 @@ Control::Control(parsed_commandline &p_cl)
 	}
 	else if (!p_cl.session_file.empty())
 	{
-		visual_mode = p_cl.vis_mode;
-		run_mode = "run";
-		curr_sess_file_name = p_cl.session_file;
-		curr_sim_file_name  = p_cl.input_sim_file;
-		out_sim_file_name   = p_cl.output_sim_file;
 		parsed_sess_file s_file;
-		tokenize_file(curr_sess_file_name, t_file);
-		lex_tokenized_file(t_file, l_file);
-		parse_lexed_sess_file(l_file, s_file);
-		translate_parsed_trials(s_file, td);
-		trials_data_initialized = true;
-
-		// TODO: move this somewhere else yike
-		trialTime   = std::stoi(s_file.parsed_var_sections["trial_spec"].param_map["trialTime"].value);
-		msPreCS     = std::stoi(s_file.parsed_var_sections["trial_spec"].param_map["msPreCS"].value);
-		msPostCS    = std::stoi(s_file.parsed_var_sections["trial_spec"].param_map["msPostCS"].value);
-		PSTHColSize = msPreCS + td.cs_lens[0] + msPostCS;
-
-		set_plasticity_modes(p_cl);
-		get_raster_filenames(p_cl.raster_files);
-		get_psth_filenames(p_cl.psth_files);
-		get_weights_filenames(p_cl.weights_files);
+		init_session(p_cl, s_file);
 		init_sim(s_file, curr_sim_file_name);
 	}
 }
 
+Control::Control(parsed_commandline &p_cl, parsed_sess_file &s_file, CBMState *con_state,
+	std::iostream &act_file_buf, std::string out_tag) : out_tag(out_tag)
+{
+	init_session_vars(p_cl, s_file);
+	init_sim(s_file, con_state, act_file_buf);
+}
+
+Control::Control(parsed_commandline &p_cl, parsed_sess_file &s_file, Control &prev,
+	std::string out_tag) : out_tag(out_tag)
+{
+	init_session_vars(p_cl, s_file);
+	init_sim(s_file, prev);
+}
+
 Control::~Control()
 {
 	// delete allocated trials_data memory
@@ -64,18 +61,24 @@ Control::~Control()
 	if (simCore)  delete simCore;
 	if (mfFreq)   delete mfFreq;
 	if (mfs)      delete mfs;
+	if (stim)     delete stim;
+	if (digest)   delete digest;
+	if (watchdog) delete watchdog;
+	if (latency)  delete latency;
+	if (weight_stats) delete weight_stats;
 
 	// deallocate output arrays
 	if (raster_arrays_initialized) delete_rasters();
 	if (psth_arrays_initialized)   delete_psths();
 	if (spike_sums_initialized)    delete_spike_sums();
+	if (goSpkCounter) delete[] goSpkCounter;
 }
 
 void Control::build_sim()
 {
 	// TODO: create a separate function to create the state,
 	// have the constructor allocate memory and initialize values
-	if (!simState) simState = new CBMState(numMZones);
+	if (!simState) simState = new CBMState(*this, numMZones);
 }
 
 void Control::set_plasticity_modes(parsed_commandline &p_cl)
@@ -92,28 +95,146 @@ void Control::set_plasticity_modes(parsed_commandline &p_cl)
 	else if (p_cl.mfnc_plasticity == "cascade") mf_nc_plast = CASCADE;
 }
 
+void Control::init_session(parsed_commandline &p_cl, parsed_sess_file &s_file)
+{
+	tokenized_file t_file;
+	lexed_file l_file;
+	tokenize_file(p_cl.session_file, t_file);
+	lex_tokenized_file(t_file, l_file);
+	parse_lexed_sess_file(l_file, s_file);
+	init_session_vars(p_cl, s_file);
+}
+
+void Control::init_session_vars(parsed_commandline &p_cl, parsed_sess_file &s_file)
+{
+	visual_mode = p_cl.vis_mode;
+	run_mode = "run";
+	curr_sess_file_name = p_cl.session_file;
+	curr_sim_file_name  = p_cl.input_sim_file;
+	out_sim_file_name   = p_cl.output_sim_file;
+	translate_parsed_trials(s_file, td);
+	trials_data_initialized = true;
+
+	// TODO: move this somewhere else yike
+	trialTime   = std::stoi(s_file.parsed_var_sections["trial_spec"].param_map["trialTime"].value);
+	msPreCS     = std::stoi(s_file.parsed_var_sections["trial_spec"].param_map["msPreCS"].value);
+	msPostCS    = std::stoi(s_file.parsed_var_sections["trial_spec"].param_map["msPostCS"].value);
+	PSTHColSize = msPreCS + td.cs_lens[0] + msPostCS;
+
+	if (!p_cl.seed.empty()) mfRandSeed = std::stoi(p_cl.seed);
+	stim = new MFStimulus(s_file, td, trialTime, pre_collection_ts, mfRandSeed);
+	set_plasticity_modes(p_cl);
+	get_raster_filenames(p_cl.raster_files);
+	get_psth_filenames(p_cl.psth_files);
+	get_weights_filenames(p_cl.weights_files);
+	if (!p_cl.weights_every.empty()) weights_every = std::stoul(p_cl.weights_every);
+	if (!p_cl.raster_window.empty()) raster_window = std::stoul(p_cl.raster_window);
+	if (!p_cl.weight_stats_file.empty())
+	{
+		weight_stats = new WeightStats(p_cl.weight_stats_file, curr_sess_file_name, curr_sim_file_name);
+	}
+	roofline_file_name = p_cl.roofline_file;
+	if (!p_cl.digest_file.empty())
+	{
+		digest = new StateDigest(p_cl.digest_file, std::stoul(p_cl.digest_every),
+			curr_sess_file_name, curr_sim_file_name);
+	}
+	if (s_file.parsed_var_sections.find("watchdog") != s_file.parsed_var_sections.end())
+	{
+		watchdog = new HealthWatchdog(s_file.parsed_var_sections["watchdog"],
+			OUTPUT_DATA_PATH + get_file_basename(curr_sess_file_name) + out_tag + "_watchdog.txt");
+	}
+	if (!p_cl.latency_file.empty())
+	{
+		latency = new StepLatency(p_cl.latency_file, !p_cl.latency_trials.empty(),
+			!roofline_file_name.empty());
+	}
+}
+
 void Control::init_sim(parsed_sess_file &s_file, std::string in_sim_filename)
 {
-	std::cout << "[INFO]: Initializing simulation...\n";
 	std::fstream sim_file_buf(in_sim_filename.c_str(), std::ios::in | std::ios::binary);
+	init_sim(s_file, sim_file_buf);
+	sim_file_buf.close();
+}
+
+void Control::init_sim(parsed_sess_file &s_file, std::iostream &sim_file_buf)
+{
+	std::cout << "[INFO]: Initializing simulation...\n";
 	read_con_params(sim_file_buf);
 	populate_act_params(s_file);
-	simState = new CBMState(numMZones, sim_file_buf);
-	simCore  = new CBMSimCore(simState, gpuIndex, gpuP2);
+	simState = new CBMState(*this, numMZones, sim_file_buf);
+	init_sim_objects();
+}
+
+void Control::init_sim(parsed_sess_file &s_file, CBMState *con_state, std::iostream &act_file_buf)
+{
+	std::cout << "[INFO]: Initializing simulation...\n";
+	(con_params &)*this = con_state->getParams();
+	con_params_populated = true;
+	numMZones = con_state->getNumZones();
+	populate_act_params(s_file);
+	simState = new CBMState(*this, *con_state, act_file_buf);
+	init_sim_objects();
+}
+
+void Control::init_sim(parsed_sess_file &s_file, Control &prev)
+{
+	std::cout << "[INFO]: Initializing simulation from the end of '" << prev.curr_sess_file_name << "'...\n";
+	(con_params &)*this = prev;
+	con_params_populated = true;
+	numMZones = prev.numMZones;
+	populate_act_params(s_file);
+	simState = prev.simState;
+	simCore  = prev.simCore;
+	/* the core and its device state carry on. act_params holds only floats,
+	 * so there is no padding to compare */
+	if (memcmp((act_params *)this, (act_params *)&prev, sizeof(act_params)) != 0)
+	{
+		std::cout << "[INFO]: Retuning the simulation to the new activity params...\n";
+		simCore->retuneActParams(*this);
+	}
+	prev.simState = NULL;
+	prev.simCore  = NULL;
+	/* prev is done with its output buffers, free them before sizing ours */
+	if (prev.raster_arrays_initialized) prev.delete_rasters();
+	if (prev.psth_arrays_initialized) prev.delete_psths();
+	prev.raster_arrays_initialized = false;
+	prev.psth_arrays_initialized   = false;
+	init_sim_objects();
+}
+
+const sim_params &Control::getParams()
+{
+	return *this;
+}
+
+void Control::retuneActParams(const act_params &tuned)
+{
+	static_cast<act_params &>(*this) = tuned;
+	if (simCore) simCore->retuneActParams(*this);
+}
+
+void Control::init_sim_objects()
+{
+	double start = omp_get_wtime();
+	if (!simCore) simCore = new CBMSimCore(simState, gpuIndex, gpuP2);
+	simCore->setPhaseTiming(!roofline_file_name.empty());
 	mfFreq   = new ECMFPopulation(num_mf, mfRandSeed, CSTonicMFFrac, CSPhasicMFFrac,
 								  contextMFFrac, nucCollFrac, bgFreqMin, csbgFreqMin,
 								  contextFreqMin, tonicFreqMin, phasicFreqMin, bgFreqMax,
 								  csbgFreqMax, contextFreqMax, tonicFreqMax, phasicFreqMax,
 								  collaterals_off, fracImport, secondCS, fracOverlap);
-	mfs = new PoissonRegenCells(mfRandSeed, threshDecayTau, numMZones);
+	stim->compile(*mfFreq, num_mf);
+	mfs = new PoissonRegenCells(*this, mfRandSeed, threshDecayTau, numMZones);
 	initialize_rast_cell_nums();
 	initialize_cell_spikes();
 	initialize_rasters();
 	initialize_psths();
 	initialize_spike_sums();
-	sim_file_buf.close();
+	goSpkCounter = new int[num_go];
 	sim_initialized = true;
-	std::cout << "[INFO]: Simulation initialized.\n";
+	std::cout << "[INFO]: Simulation initialized in " << omp_get_wtime() - start << "s.\n";
 }
 
 void Control::reset_sim(std::string in_sim_filename)
@@ -134,10 +255,12 @@ void Control::reset_sim(std::string in_sim_filename)
 
 void Control::save_sim_to_file(std::string outSimFile)
 {
+	CBM_TRACE1(write__start, outSimFile.c_str());
 	std::fstream outSimFileBuffer(outSimFile.c_str(), std::ios::out | std::ios::binary);
 	write_con_params(outSimFileBuffer);
 	if (!simCore) simState->writeState(outSimFileBuffer);
 	else simCore->writeState(outSimFileBuffer);
+	CBM_TRACE2(write__end, outSimFile.c_str(), (long long)outSimFileBuffer.tellp());
 	outSimFileBuffer.close();
 }
 
@@ -151,9 +274,11 @@ void Control::save_pfpc_weights_to_file(std::string out_pfpc_file)
 		return;
 	}
 	const float *pfpc_weights = simCore->getMZoneList()[0]->exportPFPCWeights();
+	CBM_TRACE1(write__start, out_pfpc_file.c_str());
 	std::fstream outPFPCFileBuffer(out_pfpc_file.c_str(), std::ios::out | std::ios::binary);
 	rawBytesRW((char *)pfpc_weights, num_gr * sizeof(float), false, outPFPCFileBuffer);
 	outPFPCFileBuffer.close();
+	CBM_TRACE2(write__end, out_pfpc_file.c_str(), num_gr * sizeof(float));
 }
 
 void Control::load_pfpc_weights_from_file(std::string in_pfpc_file)
@@ -179,9 +304,11 @@ void Control::save_mfdcn_weights_to_file(std::string out_mfdcn_file)
 	}
 	// TODO: make a export function for mfdcn weights
 	const float *mfdcn_weights = simCore->getMZoneList()[0]->exportMFDCNWeights();
+	CBM_TRACE1(write__start, out_mfdcn_file.c_str());
 	std::fstream outMFDCNFileBuffer(out_mfdcn_file.c_str(), std::ios::out | std::ios::binary);
 	rawBytesRW((char *)mfdcn_weights, num_nc * num_p_nc_from_mf_to_nc * sizeof(const float), false, outMFDCNFileBuffer);
 	outMFDCNFileBuffer.close();
+	CBM_TRACE2(write__end, out_mfdcn_file.c_str(), num_nc * num_p_nc_from_mf_to_nc * sizeof(float));
 }
 
 void Control::load_mfdcn_weights_from_file(std::string in_mfdcn_file)
@@ -282,10 +409,9 @@ void Control::initialize_spike_sums()
 	{
 		ssp->non_cs_spike_sum = 0;
 		ssp->cs_spike_sum     = 0;
-		ssp->non_cs_spike_counter = new uint32_t[ssp->num_cells];
-		ssp->cs_spike_counter = new uint32_t[ssp->num_cells];
-		memset((void *)ssp->non_cs_spike_counter, 0, ssp->num_cells * sizeof(uint32_t));
-		memset((void *)ssp->cs_spike_counter, 0, ssp->num_cells * sizeof(uint32_t));
+		/* calloc: the zero pages are not touched until a counter is written */
+		ssp->non_cs_spike_counter = (uint32_t *)calloc(ssp->num_cells, sizeof(uint32_t));
+		ssp->cs_spike_counter = (uint32_t *)calloc(ssp->num_cells, sizeof(uint32_t));
 	}
 	spike_sums_initialized = true;
 }
@@ -298,14 +424,24 @@ void Control::initialize_rasters()
 		{
 			/* granules are saved every trial, so their raster size is num_gr x PSTHColSize */
 			uint32_t column_size = (CELL_IDS[i] == "GR") ? PSTHColSize : PSTHColSize * td.num_trials;
-			rasters[i] = allocate2DArray<uint8_t>(rast_cell_nums[i], column_size);
+			if (CELL_IDS[i] != "GR" && raster_window > 0 && raster_window < td.num_trials)
+			{
+				raster_spills[i] = new RasterSpill(rf_names[i], rast_cell_nums[i], column_size,
+					PSTHColSize * raster_window);
+				rasters[i] = raster_spills[i]->window();
+			}
+			else rasters[i] = allocate2DArray<uint8_t>(rast_cell_nums[i], column_size);
 		}
 	}
+	raster_window_start = 0;
 
-	// TODO: find a way to initialize only within gui mode
-	pc_vm_raster = allocate2DArray<float>(num_pc, PSTHColSize);
-	nc_vm_raster = allocate2DArray<float>(num_nc, PSTHColSize);
-	io_vm_raster = allocate2DArray<float>(num_io, PSTHColSize);
+	/* membrane potential rasters are only ever drawn by the gui */
+	if (visual_mode == "GUI")
+	{
+		pc_vm_raster = allocate2DArray<float>(num_pc, PSTHColSize);
+		nc_vm_raster = allocate2DArray<float>(num_nc, PSTHColSize);
+		io_vm_raster = allocate2DArray<float>(num_io, PSTHColSize);
+	}
 
 	raster_arrays_initialized = true;
 }
@@ -324,15 +460,14 @@ void Control::runSession(struct gui *gui)
 {
 	float medTrials;
 	double start, end;
-	int goSpkCounter[num_go];
 	if (gui == NULL) run_state = IN_RUN_NO_PAUSE;
 	trial = 0;
 	raster_counter = 0;
 	while (trial < td.num_trials && run_state != NOT_IN_RUN)
 	{
-		std::string trialName = td.trial_names[trial];
+		const std::string &trialName = td.trial_names[trial];
 
-		uint32_t useCS        = td.use_css[trial];
+		const struct mf_segment *mfSegment = stim->trialSegments(trial);
 		uint32_t onsetCS      = pre_collection_ts + td.cs_onsets[trial];
 		uint32_t csLength     = td.cs_lens[trial];
 		uint32_t percentCS    = td.cs_percents[trial];
@@ -346,28 +481,35 @@ void Control::runSession(struct gui *gui)
 		memset(goSpkCounter, 0, num_go * sizeof(int));
 
 		std::cout << "[INFO]: Trial number: " << trial + 1 << "\n";
+		CBM_TRACE2(trial__start, trial, trialName.c_str());
 		start = omp_get_wtime();
+		/* nothing below may allocate until the end of the trial: every buffer
+		 * the step loop writes was sized in init_sim_objects */
+		ALLOC_AUDIT_PHASE(ALLOC_PHASE_STEP);
 		for (int ts = 0; ts < trialTime; ts++)
 		{
+			if (latency) latency->begin_step();
 			if (useUS == 1 && ts == onsetUS) /* deliver the US */
 			{
 				simCore->updateErrDrive(0, 0.3);
 			}
-			if (ts >= onsetCS && ts < onsetCS + csLength)
-			{
-				mfAP = (useCS == 1) ? mfs->calcPoissActivity(mfFreq->getMFInCSTonicA(), simCore->getMZoneList())
-									: mfs->calcPoissActivity(mfFreq->getMFBG(), simCore->getMZoneList());
-			}
-			else
-			{
-				mfAP = mfs->calcPoissActivity(mfFreq->getMFBG(),
-					  simCore->getMZoneList());
-			}
-			
+			if (ts == mfSegment->end_ts) mfSegment++;
+			mfAP = mfs->calcPoissActivity(mfSegment->freqs, simCore->getMZoneList());
+
 			bool *isTrueMF = mfs->calcTrueMFs(mfFreq->getMFBG()); /* only used for mfdcn plasticity */
 			simCore->updateTrueMFs(isTrueMF);
 			simCore->updateMFInput(mfAP);
+			if (latency) latency->mark(STEP_MF_INPUT);
 			simCore->calcActivity(spillFrac, pf_pc_plast, mf_nc_plast); 
+			if (latency) latency->mark(STEP_CORE);
+			if (digest) digest->step(simCore, numMZones, trial, ts, ts == trialTime - 1);
+			if (watchdog && !watchdog->step(simCore, simState, numMZones, trial, ts))
+			{
+				health_check_failed = true;
+				run_state = NOT_IN_RUN;
+				break;
+			}
+			if (latency && (digest || watchdog)) latency->mark(STEP_CHECKS);
 			//update_spike_sums(ts, onsetCS, onsetCS + csLength);
 
 			if (ts >= onsetCS && ts < onsetCS + csLength)
@@ -401,14 +543,23 @@ void Control::runSession(struct gui *gui)
 				PSTHCounter++;
 				raster_counter++;
 			}
+			if (latency) latency->mark(STEP_COLLECT);
 
 			if (gui != NULL)
 			{
+				ALLOC_AUDIT_PHASE(ALLOC_PHASE_GUI);
 				if (gtk_events_pending()) gtk_main_iteration();
+				ALLOC_AUDIT_PHASE(ALLOC_PHASE_STEP);
+				if (latency) latency->mark(STEP_GUI);
 			}
+			if (latency) latency->end_step(simCore);
 		}
+		ALLOC_AUDIT_PHASE(ALLOC_PHASE_TRIAL);
 		end = omp_get_wtime();
+		CBM_TRACE1(trial__end, trial);
+		if (health_check_failed) break;
 		std::cout << "[INFO]: '" << trialName << "' took " << (end - start) << "s.\n";
+		if (latency) latency->end_trial(trialName);
 		
 		if (gui != NULL)
 		{
@@ -421,10 +572,12 @@ void Control::runSession(struct gui *gui)
 			if (run_state == IN_RUN_PAUSE)
 			{
 				std::cout << "[INFO]: Simulation is paused at end of trial " << trial+1 << ".\n";
+				if (latency) latency->pause_boundary();
 				while(run_state == IN_RUN_PAUSE)
 				{
 					if (gtk_events_pending()) gtk_main_iteration();
 				}
+				if (latency) latency->resume_boundary();
 				std::cout << "[INFO]: Continuing...\n";
 			}
 			//reset_spike_sums();
@@ -432,16 +585,37 @@ void Control::runSession(struct gui *gui)
 		// save gr rasters into new file every trial 
 		save_gr_raster();
 		save_weights();
+		spill_rasters();
 		trial++;
 	}
-	if (run_state == NOT_IN_RUN) std::cout << "[INFO]: Simulation terminated.\n";
+	if (health_check_failed)
+	{
+		/* the rasters and psths of a diverged run are garbage; keep only the
+		 * state it diverged in, for post-mortem inspection */
+		std::string snapshot_name = OUTPUT_DATA_PATH + get_file_basename(curr_sess_file_name)
+			+ out_tag + "_watchdog.sim";
+		for (auto spill : raster_spills)
+		{
+			if (spill) spill->discard();
+		}
+		std::cout << "[INFO]: Saving diverged simulation to '" << snapshot_name << "'...\n";
+		save_sim_to_file(snapshot_name);
+		std::cout << "[INFO]: Simulation aborted.\n";
+	}
+	else if (run_state == NOT_IN_RUN) std::cout << "[INFO]: Simulation terminated.\n";
 	else if (run_state == IN_RUN_NO_PAUSE) std::cout << "[INFO]: Simulation Completed.\n";
 	
-	if (gui == NULL)
+	if (gui == NULL && !health_check_failed)
 	{
 		save_rasters();
 		save_psths();
 	}
+	if (!roofline_file_name.empty() && !health_check_failed)
+	{
+		write_roofline_report(roofline_file_name, simCore, pf_pc_plast);
+	}
+	if (latency && !health_check_failed) latency->write_report();
+	ALLOC_AUDIT_REPORT();
 	run_state = NOT_IN_RUN;
 }
 
@@ -463,6 +637,7 @@ void Control::reset_rasters()
 		if (!rf_names[i].empty())
 		{
 			uint32_t column_size = (CELL_IDS[i] == "GR") ? PSTHColSize : (PSTHColSize * td.num_trials);
+			if (raster_spills[i]) column_size = raster_spills[i]->window_cols();
 			memset(rasters[i][0], '\000', rast_cell_nums[i] * column_size * sizeof(uint8_t));
 		}
 	}
@@ -479,10 +654,11 @@ void Control::reset_psths()
 	}
 }
 
-void gen_gr_sample(int gr_indices[], int sample_size, int data_size)
+/* chosen is caller-owned scratch of data_size elements */
+void gen_gr_sample(int gr_indices[], bool chosen[], int sample_size, int data_size)
 {
 	CRandomSFMT0 randGen(0); // replace seed later
-	bool chosen[data_size] = {false}; 
+	memset(chosen, 0, data_size * sizeof(bool));
 	int counter = 0;
 	while (counter < sample_size)
 	{
@@ -498,6 +674,8 @@ void gen_gr_sample(int gr_indices[], int sample_size, int data_size)
 
 void Control::save_weights()
 {
+	if (weight_stats) weight_stats->sample(simCore, numMZones, trial);
+	if (weights_every == 0 || trial % weights_every != 0) return;
 	if (!pf_pc_weights_file.empty())
 	{
 		std::string trial_pfpc_weights_name = OUTPUT_DATA_PATH + get_file_basename(pf_pc_weights_file)
@@ -521,7 +699,9 @@ void Control::save_gr_raster()
 		std::string trial_raster_name = OUTPUT_DATA_PATH + get_file_basename(rf_names[GR])
 									  + "_trial_" + std::to_string(trial) + "." + BIN_EXT;
 		std::cout << "[INFO]: GR Raster file name: " << trial_raster_name << "\n";
+		CBM_TRACE1(write__start, trial_raster_name.c_str());
 		write2DArray<uint8_t>(trial_raster_name, rasters[GR], num_gr, PSTHColSize);
+		CBM_TRACE2(write__end, trial_raster_name.c_str(), (uint64_t)num_gr * PSTHColSize);
 	}
 }
 
@@ -532,7 +712,16 @@ void Control::save_rasters()
 		if (!rf_names[i].empty() && CELL_IDS[i] != "GR")
 		{
 			std::cout << "[INFO]: Filling " << CELL_IDS[i] << " raster file...\n";
-			write2DArray<uint8_t>(rf_names[i], rasters[i], rast_cell_nums[i], PSTHColSize * td.num_trials);
+			CBM_TRACE1(write__start, rf_names[i].c_str());
+			if (raster_spills[i])
+			{
+				if (!raster_spills[i]->finish(raster_counter - raster_window_start))
+				{
+					std::cerr << "[IO_ERROR]: " << CELL_IDS[i] << " raster file '" << rf_names[i] << "' is incomplete.\n";
+				}
+			}
+			else write2DArray<uint8_t>(rf_names[i], rasters[i], rast_cell_nums[i], PSTHColSize * td.num_trials);
+			CBM_TRACE2(write__end, rf_names[i].c_str(), (uint64_t)rast_cell_nums[i] * PSTHColSize * td.num_trials);
 		}
 	}
 }
@@ -544,7 +733,9 @@ void Control::save_psths()
 		if (!pf_names[i].empty())
 		{
 			std::cout << "[INFO]: Filling " << CELL_IDS[i] << " psth file...\n";
+			CBM_TRACE1(write__start, pf_names[i].c_str());
 			write2DArray<uint8_t>(pf_names[i], psths[i], rast_cell_nums[i], PSTHColSize);
+			CBM_TRACE2(write__end, pf_names[i].c_str(), (uint64_t)rast_cell_nums[i] * PSTHColSize);
 		}
 	}
 }
@@ -631,11 +822,12 @@ void Control::fill_rasters(uint32_t raster_counter, uint32_t psth_counter, struc
 		{
 			/* GR spikes are only spikes not saved on host every time step:
 			 * InNet::exportAPGR makes cudaMemcpy call before returning pointer to mem address */
-			if (CELL_IDS[i] == "GR")
+			if (i == GR)
 			{
 				cell_spks[i] = simCore->getInputNet()->exportAPGR();
 				temp_counter = psth_counter;
 			}
+			else temp_counter -= raster_window_start;
 			for (uint32_t j = 0; j < rast_cell_nums[i]; j++)
 			{
 				rasters[i][j][temp_counter] = cell_spks[i][j];
@@ -682,20 +874,41 @@ void Control::delete_spike_sums()
 {
 	FOREACH(spike_sums, ssp)
 	{
-		delete[] ssp->non_cs_spike_counter;
-		delete[] ssp->cs_spike_counter;
+		free(ssp->non_cs_spike_counter);
+		free(ssp->cs_spike_counter);
 	}
 }
 
+void Control::spill_rasters()
+{
+	if (raster_window == 0) return;
+	uint32_t num_filled = raster_counter - raster_window_start;
+	if (num_filled + PSTHColSize <= raster_window * PSTHColSize) return;
+	bool spilled = false;
+	for (uint32_t i = 0; i < NUM_CELL_TYPES; i++)
+	{
+		if (!raster_spills[i]) continue;
+		raster_spills[i]->spill(num_filled);
+		rasters[i] = raster_spills[i]->window();
+		spilled = true;
+	}
+	if (spilled) raster_window_start = raster_counter;
+}
+
 void Control::delete_rasters()
 {
 	for (uint32_t i = 0; i < NUM_CELL_TYPES; i++)
 	{
-		if (!rf_names[i].empty()) delete2DArray<uint8_t>(rasters[i]);
+		if (raster_spills[i])
+		{
+			delete raster_spills[i];
+			raster_spills[i] = NULL;
+		}
+		else if (!rf_names[i].empty()) delete2DArray<uint8_t>(rasters[i]);
 	}
-	delete2DArray<float>(pc_vm_raster);
-	delete2DArray<float>(nc_vm_raster);
-	delete2DArray<float>(io_vm_raster);
+	if (pc_vm_raster) delete2DArray<float>(pc_vm_raster);
+	if (nc_vm_raster) delete2DArray<float>(nc_vm_raster);
+	if (io_vm_raster) delete2DArray<float>(io_vm_raster);
 }
 
 void Control::delete_psths()
@@ -10,15 +10,20 @@
 
 #include "commandline.h"
 #include <cstdint>
-#include "connectivityparams.h"
-#include "activityparams.h"
+#include "simparams.h"
 #include "cbmstate.h"
 #include "innetconnectivitystate.h"
 #include "innetactivitystate.h"
 #include "cbmsimcore.h"
 #include "ecmfpopulation.h"
 #include "poissonregencells.h"
+#include "mf_stimulus.h"
 #include "bits.h"
+#include "state_digest.h"
+#include "health_watchdog.h"
+#include "step_latency.h"
+#include "weight_stats.h"
+#include "raster_spill.h"
 
 // TODO: place in a common place, as gui uses a constant like this too
 #define NUM_CELL_TYPES 8
@@ -45,18 +50,44 @@ struct cell_firing_rates
 
 enum sim_run_state {NOT_IN_RUN, IN_RUN_NO_PAUSE, IN_RUN_PAUSE};
 
-class Control 
+/* Control owns the parameter context of its simulation: it populates it from
+ * the build or session file and hands it to the objects it creates */
+class Control : protected sim_params
 {
 	public:
-		Control(parsed_commandline &p_cl);
+		Control(parsed_commandline &p_cl, std::string out_tag = "");
+		/* sweep points and server jobs: s_file is already parsed (and carries
+		 * the run's activity params), the connectivity is shared with con_state
+		 * and the activity state is read from act_file_buf (see CBMState).
+		 * out_tag is appended to the names of the files this control writes on
+		 * its own account */
+		Control(parsed_commandline &p_cl, parsed_sess_file &s_file, CBMState *con_state,
+			std::iostream &act_file_buf, std::string out_tag);
+		/* pipeline mode: s_file is already parsed, and the simulation is taken
+		 * over from prev, as left by its last session, which leaves prev without
+		 * one. out_tag as for sweep mode */
+		Control(parsed_commandline &p_cl, parsed_sess_file &s_file, Control &prev,
+			std::string out_tag);
 		~Control();
 
+		/* the simulation's param context. it is read only once populated: the
+		 * one way to change it is retuneActParams */
+		const sim_params &getParams();
+		/* copies tuned into the context and retunes the simulation with it, if
+		 * one is built (see CBMSimCore::retuneActParams) */
+		void retuneActParams(const act_params &tuned);
+
 		// Objects
 		trials_data td;
 		CBMState *simState     = NULL;
 		CBMSimCore *simCore    = NULL;
 		ECMFPopulation *mfFreq = NULL;
 		PoissonRegenCells *mfs = NULL;
+		MFStimulus *stim       = NULL;
+		StateDigest *digest    = NULL;
+		HealthWatchdog *watchdog = NULL;
+		StepLatency *latency   = NULL;
+		WeightStats *weight_stats = NULL;
 
 		/* temporary state check vars, going to refactor soon */
 		bool trials_data_initialized = false;
@@ -66,6 +97,8 @@ class Control
 		bool psth_arrays_initialized   = false;
 		bool spike_sums_initialized    = false;
 		enum sim_run_state run_state   = NOT_IN_RUN; 
+		/* set when the watchdog stopped the last session */
+		bool health_check_failed       = false;
 
 		std::string visual_mode          = "";
 		std::string run_mode             = "";
@@ -73,6 +106,9 @@ class Control
 		std::string curr_sess_file_name  = "";
 		std::string curr_sim_file_name   = "";
 		std::string out_sim_file_name    = "";
+		std::string out_tag              = "";
+		/* set by -P: time the phases of every step and report them at the end */
+		std::string roofline_file_name   = "";
 
 		// params that I do not know how to categorize
 		float goMin = 0.26; 
@@ -138,6 +174,8 @@ class Control
 
 		std::string pf_pc_weights_file = "";
 		std::string mf_nc_weights_file = "";
+		/* save_weights dumps the full weights every this many trials, 0 for never */
+		uint32_t weights_every = 1;
 
 		struct cell_spike_sums spike_sums[NUM_CELL_TYPES];
 		struct cell_firing_rates firing_rates[NUM_CELL_TYPES];
@@ -146,22 +184,35 @@ class Control
 		const float *grgoG, *mfgoG, *gogrG, *mfgrG;
 		float *sample_pfpc_syn_weights; //TODO: remove, write function to save at end of session
 		const uint8_t *mfAP, *goSpks;
+		int *goSpkCounter = NULL; /* per-trial GO spike counts, scratch for runSession */
 		
 		const uint8_t *cell_spks[NUM_CELL_TYPES];
 		int rast_cell_nums[NUM_CELL_TYPES];
 		uint8_t **rasters[NUM_CELL_TYPES];
+		/* set by -M: session rasters keep raster_window trials in memory and
+		 * spill the rest to their files. rasters[i] is then the spill's window,
+		 * which starts at column raster_window_start */
+		uint32_t raster_window       = 0;
+		uint32_t raster_window_start = 0;
+		RasterSpill *raster_spills[NUM_CELL_TYPES] = {};
 		uint8_t **psths[NUM_CELL_TYPES];
 
 		uint32_t rast_sizes[NUM_CELL_TYPES]; 
 
-		float **pc_vm_raster;
-		float **nc_vm_raster;
-		float **io_vm_raster;
+		float **pc_vm_raster = NULL;
+		float **nc_vm_raster = NULL;
+		float **io_vm_raster = NULL;
 
 		void build_sim();
 
 		void set_plasticity_modes(parsed_commandline &p_cl);
+		void init_session(parsed_commandline &p_cl, parsed_sess_file &s_file);
+		void init_session_vars(parsed_commandline &p_cl, parsed_sess_file &s_file);
 		void init_sim(parsed_sess_file &s_file, std::string in_sim_filename);
+		void init_sim(parsed_sess_file &s_file, std::iostream &sim_file_buf);
+		void init_sim(parsed_sess_file &s_file, CBMState *con_state, std::iostream &act_file_buf);
+		void init_sim(parsed_sess_file &s_file, Control &prev);
+		void init_sim_objects();
 		void reset_sim(std::string in_sim_filename);
 
 		void save_sim_to_file(std::string outSimFile);
@@ -190,6 +241,9 @@ class Control
 		void calculate_firing_rates(float onset_cs, float offset_cs);
 		void fill_rasters(uint32_t raster_counter, uint32_t psth_counter, struct gui *gui);
 		void fill_psths(uint32_t psth_counter);
+		/* called after every trial: spills the raster windows if the next
+		 * trial would not fit in them */
+		void spill_rasters();
 		void save_weights();
 		void save_gr_raster();
 		void save_rasters();
@@ -0,0 +1,170 @@
+/*
+ * File: alloc_audit.cpp
+ *
+ * Description:
+ *     This file implements the function prototypes in alloc_audit.h
+ *
+ * Implementation Notes:
+ *     Only compiled in when ALLOC_AUDIT is defined. malloc, calloc, realloc,
+ *     free and the aligned variants are defined here, in the executable, so the
+ *     dynamic linker binds every call to them (from libstdc++ included) ahead
+ *     of glibc's. Each one bumps the counter of the current phase and forwards
+ *     to glibc's own implementation through its __libc_ entry points, so the
+ *     underlying allocator is unchanged.
+ *
+ *     The hooks must not allocate themselves: the counters are lock-free
+ *     atomics, and the backtrace of the first step-phase allocation is taken
+ *     under a thread-local guard, since backtrace() may itself call malloc the
+ *     first time it runs. The backtrace is symbolized only at report time,
+ *     with backtrace_symbols_fd, which writes straight to the fd.
+ */
+#ifdef ALLOC_AUDIT
+
+#include <iostream>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <execinfo.h>
+#include <unistd.h>
+
+#include "alloc_audit.h"
+
+#define ALLOC_AUDIT_MAX_FRAMES 32
+
+extern "C"
+{
+	void *__libc_malloc(size_t size);
+	void *__libc_calloc(size_t num, size_t size);
+	void *__libc_realloc(void *ptr, size_t size);
+	void *__libc_memalign(size_t alignment, size_t size);
+	void __libc_free(void *ptr);
+}
+
+/* everything the auditor keeps. there is one per process, as there is one
+ * malloc. every member is initialized in place so that the auditor is set up
+ * at compile time, before any constructor can allocate */
+struct alloc_auditor
+{
+	std::atomic<int> curr_phase{ALLOC_PHASE_INIT};
+	std::atomic<uint64_t> phase_counts[NUM_ALLOC_PHASES] = {};
+	std::atomic<uint64_t> phase_bytes[NUM_ALLOC_PHASES]  = {};
+
+	/* step_trace_len is stored after the frames, so a report sees them all */
+	std::atomic<bool> step_trace_taken{false};
+	void *step_trace[ALLOC_AUDIT_MAX_FRAMES] = {};
+	std::atomic<int> step_trace_len{0};
+};
+
+static struct alloc_auditor auditor;
+
+static __thread bool in_hook = false;
+
+static void record_alloc(size_t size)
+{
+	if (in_hook) return;
+	int phase = auditor.curr_phase.load(std::memory_order_relaxed);
+	auditor.phase_counts[phase].fetch_add(1, std::memory_order_relaxed);
+	auditor.phase_bytes[phase].fetch_add(size, std::memory_order_relaxed);
+	if (phase == ALLOC_PHASE_STEP && !auditor.step_trace_taken.exchange(true))
+	{
+		in_hook = true;
+		int len = backtrace(auditor.step_trace, ALLOC_AUDIT_MAX_FRAMES);
+		auditor.step_trace_len.store(len, std::memory_order_release);
+		in_hook = false;
+	}
+}
+
+extern "C"
+{
+	void *malloc(size_t size)
+	{
+		record_alloc(size);
+		return __libc_malloc(size);
+	}
+
+	void *calloc(size_t num, size_t size)
+	{
+		record_alloc(num * size);
+		return __libc_calloc(num, size);
+	}
+
+	void *realloc(void *ptr, size_t size)
+	{
+		record_alloc(size);
+		return __libc_realloc(ptr, size);
+	}
+
+	void free(void *ptr)
+	{
+		__libc_free(ptr);
+	}
+
+	void *memalign(size_t alignment, size_t size)
+	{
+		record_alloc(size);
+		return __libc_memalign(alignment, size);
+	}
+
+	void *aligned_alloc(size_t alignment, size_t size)
+	{
+		record_alloc(size);
+		return __libc_memalign(alignment, size);
+	}
+
+	int posix_memalign(void **ptr, size_t alignment, size_t size)
+	{
+		if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0) return EINVAL;
+		record_alloc(size);
+		void *mem = __libc_memalign(alignment, size);
+		if (!mem) return ENOMEM;
+		*ptr = mem;
+		return 0;
+	}
+}
+
+void alloc_audit_set_phase(enum alloc_phase phase)
+{
+	static std::atomic<bool> warmed_up{false};
+	if (!warmed_up.exchange(true))
+	{
+		/* the first backtrace() loads the unwinder, which allocates */
+		void *frames[1];
+		in_hook = true;
+		backtrace(frames, 1);
+		in_hook = false;
+	}
+	auditor.curr_phase.store(phase, std::memory_order_relaxed);
+}
+
+uint64_t alloc_audit_count(enum alloc_phase phase)
+{
+	return auditor.phase_counts[phase].load(std::memory_order_relaxed);
+}
+
+bool alloc_audit_report()
+{
+	const char *phase_names[NUM_ALLOC_PHASES] = {"init", "trial", "step", "gui"};
+	int prev_phase = auditor.curr_phase.exchange(ALLOC_PHASE_INIT);
+
+	std::cout << "[INFO]: Heap allocations by phase:\n";
+	for (int i = 0; i < NUM_ALLOC_PHASES; i++)
+	{
+		std::cout << "[INFO]:     " << phase_names[i] << ": " << auditor.phase_counts[i].load()
+				  << " (" << auditor.phase_bytes[i].load() << " bytes)\n";
+	}
+
+	bool step_clean = auditor.phase_counts[ALLOC_PHASE_STEP].load() == 0;
+	if (!step_clean)
+	{
+		std::cerr << "[ERROR]: " << auditor.phase_counts[ALLOC_PHASE_STEP].load()
+				  << " heap allocation(s) in the step loop. The first came from:\n";
+		std::cerr.flush();
+		backtrace_symbols_fd(auditor.step_trace, auditor.step_trace_len.load(std::memory_order_acquire),
+			STDERR_FILENO);
+	}
+	auditor.curr_phase.store(prev_phase);
+	return step_clean;
+}
+
+#endif /* ALLOC_AUDIT */
+
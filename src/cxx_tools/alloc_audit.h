@@ -0,0 +1,52 @@
+/*
+ * File: alloc_audit.h
+ *
+ * Description:
+ *     Interface for the heap allocation auditor, a debug aid for keeping the
+ *     simulation's step loop free of allocator traffic. Built with
+ *     'make ALLOC_AUDIT=1', the program interposes malloc and friends (which
+ *     operator new goes through) and counts every allocation against the
+ *     phase the program is in when it happens. At the end of a session the
+ *     counts are reported, along with a backtrace of the first allocation made
+ *     in the step phase, if any was.
+ *
+ *     In normal builds the macros below expand to nothing and malloc is left
+ *     alone.
+ *
+ *     The phase is process-wide: in a sweep with more than one worker, the
+ *     workers' phases overlap and the per-phase counts are only approximate.
+ */
+#ifndef ALLOC_AUDIT_H_
+#define ALLOC_AUDIT_H_
+
+#include <cstdint>
+
+enum alloc_phase
+{
+	ALLOC_PHASE_INIT,  /* construction, file reads: anything goes */
+	ALLOC_PHASE_TRIAL, /* between trials: per-trial saves and logging */
+	ALLOC_PHASE_STEP,  /* inside the time step loop: must stay at zero */
+	ALLOC_PHASE_GUI,   /* gtk event pumping from within the step loop */
+	NUM_ALLOC_PHASES
+};
+
+#ifdef ALLOC_AUDIT
+
+void alloc_audit_set_phase(enum alloc_phase phase);
+uint64_t alloc_audit_count(enum alloc_phase phase);
+
+/* prints the per-phase counts. returns false if the step phase allocated */
+bool alloc_audit_report();
+
+#define ALLOC_AUDIT_PHASE(phase) alloc_audit_set_phase(phase)
+#define ALLOC_AUDIT_REPORT() alloc_audit_report()
+
+#else
+
+#define ALLOC_AUDIT_PHASE(phase) ((void)0)
+#define ALLOC_AUDIT_REPORT() ((void)0)
+
+#endif /* ALLOC_AUDIT */
+
+#endif /* ALLOC_AUDIT_H_ */
+
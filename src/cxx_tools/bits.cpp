@@ -1,76 +1,336 @@
+/*
+ * file: bits.cpp
+ *
+ * Implementation Notes:
+ *     Words are always read and written through load_le64/store_le64 so that
+ *     bit k of a word corresponds to bit (k % 8) of byte (k / 8) regardless of
+ *     host byte order and alignment; on x86 these compile down to plain movs.
+ *
+ *     The SWAR fallbacks rely on two multiply tricks:
+ *       - pack: with each byte of w in {0, 1}, (w * 0x0102040810204080) >> 56
+ *         gathers byte i into bit i with no carries between partial products.
+ *       - unpack: broadcasting a byte to all eight lanes and masking lane i
+ *         with bit i leaves a non-zero lane iff that bit was set; adding 0x7F
+ *         per lane moves that into the lane's high bit.
+ *
+ *     Each path is picked at compile time from the target's flags. Defining
+ *     BITS_NO_VECTOR leaves out the SSE2/AVX2 loops and BITS_NO_BMI2 the
+ *     pext/pdep ones, so that tests/bits_test.cpp can build and check every
+ *     path on one machine.
+ */
 #include <stdio.h>
-#include <math.h>
+#include <string.h>
+#if defined(__SSE2__) && !defined(BITS_NO_VECTOR)
+#define BITS_USE_SSE2
+#endif
+#if defined(__AVX2__) && !defined(BITS_NO_VECTOR)
+#define BITS_USE_AVX2
+#endif
+#if defined(__BMI2__) && !defined(BITS_NO_BMI2)
+#define BITS_USE_BMI2
+#endif
+
+#if defined(BITS_USE_SSE2) || defined(BITS_USE_BMI2)
+#include <immintrin.h>
+#endif
 #include "bits.h"
-#include "array_util.h"
 
-void pack_byte_array(uint8_t *byte_arr,
-					 const uint32_t byte_arr_len,
+#define LSB_PER_BYTE  0x0101010101010101ULL
+#define LOW7_PER_BYTE 0x7F7F7F7F7F7F7F7FULL
+
+static inline uint64_t load_le64(const uint8_t *src)
+{
+	uint64_t w;
+	memcpy(&w, src, sizeof(uint64_t));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	w = __builtin_bswap64(w);
+#endif
+	return w;
+}
+
+static inline void store_le64(uint8_t *dst, uint64_t w)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	w = __builtin_bswap64(w);
+#endif
+	memcpy(dst, &w, sizeof(uint64_t));
+}
+
+/* partial loads/stores for the ragged edges of rows */
+static inline uint64_t load_le_partial(const uint8_t *src, uint64_t num_bytes)
+{
+	uint64_t w = 0;
+	for (uint64_t i = 0; i < num_bytes; i++) w |= (uint64_t)src[i] << (BITS_PER_BYTE * i);
+	return w;
+}
+
+static inline void store_le_partial(uint8_t *dst, uint64_t w, uint64_t num_bytes)
+{
+	for (uint64_t i = 0; i < num_bytes; i++) dst[i] = (uint8_t)(w >> (BITS_PER_BYTE * i));
+}
+
+/* maps every non-zero byte of w to 0x01 and every zero byte to 0x00 */
+static inline uint64_t nonzero_bytes_to_lsb(uint64_t w)
+{
+	return ((((w & LOW7_PER_BYTE) + LOW7_PER_BYTE) | w) >> 7) & LSB_PER_BYTE;
+}
+
+/* gathers the low bit of each byte of w into one byte */
+static inline uint8_t pack_word(uint64_t w)
+{
+	w = nonzero_bytes_to_lsb(w);
+#if defined(BITS_USE_BMI2)
+	return (uint8_t)_pext_u64(w, LSB_PER_BYTE);
+#else
+	return (uint8_t)((w * 0x0102040810204080ULL) >> 56);
+#endif
+}
+
+/* scatters the bits of b into the low bit of each byte of the result */
+static inline uint64_t unpack_word(uint8_t b)
+{
+#if defined(BITS_USE_BMI2)
+	return _pdep_u64(b, LSB_PER_BYTE);
+#else
+	uint64_t w = ((uint64_t)b * LSB_PER_BYTE) & 0x8040201008040201ULL;
+	return ((w + LOW7_PER_BYTE) >> 7) & LSB_PER_BYTE;
+#endif
+}
+
+void pack_byte_array(const uint8_t *byte_arr,
+					 const uint64_t byte_arr_len,
 					 uint8_t *packed_byte_arr)
 {
-	uint8_t packed_elem_i = '\000';
-	uint32_t bit_counter = 1;
-	for (uint32_t i = 0; i < byte_arr_len; i++)
+	uint64_t i = 0;
+#if defined(BITS_USE_AVX2)
+	const __m256i zero_256 = _mm256_setzero_si256();
+	for (; i + 32 <= byte_arr_len; i += 32)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i *)(byte_arr + i));
+		uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero_256));
+		store_le_partial(packed_byte_arr + i / BITS_PER_BYTE, mask, 4);
+	}
+#endif
+#if defined(BITS_USE_SSE2)
+	const __m128i zero_128 = _mm_setzero_si128();
+	for (; i + 16 <= byte_arr_len; i += 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(byte_arr + i));
+		uint32_t mask = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero_128));
+		store_le_partial(packed_byte_arr + i / BITS_PER_BYTE, mask, 2);
+	}
+#endif
+	for (; i + BITS_PER_BYTE <= byte_arr_len; i += BITS_PER_BYTE)
 	{
-		uint32_t bit_index  = i % 8;
-		uint8_t temp_byte = byte_arr[i];
-		packed_elem_i |= temp_byte << bit_index;
-		if (bit_counter == 8)
+		packed_byte_arr[i / BITS_PER_BYTE] = pack_word(load_le64(byte_arr + i));
+	}
+	if (i < byte_arr_len)
+	{
+		uint8_t last = 0;
+		for (uint64_t j = 0; i + j < byte_arr_len; j++)
 		{
-			uint32_t byte_index = floor(i / 8);
-			packed_byte_arr[byte_index] = packed_elem_i;
-			packed_elem_i = '\000';
-			bit_counter = 1;
+			last |= (byte_arr[i + j] != 0) << j;
 		}
-		else bit_counter++;
+		packed_byte_arr[i / BITS_PER_BYTE] = last;
 	}
 }
 
-// TODO: DEBUG
 void pack_2d_byte_array(uint8_t **byte_arr_2d,
-						const uint32_t byte_arr_num_rows, /* num cells */
-						const uint32_t byte_arr_num_cols, /* per trial time steps */
+						const uint64_t byte_arr_num_rows, /* num cells */
+						const uint64_t byte_arr_num_cols, /* per trial time steps */
 						uint8_t *packed_byte_arr,
-						uint32_t offset)
+						uint64_t offset)
 {
+	const uint64_t packed_row_len = packed_byte_len(byte_arr_num_cols);
 	uint8_t *packed_byte_arr_cpy = packed_byte_arr + offset;
-	for (uint32_t i = 0; i < byte_arr_num_rows; i++)
+	for (uint64_t i = 0; i < byte_arr_num_rows; i++)
 	{
 		pack_byte_array(byte_arr_2d[i], byte_arr_num_cols, packed_byte_arr_cpy);
-		packed_byte_arr_cpy += (byte_arr_num_cols / 8);
+		packed_byte_arr_cpy += packed_row_len;
 	}
 }
 
-void unpack_byte_array(uint8_t *packed_byte_arr,
+void unpack_byte_array(const uint8_t *packed_byte_arr,
 					   uint8_t *unpacked_byte_arr,
-					   const uint32_t unpacked_byte_arr_len)
+					   const uint64_t unpacked_byte_arr_len)
 {
-	uint8_t bit_mask = '\001';
-	for (uint32_t i = 0; i < unpacked_byte_arr_len; i++)
+	uint64_t i = 0;
+	for (; i + BITS_PER_BYTE <= unpacked_byte_arr_len; i += BITS_PER_BYTE)
 	{
-		uint32_t bit_index = i % 8;
-		uint32_t byte_index = floor(i / 8); 
-		uint8_t temp_byte = packed_byte_arr[byte_index] & (bit_mask << bit_index);
-		unpacked_byte_arr[i] = (temp_byte >> bit_index);
+		store_le64(unpacked_byte_arr + i, unpack_word(packed_byte_arr[i / BITS_PER_BYTE]));
+	}
+	for (; i < unpacked_byte_arr_len; i++)
+	{
+		unpacked_byte_arr[i] = (packed_byte_arr[i / BITS_PER_BYTE] >> (i % BITS_PER_BYTE)) & 1;
+	}
+}
+
+uint64_t transpose_8x8(uint64_t block)
+{
+	uint64_t t;
+	t = (block ^ (block >> 7)) & 0x00AA00AA00AA00AAULL;
+	block ^= t ^ (t << 7);
+	t = (block ^ (block >> 14)) & 0x0000CCCC0000CCCCULL;
+	block ^= t ^ (t << 14);
+	t = (block ^ (block >> 28)) & 0x00000000F0F0F0F0ULL;
+	block ^= t ^ (t << 28);
+	return block;
+}
+
+void transpose_64x64(uint64_t block[BITS_PER_WORD])
+{
+	/* recursive block swap: at width j, exchange the upper-right and lower-left
+	 * j x j sub-blocks of every 2j x 2j tile */
+	uint64_t mask = 0x00000000FFFFFFFFULL;
+	for (uint32_t j = 32; j != 0; j >>= 1, mask ^= (mask << j))
+	{
+		for (uint32_t k = 0; k < BITS_PER_WORD; k = ((k | j) + 1) & ~j)
+		{
+			uint64_t t = ((block[k] >> j) ^ block[k | j]) & mask;
+			block[k]     ^= t << j;
+			block[k | j] ^= t;
+		}
+	}
+}
+
+void transpose_packed_bits(const uint8_t *src,
+						   const uint64_t num_rows,
+						   const uint64_t num_cols,
+						   uint8_t *dst)
+{
+	const uint64_t src_stride = packed_byte_len(num_cols);
+	const uint64_t dst_stride = packed_byte_len(num_rows);
+	uint64_t block[BITS_PER_WORD];
+
+	for (uint64_t row_base = 0; row_base < num_rows; row_base += BITS_PER_WORD)
+	{
+		uint64_t block_rows = num_rows - row_base;
+		if (block_rows > BITS_PER_WORD) block_rows = BITS_PER_WORD;
+		uint64_t dst_bytes = dst_stride - row_base / BITS_PER_BYTE;
+		if (dst_bytes > sizeof(uint64_t)) dst_bytes = sizeof(uint64_t);
+
+		for (uint64_t col_base = 0; col_base < num_cols; col_base += BITS_PER_WORD)
+		{
+			uint64_t block_cols = num_cols - col_base;
+			if (block_cols > BITS_PER_WORD) block_cols = BITS_PER_WORD;
+			uint64_t src_bytes = src_stride - col_base / BITS_PER_BYTE;
+			uint64_t col_mask = (block_cols == BITS_PER_WORD) ? ~0ULL : ((1ULL << block_cols) - 1);
+
+			for (uint64_t r = 0; r < block_rows; r++)
+			{
+				const uint8_t *src_row = src + (row_base + r) * src_stride + col_base / BITS_PER_BYTE;
+				uint64_t w = (src_bytes >= sizeof(uint64_t)) ? load_le64(src_row)
+														   : load_le_partial(src_row, src_bytes);
+				block[r] = w & col_mask;
+			}
+			for (uint64_t r = block_rows; r < BITS_PER_WORD; r++) block[r] = 0;
+
+			transpose_64x64(block);
+
+			for (uint64_t c = 0; c < block_cols; c++)
+			{
+				uint8_t *dst_row = dst + (col_base + c) * dst_stride + row_base / BITS_PER_BYTE;
+				if (dst_bytes == sizeof(uint64_t)) store_le64(dst_row, block[c]);
+				else store_le_partial(dst_row, block[c], dst_bytes);
+			}
+		}
+	}
+}
+
+uint64_t popcount_bytes(const uint8_t *packed_byte_arr, const uint64_t num_bytes)
+{
+	uint64_t count = 0;
+	uint64_t i = 0;
+	for (; i + sizeof(uint64_t) <= num_bytes; i += sizeof(uint64_t))
+	{
+		count += __builtin_popcountll(load_le64(packed_byte_arr + i));
+	}
+	for (; i < num_bytes; i++) count += __builtin_popcount(packed_byte_arr[i]);
+	return count;
+}
+
+uint64_t count_nonzero_bytes(const uint8_t *byte_arr, const uint64_t byte_arr_len)
+{
+	uint64_t count = 0;
+	uint64_t i = 0;
+#if defined(BITS_USE_SSE2)
+	const __m128i zero_128 = _mm_setzero_si128();
+	for (; i + 16 <= byte_arr_len; i += 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(byte_arr + i));
+		uint32_t zero_mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero_128));
+		count += 16 - __builtin_popcount(zero_mask);
+	}
+#endif
+	for (; i + sizeof(uint64_t) <= byte_arr_len; i += sizeof(uint64_t))
+	{
+		count += __builtin_popcountll(nonzero_bytes_to_lsb(load_le64(byte_arr + i)));
+	}
+	for (; i < byte_arr_len; i++) count += (byte_arr[i] != 0);
+	return count;
+}
+
+/* the row loops below stream one input row at a time over the whole output,
+ * which keeps the inner loop a plain word-wise op the compiler vectorizes */
+void or_packed_rows(const uint8_t *const *rows,
+					const uint64_t num_rows,
+					const uint64_t row_bytes,
+					uint8_t *out)
+{
+	if (num_rows == 0)
+	{
+		memset(out, 0, row_bytes);
+		return;
+	}
+	if (out != rows[0]) memmove(out, rows[0], row_bytes);
+	for (uint64_t r = 1; r < num_rows; r++)
+	{
+		const uint8_t *row = rows[r];
+		uint64_t i = 0;
+		for (; i + sizeof(uint64_t) <= row_bytes; i += sizeof(uint64_t))
+		{
+			store_le64(out + i, load_le64(out + i) | load_le64(row + i));
+		}
+		for (; i < row_bytes; i++) out[i] |= row[i];
+	}
+}
+
+void and_packed_rows(const uint8_t *const *rows,
+					 const uint64_t num_rows,
+					 const uint64_t row_bytes,
+					 uint8_t *out)
+{
+	if (num_rows == 0)
+	{
+		memset(out, 0xFF, row_bytes);
+		return;
+	}
+	if (out != rows[0]) memmove(out, rows[0], row_bytes);
+	for (uint64_t r = 1; r < num_rows; r++)
+	{
+		const uint8_t *row = rows[r];
+		uint64_t i = 0;
+		for (; i + sizeof(uint64_t) <= row_bytes; i += sizeof(uint64_t))
+		{
+			store_le64(out + i, load_le64(out + i) & load_le64(row + i));
+		}
+		for (; i < row_bytes; i++) out[i] &= row[i];
 	}
 }
 
 void print_byte_bit_repr(uint8_t byte)
 {
-	uint8_t bit_flag = '\001';
 	char byte_as_str[BITS_PER_BYTE+1];
 	for (uint32_t i = 0; i < BITS_PER_BYTE; i++)
 	{
-		bit_flag &= byte >> i;
-		if (bit_flag == '\001') byte_as_str[BITS_PER_BYTE - i - 1] = '1';
-		else if (bit_flag == '\000') byte_as_str[BITS_PER_BYTE - i - 1] = '0';
-		bit_flag = '\001';
+		byte_as_str[BITS_PER_BYTE - i - 1] = ((byte >> i) & 1) ? '1' : '0';
 	}
 	byte_as_str[BITS_PER_BYTE] = '\0';
 	puts(byte_as_str);
 }
 
-void print_byte_bit_repr_arr(uint8_t *bytes)
+void print_byte_bit_repr_arr(const uint8_t *bytes, const uint64_t num_bytes)
 {
-	FOREACH(bytes, bp) print_byte_bit_repr(*bp);
+	for (uint64_t i = 0; i < num_bytes; i++) print_byte_bit_repr(bytes[i]);
 }
 
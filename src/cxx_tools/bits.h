@@ -1,32 +1,121 @@
+/*
+ * file: bits.h
+ *
+ * Description:
+ *     Bit-level helpers for spike data. Spikes live in byte arrays (one uint8_t
+ *     per cell per time step) throughout the simulation; these routines pack
+ *     those byte arrays into bit arrays and back, transpose bit matrices, count
+ *     set bits and combine rows of bits. Packing is little-endian within each
+ *     byte: element i of a byte array maps to bit (i % 8) of packed byte (i / 8).
+ *     Any non-zero input byte packs to a set bit.
+ *
+ *     Where the target supports it (SSE2/AVX2 movemask, BMI2 pext/pdep, popcnt)
+ *     the inner loops are vectorized; every routine has a portable 64-bit SWAR
+ *     fallback and handles arbitrary lengths, including partial trailing bytes.
+ *
+ */
 #ifndef BITS_H_
-#define BITS_H_  
+#define BITS_H_
 
 #include <stdint.h>
+#include <stddef.h>
 
 #define BITS_PER_BYTE 8
+#define BITS_PER_WORD 64
 
-void populate_byte_arr(uint8_t *byte_arr, const uint32_t byte_arr_len);
+/* number of packed bytes needed to hold num_bits bits */
+inline uint64_t packed_byte_len(uint64_t num_bits)
+{
+	return (num_bits + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+}
 
-void populate_random_byte_arr(uint8_t *byte_arr,
-								 const uint32_t byte_arr_len);
-
-void pack_byte_array(uint8_t *byte_arr,
-					 const uint32_t byte_arr_len,
+/*
+ * Description:
+ *     packs byte_arr_len bytes into packed_byte_len(byte_arr_len) bytes of
+ *     packed_byte_arr. unused high bits of the last packed byte are zeroed.
+ */
+void pack_byte_array(const uint8_t *byte_arr,
+					 const uint64_t byte_arr_len,
 					 uint8_t *packed_byte_arr);
 
+/*
+ * Description:
+ *     packs each row of byte_arr_2d into packed_byte_arr starting at offset
+ *     bytes. every row begins on a byte boundary, so the packed row stride is
+ *     packed_byte_len(byte_arr_num_cols) bytes.
+ */
 void pack_2d_byte_array(uint8_t **byte_arr_2d,
-					 const uint32_t byte_arr_num_rows,
-					 const uint32_t byte_arr_num_cols,
+					 const uint64_t byte_arr_num_rows,
+					 const uint64_t byte_arr_num_cols,
 					 uint8_t *packed_byte_arr,
-					 uint32_t offset);
-
-void print_byte_bit_repr(uint8_t byte);
+					 uint64_t offset);
 
-void unpack_byte_array(uint8_t *packed_byte_arr,
+/*
+ * Description:
+ *     inverse of pack_byte_array: writes unpacked_byte_arr_len bytes, each 0 or 1.
+ */
+void unpack_byte_array(const uint8_t *packed_byte_arr,
 					   uint8_t *unpacked_byte_arr,
-					   const uint32_t unpacked_byte_arr_len);
+					   const uint64_t unpacked_byte_arr_len);
+
+/*
+ * Description:
+ *     transposes an 8x8 bit matrix held in a 64-bit word, where byte r holds
+ *     row r and bit c of that byte holds column c.
+ */
+uint64_t transpose_8x8(uint64_t block);
+
+/*
+ * Description:
+ *     transposes, in place, a 64x64 bit matrix where word r holds row r and
+ *     bit c of that word holds column c.
+ */
+void transpose_64x64(uint64_t block[BITS_PER_WORD]);
+
+/*
+ * Description:
+ *     transposes a packed num_rows x num_cols bit matrix. src rows have a
+ *     stride of packed_byte_len(num_cols) bytes and dst rows (num_cols of them)
+ *     a stride of packed_byte_len(num_rows) bytes. use this to turn per-step
+ *     population spike vectors into per-cell spike trains, or vice versa.
+ */
+void transpose_packed_bits(const uint8_t *src,
+						   const uint64_t num_rows,
+						   const uint64_t num_cols,
+						   uint8_t *dst);
+
+/*
+ * Description:
+ *     number of set bits in the first num_bytes bytes of packed_byte_arr.
+ */
+uint64_t popcount_bytes(const uint8_t *packed_byte_arr, const uint64_t num_bytes);
+
+/*
+ * Description:
+ *     number of non-zero bytes in an unpacked byte array, ie the spike count
+ *     of a byte raster row or population vector.
+ */
+uint64_t count_nonzero_bytes(const uint8_t *byte_arr, const uint64_t byte_arr_len);
+
+/*
+ * Description:
+ *     bitwise OR (resp. AND) of num_rows packed rows of row_bytes bytes each
+ *     into out. out may alias rows[0]. for num_rows == 0, out is set to all
+ *     zeros (resp. all ones).
+ */
+void or_packed_rows(const uint8_t *const *rows,
+					const uint64_t num_rows,
+					const uint64_t row_bytes,
+					uint8_t *out);
+
+void and_packed_rows(const uint8_t *const *rows,
+					 const uint64_t num_rows,
+					 const uint64_t row_bytes,
+					 uint8_t *out);
+
+void print_byte_bit_repr(uint8_t byte);
 
-void print_byte_bit_repr_arr(uint8_t *bytes);
+void print_byte_bit_repr_arr(const uint8_t *bytes, const uint64_t num_bytes);
 
-#endif /* BITS_H_ */ 
+#endif /* BITS_H_ */
 
@@ -13,6 +13,9 @@
 #include <sstream>
 #include <algorithm>
 #include <utility>
+#include <climits>
+#include <cerrno>
+#include <cstdlib>
 #include "commandline.h"
 #include <cstdint>
 
@@ -22,6 +25,8 @@ const std::vector<std::string> command_line_single_opts
 	"--mfnc-off",
 	"--binary",
 	"--cascade",
+	"--save-stages",
+	"--latency-trials",
 };
 
 const std::vector<std::pair<std::string, std::string>> command_line_pair_opts 
@@ -34,7 +39,26 @@ const std::vector<std::pair<std::string, std::string>> command_line_pair_opts
 	{ "-o", "--output"  },
 	{ "-r", "--raster"  },
 	{ "-p", "--psth"    },
-	{ "-w", "--weights" }
+	{ "-w", "--weights" },
+	{ "-S", "--seed"    },
+	{ "-d", "--daemon"  },
+	{ "-n", "--workers" },
+	{ "-R", "--realtime"   },
+	{ "-T", "--rt-steps"   },
+	{ "-D", "--rt-degrade" },
+	{ "-g", "--digest"       },
+	{ "-G", "--digest-every" },
+	{ "-c", "--compare"      },
+	{ "-t", "--tolerance"    },
+	{ "-X", "--sweep"        },
+	{ "-P", "--roofline"     },
+	{ "-k", "--pack-rasters" },
+	{ "-q", "--slice"        },
+	{ "-L", "--pipeline"     },
+	{ "-l", "--latency"      },
+	{ "-W", "--weight-stats"  },
+	{ "-e", "--weights-every" },
+	{ "-M", "--raster-window" }
 };
 
 bool is_cmd_opt(std::string in_str)
@@ -43,6 +67,11 @@ bool is_cmd_opt(std::string in_str)
 	{
 		if (in_str == opt.first || in_str == opt.second) return true;
 	}
+	/* so that lists of params end at a flag, too */
+	for (auto opt : command_line_single_opts)
+	{
+		if (in_str == opt) return true;
+	}
 	return false;
 }
 
@@ -61,6 +90,24 @@ std::string get_opt_param(std::vector<std::string> &token_buf, std::string opt)
 	return "";
 }
 
+/* returns 0 if value is a whole number in [min, max], so that std::stoi and
+ * friends read it without throwing, else prints why not and returns 17 */
+static int check_int_opt(std::string value, std::string opt, long long min, long long max)
+{
+	size_t digits = (!value.empty() && value[0] == '-') ? 1 : 0;
+	bool valid = digits < value.size() && value.find_first_not_of("0123456789", digits) == std::string::npos;
+	if (valid)
+	{
+		errno = 0;
+		long long number = strtoll(value.c_str(), NULL, 10);
+		valid = errno != ERANGE && number >= min && number <= max;
+	}
+	if (valid) return 0;
+	std::cerr << "[ERROR]: '" << value << "' is not a valid argument for " << opt << ". It takes a whole\n"
+			  << "[ERROR]: number from " << min << " to " << max << ". See {-h|--help} for usage. Exiting...\n";
+	return 17;
+}
+
 void print_usage_info()
 {
 	std::cout << "Usage: ./cbm_sim [options]\n";
@@ -71,6 +118,27 @@ void print_usage_info()
 	std::cout << std::right << std::setw(20) << "\t-s, --session [FILE]" << "\tsets the simulation to run a session using FILE as the session file\n";
 	std::cout << std::right << std::setw(20) << "\t-i, --input [FILE]" << "\tspecify the input simulation file\n";
 	std::cout << std::right << std::setw(20) << "\t-o, --output [FILE]" << "\tspecify the output simulation file\n";
+	std::cout << std::right << std::setw(20) << "\t-S, --seed [INT]" << "\tspecify the random seed for mossy fiber generation\n";
+	std::cout << std::right << std::setw(20) << "\t-d, --daemon [SOCKET]" << "\truns as a simulation server listening for session jobs on the unix socket SOCKET\n";
+	std::cout << std::right << std::setw(20) << "\t-n, --workers [INT]" << "\tnumber of jobs the simulation server runs at once (default 1)\n";
+	std::cout << std::right << std::setw(20) << "\t-R, --realtime [SOCKET]" << "\truns the session closed loop in real time, exchanging inputs and NC output with a plant on SOCKET\n";
+	std::cout << std::right << std::setw(20) << "\t-T, --rt-steps [INT]" << "\tnumber of real-time steps to run; 0 (default) runs until the plant stops\n";
+	std::cout << std::right << std::setw(20) << "\t-D, --rt-degrade [off|collect|output]" << "\twhat real-time mode skips when a step risks its deadline (default collect)\n";
+	std::cout << std::right << std::setw(20) << "\t-g, --digest [FILE]" << "\twrites per-trial state digests (hashes and summary statistics of all cell state) to FILE\n";
+	std::cout << std::right << std::setw(20) << "\t-G, --digest-every [INT]" << "\talso digest every INT time steps; 0 (default) digests at the end of each trial only\n";
+	std::cout << std::right << std::setw(20) << "\t-c, --compare [FILE] [FILE]" << "\tcompares two digest files, reports the first diverging step and variable, and exits\n";
+	std::cout << std::right << std::setw(20) << "\t-t, --tolerance [FLOAT]" << "\trelative tolerance for --compare; 0 (default) requires bitwise identical state\n";
+	std::cout << std::right << std::setw(20) << "\t-X, --sweep [FILE]" << "\truns the session once per point of the activity parameter sweep in FILE, -n points at a time\n";
+	std::cout << std::right << std::setw(20) << "\t-P, --roofline [FILE]" << "\ttimes each phase of the time step and writes its bandwidth and roofline report to FILE\n";
+	std::cout << std::right << std::setw(20) << "\t-k, --pack-rasters [FILE]" << "\tmerges the rasters a session run saved with -r into the raster pack FILE and exits; give the run's -s and -r\n";
+	std::cout << std::right << std::setw(20) << "\t-q, --slice [PACK] [CODE] [T0:T1] [C0:C1] [FILE]" << "\twrites trials T0 to T1 of cells C0 to C1 of PACK's CODE raster to FILE and exits\n";
+	std::cout << std::right << std::setw(20) << "\t-L, --pipeline [FILE ...]" << "\truns the session FILEs one after the other on the input simulation, carrying its state from each to the next in memory\n";
+	std::cout << std::right << std::setw(20) << "\t-W, --weight-stats [FILE]" << "\twrites per-PC, per-NC and per-zone weight distribution summaries to FILE at the end of every trial\n";
+	std::cout << std::right << std::setw(20) << "\t-e, --weights-every [INT]" << "\tsaves the full weights given with -w every INT trials only; 0 saves none (default 1)\n";
+	std::cout << std::right << std::setw(20) << "\t-M, --raster-window [INT]" << "\tkeeps only INT trials of each -r raster in memory, writing the rest to its file as the session runs\n";
+	std::cout << std::right << std::setw(20) << "\t-l, --latency [FILE]" << "\trecords the latency of every time step and trial boundary and writes their percentiles to FILE\n";
+	std::cout << std::right << std::setw(10) << "\t--latency-trials" << "\talso prints the step latency percentiles of each trial at its end\n";
+	std::cout << std::right << std::setw(10) << "\t--save-stages" << "\t\talso saves the simulation after each pipeline stage but the last, tagged '_s<stage>'\n";
 	std::cout << std::right << std::setw(10) << "\t--pfpc-off|--binary|--cascade" << "\tturns off or sets PFPC plasticity mode; options are mutually exclusive and work as follows:\n\n";
 	std::cout << "\t\t\t\t \t--pfpc-off - turns PFPC plasticity off\n";
 	std::cout << "\t\t\t\t \t--binary - turns PFPC plasticity on and sets the type of plasticity to 'dual' ie 'binary'\n";
@@ -98,6 +166,25 @@ void print_usage_info()
 	std::cout << "3) uses file 'acquisition.sess' to train the input simulation 'bunny.sim' with PFPC and MFNC plasticity on and set to graded;\n";
 	std::cout << "   PC, SC, and BC rasters are saved to files 'allPCRaster.bin' 'allSCRaster.bin' and 'allBCRaster.bin' respectively:\n\n";
 	std::cout << "\t./cbm_sim -s acquisition.sess -i bunny.sim -r PC,allPCRaster SC,allSCRaster BC,allBCRaster\n\n";
+	std::cout << "4) starts a simulation server on socket 'cbm.sock' with 'bunny.sim' preloaded. Each line a client sends is\n";
+	std::cout << "   'run' followed by run-mode options as in 2) and 3); 'load FILE', 'status' and 'shutdown' are also understood:\n\n";
+	std::cout << "\t./cbm_sim -d cbm.sock -i bunny.sim -n 2\n";
+	std::cout << "\techo 'run -s acquisition.sess -i bunny.sim -S 7 -r PC,allPCRaster' | nc -U cbm.sock\n\n";
+	std::cout << "5) runs the session of 2) twice, once per engine build, writing digests every 100 steps, then checks the runs agree:\n\n";
+	std::cout << "\t./cbm_sim -s acquisition.sess -i bunny.sim -g ref.dgst -G 100\n";
+	std::cout << "\t./cbm_sim -s acquisition.sess -i bunny.sim -g new.dgst -G 100\n";
+	std::cout << "\t./cbm_sim -c ref.dgst new.dgst\n\n";
+	std::cout << "6) runs the session of 2) at every point of the sweep in 'gogr.swp', four points at a time, each\n";
+	std::cout << "   saving its PC raster to 'allPCRaster_p<point>'; per-point results are streamed to 'gogr_results.txt':\n\n";
+	std::cout << "\t./cbm_sim -s acquisition.sess -i bunny.sim -X gogr.swp -n 4 -r PC,allPCRaster\n\n";
+	std::cout << "7) packs the PC and GR rasters of a run of 3) into 'acq.rpk', then extracts the PC raster of trials 100 to 199\n";
+	std::cout << "   (cells 0 to 15, every step) to 'pc_late.bin', laid out trial by cell by step. Range ends are exclusive\n";
+	std::cout << "   and either side may be left out:\n\n";
+	std::cout << "\t./cbm_sim -s acquisition.sess -r PC,allPCRaster GR,allGRRaster -k acq.rpk\n";
+	std::cout << "\t./cbm_sim -q acq.rpk PC 100:200 0:16 pc_late.bin\n\n";
+	std::cout << "8) trains 'bunny.sim' with 'acquisition.sess', then 'extinction.sess', then 'probe.sess' in one run, saving only the\n";
+	std::cout << "   final state to 'bunny_ext.sim'. Each stage saves its PC raster to 'allPCRaster_s<stage>', stages counting from 0:\n\n";
+	std::cout << "\t./cbm_sim -L acquisition.sess extinction.sess probe.sess -i bunny.sim -o bunny_ext.sim -r PC,allPCRaster\n\n";
 }
 
 
@@ -109,7 +196,13 @@ void parse_commandline(int *argc, char ***argv, parsed_commandline &p_cl)
 	{
 		tokens.push_back(std::string(*iter));
 	}
+	int parse_status = parse_commandline_tokens(tokens, p_cl);
+	if (parse_status != 0) exit(parse_status);
+	validate_commandline(p_cl);
+}
 
+int parse_commandline_tokens(std::vector<std::string> &tokens, parsed_commandline &p_cl)
+{
 	for (auto opt : command_line_single_opts)
 	{
 		if (cmd_opt_exists(tokens, opt) == 1)
@@ -130,6 +223,12 @@ void parse_commandline(int *argc, char ***argv, parsed_commandline &p_cl)
 				case 'c':
 					p_cl.pfpc_plasticity = "cascade";
 					break;
+				case 's':
+					p_cl.save_stages = "yes";
+					break;
+				case 'l':
+					p_cl.latency_trials = "yes";
+					break;
 			}
 		}
 	}
@@ -154,13 +253,12 @@ void parse_commandline(int *argc, char ***argv, parsed_commandline &p_cl)
 			case 2:
 				std::cerr << "[IO_ERROR]: Specified both short and long command line option. You can specify only one\n"
 						  << "[IO_ERROR]: argumnet for each command line argument type. Exiting...\n";
-				exit(9);
-				break;
+				return 9;
 			case 1:
 				this_opt = (first_opt_exist == 1) ? opt.first : opt.second;
-				// both give the same thing, it is a matter of which exists, the
-				// long or the short version.
-				opt_char_code = (first_opt_exist == 1) ? this_opt[1] : this_opt[2];
+				// dispatch on the short version so that long names are free to
+				// share a first letter (e.g. --session and --seed)
+				opt_char_code = opt.first[1];
 				if (opt_char_code == 'h') p_cl.print_help = "help";
 				else 
 				{
@@ -184,6 +282,75 @@ void parse_commandline(int *argc, char ***argv, parsed_commandline &p_cl)
 					case 'o':
 						p_cl.output_sim_file = this_param;
 						break;
+					case 'S':
+						p_cl.seed = this_param;
+						break;
+					case 'd':
+						p_cl.daemon_socket = this_param;
+						break;
+					case 'n':
+						p_cl.num_workers = this_param;
+						break;
+					case 'R':
+						p_cl.realtime_socket = this_param;
+						break;
+					case 'T':
+						p_cl.rt_steps = this_param;
+						break;
+					case 'D':
+						p_cl.rt_degrade = this_param;
+						break;
+					case 'g':
+						p_cl.digest_file = this_param;
+						break;
+					case 'G':
+						p_cl.digest_every = this_param;
+						break;
+					case 't':
+						p_cl.digest_tol = this_param;
+						break;
+					case 'X':
+						p_cl.sweep_file = this_param;
+						break;
+					case 'P':
+						p_cl.roofline_file = this_param;
+						break;
+					case 'k':
+						p_cl.pack_file = this_param;
+						break;
+					case 'l':
+						p_cl.latency_file = this_param;
+						break;
+					case 'W':
+						p_cl.weight_stats_file = this_param;
+						break;
+					case 'e':
+						p_cl.weights_every = this_param;
+						break;
+					case 'M':
+						p_cl.raster_window = this_param;
+						break;
+					case 'L':
+						while (curr_token_iter != tokens.end() && !is_cmd_opt(*curr_token_iter))
+						{
+							p_cl.pipeline_files.push_back(*curr_token_iter);
+							curr_token_iter++;
+						}
+						break;
+					case 'q':
+						while (curr_token_iter != tokens.end() && !is_cmd_opt(*curr_token_iter))
+						{
+							p_cl.slice_args.push_back(*curr_token_iter);
+							curr_token_iter++;
+						}
+						break;
+					case 'c':
+						while (curr_token_iter != tokens.end() && !is_cmd_opt(*curr_token_iter))
+						{
+							p_cl.compare_files.push_back(*curr_token_iter);
+							curr_token_iter++;
+						}
+						break;
 					case 'r':
 						while (curr_token_iter != tokens.end() && !is_cmd_opt(*curr_token_iter))
 						{
@@ -191,8 +358,7 @@ void parse_commandline(int *argc, char ***argv, parsed_commandline &p_cl)
 							if (div == std::string::npos)
 							{
 								std::cerr << "[IO_ERROR]: Comma not given for raster argument '" << *curr_token_iter << "'. Exiting...\n";
-								exit(8);
-								// we have a problem, so exit
+								return 8;
 							}
 							raster_code = curr_token_iter->substr(0, div);
 							raster_file_name = curr_token_iter->substr(div+1);
@@ -207,8 +373,7 @@ void parse_commandline(int *argc, char ***argv, parsed_commandline &p_cl)
 							if (div == std::string::npos)
 							{
 								std::cerr << "[IO_ERROR]: Comma not given for raster argument '" << *curr_token_iter << "'. Exiting...\n";
-								exit(8);
-								// we have a problem, so exit
+								return 8;
 							}
 							psth_code = curr_token_iter->substr(0, div);
 							psth_file_name = curr_token_iter->substr(div+1);
@@ -223,8 +388,7 @@ void parse_commandline(int *argc, char ***argv, parsed_commandline &p_cl)
 							if (div == std::string::npos)
 							{
 								std::cerr << "[IO_ERROR]: Comma not given for weights argument '" << *curr_token_iter << "'. Exiting...\n";
-								exit(9);
-								// we have a problem, so exit
+								return 9;
 							}
 							weights_code = curr_token_iter->substr(0, div);
 							weights_file_name = curr_token_iter->substr(div+1);
@@ -239,7 +403,7 @@ void parse_commandline(int *argc, char ***argv, parsed_commandline &p_cl)
 				break;
 		}
 	}
-	validate_commandline(p_cl);
+	return 0;
 }
 
 void validate_commandline(parsed_commandline &p_cl)
@@ -252,6 +416,68 @@ void validate_commandline(parsed_commandline &p_cl)
 		print_usage_info();
 		exit(0);
 	}
+	if (!p_cl.compare_files.empty())
+	{
+		if (p_cl.compare_files.size() != 2)
+		{
+			std::cerr << "[IO_ERROR]: Comparing digests takes exactly two digest files. Exiting...\n";
+			exit(12);
+		}
+		for (auto &file_name : p_cl.compare_files)
+		{
+			file_name = OUTPUT_DATA_PATH + file_name;
+		}
+		if (p_cl.digest_tol.empty()) p_cl.digest_tol = "0";
+		return;
+	}
+	if (!p_cl.pack_file.empty())
+	{
+		if (p_cl.session_file.empty() || p_cl.raster_files.empty())
+		{
+			std::cerr << "[IO_ERROR]: Packing rasters takes the session file and the rasters of the run\n"
+					  << "[IO_ERROR]: ({-s|--session} and {-r|--raster}). Exiting...\n";
+			exit(14);
+		}
+		p_cl.session_file = INPUT_DATA_PATH + p_cl.session_file;
+		for (auto iter = p_cl.raster_files.begin(); iter != p_cl.raster_files.end(); iter++)
+		{
+			iter->second = OUTPUT_DATA_PATH + iter->second;
+		}
+		p_cl.pack_file = OUTPUT_DATA_PATH + p_cl.pack_file;
+		return;
+	}
+	if (!p_cl.slice_args.empty())
+	{
+		if (p_cl.slice_args.size() != 5)
+		{
+			std::cerr << "[IO_ERROR]: A slice takes a raster pack, a cell type code, a trial range, a cell range\n"
+					  << "[IO_ERROR]: and an output file. Exiting...\n";
+			exit(14);
+		}
+		p_cl.slice_args[0] = OUTPUT_DATA_PATH + p_cl.slice_args[0];
+		p_cl.slice_args[4] = OUTPUT_DATA_PATH + p_cl.slice_args[4];
+		return;
+	}
+	if (!p_cl.daemon_socket.empty())
+	{
+		if (!p_cl.build_file.empty() || !p_cl.session_file.empty())
+		{
+			std::cerr << "[IO_ERROR]: Cannot specify a build or session file in daemon mode. Sessions are\n"
+					  << "[IO_ERROR]: submitted to the server as jobs. Exiting...\n";
+			exit(10);
+		}
+		if (!p_cl.input_sim_file.empty())
+		{
+			p_cl.input_sim_file = INPUT_DATA_PATH + p_cl.input_sim_file;
+		}
+		if (p_cl.num_workers.empty())
+		{
+			p_cl.num_workers = "1";
+		}
+		int workers_status = check_int_opt(p_cl.num_workers, "{-n|--workers}", 0, INT_MAX);
+		if (workers_status != 0) exit(workers_status);
+		return;
+	}
 	if (!p_cl.build_file.empty())
 	{
 		if (!p_cl.session_file.empty())
@@ -271,78 +497,191 @@ void validate_commandline(parsed_commandline &p_cl)
 		}
 		p_cl.build_file = INPUT_DATA_PATH + p_cl.build_file;
 	}
-	else if (!p_cl.session_file.empty())
+	else if (!p_cl.pipeline_files.empty())
 	{
-		if (!p_cl.build_file.empty())
+		if (!p_cl.session_file.empty())
 		{
-			std::cerr << "[IO_ERROR]: Cannot specify both build and session file. Exiting.\n";
-			exit(6);
+			std::cerr << "[IO_ERROR]: Cannot specify both a session file and a pipeline. Exiting...\n";
+			exit(15);
 		}
-		if (!p_cl.output_sim_file.empty())
+		p_cl.session_file = p_cl.pipeline_files[0];
+		int session_status = validate_session_commandline(p_cl);
+		if (session_status != 0) exit(session_status);
+		if (p_cl.vis_mode != "TUI" || !p_cl.realtime_socket.empty() || !p_cl.sweep_file.empty())
 		{
-			p_cl.output_sim_file = INPUT_DATA_PATH + p_cl.output_sim_file;
+			std::cerr << "[IO_ERROR]: Pipelines can only be run in TUI mode, and not in real time or as a sweep. Exiting...\n";
+			exit(15);
 		}
-		if (!p_cl.input_sim_file.empty())
+		for (auto &file_name : p_cl.pipeline_files)
 		{
-			p_cl.input_sim_file = INPUT_DATA_PATH + p_cl.input_sim_file;
+			file_name = INPUT_DATA_PATH + file_name;
 		}
-		else
+		p_cl.session_file = "";
+	}
+	else if (!p_cl.session_file.empty())
+	{
+		int session_status = validate_session_commandline(p_cl);
+		if (session_status != 0) exit(session_status);
+	}
+	else
+	{
+		std::cerr << "[IO_ERROR]: Run mode not specified. You must provide either {-b|--build}, {-s|--session} or {-L|--pipeline}\n"
+				  << "[IO_ERROR]: arguments. Exiting...\n";
+		exit(7);
+	}
+}
+
+int validate_session_commandline(parsed_commandline &p_cl)
+{
+	if (!p_cl.build_file.empty())
+	{
+		std::cerr << "[IO_ERROR]: Cannot specify both build and session file. Exiting.\n";
+		return 6;
+	}
+	if (!p_cl.output_sim_file.empty())
+	{
+		p_cl.output_sim_file = INPUT_DATA_PATH + p_cl.output_sim_file;
+	}
+	if (!p_cl.input_sim_file.empty())
+	{
+		p_cl.input_sim_file = INPUT_DATA_PATH + p_cl.input_sim_file;
+	}
+	else
+	{
+		std::cerr << "[IO_ERROR]: No input simulation specified in run mode. Exiting...\n";
+		return 8;
+	}
+	if (!p_cl.seed.empty())
+	{
+		/* the seed is read on the thread that runs the session, which for a sim
+		 * server job is a worker that must not throw */
+		int seed_status = check_int_opt(p_cl.seed, "{-S|--seed}", INT_MIN, INT_MAX);
+		if (seed_status != 0) return seed_status;
+	}
+	if (p_cl.pfpc_plasticity.empty())
+	{
+		std::cout << "[INFO]: Turning PFPC plasticity on to default mode 'graded'...\n";
+		p_cl.pfpc_plasticity = "graded";
+	}
+	else
+	{
+		// just notify user what we already set above
+		if (p_cl.pfpc_plasticity == "dual") std::cout << "[INFO]: Turning PFPC plasticity on in 'dual' mode...\n";
+		else if (p_cl.pfpc_plasticity == "cascade") std::cout << "[INFO]: Turning PFPC plasticity on in 'cascade' mode...\n";
+		else if (p_cl.pfpc_plasticity == "off") std::cout << "[INFO]: Turning PFPC plasticity off..\n";
+	}
+	if (p_cl.mfnc_plasticity.empty())
+	{
+		std::cout << "[INFO]: Turning MFNC plasticity on to default mode 'graded'...\n";
+		p_cl.mfnc_plasticity = "graded";
+	}
+	else if (p_cl.mfnc_plasticity == "off") std::cout << "[INFO]: Turning MFNC plasticity off...\n";
+	if (!p_cl.raster_files.empty())
+	{
+		for (auto iter = p_cl.raster_files.begin(); iter != p_cl.raster_files.end(); iter++)
 		{
-			std::cerr << "[IO_ERROR]: No input simulation specified in run mode. Exiting...\n";
-			exit(8);
+			iter->second = OUTPUT_DATA_PATH + iter->second;
 		}
-		if (p_cl.pfpc_plasticity.empty())
+	}
+	if (!p_cl.psth_files.empty())
+	{
+		for (auto iter = p_cl.psth_files.begin(); iter != p_cl.psth_files.end(); iter++)
 		{
-			std::cout << "[INFO]: Turning PFPC plasticity on to default mode 'graded'...\n";
-			p_cl.pfpc_plasticity = "graded";
+			iter->second = OUTPUT_DATA_PATH + iter->second;
 		}
-		else
+	}
+	if (!p_cl.weights_files.empty())
+	{
+		for (auto iter = p_cl.weights_files.begin(); iter != p_cl.weights_files.end(); iter++)
 		{
-			// just notify user what we already set above
-			if (p_cl.pfpc_plasticity == "dual") std::cout << "[INFO]: Turning PFPC plasticity on in 'dual' mode...\n";
-			else if (p_cl.pfpc_plasticity == "cascade") std::cout << "[INFO]: Turning PFPC plasticity on in 'cascade' mode...\n";
-			else if (p_cl.pfpc_plasticity == "off") std::cout << "[INFO]: Turning PFPC plasticity off..\n";
+			iter->second = OUTPUT_DATA_PATH + iter->second;
 		}
-		if (p_cl.mfnc_plasticity.empty())
+	}
+	if (p_cl.vis_mode.empty())
+	{
+		std::cout << "[INFO]: Visual mode not specified in run mode. Setting to default value of 'TUI'...\n";
+		p_cl.vis_mode = "TUI";
+	}
+	if (!p_cl.realtime_socket.empty())
+	{
+		if (p_cl.vis_mode != "TUI")
 		{
-			std::cout << "[INFO]: Turning MFNC plasticity on to default mode 'graded'...\n";
-			p_cl.mfnc_plasticity = "graded";
+			std::cerr << "[IO_ERROR]: Real-time mode can only be run in TUI mode. Exiting...\n";
+			return 11;
 		}
-		else if (p_cl.mfnc_plasticity == "off") std::cout << "[INFO]: Turning MFNC plasticity off...\n";
-		if (!p_cl.raster_files.empty())
+		if (p_cl.rt_steps.empty()) p_cl.rt_steps = "0";
+		int steps_status = check_int_opt(p_cl.rt_steps, "{-T|--rt-steps}", 0, LLONG_MAX);
+		if (steps_status != 0) return steps_status;
+		if (p_cl.rt_degrade.empty()) p_cl.rt_degrade = "collect";
+		else if (p_cl.rt_degrade != "off" && p_cl.rt_degrade != "collect" && p_cl.rt_degrade != "output")
 		{
-			for (auto iter = p_cl.raster_files.begin(); iter != p_cl.raster_files.end(); iter++)
-			{
-				iter->second = OUTPUT_DATA_PATH + iter->second;
-			}
+			std::cerr << "[IO_ERROR]: Unknown real-time degrade mode '" << p_cl.rt_degrade << "'. Exiting...\n";
+			return 11;
 		}
-		if (!p_cl.psth_files.empty())
+	}
+	if (!p_cl.digest_file.empty())
+	{
+		p_cl.digest_file = OUTPUT_DATA_PATH + p_cl.digest_file;
+		if (p_cl.digest_every.empty()) p_cl.digest_every = "0";
+		int every_status = check_int_opt(p_cl.digest_every, "{-G|--digest-every}", 0, UINT_MAX);
+		if (every_status != 0) return every_status;
+	}
+	if (!p_cl.roofline_file.empty())
+	{
+		if (!p_cl.realtime_socket.empty())
 		{
-			for (auto iter = p_cl.psth_files.begin(); iter != p_cl.psth_files.end(); iter++)
-			{
-				iter->second = OUTPUT_DATA_PATH + iter->second;
-			}
+			/* phase timing syncs the GPUs every phase, which would wreck the step budget */
+			std::cerr << "[IO_ERROR]: The roofline report cannot be made in real-time mode. Exiting...\n";
+			return 11;
 		}
-		if (!p_cl.weights_files.empty())
+		p_cl.roofline_file = OUTPUT_DATA_PATH + p_cl.roofline_file;
+	}
+	if (!p_cl.weight_stats_file.empty())
+	{
+		p_cl.weight_stats_file = OUTPUT_DATA_PATH + p_cl.weight_stats_file;
+	}
+	if (p_cl.weights_every.empty()) p_cl.weights_every = "1";
+	int weights_every_status = check_int_opt(p_cl.weights_every, "{-e|--weights-every}", 0, UINT_MAX);
+	if (weights_every_status != 0) return weights_every_status;
+	if (!p_cl.raster_window.empty())
+	{
+		int window_status = check_int_opt(p_cl.raster_window, "{-M|--raster-window}", 0, UINT_MAX);
+		if (window_status != 0) return window_status;
+		if (p_cl.vis_mode != "TUI" || !p_cl.realtime_socket.empty())
 		{
-			for (auto iter = p_cl.weights_files.begin(); iter != p_cl.weights_files.end(); iter++)
-			{
-				iter->second = OUTPUT_DATA_PATH + iter->second;
-			}
+			/* the gui draws from the whole rasters, and real time wraps around them */
+			std::cerr << "[IO_ERROR]: Raster windows can only be used in TUI mode, and not in real time. Exiting...\n";
+			return 16;
 		}
-		if (p_cl.vis_mode.empty())
+	}
+	if (!p_cl.latency_file.empty())
+	{
+		if (!p_cl.realtime_socket.empty())
 		{
-			std::cout << "[INFO]: Visual mode not specified in run mode. Setting to default value of 'TUI'...\n";
-			p_cl.vis_mode = "TUI";
+			/* real-time mode keeps its own step latency histogram */
+			std::cerr << "[IO_ERROR]: The latency report cannot be made in real-time mode. Exiting...\n";
+			return 11;
 		}
-		p_cl.session_file = INPUT_DATA_PATH + p_cl.session_file;
+		p_cl.latency_file = OUTPUT_DATA_PATH + p_cl.latency_file;
 	}
-	else
+	else if (!p_cl.latency_trials.empty())
 	{
-		std::cerr << "[IO_ERROR]: Run mode not specified. You must provide either {-b|--build} or {-s|--session}\n"
-				  << "[IO_ERROR]: arguments. Exiting...\n";
-		exit(7);
+		std::cout << "[INFO]: --latency-trials given without -l. Ignoring...\n";
+	}
+	if (!p_cl.sweep_file.empty())
+	{
+		if (p_cl.vis_mode != "TUI" || !p_cl.realtime_socket.empty())
+		{
+			std::cerr << "[IO_ERROR]: Sweeps can only be run in TUI mode, and not in real time. Exiting...\n";
+			return 13;
+		}
+		p_cl.sweep_file = INPUT_DATA_PATH + p_cl.sweep_file;
+		if (p_cl.num_workers.empty()) p_cl.num_workers = "1";
+		int workers_status = check_int_opt(p_cl.num_workers, "{-n|--workers}", 0, INT_MAX);
+		if (workers_status != 0) return workers_status;
 	}
+	p_cl.session_file = INPUT_DATA_PATH + p_cl.session_file;
+	return 0;
 }
 
 std::string parsed_commandline_to_str(parsed_commandline &p_cl)
@@ -356,6 +695,36 @@ std::string parsed_commandline_to_str(parsed_commandline &p_cl)
 	p_cl_buf << "{ 'output_sim_file', '" << p_cl.output_sim_file << "' }\n";
 	p_cl_buf << "{ 'pfpc_plasticity', '" << p_cl.pfpc_plasticity << "' }\n";
 	p_cl_buf << "{ 'mfnc_plasticity', '" << p_cl.mfnc_plasticity << "' }\n";
+	p_cl_buf << "{ 'seed', '" << p_cl.seed << "' }\n";
+	p_cl_buf << "{ 'daemon_socket', '" << p_cl.daemon_socket << "' }\n";
+	p_cl_buf << "{ 'num_workers', '" << p_cl.num_workers << "' }\n";
+	p_cl_buf << "{ 'realtime_socket', '" << p_cl.realtime_socket << "' }\n";
+	p_cl_buf << "{ 'rt_steps', '" << p_cl.rt_steps << "' }\n";
+	p_cl_buf << "{ 'rt_degrade', '" << p_cl.rt_degrade << "' }\n";
+	p_cl_buf << "{ 'digest_file', '" << p_cl.digest_file << "' }\n";
+	p_cl_buf << "{ 'digest_every', '" << p_cl.digest_every << "' }\n";
+	p_cl_buf << "{ 'digest_tol', '" << p_cl.digest_tol << "' }\n";
+	p_cl_buf << "{ 'sweep_file', '" << p_cl.sweep_file << "' }\n";
+	p_cl_buf << "{ 'roofline_file', '" << p_cl.roofline_file << "' }\n";
+	p_cl_buf << "{ 'pack_file', '" << p_cl.pack_file << "' }\n";
+	p_cl_buf << "{ 'save_stages', '" << p_cl.save_stages << "' }\n";
+	p_cl_buf << "{ 'latency_file', '" << p_cl.latency_file << "' }\n";
+	p_cl_buf << "{ 'weight_stats_file', '" << p_cl.weight_stats_file << "' }\n";
+	p_cl_buf << "{ 'weights_every', '" << p_cl.weights_every << "' }\n";
+	p_cl_buf << "{ 'raster_window', '" << p_cl.raster_window << "' }\n";
+	p_cl_buf << "{ 'latency_trials', '" << p_cl.latency_trials << "' }\n";
+	for (auto file_name : p_cl.compare_files)
+	{
+		p_cl_buf << "{ 'compare_file', '" << file_name << "' }\n";
+	}
+	for (auto file_name : p_cl.pipeline_files)
+	{
+		p_cl_buf << "{ 'pipeline_file', '" << file_name << "' }\n";
+	}
+	for (auto arg : p_cl.slice_args)
+	{
+		p_cl_buf << "{ 'slice_arg', '" << arg << "' }\n";
+	}
 	for (auto pair : p_cl.raster_files)
 	{
 		p_cl_buf << "{ '" << pair.first << "', '" << pair.second << "' }\n";
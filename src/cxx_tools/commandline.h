@@ -29,6 +29,27 @@ typedef struct
 	std::string output_sim_file;
 	std::string pfpc_plasticity;
 	std::string mfnc_plasticity;
+	std::string seed;
+	std::string daemon_socket;
+	std::string num_workers;
+	std::string realtime_socket;
+	std::string rt_steps;
+	std::string rt_degrade;
+	std::string digest_file;
+	std::string digest_every;
+	std::string digest_tol;
+	std::string sweep_file;
+	std::string roofline_file;
+	std::string pack_file;
+	std::string save_stages;
+	std::string latency_file;
+	std::string latency_trials;
+	std::string weight_stats_file;
+	std::string weights_every;
+	std::string raster_window;
+	std::vector<std::string> compare_files;
+	std::vector<std::string> pipeline_files; /* session files, in the order they run */
+	std::vector<std::string> slice_args; /* pack, code, trial range, cell range, out file */
 	std::map<std::string, std::string> raster_files;
 	std::map<std::string, std::string> psth_files;
 	std::map<std::string, std::string> weights_files;
@@ -36,11 +57,20 @@ typedef struct
 
 void parse_commandline(int *argc, char ***argv, parsed_commandline &p_cl);
 
+/* parses already-split tokens without validating. returns 0 on success or the
+ * exit code parse_commandline would have exited with on a malformed option */
+int parse_commandline_tokens(std::vector<std::string> &tokens, parsed_commandline &p_cl);
+
 std::string parsed_commandline_to_str(parsed_commandline &p_cl);
 
 std::ostream &operator<<(std::ostream &os, parsed_commandline &p_cl);
 
 void validate_commandline(parsed_commandline &p_cl);
 
+/* run-mode half of validate_commandline: fills in defaults and data paths for a
+ * session run. returns 0 on success or an exit code instead of exiting, so that
+ * the sim server can reject a bad job without going down */
+int validate_session_commandline(parsed_commandline &p_cl);
+
 #endif /* COMMAND_LINE_H_ */
 
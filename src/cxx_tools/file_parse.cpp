@@ -50,6 +50,8 @@ std::map<std::string, lexeme> token_defs =
 		{ "mf_input", REGION_TYPE },
 		{ "trial_spec", REGION_TYPE },
 		{ "activity", REGION_TYPE },
+		{ "watchdog", REGION_TYPE },
+		{ "stimulus", REGION_TYPE },
 		{ "int", TYPE_NAME },
 		{ "float", TYPE_NAME },
 		{ "[a-zA-Z_]{1}[a-zA-Z0-9_]*", VAR_IDENTIFIER },
@@ -78,8 +80,7 @@ void tokenize_file(std::string in_file, tokenized_file &t_file)
 	std::ifstream in_file_buf(in_file.c_str());
 	if (!in_file_buf.is_open())
 	{
-		std::cerr << "[IO_ERROR]: Could not open file. Exiting..." << std::endl;
-		exit(3);
+		throw file_parse_error(3, "Could not open file '" + in_file + "'");
 	}
 
 	std::string line = "";
@@ -337,7 +338,9 @@ void parse_region(std::vector<lexed_token>::iterator &ltp, lexed_file &l_file, p
 {
 	if (region_type == "mf_input"
 		|| region_type == "activity"
-		|| region_type == "trial_spec")
+		|| region_type == "trial_spec"
+		|| region_type == "watchdog"
+		|| region_type == "stimulus")
 	{
 		parse_var_section(ltp, l_file, s_file, region_type);
 	}
@@ -389,8 +392,7 @@ void parse_lexed_sess_file(lexed_file &l_file, parsed_sess_file &s_file)
 		}
 		else if (ltp->lex != NEW_LINE)
 		{
-			std::cerr << "[IO_ERROR]: Unidentified token. Exiting...\n";
-			exit(1);
+			throw file_parse_error(1, "Unidentified token");
 		}
 		ltp++;
 	}
@@ -400,13 +402,11 @@ void parse_lexed_sess_file(lexed_file &l_file, parsed_sess_file &s_file)
 	{
 		if (next_lt->raw_token != "filetype")
 		{
-			std::cerr << "[IO_ERROR]: First interpretable line does not specify filetype. Exiting...\n";
-			exit(2);
+			throw file_parse_error(2, "First interpretable line does not specify filetype");
 		}
 		else if (second_next_lt->raw_token != "run")
 		{
-			std::cerr << "[IO_ERROR]: '" << second_next_lt->raw_token << "' does not indicate an experiment file. Exiting...\n";
-			exit(3);
+			throw file_parse_error(3, "'" + second_next_lt->raw_token + "' does not indicate an experiment file");
 		}
 		else
 		{
@@ -416,8 +416,7 @@ void parse_lexed_sess_file(lexed_file &l_file, parsed_sess_file &s_file)
 	}
 	else
 	{
-		std::cerr << "[IO_ERROR]: Unidentified token after '" << ltp->raw_token << "'. Exiting...\n";
-		exit(4);
+		throw file_parse_error(4, "Unidentified token after '" + ltp->raw_token + "'");
 	}
 }
 
@@ -527,8 +526,7 @@ void parse_lexed_build_file(lexed_file &l_file, parsed_build_file &b_file)
 		}
 		else if (ltp->lex != NEW_LINE)
 		{
-			std::cerr << "[IO_ERROR]: Unidentified token. Exiting...\n";
-			exit(1);
+			throw file_parse_error(1, "Unidentified token");
 		}
 		ltp++;
 	}
@@ -538,13 +536,11 @@ void parse_lexed_build_file(lexed_file &l_file, parsed_build_file &b_file)
 	{
 		if (next_lt->raw_token != "filetype")
 		{
-			std::cerr << "[IO_ERROR]: First interpretable line does not specify filetype. Exiting...\n";
-			exit(2);
+			throw file_parse_error(2, "First interpretable line does not specify filetype");
 		}
 		else if (second_next_lt->raw_token != "build")
 		{
-			std::cerr << "[IO_ERROR]: '" << second_next_lt->raw_token << "' does not indicate a build file. Exiting...\n";
-			exit(3);
+			throw file_parse_error(3, "'" + second_next_lt->raw_token + "' does not indicate a build file");
 		}
 		else
 		{
@@ -554,8 +550,7 @@ void parse_lexed_build_file(lexed_file &l_file, parsed_build_file &b_file)
 	}
 	else
 	{
-		std::cerr << "[IO_ERROR]: Unidentified token after '" << ltp->raw_token << "'. Exiting...\n";
-		exit(4);
+		throw file_parse_error(4, "Unidentified token after '" + ltp->raw_token + "'");
 	}
 }
 
@@ -18,6 +18,7 @@
 #include <utility> /* for std::pair */
 #include <vector>
 #include <map>
+#include <stdexcept>
 #include <cstdint>
 
 // lexemes of the input files ie the fundamental meanings behind each token
@@ -105,6 +106,21 @@ typedef struct
 	std::map<std::string, parsed_var_section> parsed_var_sections;
 } parsed_sess_file;
 
+/*
+ * thrown by tokenize_file and the parse functions below when a file cannot be
+ * read or is malformed, so that a caller serving many files (see sim_server.h)
+ * can reject the one file and carry on. code is the status the program exits
+ * with when the error reaches main.
+ *
+ */
+class file_parse_error : public std::runtime_error
+{
+	public:
+		file_parse_error(int code, const std::string &what)
+			: std::runtime_error(what), code(code) {}
+		int code;
+};
+
 /*
  * Description:
  *     takes in the string in_file representing the input file's name and constructs
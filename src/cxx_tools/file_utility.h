@@ -18,14 +18,30 @@
 #include <string>
 #include <cstring>
 #include <fstream>
+#include <streambuf>
 #include <map>
 
+/*
+ * read-only stream buffer over bytes already in memory. wrap it in a
+ * std::iostream to hand an in-memory file image (e.g. a cached .sim file) to
+ * the state read functions without copying it.
+ */
+class mem_read_buf : public std::streambuf
+{
+public:
+	mem_read_buf(const char *data, size_t len)
+	{
+		char *begin = const_cast<char *>(data);
+		setg(begin, begin, begin + len);
+	}
+};
+
 std::string get_file_basename(std::string full_file_path);
 
-void rawBytesRW(char *arr, unsigned long byteLen, bool read, std::fstream &file);
+void rawBytesRW(char *arr, unsigned long byteLen, bool read, std::iostream &file);
 
 template<typename key_t, typename val_t>
-void serialize_map_to_file(std::map<key_t, val_t> &map, std::fstream &file_buf)
+void serialize_map_to_file(std::map<key_t, val_t> &map, std::iostream &file_buf)
 {
 	size_t map_size = map.size();
 	char *map_size_bytes = (char *)calloc(1, sizeof(size_t));
@@ -59,7 +75,7 @@ void serialize_map_to_file(std::map<key_t, val_t> &map, std::fstream &file_buf)
 }
 
 template<typename key_t, typename val_t>
-void unserialize_map_from_file(std::map<key_t, val_t> &map, std::fstream &file_buf)
+void unserialize_map_from_file(std::map<key_t, val_t> &map, std::iostream &file_buf)
 {
 	size_t int_params_size;
 	char *int_params_size_arr = (char *)calloc(1, sizeof(size_t));
@@ -0,0 +1,114 @@
+/*
+ * File: latency_hist.cpp
+ *
+ * Description:
+ *     This file implements the function prototypes in latency_hist.h
+ *
+ * Implementation Notes:
+ *     A value v >= LAT_HIST_SUB with its top bit at k keeps its top
+ *     LAT_HIST_SUB_BITS bits, which lie in [SUB / 2, SUB); the bucket is that
+ *     mantissa's offset in its octave plus SUB / 2 buckets for every octave
+ *     below k. Values below SUB are their own bucket, which makes the first
+ *     octave of the log-linear part line up with the linear part with no gap.
+ */
+#include <algorithm>
+#include <cmath>
+
+#include "latency_hist.h"
+
+#define LAT_HIST_HALF (LAT_HIST_SUB / 2)
+
+static inline uint32_t bucket_of(uint64_t ns)
+{
+	if (ns < LAT_HIST_SUB) return (uint32_t)ns;
+	if (ns > LAT_HIST_MAX_NS) ns = LAT_HIST_MAX_NS;
+	uint32_t k = 63 - __builtin_clzll(ns);
+	uint32_t shift = k - LAT_HIST_SUB_BITS + 1;
+	return LAT_HIST_SUB + (k - LAT_HIST_SUB_BITS) * LAT_HIST_HALF
+		+ (uint32_t)((ns >> shift) - LAT_HIST_HALF);
+}
+
+/* largest value that lands in bucket b */
+static inline uint64_t bucket_high(uint32_t b)
+{
+	if (b < LAT_HIST_SUB) return b;
+	uint32_t j = b - LAT_HIST_SUB;
+	uint32_t shift = j / LAT_HIST_HALF + 1;
+	uint64_t mantissa = LAT_HIST_HALF + j % LAT_HIST_HALF;
+	return ((mantissa + 1) << shift) - 1;
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+	reset();
+}
+
+void LatencyHistogram::record(uint64_t ns)
+{
+	counts[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+	total.fetch_add(1, std::memory_order_relaxed);
+	sum_ns.fetch_add(ns, std::memory_order_relaxed);
+	uint64_t curr_max = max_ns.load(std::memory_order_relaxed);
+	while (ns > curr_max
+		&& !max_ns.compare_exchange_weak(curr_max, ns, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+	for (uint32_t b = 0; b < LAT_HIST_NUM_BUCKETS; b++)
+	{
+		uint64_t n = other.counts[b].load(std::memory_order_relaxed);
+		if (n > 0) counts[b].fetch_add(n, std::memory_order_relaxed);
+	}
+	total.fetch_add(other.count(), std::memory_order_relaxed);
+	sum_ns.fetch_add(other.sum_ns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	uint64_t other_max = other.max();
+	uint64_t curr_max  = max_ns.load(std::memory_order_relaxed);
+	while (other_max > curr_max
+		&& !max_ns.compare_exchange_weak(curr_max, other_max, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::reset()
+{
+	for (uint32_t b = 0; b < LAT_HIST_NUM_BUCKETS; b++)
+	{
+		counts[b].store(0, std::memory_order_relaxed);
+	}
+	total.store(0, std::memory_order_relaxed);
+	sum_ns.store(0, std::memory_order_relaxed);
+	max_ns.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const
+{
+	return total.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::max() const
+{
+	return max_ns.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const
+{
+	uint64_t n = count();
+	return (n > 0) ? (double)sum_ns.load(std::memory_order_relaxed) / n : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double pct) const
+{
+	uint64_t n = count();
+	if (n == 0) return 0;
+	uint64_t rank = (uint64_t)std::ceil(pct / 100.0 * n);
+	rank = std::min(std::max(rank, (uint64_t)1), n);
+	uint64_t seen = 0;
+	for (uint32_t b = 0; b < LAT_HIST_NUM_BUCKETS; b++)
+	{
+		seen += counts[b].load(std::memory_order_relaxed);
+		if (seen < rank) continue;
+		/* the last bucket also holds every clamped value */
+		if (b == LAT_HIST_NUM_BUCKETS - 1) return max();
+		return std::min(bucket_high(b), max());
+	}
+	return max();
+}
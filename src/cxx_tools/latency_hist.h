@@ -0,0 +1,67 @@
+/*
+ * File: latency_hist.h
+ *
+ * Description:
+ *     Interface for a fixed-size, HDR-style latency histogram. Values are
+ *     nanoseconds, binned log-linearly: every value below LAT_HIST_SUB has a
+ *     bucket of its own, and every power of two above that is split into
+ *     LAT_HIST_SUB / 2 equal buckets, so a bucket is never wider than 1/64 of
+ *     the values in it. Percentiles are read off the buckets and come out at
+ *     most that much high. Values of LAT_HIST_MAX_NS and above (about 18 min)
+ *     land in the last bucket; the exact maximum is kept on the side.
+ *
+ *     Recording is a relaxed atomic add on one bucket, with no locks and no
+ *     allocation, so it is safe inside the step loop and while another thread
+ *     reads the histogram. A reader racing a writer may see a value counted in
+ *     its bucket but not yet in the sum, which is fine for reporting.
+ */
+#ifndef LATENCY_HIST_H_
+#define LATENCY_HIST_H_
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+#define LAT_HIST_SUB_BITS 7
+#define LAT_HIST_SUB      (1 << LAT_HIST_SUB_BITS)
+#define LAT_HIST_MAX_BITS 40
+#define LAT_HIST_MAX_NS   ((1ULL << LAT_HIST_MAX_BITS) - 1)
+#define LAT_HIST_NUM_BUCKETS \
+	(LAT_HIST_SUB + (LAT_HIST_MAX_BITS - LAT_HIST_SUB_BITS) * (LAT_HIST_SUB / 2))
+
+/* monotonic clock, ns */
+inline uint64_t latency_now_ns()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000ULL + (uint64_t)t.tv_nsec;
+}
+
+class LatencyHistogram
+{
+	public:
+		LatencyHistogram();
+
+		void record(uint64_t ns);
+		/* adds other's counts to this one's. other should not be written meanwhile */
+		void merge(const LatencyHistogram &other);
+		void reset();
+
+		uint64_t count() const;
+		uint64_t max() const;
+		double mean() const;
+		/* smallest recorded value v such that pct percent of the values are <= v,
+		 * to within a bucket. 0 when empty */
+		uint64_t percentile(double pct) const;
+
+	private:
+		std::atomic<uint64_t> counts[LAT_HIST_NUM_BUCKETS];
+		std::atomic<uint64_t> total;
+		std::atomic<uint64_t> sum_ns;
+		std::atomic<uint64_t> max_ns;
+
+		LatencyHistogram(const LatencyHistogram &) = delete;
+		LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+};
+
+#endif /* LATENCY_HIST_H_ */
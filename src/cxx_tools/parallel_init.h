@@ -0,0 +1,52 @@
+/*
+ * File: parallel_init.h
+ *
+ * Description:
+ *     Helpers for filling large arrays at start-up with every available
+ *     thread. Each thread writes a contiguous, static slice of the array, so
+ *     under a first-touch NUMA policy the pages of that slice are placed on the
+ *     writing thread's node. Arrays allocated through make_placed_array are not
+ *     value-initialized first: the only touch is the parallel fill.
+ *
+ *     Arrays shorter than PARALLEL_INIT_MIN_ELEMS are filled serially, where
+ *     starting a thread team would cost more than it saves.
+ */
+#ifndef PARALLEL_INIT_H_
+#define PARALLEL_INIT_H_
+
+#include <cstddef>
+#include <memory>
+
+#define PARALLEL_INIT_MIN_ELEMS (1 << 16)
+
+template<typename Type>
+void parallel_fill(Type *arr, size_t n, Type val)
+{
+	#pragma omp parallel for schedule(static) if(n >= PARALLEL_INIT_MIN_ELEMS)
+	for (size_t i = 0; i < n; i++)
+	{
+		arr[i] = val;
+	}
+}
+
+template<typename Type>
+void parallel_copy(Type *dst, const Type *src, size_t n)
+{
+	#pragma omp parallel for schedule(static) if(n >= PARALLEL_INIT_MIN_ELEMS)
+	for (size_t i = 0; i < n; i++)
+	{
+		dst[i] = src[i];
+	}
+}
+
+/* drop-in for std::make_unique<Type[]>(n) that fills with val in parallel */
+template<typename Type>
+std::unique_ptr<Type[]> make_placed_array(size_t n, Type val = Type())
+{
+	std::unique_ptr<Type[]> arr(new Type[n]);
+	parallel_fill(arr.get(), n, val);
+	return arr;
+}
+
+#endif /* PARALLEL_INIT_H_ */
+
@@ -0,0 +1,412 @@
+/*
+ * File: raster_pack.cpp
+ *
+ * Description:
+ *     This file implements the function prototypes in raster_pack.h
+ *
+ * Implementation Notes:
+ *     pack_rasters lays the whole pack out before copying anything. It sizes
+ *     every raster from its files, sizes the output file to match, and maps
+ *     it. Every (raster, trial) block then has a fixed place in the mapping,
+ *     and the blocks are filled by one parallel loop with no locking. Per-trial
+ *     sources (GR) are read with pread straight into their block. Session
+ *     sources are mapped once, and each trial gathers its ts-long run of every
+ *     cell's row. The magic is written last, so a pack cut short by an error
+ *     or a crash fails to open rather than reading as zeros.
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "file_parse.h"
+#include "file_utility.h"
+#include "raster_pack.h"
+
+static inline uint64_t align_up(uint64_t off)
+{
+	return (off + RASTER_PACK_ALIGN - 1) / RASTER_PACK_ALIGN * RASTER_PACK_ALIGN;
+}
+
+static int file_size(std::string file_name, uint64_t &size)
+{
+	struct stat st;
+	if (stat(file_name.c_str(), &st) != 0)
+	{
+		std::cerr << "[IO_ERROR]: Could not stat raster file '" << file_name << "': " << strerror(errno) << "\n";
+		return 2;
+	}
+	size = st.st_size;
+	return 0;
+}
+
+/* reads n bytes at offset 0 of fd into dst. returns false on a short read */
+static bool pread_full(int fd, uint8_t *dst, uint64_t n)
+{
+	uint64_t done = 0;
+	while (done < n)
+	{
+		ssize_t got = pread(fd, dst + done, n - done, done);
+		if (got <= 0) return false;
+		done += got;
+	}
+	return true;
+}
+
+int pack_rasters(std::string out_file_name, std::vector<struct raster_source> &sources,
+	uint32_t num_trials, uint32_t ts_per_trial)
+{
+	uint32_t num_rasters = sources.size();
+	std::vector<uint32_t> num_cells(num_rasters);
+	for (uint32_t r = 0; r < num_rasters; r++)
+	{
+		struct raster_source &src = sources[r];
+		if (src.code.size() >= RASTER_PACK_CODE_SIZE)
+		{
+			std::cerr << "[IO_ERROR]: Raster code '" << src.code << "' is too long.\n";
+			return 2;
+		}
+		uint64_t expected_files = src.per_trial ? num_trials : 1;
+		if (src.files.size() != expected_files)
+		{
+			std::cerr << "[IO_ERROR]: Expected " << expected_files << " file(s) for the " << src.code
+					  << " raster, got " << src.files.size() << ".\n";
+			return 2;
+		}
+		uint64_t row_len = src.per_trial ? ts_per_trial : (uint64_t)ts_per_trial * num_trials;
+		uint64_t size = 0;
+		for (uint32_t f = 0; f < src.files.size(); f++)
+		{
+			uint64_t this_size;
+			if (file_size(src.files[f], this_size) != 0) return 2;
+			if (this_size == 0 || this_size % row_len != 0 || (f > 0 && this_size != size))
+			{
+				std::cerr << "[IO_ERROR]: Raster file '" << src.files[f] << "' does not hold a whole number of "
+						  << row_len << "-step rows, or differs in size from the raster's other files.\n";
+				return 2;
+			}
+			size = this_size;
+		}
+		num_cells[r] = size / row_len;
+	}
+
+	/* layout */
+	uint64_t dir_offset   = sizeof(struct raster_pack_header);
+	uint64_t table_offset = dir_offset + num_rasters * sizeof(struct raster_pack_entry);
+	uint64_t block_offset = align_up(table_offset + (uint64_t)num_rasters * num_trials * sizeof(uint64_t));
+	std::vector<uint64_t> block_offsets((uint64_t)num_rasters * num_trials);
+	for (uint32_t r = 0; r < num_rasters; r++)
+	{
+		uint64_t block_size = (uint64_t)num_cells[r] * ts_per_trial;
+		for (uint32_t t = 0; t < num_trials; t++)
+		{
+			block_offsets[(uint64_t)r * num_trials + t] = block_offset;
+			block_offset = align_up(block_offset + block_size);
+		}
+	}
+	uint64_t total_size = block_offset;
+
+	int out_fd = open(out_file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (out_fd < 0 || ftruncate(out_fd, total_size) != 0)
+	{
+		std::cerr << "[IO_ERROR]: Could not create raster pack '" << out_file_name << "': " << strerror(errno) << "\n";
+		if (out_fd >= 0) close(out_fd);
+		return 2;
+	}
+	uint8_t *out = (uint8_t *)mmap(NULL, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, out_fd, 0);
+	if (out == MAP_FAILED)
+	{
+		std::cerr << "[IO_ERROR]: Could not map raster pack '" << out_file_name << "': " << strerror(errno) << "\n";
+		close(out_fd);
+		return 2;
+	}
+
+	/* session sources are gathered from, so map them */
+	std::vector<const uint8_t *> src_maps(num_rasters, NULL);
+	std::vector<uint64_t> src_sizes(num_rasters, 0);
+	int status = 0;
+	for (uint32_t r = 0; r < num_rasters && status == 0; r++)
+	{
+		if (sources[r].per_trial) continue;
+		int fd = open(sources[r].files[0].c_str(), O_RDONLY);
+		src_sizes[r] = (uint64_t)num_cells[r] * ts_per_trial * num_trials;
+		void *map = (fd < 0) ? MAP_FAILED : mmap(NULL, src_sizes[r], PROT_READ, MAP_PRIVATE, fd, 0);
+		if (fd >= 0) close(fd);
+		if (map == MAP_FAILED)
+		{
+			std::cerr << "[IO_ERROR]: Could not map raster file '" << sources[r].files[0] << "': " << strerror(errno) << "\n";
+			status = 2;
+		}
+		else src_maps[r] = (const uint8_t *)map;
+	}
+
+	if (status == 0)
+	{
+		std::cout << "[INFO]: Packing " << num_rasters << " raster(s) of " << num_trials << " trials into '"
+				  << out_file_name << "'...\n";
+		int64_t num_jobs = (int64_t)num_rasters * num_trials;
+		#pragma omp parallel for schedule(dynamic)
+		for (int64_t job = 0; job < num_jobs; job++)
+		{
+			uint32_t r = job / num_trials;
+			uint32_t t = job % num_trials;
+			uint8_t *block = out + block_offsets[job];
+			uint64_t block_size = (uint64_t)num_cells[r] * ts_per_trial;
+			if (sources[r].per_trial)
+			{
+				int fd = open(sources[r].files[t].c_str(), O_RDONLY);
+				bool ok = fd >= 0 && pread_full(fd, block, block_size);
+				if (fd >= 0) close(fd);
+				if (!ok)
+				{
+					#pragma omp critical
+					{
+						std::cerr << "[IO_ERROR]: Could not read raster file '" << sources[r].files[t] << "'.\n";
+						status = 2;
+					}
+				}
+			}
+			else
+			{
+				uint64_t row_len = (uint64_t)ts_per_trial * num_trials;
+				const uint8_t *src = src_maps[r] + (uint64_t)t * ts_per_trial;
+				for (uint32_t c = 0; c < num_cells[r]; c++)
+				{
+					memcpy(block + (uint64_t)c * ts_per_trial, src + c * row_len, ts_per_trial);
+				}
+			}
+		}
+	}
+
+	for (uint32_t r = 0; r < num_rasters; r++)
+	{
+		if (src_maps[r]) munmap((void *)src_maps[r], src_sizes[r]);
+	}
+
+	if (status == 0)
+	{
+		struct raster_pack_entry *entries = (struct raster_pack_entry *)(out + dir_offset);
+		uint64_t *tables = (uint64_t *)(out + table_offset);
+		for (uint32_t r = 0; r < num_rasters; r++)
+		{
+			memset(entries[r].code, 0, RASTER_PACK_CODE_SIZE);
+			memcpy(entries[r].code, sources[r].code.c_str(), sources[r].code.size());
+			entries[r].num_cells  = num_cells[r];
+			entries[r].num_trials = num_trials;
+			entries[r].trial_table_offset = table_offset + (uint64_t)r * num_trials * sizeof(uint64_t);
+			memcpy(tables + (uint64_t)r * num_trials, &block_offsets[(uint64_t)r * num_trials],
+				num_trials * sizeof(uint64_t));
+		}
+		struct raster_pack_header *header = (struct raster_pack_header *)out;
+		header->version      = RASTER_PACK_VERSION;
+		header->num_rasters  = num_rasters;
+		header->num_trials   = num_trials;
+		header->ts_per_trial = ts_per_trial;
+		header->dir_offset   = dir_offset;
+		if (msync(out, total_size, MS_SYNC) == 0)
+		{
+			memcpy(header->magic, RASTER_PACK_MAGIC, sizeof(header->magic));
+		}
+		else
+		{
+			std::cerr << "[IO_ERROR]: Could not write raster pack '" << out_file_name << "': " << strerror(errno) << "\n";
+			status = 2;
+		}
+	}
+	munmap(out, total_size);
+	close(out_fd);
+	if (status == 0) std::cout << "[INFO]: Wrote " << total_size << " bytes to '" << out_file_name << "'.\n";
+	return status;
+}
+
+int open_raster_pack(std::string file_name, struct raster_pack &rp)
+{
+	rp = {};
+	rp.fd = open(file_name.c_str(), O_RDONLY);
+	struct stat st;
+	if (rp.fd < 0 || fstat(rp.fd, &st) != 0)
+	{
+		std::cerr << "[IO_ERROR]: Could not open raster pack '" << file_name << "': " << strerror(errno) << "\n";
+		if (rp.fd >= 0) close(rp.fd);
+		return 2;
+	}
+	rp.size = st.st_size;
+	void *map = (rp.size >= sizeof(struct raster_pack_header))
+			  ? mmap(NULL, rp.size, PROT_READ, MAP_SHARED, rp.fd, 0)
+			  : MAP_FAILED;
+	if (map == MAP_FAILED)
+	{
+		std::cerr << "[IO_ERROR]: Could not map raster pack '" << file_name << "'.\n";
+		close(rp.fd);
+		return 2;
+	}
+	rp.base    = (const uint8_t *)map;
+	rp.header  = (const struct raster_pack_header *)rp.base;
+	rp.entries = (const struct raster_pack_entry *)(rp.base + rp.header->dir_offset);
+
+	bool valid = memcmp(rp.header->magic, RASTER_PACK_MAGIC, sizeof(rp.header->magic)) == 0
+			  && rp.header->version == RASTER_PACK_VERSION
+			  && rp.header->dir_offset + rp.header->num_rasters * sizeof(struct raster_pack_entry) <= rp.size;
+	if (!valid)
+	{
+		std::cerr << "[IO_ERROR]: '" << file_name << "' is not a complete version " << RASTER_PACK_VERSION
+				  << " raster pack.\n";
+		close_raster_pack(rp);
+		return 2;
+	}
+	return 0;
+}
+
+void close_raster_pack(struct raster_pack &rp)
+{
+	if (rp.base) munmap((void *)rp.base, rp.size);
+	if (rp.fd >= 0) close(rp.fd);
+	rp = {};
+	rp.fd = -1;
+}
+
+const struct raster_pack_entry *find_raster(const struct raster_pack &rp, std::string code)
+{
+	for (uint32_t r = 0; r < rp.header->num_rasters; r++)
+	{
+		if (strncmp(rp.entries[r].code, code.c_str(), RASTER_PACK_CODE_SIZE) == 0) return &rp.entries[r];
+	}
+	return NULL;
+}
+
+const uint8_t *raster_trial_block(const struct raster_pack &rp,
+	const struct raster_pack_entry *entry, uint32_t trial)
+{
+	const uint64_t *table = (const uint64_t *)(rp.base + entry->trial_table_offset);
+	return rp.base + table[trial];
+}
+
+void read_raster_slice(const struct raster_pack &rp, const struct raster_pack_entry *entry,
+	uint32_t trial_begin, uint32_t trial_end, uint32_t cell_begin, uint32_t cell_end,
+	uint8_t *out)
+{
+	uint64_t ts_per_trial = rp.header->ts_per_trial;
+	uint64_t run_len = (cell_end - cell_begin) * ts_per_trial;
+	#pragma omp parallel for
+	for (uint32_t t = trial_begin; t < trial_end; t++)
+	{
+		memcpy(out + (t - trial_begin) * run_len,
+			raster_trial_block(rp, entry, t) + cell_begin * ts_per_trial, run_len);
+	}
+}
+
+/* trial count and steps per trial of the rasters a session file makes */
+static void get_session_raster_dims(std::string session_file, uint32_t &num_trials, uint32_t &ts_per_trial)
+{
+	tokenized_file t_file;
+	lexed_file l_file;
+	parsed_sess_file s_file;
+	trials_data td;
+	tokenize_file(session_file, t_file);
+	lex_tokenized_file(t_file, l_file);
+	parse_lexed_sess_file(l_file, s_file);
+	translate_parsed_trials(s_file, td);
+
+	/* as Control::init_session_vars sizes the rasters */
+	std::map<std::string, variable> &trial_spec = s_file.parsed_var_sections["trial_spec"].param_map;
+	num_trials   = td.num_trials;
+	ts_per_trial = std::stoi(trial_spec["msPreCS"].value) + td.cs_lens[0]
+				 + std::stoi(trial_spec["msPostCS"].value);
+	delete_trials_data(td);
+}
+
+int run_raster_pack(parsed_commandline &p_cl)
+{
+	uint32_t num_trials, ts_per_trial;
+	get_session_raster_dims(p_cl.session_file, num_trials, ts_per_trial);
+
+	std::vector<struct raster_source> sources;
+	for (auto &pair : p_cl.raster_files)
+	{
+		struct raster_source src;
+		src.code = pair.first;
+		src.per_trial = (pair.first == "GR");
+		if (src.per_trial)
+		{
+			/* named as Control::save_gr_raster names them */
+			for (uint32_t t = 0; t < num_trials; t++)
+			{
+				src.files.push_back(OUTPUT_DATA_PATH + get_file_basename(pair.second)
+					+ "_trial_" + std::to_string(t) + ".bin");
+			}
+		}
+		else src.files.push_back(pair.second);
+		sources.push_back(src);
+	}
+	return pack_rasters(p_cl.pack_file, sources, num_trials, ts_per_trial);
+}
+
+/* parses "BEGIN:END" into [begin, end). either side may be left out, meaning 0
+ * or max respectively */
+static bool parse_range(std::string range, uint32_t max, uint32_t &begin, uint32_t &end)
+{
+	size_t div = range.find(':');
+	if (div == std::string::npos) return false;
+	try
+	{
+		begin = (div == 0) ? 0 : std::stoul(range.substr(0, div));
+		end   = (div == range.size() - 1) ? max : std::stoul(range.substr(div + 1));
+	}
+	catch (std::exception &e)
+	{
+		return false;
+	}
+	return begin < end && end <= max;
+}
+
+int run_raster_slice(parsed_commandline &p_cl)
+{
+	struct raster_pack rp;
+	if (open_raster_pack(p_cl.slice_args[0], rp) != 0) return 2;
+
+	int status = 0;
+	uint32_t trial_begin, trial_end, cell_begin, cell_end;
+	const struct raster_pack_entry *entry = find_raster(rp, p_cl.slice_args[1]);
+	if (!entry)
+	{
+		std::cerr << "[IO_ERROR]: '" << p_cl.slice_args[0] << "' has no " << p_cl.slice_args[1] << " raster.\n";
+		status = 2;
+	}
+	else if (!parse_range(p_cl.slice_args[2], entry->num_trials, trial_begin, trial_end)
+		  || !parse_range(p_cl.slice_args[3], entry->num_cells, cell_begin, cell_end))
+	{
+		std::cerr << "[IO_ERROR]: Bad slice range. The " << p_cl.slice_args[1] << " raster has "
+				  << entry->num_trials << " trials and " << entry->num_cells << " cells.\n";
+		status = 2;
+	}
+	else
+	{
+		std::fstream out_file_buf(p_cl.slice_args[4].c_str(), std::ios::out | std::ios::binary);
+		if (!out_file_buf.is_open())
+		{
+			std::cerr << "[IO_ERROR]: Could not open '" << p_cl.slice_args[4] << "' for writing.\n";
+			status = 2;
+		}
+		else
+		{
+			/* straight from the mapping: only the slice's pages are ever read */
+			uint64_t run_len = (uint64_t)(cell_end - cell_begin) * rp.header->ts_per_trial;
+			for (uint32_t t = trial_begin; t < trial_end; t++)
+			{
+				const uint8_t *run = raster_trial_block(rp, entry, t)
+								   + (uint64_t)cell_begin * rp.header->ts_per_trial;
+				rawBytesRW((char *)run, run_len, false, out_file_buf);
+			}
+			std::cout << "[INFO]: Wrote trials [" << trial_begin << ", " << trial_end << ") x cells ["
+					  << cell_begin << ", " << cell_end << ") x " << rp.header->ts_per_trial
+					  << " steps of the " << p_cl.slice_args[1] << " raster to '" << p_cl.slice_args[4] << "'.\n";
+		}
+	}
+	close_raster_pack(rp);
+	return status;
+}
@@ -0,0 +1,107 @@
+/*
+ * File: raster_pack.h
+ *
+ * Description:
+ *     Interface for raster packs: single indexed files that hold all the rasters
+ *     of one session run, so that analysis reads only the trials and cells it
+ *     looks at. A session run leaves one raster file per cell type for the whole
+ *     session (Control::save_rasters, cells x (trial, ts)) and, for granules,
+ *     one file per trial (Control::save_gr_raster, cells x ts). A pack holds
+ *     the same spikes regrouped by trial:
+ *
+ *         header | directory | trial tables | trial blocks
+ *
+ *     The directory has one entry per raster, giving its cell type code, its
+ *     number of cells and the offset of its trial table. A trial table holds
+ *     the offset of each of the raster's trial blocks. A trial block is the
+ *     raster's (cell, ts) matrix for one trial, row-major, so the cells of any
+ *     cell range in one trial are one contiguous run of bytes. Blocks are
+ *     page-aligned.
+ *
+ *     pack_rasters merges a run's raster files into a pack. It writes the
+ *     trial blocks in parallel, straight into the mapped output file.
+ *     open_raster_pack maps a pack read-only. read_raster_slice copies out a
+ *     (trial range x cell range) slice, which touches only that slice's pages.
+ *
+ *     From the command line, '-k, --pack-rasters' packs the rasters a session
+ *     run saved with -r, and '-q, --slice' extracts a slice of a pack to a file.
+ */
+#ifndef RASTER_PACK_H_
+#define RASTER_PACK_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "commandline.h"
+
+#define RASTER_PACK_MAGIC     "CBMRPACK"
+#define RASTER_PACK_VERSION   1
+#define RASTER_PACK_ALIGN     4096
+#define RASTER_PACK_CODE_SIZE 8
+
+struct raster_pack_header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t num_rasters;
+	uint32_t num_trials;
+	uint32_t ts_per_trial;
+	uint64_t dir_offset;
+};
+
+struct raster_pack_entry
+{
+	char code[RASTER_PACK_CODE_SIZE]; /* cell type code, e.g. "PC", NUL-padded */
+	uint32_t num_cells;
+	uint32_t num_trials;
+	uint64_t trial_table_offset;
+};
+
+/* where a pack takes one raster's spikes from */
+struct raster_source
+{
+	std::string code;
+	/* a single file for the whole session, or with per_trial one file per trial */
+	std::vector<std::string> files;
+	bool per_trial;
+};
+
+struct raster_pack
+{
+	int fd;
+	const uint8_t *base;
+	size_t size;
+	const struct raster_pack_header *header;
+	const struct raster_pack_entry *entries;
+};
+
+/* merges sources into out_file_name. each source file's cell count is taken
+ * from its size. returns 0 on success, non-zero after printing the error */
+int pack_rasters(std::string out_file_name, std::vector<struct raster_source> &sources,
+	uint32_t num_trials, uint32_t ts_per_trial);
+
+/* returns 0 on success, non-zero after printing the error */
+int open_raster_pack(std::string file_name, struct raster_pack &rp);
+
+void close_raster_pack(struct raster_pack &rp);
+
+/* NULL if the pack has no raster for code */
+const struct raster_pack_entry *find_raster(const struct raster_pack &rp, std::string code);
+
+/* the (cell, ts) block of one trial, in the mapping */
+const uint8_t *raster_trial_block(const struct raster_pack &rp,
+	const struct raster_pack_entry *entry, uint32_t trial);
+
+/* copies trials [trial_begin, trial_end) of cells [cell_begin, cell_end) to out,
+ * laid out (trial, cell, ts). ranges must be within the raster */
+void read_raster_slice(const struct raster_pack &rp, const struct raster_pack_entry *entry,
+	uint32_t trial_begin, uint32_t trial_end, uint32_t cell_begin, uint32_t cell_end,
+	uint8_t *out);
+
+/* command line modes. return the process exit status */
+int run_raster_pack(parsed_commandline &p_cl);
+int run_raster_slice(parsed_commandline &p_cl);
+
+#endif /* RASTER_PACK_H_ */
@@ -0,0 +1,130 @@
+/*
+ * File: raster_spill.cpp
+ *
+ * Description:
+ *     This file implements the function prototypes in raster_spill.h
+ *
+ * Implementation Notes:
+ *     A window's row r holds columns [start, start + num_filled) of raster row
+ *     r, which sit at byte r * num_cols + start of the file, so a window is
+ *     written with one pwrite per row. Rows of different windows interleave in
+ *     the file, which is why it is sized with ftruncate first: the holes read
+ *     back as zeros and nothing has to be written in order.
+ *
+ *     Only one writer runs at a time. spill joins the previous one before
+ *     handing over the next window, since that window's buffer is the one the
+ *     caller is about to fill.
+ */
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "dynamic2darray.h"
+#include "raster_spill.h"
+
+RasterSpill::RasterSpill(std::string file_name, uint32_t num_rows, uint64_t num_cols, uint32_t window_cols)
+	: file_name(file_name), num_rows(num_rows), num_cols(num_cols), win_cols(window_cols)
+{
+	front = allocate2DArray<uint8_t>(num_rows, win_cols);
+	back  = allocate2DArray<uint8_t>(num_rows, win_cols);
+	fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0 || ftruncate(fd, (off_t)num_rows * num_cols) != 0)
+	{
+		std::cerr << "[IO_ERROR]: Could not create raster file '" << file_name << "': "
+				  << strerror(errno) << ". It will not be written.\n";
+		if (fd >= 0) close(fd);
+		fd = -1;
+		write_failed = true;
+	}
+}
+
+RasterSpill::~RasterSpill()
+{
+	wait_writer();
+	if (fd >= 0) close(fd);
+	delete2DArray<uint8_t>(front);
+	delete2DArray<uint8_t>(back);
+}
+
+uint8_t **RasterSpill::window()
+{
+	return front;
+}
+
+uint64_t RasterSpill::window_start()
+{
+	return front_start;
+}
+
+uint32_t RasterSpill::window_cols()
+{
+	return win_cols;
+}
+
+void RasterSpill::spill(uint32_t num_filled)
+{
+	num_filled = std::min(num_filled, win_cols);
+	wait_writer();
+	std::swap(front, back);
+	if (fd >= 0 && num_filled > 0)
+	{
+		writer = std::thread(&RasterSpill::write_window, this, back, front_start, num_filled);
+	}
+	front_start += num_filled;
+}
+
+bool RasterSpill::finish(uint32_t num_filled)
+{
+	spill(num_filled);
+	wait_writer();
+	if (fd >= 0)
+	{
+		if (close(fd) != 0) write_failed = true;
+		fd = -1;
+	}
+	return !write_failed;
+}
+
+void RasterSpill::discard()
+{
+	wait_writer();
+	if (fd >= 0) close(fd);
+	fd = -1;
+	unlink(file_name.c_str());
+}
+
+void RasterSpill::write_window(uint8_t **rows, uint64_t start, uint32_t num_filled)
+{
+	/* the window may run past the raster's end if trials ran longer than planned */
+	if (start >= num_cols) return;
+	num_filled = (uint32_t)std::min((uint64_t)num_filled, num_cols - start);
+	for (uint32_t r = 0; r < num_rows; r++)
+	{
+		const uint8_t *src = rows[r];
+		off_t offset = (off_t)r * num_cols + start;
+		uint32_t left = num_filled;
+		while (left > 0)
+		{
+			ssize_t n = pwrite(fd, src, left, offset);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0)
+			{
+				std::cerr << "[IO_ERROR]: Could not write raster file '" << file_name << "': "
+						  << strerror(errno) << "\n";
+				write_failed = true;
+				return;
+			}
+			src    += n;
+			offset += n;
+			left   -= n;
+		}
+	}
+}
+
+void RasterSpill::wait_writer()
+{
+	if (writer.joinable()) writer.join();
+}
@@ -0,0 +1,67 @@
+/*
+ * File: raster_spill.h
+ *
+ * Description:
+ *     Interface for spilled rasters: a raster of num_rows cells by num_cols
+ *     time steps that is kept in memory only as a window of window_cols
+ *     columns, with the columns already filled written out to the raster's
+ *     file as the session runs. The file has the layout write2DArray gives a
+ *     whole raster, row-major num_rows x num_cols bytes, so readers cannot
+ *     tell a spilled raster from one saved in one go.
+ *
+ *     The file is sized up front, so columns that are never filled read as 0,
+ *     as they would in a saved raster. Spilling hands the filled columns of the
+ *     window to a writer thread and carries on filling a second window, so
+ *     the step loop only waits on the disk when a window fills before the
+ *     previous one is written. Memory is bounded at two windows.
+ */
+#ifndef RASTER_SPILL_H_
+#define RASTER_SPILL_H_
+
+#include <string>
+#include <thread>
+#include <cstdint>
+
+class RasterSpill
+{
+	public:
+		/* creates or truncates file_name. on failure the raster is still filled
+		 * but nothing is written, and finish returns false */
+		RasterSpill(std::string file_name, uint32_t num_rows, uint64_t num_cols, uint32_t window_cols);
+		/* waits for the writer. columns not spilled or finished are lost */
+		~RasterSpill();
+
+		/* rows of the window being filled: column c of the window is column
+		 * window_start() + c of the raster. both change with every spill */
+		uint8_t **window();
+		uint64_t window_start();
+		uint32_t window_cols();
+
+		/* writes out the first num_filled columns of the window, in the
+		 * background, and starts the next window right after them */
+		void spill(uint32_t num_filled);
+		/* spills num_filled columns, waits for every write and closes the file.
+		 * returns false if a write failed */
+		bool finish(uint32_t num_filled);
+		/* waits for the writer and removes the file */
+		void discard();
+
+	private:
+		std::string file_name;
+		int fd = -1;
+		uint32_t num_rows;
+		uint64_t num_cols;
+		uint32_t win_cols;
+
+		uint8_t **front = NULL; /* being filled */
+		uint8_t **back  = NULL; /* being written */
+		uint64_t front_start = 0;
+
+		std::thread writer;
+		bool write_failed = false; /* set by the writer, read after joining it */
+
+		void write_window(uint8_t **rows, uint64_t start, uint32_t num_filled);
+		void wait_writer();
+};
+
+#endif /* RASTER_SPILL_H_ */
@@ -0,0 +1,58 @@
+/*
+ * File: tracepoints.h
+ *
+ * Description:
+ *     Static user-space (USDT) tracepoints, for profiling a running simulation
+ *     with perf or bpftrace without rebuilding or restarting it. A tracepoint
+ *     compiles to a single nop plus a note in the binary; it costs next to
+ *     nothing until a tracer attaches, which patches the nop into a breakpoint.
+ *     Their arguments are always evaluated, so they are kept to values already
+ *     at hand.
+ *
+ *     The probes are built in whenever <sys/sdt.h> (systemtap-sdt-dev) is
+ *     found, and left out with 'make NO_USDT=1'. Provider 'cbm_sim':
+ *
+ *         trial__start(trial, name)     Control::runSession, before the first step
+ *         trial__end(trial)             after the last step of the trial
+ *         step__start(step)             CBMSimCore::calcActivity, after the GPU sync
+ *         phase__end(step, phase)       at each phase boundary; phase is an enum
+ *                                       sim_phase (cbmsimcore.h), and the phase ran
+ *                                       since the previous phase__end or step__start
+ *         step__end(step)
+ *         pfpc__plast__start(step)      MZone::runPFPCPlastCUDA and
+ *         pfpc__plast__end(step)          MZone::runPFPCDiscretePlast, per zone
+ *         mf__gen__start()              PoissonRegenCells::calcPoissActivity
+ *         mf__gen__end(num_mf)
+ *         write__start(path)            every file write of Control's save_*
+ *         write__end(path, bytes)
+ *
+ *     GPU work is launched asynchronously, so outside a '-P' run, where every
+ *     phase boundary synchronizes, phase times are the host's share: issuing
+ *     work and waiting on the copies it needs. scripts/cbm_phase_latency.bt
+ *     collects per-phase latency histograms from a running simulation.
+ */
+#ifndef TRACEPOINTS_H_
+#define TRACEPOINTS_H_
+
+#if !defined(NO_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define CBM_USDT
+#endif
+#endif
+
+#ifdef CBM_USDT
+
+#define CBM_TRACE(name) DTRACE_PROBE(cbm_sim, name)
+#define CBM_TRACE1(name, a) DTRACE_PROBE1(cbm_sim, name, a)
+#define CBM_TRACE2(name, a, b) DTRACE_PROBE2(cbm_sim, name, a, b)
+
+#else
+
+#define CBM_TRACE(name) ((void)0)
+#define CBM_TRACE1(name, a) ((void)0)
+#define CBM_TRACE2(name, a, b) ((void)0)
+
+#endif /* CBM_USDT */
+
+#endif /* TRACEPOINTS_H_ */
@@ -0,0 +1,201 @@
+/*
+ * File: health_watchdog.cpp
+ *
+ * Description:
+ *     This file implements the function prototypes in health_watchdog.h
+ *
+ * Implementation Notes:
+ *     The hot path is count_out_of_bounds: a branch-free, vectorized count of
+ *     the values that fail lo <= x <= hi. Every comparison with NaN is false, so
+ *     that single test also catches NaN, and +-Inf falls outside any finite
+ *     bounds. Only when the count is nonzero is the array scanned again, in
+ *     scalar code, for the first bad index and the finite extrema that go into
+ *     the report. This relies on the build not using -ffast-math.
+ *
+ *     Host-side populations (GO, SC, BC, PC, IO, NC) are checked in place in
+ *     their activity states. GR variables and the PFPC weights live on the GPU
+ *     and are copied back through the usual export functions, which is what
+ *     makes a check cost more than a handful of microseconds; check_every
+ *     amortizes that.
+ */
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <algorithm>
+
+#include "health_watchdog.h"
+
+uint64_t count_out_of_bounds(const float *arr, uint64_t n, float lo, float hi)
+{
+	uint64_t num_bad = 0;
+	#pragma omp simd reduction(+:num_bad)
+	for (uint64_t i = 0; i < n; i++)
+	{
+		num_bad += !(arr[i] >= lo && arr[i] <= hi);
+	}
+	return num_bad;
+}
+
+void check_float_arr(const float *arr, uint64_t n, float lo, float hi, struct var_health &h)
+{
+	h.lo = lo;
+	h.hi = hi;
+	h.n  = n;
+	h.num_bad = count_out_of_bounds(arr, n, lo, hi);
+	h.num_nonfinite = 0;
+	h.first_bad = 0;
+	h.first_bad_val = 0.0;
+	h.min = h.max = 0.0;
+	if (h.num_bad == 0) return;
+
+	bool seen_bad = false, seen_finite = false;
+	for (uint64_t i = 0; i < n; i++)
+	{
+		if (!seen_bad && !(arr[i] >= lo && arr[i] <= hi))
+		{
+			h.first_bad = i;
+			h.first_bad_val = arr[i];
+			seen_bad = true;
+		}
+		if (!std::isfinite(arr[i]))
+		{
+			h.num_nonfinite++;
+			continue;
+		}
+		if (!seen_finite)
+		{
+			h.min = h.max = arr[i];
+			seen_finite = true;
+		}
+		else
+		{
+			h.min = std::min(h.min, arr[i]);
+			h.max = std::max(h.max, arr[i]);
+		}
+	}
+}
+
+static float section_float(parsed_var_section &section, std::string name, float default_val)
+{
+	auto entry = section.param_map.find(name);
+	if (entry == section.param_map.end()) return default_val;
+	return std::stof(entry->second.value);
+}
+
+HealthWatchdog::HealthWatchdog(parsed_var_section &section, std::string report_file_name)
+	: report_file_name(report_file_name)
+{
+	bounds.check_every = (uint32_t)section_float(section, "check_every", 100);
+	bounds.vm_min      = section_float(section, "vm_min", -150.0);
+	bounds.vm_max      = section_float(section, "vm_max", 100.0);
+	bounds.g_min       = section_float(section, "g_min", -0.001);
+	bounds.g_max       = section_float(section, "g_max", 1000.0);
+	bounds.w_min       = section_float(section, "w_min", 0.0);
+	bounds.w_max       = section_float(section, "w_max", 1.0);
+	if (bounds.check_every == 0) bounds.check_every = 1;
+	std::cout << "[INFO]: Checking numerical health every " << bounds.check_every << " steps.\n";
+}
+
+bool HealthWatchdog::tripped()
+{
+	return has_tripped;
+}
+
+void HealthWatchdog::check(const char *name, int zone, const float *arr, uint64_t n, float lo, float hi)
+{
+	struct var_health h;
+	check_float_arr(arr, n, lo, hi, h);
+	if (h.num_bad == 0) return;
+	/* names are only built for violations, so a passing check never allocates */
+	h.name = name;
+	if (zone >= 0) h.name += "." + std::to_string(zone);
+	violations.push_back(h);
+}
+
+bool HealthWatchdog::step(CBMSimCore *simCore, CBMState *simState, uint32_t num_zones,
+	uint32_t trial, uint32_t ts)
+{
+	global_step++;
+	if (has_tripped) return false;
+	if (global_step % bounds.check_every != 0) return true;
+
+	InNet *inputNet = simCore->getInputNet();
+	InNetActivityState *inState = simState->getInnetActStateInternal();
+	const sim_params &p = simCore->getParams();
+	float vm_lo = bounds.vm_min, vm_hi = bounds.vm_max;
+	float g_lo  = bounds.g_min,  g_hi  = bounds.g_max;
+	float w_lo  = bounds.w_min,  w_hi  = bounds.w_max;
+
+	check("GR_Vm", -1, inputNet->exportVmGR(), p.num_gr, vm_lo, vm_hi);
+	check("GR_gESum", -1, inputNet->exportGESumGR(), p.num_gr, g_lo, g_hi);
+	check("GR_gISum", -1, inputNet->exportGISumGR(), p.num_gr, g_lo, g_hi);
+	check("GO_Vm", -1, inState->vGO.get(), p.num_go, vm_lo, vm_hi);
+	check("GO_gMFSum", -1, inState->gSum_MFGO.get(), p.num_go, g_lo, g_hi);
+	check("GO_gGR", -1, inState->gGRGO.get(), p.num_go, g_lo, g_hi);
+	check("GO_gNMDAMF", -1, inState->gNMDAMFGO.get(), p.num_go, g_lo, g_hi);
+	check("GO_gNMDAIncMF", -1, inState->gNMDAIncMFGO.get(), p.num_go, g_lo, g_hi);
+	check("GO_gNMDAGR", -1, inState->gGRGO_NMDA.get(), p.num_go, g_lo, g_hi);
+
+	for (uint32_t z = 0; z < num_zones; z++)
+	{
+		MZone *zone = simCore->getMZoneList()[z];
+		MZoneActivityState *zoneState = simState->getMZoneActStateInternal(z);
+
+		check("SC_Vm", z, zoneState->vSC.get(), p.num_sc, vm_lo, vm_hi);
+		check("SC_gPF", z, zoneState->gPFSC.get(), p.num_sc, g_lo, g_hi);
+		check("BC_Vm", z, zoneState->vBC.get(), p.num_bc, vm_lo, vm_hi);
+		check("BC_gPF", z, zoneState->gPFBC.get(), p.num_bc, g_lo, g_hi);
+		check("BC_gPC", z, zoneState->gPCBC.get(), p.num_bc, g_lo, g_hi);
+		check("PC_Vm", z, zoneState->vPC.get(), p.num_pc, vm_lo, vm_hi);
+		check("PC_gPF", z, zoneState->gPFPC.get(), p.num_pc, g_lo, g_hi);
+		check("PC_gBC", z, zoneState->gBCPC.get(), p.num_pc, g_lo, g_hi);
+		check("PC_gSC", z, zoneState->gSCPC.get(), p.num_pc, g_lo, g_hi);
+		check("IO_Vm", z, zoneState->vIO.get(), p.num_io, vm_lo, vm_hi);
+		check("IO_gNC", z, zoneState->gNCIO.get(),
+			p.num_io * p.num_p_io_from_nc_to_io, g_lo, g_hi);
+		check("NC_Vm", z, zoneState->vNC.get(), p.num_nc, vm_lo, vm_hi);
+		check("NC_gPC", z, zoneState->gPCNC.get(),
+			p.num_nc * p.num_p_nc_from_pc_to_nc, g_lo, g_hi);
+		check("NC_gMF", z, zoneState->gMFAMPANC.get(),
+			p.num_nc * p.num_p_nc_from_mf_to_nc, g_lo, g_hi);
+		check("PFPC_W", z, zone->exportPFPCWeights(), p.num_gr, w_lo, w_hi);
+		check("MFNC_W", z, zoneState->mfSynWeightNC.get(),
+			p.num_nc * p.num_p_nc_from_mf_to_nc, w_lo, w_hi);
+	}
+
+	if (violations.empty()) return true;
+	has_tripped = true;
+	write_report(trial, ts);
+	return false;
+}
+
+void HealthWatchdog::write_report(uint32_t trial, uint32_t ts)
+{
+	std::cerr << "[ERROR]: Numerical health check failed at trial " << trial << ", ts " << ts
+			  << " (step " << global_step << "): " << violations.size() << " variable(s) out of bounds:\n";
+	for (auto &h : violations)
+	{
+		std::cerr << "[ERROR]:     " << h.name << ": " << h.num_bad << "/" << h.n << " out of ["
+				  << h.lo << ", " << h.hi << "], " << h.num_nonfinite << " non-finite\n";
+	}
+
+	std::fstream report_file_buf(report_file_name.c_str(), std::ios::out);
+	if (!report_file_buf.is_open())
+	{
+		std::cerr << "[IO_ERROR]: Could not open watchdog report '" << report_file_name << "'.\n";
+		return;
+	}
+	report_file_buf << "# cbm_sim numerical health report\n";
+	report_file_buf << "# step " << global_step << " trial " << trial << " ts " << ts << "\n";
+	report_file_buf << "# var n num_bad num_nonfinite lo hi first_bad first_bad_val finite_min finite_max\n";
+	report_file_buf.precision(9);
+	for (auto &h : violations)
+	{
+		report_file_buf << h.name << " " << h.n << " " << h.num_bad << " " << h.num_nonfinite << " "
+						<< h.lo << " " << h.hi << " " << h.first_bad << " " << h.first_bad_val << " "
+						<< h.min << " " << h.max << "\n";
+	}
+	report_file_buf.close();
+	std::cout << "[INFO]: Wrote numerical health report to '" << report_file_name << "'\n";
+}
+
@@ -0,0 +1,93 @@
+/*
+ * File: health_watchdog.h
+ *
+ * Description:
+ *     Interface for the numerical health watchdog. Every N time steps it checks
+ *     the membrane potentials, conductances and synaptic weights of every cell
+ *     population against configurable bounds. NaN and Inf always fail. The first
+ *     failed check writes a report of every offending variable and tells the
+ *     caller to stop, so a diverging run ends within N steps instead of grinding
+ *     through its remaining trials.
+ *
+ *     The watchdog is enabled by a watchdog section in the session file. Every
+ *     variable in it is optional:
+ *
+ *         begin section watchdog
+ *             int check_every 100    // steps between checks
+ *             float vm_min -150.0    // membrane potentials, mV
+ *             float vm_max 100.0
+ *             float g_min -0.001     // conductances
+ *             float g_max 1000.0
+ *             float w_min 0.0        // PF-PC and MF-NC synaptic weights
+ *             float w_max 1.0
+ *         end
+ */
+#ifndef HEALTH_WATCHDOG_H_
+#define HEALTH_WATCHDOG_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "file_parse.h"
+#include "cbmstate.h"
+#include "cbmsimcore.h"
+
+struct watchdog_bounds
+{
+	uint32_t check_every;
+	float vm_min;
+	float vm_max;
+	float g_min;
+	float g_max;
+	float w_min;
+	float w_max;
+};
+
+struct var_health
+{
+	std::string name;
+	float lo;
+	float hi;
+	uint64_t n;
+	uint64_t num_bad;       /* out of [lo, hi], including non-finite values */
+	uint64_t num_nonfinite;
+	uint64_t first_bad;     /* index of the first bad value */
+	float first_bad_val;
+	float min;              /* over finite values */
+	float max;
+};
+
+/* number of values of arr outside [lo, hi]. NaN counts as outside */
+uint64_t count_out_of_bounds(const float *arr, uint64_t n, float lo, float hi);
+
+/* fills h for arr. the vectorized count runs always, the scalar details only
+ * when it finds a bad value */
+void check_float_arr(const float *arr, uint64_t n, float lo, float hi, struct var_health &h);
+
+class HealthWatchdog
+{
+	public:
+		HealthWatchdog(parsed_var_section &section, std::string report_file_name);
+
+		/* called once per time step, after CBMSimCore::calcActivity. returns false
+		 * when this step's check failed, after writing the report */
+		bool step(CBMSimCore *simCore, CBMState *simState, uint32_t num_zones,
+			uint32_t trial, uint32_t ts);
+
+		bool tripped();
+
+	private:
+		struct watchdog_bounds bounds;
+		std::string report_file_name;
+		uint64_t global_step = 0;
+		bool has_tripped = false;
+		std::vector<struct var_health> violations;
+
+		/* zone < 0 for variables that are not per microzone */
+		void check(const char *name, int zone, const float *arr, uint64_t n, float lo, float hi);
+		void write_report(uint32_t trial, uint32_t ts);
+};
+
+#endif /* HEALTH_WATCHDOG_H_ */
+
@@ -6,7 +6,10 @@
  * Description:
  *     this is the main entry point to the program. It calls functions from commandline.h
  *     in order to parse arguments and from control.h in order to run the simulation
- *     in one of several user-specified modes.
+ *     in one of several user-specified modes, or hands off to sim_server.h when
+ *     started in daemon mode, to sweep.h when running a parameter sweep and to
+ *     state_digest.h when comparing digests, to raster_pack.h when packing or
+ *     slicing rasters and to pipeline.h when chaining sessions.
  *
  */
 
@@ -16,6 +19,12 @@
 #include <omp.h>
 
 #include "control.h"
+#include "sim_server.h"
+#include "sweep.h"
+#include "realtime.h"
+#include "state_digest.h"
+#include "raster_pack.h"
+#include "pipeline.h"
 #include "gui.h"
 #include "commandline.h"
 #include "file_parse.h"
@@ -25,33 +34,81 @@ int main(int argc, char **argv)
 	parsed_commandline p_cl = {};
 	parse_commandline(&argc, &argv, p_cl); /* includes validation step */
 
-	Control *control = new Control(p_cl);
-	int exit_status = 0;
+	/* a malformed build or session file ends the run with the parser's status */
+	try
+	{
+		if (!p_cl.compare_files.empty())
+		{
+			return compare_digest_files(p_cl.compare_files[0], p_cl.compare_files[1], std::stod(p_cl.digest_tol));
+		}
 
-	omp_set_num_threads(1); /* for 4 gpus, 8 is the sweet spot. Unsure for 2. */
+		if (!p_cl.pack_file.empty())
+		{
+			return run_raster_pack(p_cl);
+		}
 
-	if (!p_cl.build_file.empty())
-	{
-		control->build_sim();
-		control->save_sim_to_file(p_cl.output_sim_file);
-	}
-	else if (!p_cl.session_file.empty())
-	{
-		if (p_cl.vis_mode == "TUI")
+		if (!p_cl.slice_args.empty())
 		{
-			control->runSession(NULL);
-			if (!p_cl.output_sim_file.empty())
-			{
-				std::cout << "[INFO]: Saving simulation to file...\n";
-				control->save_sim_to_file(p_cl.output_sim_file);
-			}
+			return run_raster_slice(p_cl);
+		}
+
+		if (!p_cl.daemon_socket.empty())
+		{
+			return run_sim_server(p_cl);
+		}
+
+		if (!p_cl.sweep_file.empty())
+		{
+			return run_sweep(p_cl);
 		}
-		else if (p_cl.vis_mode == "GUI")
+
+		if (!p_cl.pipeline_files.empty())
+		{
+			return run_pipeline(p_cl);
+		}
+
+		/* initialization fills and transposes its large arrays with every core */
+		Control *control = new Control(p_cl);
+		int exit_status = 0;
+		omp_set_num_threads(1); /* for 4 gpus, 8 is the sweet spot. Unsure for 2. */
+
+		if (!p_cl.build_file.empty())
+		{
+			control->build_sim();
+			control->save_sim_to_file(p_cl.output_sim_file);
+		}
+		else if (!p_cl.session_file.empty())
 		{
-			exit_status = gui_init_and_run(&argc, &argv, control);
+			if (!p_cl.realtime_socket.empty())
+			{
+				exit_status = run_realtime(control, p_cl);
+				if (exit_status == 0 && !p_cl.output_sim_file.empty())
+				{
+					std::cout << "[INFO]: Saving simulation to file...\n";
+					control->save_sim_to_file(p_cl.output_sim_file);
+				}
+			}
+			else if (p_cl.vis_mode == "TUI")
+			{
+				control->runSession(NULL);
+				if (control->health_check_failed) exit_status = 3;
+				else if (!p_cl.output_sim_file.empty())
+				{
+					std::cout << "[INFO]: Saving simulation to file...\n";
+					control->save_sim_to_file(p_cl.output_sim_file);
+				}
+			}
+			else if (p_cl.vis_mode == "GUI")
+			{
+				exit_status = gui_init_and_run(&argc, &argv, control);
+			}
 		}
+		delete control;
+		return exit_status;
+	}
+	catch (file_parse_error &e)
+	{
+		std::cerr << "[IO_ERROR]: " << e.what() << ". Exiting...\n";
+		return e.code;
 	}
-	delete control;
-	return exit_status;
 }
-
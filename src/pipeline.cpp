@@ -0,0 +1,105 @@
+/*
+ * File: pipeline.cpp
+ *
+ * Description:
+ *     This file implements the function prototypes in pipeline.h
+ *
+ * Implementation Notes:
+ *     Each stage gets its own Control, built from a copy of the command line
+ *     naming the stage's session and its tagged output files. A later stage's
+ *     Control is built from the previous one, which hands over its simulation
+ *     state and core and frees its output buffers, and is deleted right after.
+ *     So only one stage's rasters are held at a time. Before a later stage
+ *     runs, the core it took over is checked to be running on the stage's
+ *     activity params, derived values included.
+ */
+#include <iostream>
+#include <omp.h>
+
+#include "control.h"
+#include "file_parse.h"
+#include "sweep.h"
+#include "pipeline.h"
+
+int run_pipeline(parsed_commandline &p_cl)
+{
+	uint32_t num_stages = p_cl.pipeline_files.size();
+	std::string stage_sim_base = p_cl.output_sim_file.empty() ? p_cl.input_sim_file : p_cl.output_sim_file;
+	Control *control = NULL;
+	int exit_status = 0;
+	double start = omp_get_wtime();
+
+	for (uint32_t stage = 0; stage < num_stages; stage++)
+	{
+		std::string tag = "_s" + std::to_string(stage);
+		parsed_commandline stage_p_cl = p_cl;
+		stage_p_cl.session_file = p_cl.pipeline_files[stage];
+		for (auto &entry : stage_p_cl.raster_files) entry.second = tag_file_name(entry.second, tag);
+		for (auto &entry : stage_p_cl.psth_files) entry.second = tag_file_name(entry.second, tag);
+		for (auto &entry : stage_p_cl.weights_files) entry.second = tag_file_name(entry.second, tag);
+		if (!stage_p_cl.digest_file.empty())
+			stage_p_cl.digest_file = tag_file_name(stage_p_cl.digest_file, tag);
+		if (!stage_p_cl.roofline_file.empty())
+			stage_p_cl.roofline_file = tag_file_name(stage_p_cl.roofline_file, tag);
+		if (!stage_p_cl.latency_file.empty())
+			stage_p_cl.latency_file = tag_file_name(stage_p_cl.latency_file, tag);
+		if (!stage_p_cl.weight_stats_file.empty())
+			stage_p_cl.weight_stats_file = tag_file_name(stage_p_cl.weight_stats_file, tag);
+
+		std::cout << "[INFO]: Starting pipeline stage " << stage << " of " << num_stages
+				  << " ('" << stage_p_cl.session_file << "').\n";
+		if (stage == 0)
+		{
+			/* initialization fills and transposes its large arrays with every core */
+			control = new Control(stage_p_cl, tag);
+			omp_set_num_threads(1);
+		}
+		else
+		{
+			tokenized_file t_file;
+			lexed_file l_file;
+			parsed_sess_file s_file;
+			tokenize_file(stage_p_cl.session_file, t_file);
+			lex_tokenized_file(t_file, l_file);
+			parse_lexed_sess_file(l_file, s_file);
+			Control *next = new Control(stage_p_cl, s_file, *control, tag);
+			delete control;
+			control = next;
+			/* the stage takes over a built core, so its session's params only
+			 * reach the step loop through the retune */
+			if (!control->simCore->actParamsInEffect(control->getParams()))
+			{
+				std::cerr << "[ERROR]: Pipeline stage " << stage << "'s activity params did not take effect in the\n"
+						  << "[ERROR]: simulation it took over. Stopping the pipeline.\n";
+				exit_status = 4;
+				break;
+			}
+		}
+
+		control->runSession(NULL);
+		if (control->health_check_failed)
+		{
+			std::cerr << "[ERROR]: Pipeline stage " << stage << " failed its health check. Stopping the pipeline.\n";
+			exit_status = 3;
+			break;
+		}
+		if (stage < num_stages - 1 && !p_cl.save_stages.empty())
+		{
+			std::string stage_sim_file = tag_file_name(stage_sim_base, tag);
+			std::cout << "[INFO]: Saving stage " << stage << " simulation to '" << stage_sim_file << "'...\n";
+			control->save_sim_to_file(stage_sim_file);
+		}
+	}
+	if (exit_status == 0 && !p_cl.output_sim_file.empty())
+	{
+		std::cout << "[INFO]: Saving simulation to file...\n";
+		control->save_sim_to_file(p_cl.output_sim_file);
+	}
+	if (exit_status == 0)
+	{
+		std::cout << "[INFO]: Pipeline of " << num_stages << " stages completed in "
+				  << omp_get_wtime() - start << "s.\n";
+	}
+	delete control;
+	return exit_status;
+}
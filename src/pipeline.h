@@ -0,0 +1,32 @@
+/*
+ * File: pipeline.h
+ *
+ * Description:
+ *     Interface for session pipelines ('pipeline mode'). A protocol such as
+ *     acquisition, then extinction, then a probe is a chain of sessions, each
+ *     training the simulation the previous one left. Run as separate
+ *     invocations, every link writes the whole simulation to a file only for
+ *     the next to read it back. A pipeline runs the chain in one invocation
+ *     instead: the first session reads the input simulation, and each later
+ *     session takes over the live simulation of the one before it, GPU state
+ *     and all. Activity params that differ between sessions are retuned in
+ *     place (see CBMSimCore::retuneActParams).
+ *
+ *     Every stage runs its session exactly as a TUI run would, except that the
+ *     names of the rasters, PSTHs, weights, digest, roofline and watchdog files
+ *     it writes are tagged with '_s<stage>'. Only the last stage writes the
+ *     output simulation, untagged; with --save-stages every earlier stage also
+ *     writes its own, tagged, to the name of the output simulation or else of
+ *     the input simulation.
+ */
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include "commandline.h"
+
+/* runs p_cl.pipeline_files in order. returns 0 if every stage completed, 3 if
+ * one failed its numerical health check and 4 if a stage's activity params did
+ * not take effect in the simulation it took over. either ends the pipeline */
+int run_pipeline(parsed_commandline &p_cl);
+
+#endif /* PIPELINE_H_ */
@@ -0,0 +1,304 @@
+/*
+ * File: realtime.cpp
+ *
+ * Description:
+ *     This file implements the function prototypes in realtime.h
+ *
+ * Implementation Notes:
+ *     Pacing uses absolute deadlines on CLOCK_MONOTONIC: step n is scheduled at
+ *     t0 + n * budget and we clock_nanosleep until then, so per-step jitter does
+ *     not accumulate into drift. If we fall more than RT_RESYNC_STEPS behind, the
+ *     schedule is reset to the current time rather than running flat out to
+ *     catch up, which would hand the plant a burst of stale steps.
+ *
+ *     Rasters and PSTHs have no trial structure to follow here, so collection
+ *     wraps: PSTHs accumulate over consecutive windows of PSTHColSize steps and
+ *     rasters hold the most recent PSTHColSize * num_trials steps.
+ */
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <csignal>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "file_utility.h"
+#include "alloc_audit.h"
+#include "realtime.h"
+
+#define RT_RESYNC_STEPS 10
+
+static double timespec_diff_us(const struct timespec &a, const struct timespec &b)
+{
+	return (a.tv_sec - b.tv_sec) * 1.0e6 + (a.tv_nsec - b.tv_nsec) / 1.0e3;
+}
+
+static void timespec_add_us(struct timespec &t, double us)
+{
+	long long ns = t.tv_nsec + (long long)(us * 1.0e3);
+	t.tv_sec  += ns / 1000000000LL;
+	t.tv_nsec  = ns % 1000000000LL;
+}
+
+RealtimeLoop::RealtimeLoop(Control *control, parsed_commandline &p_cl) : control(control)
+{
+	socket_path  = p_cl.realtime_socket;
+	max_steps    = std::stoull(p_cl.rt_steps);
+	if (p_cl.rt_degrade == "off") degrade_mode = RT_DEGRADE_OFF;
+	else if (p_cl.rt_degrade == "output") degrade_mode = RT_DEGRADE_OUTPUT;
+	else degrade_mode = RT_DEGRADE_COLLECT;
+	latency_file_name = OUTPUT_DATA_PATH + get_file_basename(p_cl.session_file) + "_rt_latency.txt";
+
+	const sim_params &p = control->getParams();
+	step_budget_us = p.msPerTimeStep * 1000.0;
+	const float *mf_bg = control->mfFreq->getMFBG();
+	mf_rates.assign(mf_bg, mf_bg + p.num_mf);
+	in_packet.resize(sizeof(struct rt_input_header) + p.num_mf * sizeof(float));
+	out_packet.resize(sizeof(struct rt_output_header) + p.num_nc * (sizeof(uint8_t) + sizeof(float)));
+}
+
+RealtimeLoop::~RealtimeLoop()
+{
+	if (plant_fd >= 0) close(plant_fd);
+	if (listen_fd >= 0)
+	{
+		close(listen_fd);
+		unlink(socket_path.c_str());
+	}
+}
+
+bool RealtimeLoop::accept_plant()
+{
+	struct sockaddr_un addr = {};
+	addr.sun_family = AF_UNIX;
+	if (socket_path.size() >= sizeof(addr.sun_path))
+	{
+		std::cerr << "[ERROR]: Socket path '" << socket_path << "' is too long.\n";
+		return false;
+	}
+	strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+	listen_fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+	if (listen_fd < 0)
+	{
+		std::cerr << "[ERROR]: Could not create socket: " << strerror(errno) << "\n";
+		return false;
+	}
+	unlink(socket_path.c_str());
+	if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listen_fd, 1) < 0)
+	{
+		std::cerr << "[ERROR]: Could not listen on '" << socket_path << "': " << strerror(errno) << "\n";
+		return false;
+	}
+	std::cout << "[INFO]: Waiting for plant to connect on '" << socket_path << "'...\n";
+	plant_fd = accept(listen_fd, NULL, NULL);
+	if (plant_fd < 0)
+	{
+		std::cerr << "[ERROR]: accept failed: " << strerror(errno) << "\n";
+		return false;
+	}
+	std::cout << "[INFO]: Plant connected.\n";
+	return true;
+}
+
+bool RealtimeLoop::poll_inputs(bool &apply_err, float &err_drive, bool &stop)
+{
+	const sim_params &p = control->getParams();
+	const float *mf_bg = control->mfFreq->getMFBG();
+	while (true)
+	{
+		ssize_t n = recv(plant_fd, in_packet.data(), in_packet.size(), MSG_DONTWAIT);
+		if (n == 0) return false; /* plant hung up */
+		if (n < 0)
+		{
+			if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+			if (errno == EINTR) continue;
+			std::cerr << "[ERROR]: Plant socket error: " << strerror(errno) << "\n";
+			return false;
+		}
+		if ((size_t)n < sizeof(struct rt_input_header)) continue;
+
+		struct rt_input_header header;
+		memcpy(&header, in_packet.data(), sizeof(header));
+		if (header.magic != RT_MAGIC) continue;
+		if (header.flags & RT_IN_STOP) stop = true;
+		if (header.flags & RT_IN_ERR_DRIVE)
+		{
+			apply_err = true;
+			err_drive = header.err_drive;
+		}
+		if ((header.flags & RT_IN_MF_RATES) && header.num_mf == (uint32_t)p.num_mf
+			&& (size_t)n == sizeof(header) + p.num_mf * sizeof(float))
+		{
+			const uint8_t *payload = in_packet.data() + sizeof(header);
+			for (int i = 0; i < p.num_mf; i++)
+			{
+				/* negative rates mark collaterals and imports, which the plant does not drive */
+				if (mf_bg[i] < 0) continue;
+				memcpy(&mf_rates[i], payload + i * sizeof(float), sizeof(float));
+			}
+		}
+	}
+}
+
+void RealtimeLoop::send_outputs(uint32_t step, uint32_t flags, float last_latency_us)
+{
+	const sim_params &p = control->getParams();
+	struct rt_output_header header = { RT_MAGIC, step, flags, (uint32_t)p.num_nc, last_latency_us };
+	const uint8_t *ap_nc = control->simCore->getMZoneList()[0]->exportAPNC();
+	const float *vm_nc   = control->simCore->getMZoneList()[0]->exportVmNC();
+
+	uint8_t *out = out_packet.data();
+	memcpy(out, &header, sizeof(header));
+	out += sizeof(header);
+	memcpy(out, ap_nc, p.num_nc * sizeof(uint8_t));
+	out += p.num_nc * sizeof(uint8_t);
+	memcpy(out, vm_nc, p.num_nc * sizeof(float));
+
+	if (send(plant_fd, out_packet.data(), out_packet.size(), MSG_DONTWAIT | MSG_NOSIGNAL) < 0)
+	{
+		stats.failed_sends++;
+	}
+}
+
+void RealtimeLoop::record_latency(double latency_us)
+{
+	stats.num_steps++;
+	stats.sum_latency_us += latency_us;
+	if (latency_us > stats.max_latency_us) stats.max_latency_us = latency_us;
+	uint64_t bin = (latency_us < 0) ? 0 : (uint64_t)(latency_us / RT_HIST_BIN_US);
+	if (bin >= RT_HIST_NUM_BINS) bin = RT_HIST_NUM_BINS - 1;
+	stats.latency_hist[bin]++;
+	if (latency_us > step_budget_us) stats.deadline_misses++;
+}
+
+void RealtimeLoop::report()
+{
+	double mean_us = (stats.num_steps > 0) ? stats.sum_latency_us / stats.num_steps : 0.0;
+	double miss_pct = (stats.num_steps > 0) ? 100.0 * stats.deadline_misses / stats.num_steps : 0.0;
+	std::cout << "[INFO]: Real-time run: " << stats.num_steps << " steps, budget " << step_budget_us << "us\n";
+	std::cout << "[INFO]: Latency mean " << mean_us << "us, max " << stats.max_latency_us << "us\n";
+	std::cout << "[INFO]: Deadline misses: " << stats.deadline_misses << " (" << miss_pct << "%)\n";
+	std::cout << "[INFO]: Degraded steps: " << stats.degraded_steps
+			  << ", dropped outputs: " << stats.dropped_outputs
+			  << ", failed sends: " << stats.failed_sends
+			  << ", schedule resyncs: " << stats.resyncs << "\n";
+
+	std::fstream latency_file(latency_file_name.c_str(), std::ios::out);
+	latency_file << "# steps " << stats.num_steps << "\n";
+	latency_file << "# budget_us " << step_budget_us << "\n";
+	latency_file << "# mean_us " << mean_us << "\n";
+	latency_file << "# max_us " << stats.max_latency_us << "\n";
+	latency_file << "# deadline_misses " << stats.deadline_misses << "\n";
+	latency_file << "# degraded_steps " << stats.degraded_steps << "\n";
+	latency_file << "# dropped_outputs " << stats.dropped_outputs << "\n";
+	latency_file << "# failed_sends " << stats.failed_sends << "\n";
+	latency_file << "# bin_start_us count\n";
+	for (uint32_t i = 0; i < RT_HIST_NUM_BINS; i++)
+	{
+		if (stats.latency_hist[i] > 0) latency_file << i * RT_HIST_BIN_US << " " << stats.latency_hist[i] << "\n";
+	}
+	latency_file.close();
+	std::cout << "[INFO]: Latency histogram written to '" << latency_file_name << "'\n";
+}
+
+int RealtimeLoop::run()
+{
+	signal(SIGPIPE, SIG_IGN);
+	if (!accept_plant()) return 1;
+
+	CBMSimCore *simCore = control->simCore;
+	const uint32_t psth_len   = control->PSTHColSize;
+	const uint32_t raster_len = control->PSTHColSize * control->td.num_trials;
+	uint32_t collect_counter  = 0;
+	bool last_missed          = false;
+	float last_latency_us     = 0.0;
+
+	control->run_state = IN_RUN_NO_PAUSE;
+	std::cout << "[INFO]: Starting real-time loop...\n";
+
+	struct timespec next, now;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	ALLOC_AUDIT_PHASE(ALLOC_PHASE_STEP);
+	for (uint64_t step = 0; max_steps == 0 || step < max_steps; step++)
+	{
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		double lag_us = timespec_diff_us(now, next);
+
+		bool apply_err = false, stop = false;
+		float err_drive = 0.0;
+		if (!poll_inputs(apply_err, err_drive, stop) || stop) break;
+		if (apply_err) simCore->updateErrDrive(0, err_drive);
+
+		const uint8_t *mfAP = control->mfs->calcPoissActivity(mf_rates.data(), simCore->getMZoneList());
+		bool *isTrueMF = control->mfs->calcTrueMFs(control->mfFreq->getMFBG());
+		simCore->updateTrueMFs(isTrueMF);
+		simCore->updateMFInput(mfAP);
+		simCore->calcActivity(control->spillFrac, control->pf_pc_plast, control->mf_nc_plast);
+		if (control->watchdog && !control->watchdog->step(simCore, control->simState,
+				control->numMZones, 0, (uint32_t)step))
+		{
+			control->health_check_failed = true;
+			break;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		bool at_risk = timespec_diff_us(now, next) > risk_frac * step_budget_us;
+		uint32_t out_flags = last_missed ? RT_OUT_DEADLINE_MISS : 0;
+
+		if (degrade_mode != RT_DEGRADE_OFF && at_risk)
+		{
+			stats.degraded_steps++;
+			out_flags |= RT_OUT_DEGRADED;
+		}
+		else
+		{
+			control->fill_rasters(collect_counter % raster_len, collect_counter % psth_len, NULL);
+			control->fill_psths(collect_counter % psth_len);
+			collect_counter++;
+		}
+
+		if (degrade_mode == RT_DEGRADE_OUTPUT && lag_us >= step_budget_us) stats.dropped_outputs++;
+		else send_outputs((uint32_t)step, out_flags, last_latency_us);
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		last_latency_us = timespec_diff_us(now, next);
+		last_missed = last_latency_us > step_budget_us;
+		record_latency(last_latency_us);
+
+		timespec_add_us(next, step_budget_us);
+		if (timespec_diff_us(now, next) > RT_RESYNC_STEPS * step_budget_us)
+		{
+			next = now;
+			stats.resyncs++;
+		}
+	}
+	ALLOC_AUDIT_PHASE(ALLOC_PHASE_TRIAL);
+	control->run_state = NOT_IN_RUN;
+	std::cout << "[INFO]: Real-time loop finished.\n";
+	ALLOC_AUDIT_REPORT();
+	if (control->health_check_failed)
+	{
+		report();
+		return 3;
+	}
+
+	control->trial = 0;
+	control->save_gr_raster();
+	control->save_rasters();
+	control->save_psths();
+	control->save_weights();
+	report();
+	return 0;
+}
+
+int run_realtime(Control *control, parsed_commandline &p_cl)
+{
+	RealtimeLoop loop(control, p_cl);
+	return loop.run();
+}
+
@@ -0,0 +1,129 @@
+/*
+ * File: realtime.h
+ *
+ * Description:
+ *     Interface for running a simulation in real time, closed loop with an
+ *     external plant (a simulated or robotic one). Instead of following the
+ *     session's trial timeline, each time step takes its error drive and mossy
+ *     fiber rates from the plant and sends the deep nucleus output back. Steps
+ *     are paced against the monotonic clock so that every step of
+ *     msPerTimeStep ms starts on its wall-clock boundary.
+ *
+ *     The plant connects to a local unix SOCK_SEQPACKET socket. Every packet is
+ *     a fixed header followed by an optional payload, all in host byte order:
+ *
+ *         plant -> sim: rt_input_header, then num_mf floats if RT_IN_MF_RATES
+ *         sim -> plant: rt_output_header, then num_nc uint8 spikes and num_nc
+ *                       float membrane potentials
+ *
+ *     Inputs are sampled once at the start of every step. MF rates are held
+ *     until the plant sends new ones; an error drive applies to the step it
+ *     arrives in, just as a US does in a normal session.
+ *
+ *     Per-step latencies (step start to end of the step's work) go into a
+ *     histogram that is printed and written next to the other outputs when the
+ *     run ends, along with the deadline miss count. When a step is at risk of
+ *     missing its deadline, the degrade mode decides what work is dropped:
+ *
+ *         off     - nothing is skipped
+ *         collect - raster and PSTH collection is skipped for that step
+ *         output  - as collect, and when already a full step behind the output
+ *                   packet is not sent either (the plant holds its last value)
+ */
+#ifndef REALTIME_H_
+#define REALTIME_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "control.h"
+
+#define RT_MAGIC 0x43424d52 /* 'CBMR' */
+
+/* rt_input_header.flags */
+#define RT_IN_ERR_DRIVE 0x1
+#define RT_IN_MF_RATES  0x2
+#define RT_IN_STOP      0x4
+
+/* rt_output_header.flags */
+#define RT_OUT_DEADLINE_MISS 0x1
+#define RT_OUT_DEGRADED      0x2
+
+struct rt_input_header
+{
+	uint32_t magic;
+	uint32_t step;
+	uint32_t flags;
+	float err_drive;     /* relative error drive, as given to CBMSimCore::updateErrDrive */
+	uint32_t num_mf;     /* payload length in floats when RT_IN_MF_RATES is set */
+};
+
+struct rt_output_header
+{
+	uint32_t magic;
+	uint32_t step;
+	uint32_t flags;
+	uint32_t num_nc;
+	float last_latency_us; /* latency of the previous step */
+};
+
+enum rt_degrade_mode {RT_DEGRADE_OFF, RT_DEGRADE_COLLECT, RT_DEGRADE_OUTPUT};
+
+/* linear latency histogram, RT_HIST_BIN_US wide bins up to RT_HIST_NUM_BINS, last bin is overflow */
+#define RT_HIST_BIN_US   10
+#define RT_HIST_NUM_BINS 401
+
+struct rt_stats
+{
+	uint64_t num_steps;
+	uint64_t deadline_misses;
+	uint64_t degraded_steps;
+	uint64_t dropped_outputs; /* not sent by the 'output' degrade mode */
+	uint64_t failed_sends;    /* sent but refused by the socket, e.g. the plant is not reading */
+	uint64_t resyncs;
+	double sum_latency_us;
+	double max_latency_us;
+	uint64_t latency_hist[RT_HIST_NUM_BINS];
+};
+
+class RealtimeLoop
+{
+	public:
+		RealtimeLoop(Control *control, parsed_commandline &p_cl);
+		~RealtimeLoop();
+
+		/* runs until the plant disconnects, sends RT_IN_STOP or max_steps is reached.
+		 * returns the exit status */
+		int run();
+
+	private:
+		Control *control;
+		std::string socket_path;
+		std::string latency_file_name;
+		uint64_t max_steps;
+		enum rt_degrade_mode degrade_mode;
+
+		double step_budget_us;
+		double risk_frac = 0.8; /* fraction of the budget after which a step is at risk */
+
+		int listen_fd = -1;
+		int plant_fd  = -1;
+
+		std::vector<float> mf_rates;
+		std::vector<uint8_t> in_packet;
+		std::vector<uint8_t> out_packet;
+
+		struct rt_stats stats = {};
+
+		bool accept_plant();
+		bool poll_inputs(bool &apply_err, float &err_drive, bool &stop);
+		void send_outputs(uint32_t step, uint32_t flags, float last_latency_us);
+		void record_latency(double latency_us);
+		void report();
+};
+
+int run_realtime(Control *control, parsed_commandline &p_cl);
+
+#endif /* REALTIME_H_ */
+
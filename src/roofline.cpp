@@ -0,0 +1,431 @@
+/*
+ * File: roofline.cpp
+ *
+ * Description:
+ *     This file implements the function prototypes in roofline.h
+ *
+ * Implementation Notes:
+ *     The per-cell byte and flop counts in model_phase_costs are read off the
+ *     kernels in kernels.cu and the host loops in innet.cpp and mzone.cpp: a
+ *     float or uint32_t array read or written once per cell counts 4 bytes, a
+ *     read-modify-write 8, a uint8_t spike array 1. Flops count adds, muls and
+ *     compares on floats; an exp counts as 10. The large per-cell constants are
+ *     named below; smaller ones are inline with the loop they come from.
+ *
+ *     The peak benchmarks are kept short (a few hundred ms all told) and take
+ *     the best of PEAK_REPS runs. The host FMA loop is compiled with the
+ *     simulation's own flags, so its peak is what this binary can reach rather
+ *     than what the CPU could reach with every vector extension turned on.
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <omp.h>
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include "roofline.h"
+#include "kernels.h"
+
+#define PEAK_REPS 5
+
+#define HOST_TRIAD_ELEMS (1 << 23) /* 64MB per array */
+#define HOST_FMA_ITERS   (1 << 22)
+
+#define GPU_COPY_BYTES   (1 << 27)
+#define PCIE_COPY_BYTES  (1 << 26)
+#define GPU_FMA_ITERS    (1 << 14)
+#define GPU_FMA_THREADS  256
+#define GPU_FMA_BLOCKS_PER_SM 16
+
+/* calcActivityGRGPU: v, gKCa, gLeak, gNMDA, gNMDAInc and thresh read and
+ * written, apBuf rmw, gESum, gISum and apMFtoGR read, apOut and ap written */
+#define GR_ACT_BYTES 65
+#define GR_ACT_FLOPS 46
+
+/* calcGOActivities: 13 float inputs and state reads plus a GR input per GPU,
+ * 12 float writes plus a spike per GPU */
+#define GO_ACT_BYTES(n_gpus) ((25 + 2 * (n_gpus)) * 4)
+#define GO_ACT_FLOPS 60
+
+const char *sim_phase_name(enum sim_phase phase)
+{
+	switch (phase)
+	{
+		case PHASE_GR_UPDATE:   return "gr_update";
+		case PHASE_GR_INPUT:    return "gr_input";
+		case PHASE_GR_GO:       return "gr_go";
+		case PHASE_PF_SUMS:     return "pf_sums";
+		case PHASE_PFPC_PLAST:  return "pfpc_plast";
+		case PHASE_TRANSFERS:   return "transfers";
+		case PHASE_GO_CELLS:    return "go_cells";
+		case PHASE_MZONE_CELLS: return "mzone_cells";
+		default:                return "unknown";
+	}
+}
+
+static const char *device_name(enum roofline_device device)
+{
+	switch (device)
+	{
+		case ROOF_GPU:  return "gpu";
+		case ROOF_PCIE: return "pcie";
+		default:        return "host";
+	}
+}
+
+void model_phase_costs(const sim_params &params, uint32_t num_zones, int num_gpus,
+	enum plasticity pf_pc_plast, struct phase_cost costs[NUM_SIM_PHASES])
+{
+	double gr = params.num_gr;
+	double go = params.num_go;
+	double mf = params.num_mf;
+	double pc = params.num_pc;
+	double bc = params.num_bc;
+	double sc = params.num_sc;
+	double io = params.num_io;
+	double nc = params.num_nc;
+	double zones = num_zones;
+	double gpus  = num_gpus;
+
+	double mf_gr = params.max_num_p_gr_from_mf_to_gr;
+	double go_gr = params.max_num_p_gr_from_go_to_gr;
+	double gr_go = params.max_num_p_gr_from_gr_to_go;
+
+	double pf_pc = pc * params.num_p_pc_from_gr_to_pc;
+	double pf_bc = bc * params.num_p_bc_from_gr_to_bc;
+	double pf_sc = sc * params.num_p_sc_from_gr_to_sc;
+
+	for (int i = 0; i < NUM_SIM_PHASES; i++)
+	{
+		costs[i].bytes  = 0.0;
+		costs[i].flops  = 0.0;
+		costs[i].device = ROOF_GPU;
+	}
+
+	/* GR activity, the 64-bit history shift (apBuf read, history rmw) and the
+	 * delayed PF activity shared by the zones (apBuf, delay mask read) */
+	costs[PHASE_GR_UPDATE].bytes = gr * (GR_ACT_BYTES + 20 + 9);
+	costs[PHASE_GR_UPDATE].flops = gr * GR_ACT_FLOPS;
+
+	/* MF input: numIn, depAmp, apMFtoGR and gSum, gDirect and gSpill rmw, plus
+	 * one index per synapse; GO input likewise without the spike output. then
+	 * the MF depression and the GO depression and spillover kernels, each an
+	 * index per synapse plus numIn and one output. the apIn vectors are read
+	 * once per GPU */
+	costs[PHASE_GR_INPUT].bytes = gr * ((32 + 4 * mf_gr) + (28 + 4 * go_gr)
+		+ (8 + 4 * mf_gr) + 2 * (8 + 4 * go_gr)) + gpus * 4 * (mf + 3 * go);
+	costs[PHASE_GR_INPUT].flops = gr * ((mf_gr + 10) + (go_gr + 6) + mf_gr + 2 * go_gr);
+
+	/* updateGRGOOut: numSyn and apBuf, an index and a delay mask per synapse,
+	 * then one row of num_go sums per updateGRGOOutNumGRPerR granules, each
+	 * written, read back by the sum kernel and reduced into num_go outputs */
+	double gr_go_rows = gr / std::min(512.0, go);
+	costs[PHASE_GR_GO].bytes = gr * (8 + 8 * gr_go) + 2 * 4 * gr_go_rows * go + gpus * 4 * go;
+	costs[PHASE_GR_GO].flops = gr_go_rows * go;
+
+	/* per zone: the PF-PC output (PF activity byte and weight read, input
+	 * written) and the PF-BC/SC output (PF activity byte read, two inputs
+	 * written), then the sums over every input of the PCs, BCs and SCs */
+	costs[PHASE_PF_SUMS].bytes = zones * (gr * 18 + 4 * (pf_pc + pf_bc + pf_sc)
+		+ 4 * (pc + bc + sc));
+	costs[PHASE_PF_SUMS].flops = zones * (gr + pf_pc + pf_bc + pf_sc);
+
+	/* graded plasticity runs once per GR history bin: weight rmw, history read */
+	if (pf_pc_plast == GRADED && params.tsPerHistBinGR > 0)
+	{
+		costs[PHASE_PFPC_PLAST].bytes = zones * gr * 16 / params.tsPerHistBinGR;
+		costs[PHASE_PFPC_PLAST].flops = zones * gr * 5 / params.tsPerHistBinGR;
+	}
+	/* binary and cascade: the history bin packed to a bit per GR and the new
+	 * efficacies expanded to float weights on the GPU. the bitwise update on
+	 * the host moves a few bits per synapse and is left out */
+	else if ((pf_pc_plast == DUAL || pf_pc_plast == CASCADE) && params.tsPerHistBinGR > 0)
+	{
+		costs[PHASE_PFPC_PLAST].bytes = zones * gr * (8 + 4 + 2.0 / 8) / params.tsPerHistBinGR;
+	}
+
+	/* per GPU: MF depression and spikes, GO dynamic spillover and spikes up;
+	 * the GR->GO sums and, per zone, the PF->BC and PF->SC sums down */
+	costs[PHASE_TRANSFERS].bytes = gpus * 4 * (2 * mf + 2 * go) + gpus * 4 * go
+		+ zones * gpus * 4 * (bc + sc);
+	costs[PHASE_TRANSFERS].device = ROOF_PCIE;
+
+	/* GO activity; GO->GR output parameters (counter rmw, spike, two outputs per
+	 * GPU); GO->GO depression and gap junctions (an index, a coefficient and a
+	 * neighbour's vGO per coupling); MF->GO and MF->GR depression */
+	double go_gj = params.num_p_go_to_go_gj;
+	costs[PHASE_GO_CELLS].bytes = go * (GO_ACT_BYTES(gpus) + (17 + 8 * gpus)
+		+ (17 + 12 + 12 * go_gj)) + mf * (20 + 12 + 4 * gpus);
+	costs[PHASE_GO_CELLS].flops = go * (GO_ACT_FLOPS + 25 + 4 + 5 * go_gj) + mf * 16;
+	costs[PHASE_GO_CELLS].device = ROOF_HOST;
+
+	/* per zone: PC, SC and BC state updates; IO with a conductance rmw and an
+	 * input spike per NC synapse; NC likewise per PC synapse, plus a weight per
+	 * MF synapse; the MF->NC inputs and the spike buffers of every output */
+	double nc_io = io * params.num_p_io_from_nc_to_io;
+	double pc_nc = nc * params.num_p_nc_from_pc_to_nc;
+	double mf_nc = nc * params.num_p_nc_from_mf_to_nc;
+	costs[PHASE_MZONE_CELLS].bytes = zones * (pc * 61 + sc * 37 + bc * 53
+		+ io * 40 + 9 * nc_io + nc * 40 + 9 * pc_nc + 13 * mf_nc + 5 * mf_nc
+		+ 4 * (pc + sc + bc + io + nc));
+	costs[PHASE_MZONE_CELLS].flops = zones * (pc * 25 + sc * 12 + bc * 18
+		+ io * 20 + 4 * nc_io + nc * 20 + 4 * pc_nc + 5 * mf_nc);
+	costs[PHASE_MZONE_CELLS].device = ROOF_HOST;
+}
+
+static bool cuda_ok(cudaError_t error, const char *what)
+{
+	if (error == cudaSuccess) return true;
+	std::cerr << "[ERROR]: Roofline peak measurement: " << what << ": "
+			  << cudaGetErrorString(error) << "\n";
+	return false;
+}
+
+static double measure_host_bw()
+{
+	size_t n = HOST_TRIAD_ELEMS;
+	double *a = new double[n];
+	double *b = new double[n];
+	double *c = new double[n];
+	#pragma omp parallel for schedule(static)
+	for (size_t i = 0; i < n; i++)
+	{
+		a[i] = 0.0;
+		b[i] = 1.0;
+		c[i] = 2.0;
+	}
+	double best = 1e30;
+	for (int r = 0; r < PEAK_REPS; r++)
+	{
+		double start = omp_get_wtime();
+		#pragma omp parallel for schedule(static)
+		for (size_t i = 0; i < n; i++)
+		{
+			a[i] = b[i] + 3.0 * c[i];
+		}
+		best = std::min(best, omp_get_wtime() - start);
+	}
+	delete[] a;
+	delete[] b;
+	delete[] c;
+	return 3.0 * sizeof(double) * n / best;
+}
+
+static double measure_host_flops()
+{
+	const int chains = PEAK_FLOPS_CHAINS * 2;
+	double best = 1e30;
+	volatile float sink = 0.0f;
+	for (int r = 0; r < PEAK_REPS; r++)
+	{
+		double start = omp_get_wtime();
+		#pragma omp parallel
+		{
+			float acc[chains];
+			for (int j = 0; j < chains; j++) acc[j] = omp_get_thread_num() + j;
+			for (int i = 0; i < HOST_FMA_ITERS; i++)
+			{
+				for (int j = 0; j < chains; j++) acc[j] = acc[j] * 0.9999f + 0.0001f;
+			}
+			float sum = 0.0f;
+			for (int j = 0; j < chains; j++) sum += acc[j];
+			#pragma omp atomic
+			sink += sum;
+		}
+		best = std::min(best, omp_get_wtime() - start);
+	}
+	return 2.0 * chains * HOST_FMA_ITERS * omp_get_max_threads() / best;
+}
+
+/* device-to-device and pinned host-to-device bandwidth and FMA throughput of
+ * the current device. returns false if any of them could not be measured */
+static bool measure_gpu(double &bw, double &flops, double &pcie_bw)
+{
+	char *src = NULL, *dst = NULL, *host = NULL;
+	float *out = NULL;
+	cudaEvent_t start, stop;
+	cudaStream_t st = 0;
+	cudaDeviceProp prop;
+	int dev = 0;
+	float ms, best;
+	bool ok = cuda_ok(cudaGetDevice(&dev), "current device")
+		&& cuda_ok(cudaGetDeviceProperties(&prop, dev), "device properties")
+		&& cuda_ok(cudaMalloc((void **)&src, GPU_COPY_BYTES), "device alloc")
+		&& cuda_ok(cudaMalloc((void **)&dst, GPU_COPY_BYTES), "device alloc")
+		&& cuda_ok(cudaMallocHost((void **)&host, PCIE_COPY_BYTES), "pinned alloc");
+	unsigned int num_blocks = prop.multiProcessorCount * GPU_FMA_BLOCKS_PER_SM;
+	ok = ok && cuda_ok(cudaMalloc((void **)&out, num_blocks * GPU_FMA_THREADS * sizeof(float)), "device alloc");
+
+	cudaEventCreate(&start);
+	cudaEventCreate(&stop);
+	if (ok)
+	{
+		best = 1e30;
+		for (int r = 0; r < PEAK_REPS; r++)
+		{
+			cudaEventRecord(start, st);
+			cudaMemcpyAsync(dst, src, GPU_COPY_BYTES, cudaMemcpyDeviceToDevice, st);
+			cudaEventRecord(stop, st);
+			cudaEventSynchronize(stop);
+			cudaEventElapsedTime(&ms, start, stop);
+			best = std::min(best, ms);
+		}
+		bw = 2.0 * GPU_COPY_BYTES / (best * 1e-3);
+
+		best = 1e30;
+		for (int r = 0; r < PEAK_REPS; r++)
+		{
+			cudaEventRecord(start, st);
+			cudaMemcpyAsync(dst, host, PCIE_COPY_BYTES, cudaMemcpyHostToDevice, st);
+			cudaEventRecord(stop, st);
+			cudaEventSynchronize(stop);
+			cudaEventElapsedTime(&ms, start, stop);
+			best = std::min(best, ms);
+		}
+		pcie_bw = (double)PCIE_COPY_BYTES / (best * 1e-3);
+
+		best = 1e30;
+		for (int r = 0; r < PEAK_REPS; r++)
+		{
+			cudaEventRecord(start, st);
+			callPeakFlopsKernel(st, num_blocks, GPU_FMA_THREADS, out, GPU_FMA_ITERS);
+			cudaEventRecord(stop, st);
+			cudaEventSynchronize(stop);
+			cudaEventElapsedTime(&ms, start, stop);
+			best = std::min(best, ms);
+		}
+		flops = 2.0 * PEAK_FLOPS_CHAINS * GPU_FMA_ITERS * num_blocks * GPU_FMA_THREADS
+			/ (best * 1e-3);
+		ok = cuda_ok(cudaGetLastError(), "benchmark");
+	}
+	cudaEventDestroy(start);
+	cudaEventDestroy(stop);
+	if (src)  cudaFree(src);
+	if (dst)  cudaFree(dst);
+	if (out)  cudaFree(out);
+	if (host) cudaFreeHost(host);
+	return ok;
+}
+
+void measure_machine_peaks(int gpu_ind_start, int num_gpus, struct machine_peaks &peaks)
+{
+	peaks = {};
+	peaks.host_threads = omp_get_max_threads();
+	peaks.num_gpus     = num_gpus;
+	peaks.host_bw      = measure_host_bw();
+	peaks.host_flops   = measure_host_flops();
+
+	for (int i = 0; i < num_gpus; i++)
+	{
+		double bw = 0.0, flops = 0.0, pcie_bw = 0.0;
+		if (!cuda_ok(cudaSetDevice(i + gpu_ind_start), "selecting device")
+			|| !measure_gpu(bw, flops, pcie_bw))
+		{
+			peaks.gpu_bw = peaks.gpu_flops = peaks.pcie_bw = 0.0;
+			return;
+		}
+		peaks.gpu_bw    += bw;
+		peaks.gpu_flops += flops;
+		peaks.pcie_bw   += pcie_bw;
+	}
+}
+
+void write_roofline_report(std::string file_name, CBMSimCore *simCore,
+	enum plasticity pf_pc_plast)
+{
+	struct phase_cost costs[NUM_SIM_PHASES];
+	struct machine_peaks peaks;
+	uint64_t num_steps = simCore->getNumTimedSteps();
+	const double *times = simCore->getPhaseTimes();
+	if (num_steps == 0)
+	{
+		std::cerr << "[ERROR]: No time steps were timed, not writing roofline report.\n";
+		return;
+	}
+
+	std::cout << "[INFO]: Measuring machine peaks for the roofline report...\n";
+	model_phase_costs(simCore->getParams(), simCore->getNumZones(), simCore->getNumGPUs(),
+		pf_pc_plast, costs);
+	measure_machine_peaks(simCore->getGPUIndStart(), simCore->getNumGPUs(), peaks);
+
+	std::stringstream report;
+	report << std::fixed;
+	report << "# timed steps: " << num_steps << "\n";
+	report << "# host (" << peaks.host_threads << " threads): "
+		   << std::setprecision(1) << peaks.host_bw * 1e-9 << " GB/s, "
+		   << peaks.host_flops * 1e-9 << " GFLOP/s\n";
+	report << "# gpu (" << peaks.num_gpus << " devices): "
+		   << peaks.gpu_bw * 1e-9 << " GB/s, " << peaks.gpu_flops * 1e-9 << " GFLOP/s\n";
+	report << "# pcie: " << peaks.pcie_bw * 1e-9 << " GB/s\n";
+	report << std::left << std::setw(12) << "phase" << std::setw(6) << "dev"
+		   << std::right << std::setw(11) << "us/step" << std::setw(13) << "bytes"
+		   << std::setw(13) << "flops" << std::setw(8) << "AI" << std::setw(10) << "GB/s"
+		   << std::setw(8) << "%bw" << std::setw(10) << "GFLOP/s" << std::setw(8) << "%flops"
+		   << std::setw(10) << "bound" << std::setw(8) << "%roof" << "\n";
+
+	double total_time = 0.0;
+	for (int i = 0; i < NUM_SIM_PHASES; i++)
+	{
+		struct phase_cost &c = costs[i];
+		double t = times[i] / num_steps;
+		total_time += t;
+
+		double peak_bw = (c.device == ROOF_GPU) ? peaks.gpu_bw
+			: (c.device == ROOF_PCIE) ? peaks.pcie_bw : peaks.host_bw;
+		double peak_flops = (c.device == ROOF_GPU) ? peaks.gpu_flops
+			: (c.device == ROOF_PCIE) ? 0.0 : peaks.host_flops;
+
+		double ai = (c.bytes > 0.0) ? c.flops / c.bytes : 0.0;
+		double bw = (t > 0.0) ? c.bytes / t : 0.0;
+		double fl = (t > 0.0) ? c.flops / t : 0.0;
+
+		const char *bound = "-";
+		double t_roof = 0.0;
+		if (c.bytes > 0.0 && peak_bw > 0.0)
+		{
+			t_roof = c.bytes / peak_bw;
+			bound = "memory";
+			if (c.device == ROOF_PCIE) bound = "transfer";
+			else if (peak_flops > 0.0 && ai >= peak_flops / peak_bw) bound = "compute";
+		}
+		if (c.flops > 0.0 && peak_flops > 0.0)
+			t_roof = std::max(t_roof, c.flops / peak_flops);
+
+		report << std::left << std::setw(12) << sim_phase_name((enum sim_phase)i)
+			   << std::setw(6) << device_name(c.device) << std::right
+			   << std::setprecision(1) << std::setw(11) << t * 1e6
+			   << std::setprecision(0) << std::setw(13) << c.bytes << std::setw(13) << c.flops
+			   << std::setprecision(3) << std::setw(8) << ai
+			   << std::setprecision(1) << std::setw(10) << bw * 1e-9
+			   << std::setw(8) << ((peak_bw > 0.0) ? 100.0 * bw / peak_bw : 0.0)
+			   << std::setw(10) << fl * 1e-9
+			   << std::setw(8) << ((peak_flops > 0.0) ? 100.0 * fl / peak_flops : 0.0)
+			   << std::setw(10) << bound
+			   << std::setw(8) << ((t > 0.0) ? 100.0 * t_roof / t : 0.0) << "\n";
+	}
+	report << std::left << std::setw(18) << "total" << std::right
+		   << std::setprecision(1) << std::setw(11) << total_time * 1e6 << "\n";
+
+	std::fstream out_file_buf(file_name.c_str(), std::ios::out);
+	if (!out_file_buf.is_open())
+	{
+		std::cerr << "[IO_ERROR]: Could not open roofline report file '" << file_name << "'.\n";
+	}
+	else
+	{
+		out_file_buf << report.str();
+		out_file_buf.close();
+		std::cout << "[INFO]: Roofline report written to '" << file_name << "'.\n";
+	}
+
+	std::string line;
+	std::cout << "[INFO]: Per-phase roofline:\n";
+	while (std::getline(report, line))
+	{
+		std::cout << "[INFO]:     " << line << "\n";
+	}
+}
+
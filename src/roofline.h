@@ -0,0 +1,79 @@
+/*
+ * File: roofline.h
+ *
+ * Description:
+ *     Interface for the per-phase bandwidth and roofline report, written at the
+ *     end of a session run with '-P, --roofline FILE'. During the run,
+ *     CBMSimCore times each phase of calcActivity (see enum sim_phase). The
+ *     report sets each phase's measured time per step against an analytic model
+ *     of the bytes it must move and the flops it must do per step, derived from
+ *     the network's sizes, and against the peaks of the machine, measured just
+ *     before the report is written:
+ *
+ *         host - STREAM triad bandwidth and FMA throughput, on as many threads
+ *                as the simulation itself runs with
+ *         GPU  - device-to-device copy bandwidth and FMA throughput, summed
+ *                over the simulation's GPUs
+ *         PCIe - pinned host-to-device copy bandwidth, summed over the GPUs
+ *
+ *     For each phase the report gives the achieved bandwidth and flop rate, the
+ *     arithmetic intensity, whether that intensity puts the phase left (memory
+ *     bound) or right (compute bound) of its device's ridge point, and the
+ *     ratio of the roofline bound max(bytes / bw, flops / peak) to the measured
+ *     time.
+ *
+ *     The model counts compulsory traffic only: every array a phase touches is
+ *     counted once per step, as though nothing stays cached between phases,
+ *     and scattered spike outputs, whose cost depends on activity, are left
+ *     out. MF and GO input to GR is modelled on the pull path. The numbers are
+ *     meant to rank the phases and tell memory-bound ones from compute-bound
+ *     ones, not to predict times.
+ *
+ *     Phase timing synchronizes the GPUs at the end of every phase, which takes
+ *     away the overlap of host and GPU work, so a profiled run is slower than a
+ *     normal one. In a sweep the peaks are measured while the other workers are
+ *     running and come out low.
+ */
+#ifndef ROOFLINE_H_
+#define ROOFLINE_H_
+
+#include <string>
+
+#include "simparams.h"
+#include "cbmsimcore.h"
+
+enum roofline_device {ROOF_GPU, ROOF_PCIE, ROOF_HOST};
+
+/* per time step, summed over GPUs and microzones */
+struct phase_cost
+{
+	double bytes;
+	double flops;
+	enum roofline_device device;
+};
+
+struct machine_peaks
+{
+	int host_threads;
+	int num_gpus;
+	double host_bw;    /* bytes/s */
+	double host_flops; /* flop/s */
+	double gpu_bw;
+	double gpu_flops;
+	double pcie_bw;
+};
+
+const char *sim_phase_name(enum sim_phase phase);
+
+void model_phase_costs(const sim_params &params, uint32_t num_zones, int num_gpus,
+	enum plasticity pf_pc_plast, struct phase_cost costs[NUM_SIM_PHASES]);
+
+/* a peak that could not be measured is left at zero */
+void measure_machine_peaks(int gpu_ind_start, int num_gpus, struct machine_peaks &peaks);
+
+/* writes the report for simCore's timed steps to file_name and prints it */
+void write_roofline_report(std::string file_name, CBMSimCore *simCore,
+	enum plasticity pf_pc_plast);
+
+#endif /* ROOFLINE_H_ */
+
@@ -0,0 +1,381 @@
+/*
+ * File: sim_server.cpp
+ *
+ * Description:
+ *     This file implements the function prototypes in sim_server.h
+ *
+ * Implementation Notes:
+ *     Each client connection gets its own thread that reads request lines and,
+ *     for a 'run' request, blocks until its job has finished before reading the
+ *     next line. Jobs from all clients share a single FIFO that a fixed pool of
+ *     worker threads drains. Simulations are loaded once and never evicted, so
+ *     pointers into sim_snapshots stay valid for the lifetime of the server.
+ *     Loading only reads connectivity params, which are all that reading a
+ *     state needs; each job brings its activity params from its session file.
+ *
+ *     Whatever can be checked before a job runs, its options and its session
+ *     file, is checked on the client's thread and rejected there. What is left
+ *     to throw on the worker, e.g. a session value that is not a number, is
+ *     caught per job and sent back as the job's error.
+ */
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <cstring>
+#include <csignal>
+#include <cerrno>
+#include <exception>
+#include <omp.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "control.h"
+#include "file_utility.h"
+#include "sim_server.h"
+
+static bool send_line(int fd, const std::string &line)
+{
+	std::string out = line + "\n";
+	size_t sent = 0;
+	while (sent < out.size())
+	{
+		ssize_t n = send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+		if (n < 0)
+		{
+			if (errno == EINTR) continue;
+			return false;
+		}
+		sent += n;
+	}
+	return true;
+}
+
+SimServer::SimServer(parsed_commandline &p_cl)
+{
+	socket_path = p_cl.daemon_socket;
+	num_workers = std::stoi(p_cl.num_workers);
+	if (num_workers == 0) num_workers = 1;
+	if (!p_cl.input_sim_file.empty())
+	{
+		std::string err;
+		if (!load_snapshot(p_cl.input_sim_file, err))
+		{
+			std::cerr << "[ERROR]: " << err << "\n";
+		}
+	}
+}
+
+SimServer::~SimServer()
+{
+	if (listen_fd >= 0) close(listen_fd);
+	for (auto &entry : sim_snapshots) delete entry.second.con_state;
+}
+
+bool SimServer::load_snapshot(std::string sim_file, std::string &err)
+{
+	std::lock_guard<std::mutex> lock(snapshot_mutex);
+	if (sim_snapshots.find(sim_file) != sim_snapshots.end()) return true;
+
+	std::fstream sim_file_buf(sim_file.c_str(), std::ios::in | std::ios::binary);
+	if (!sim_file_buf.is_open())
+	{
+		err = "could not open simulation file '" + sim_file + "'";
+		return false;
+	}
+	sim_params con_only;
+	con_only.read_con_params(sim_file_buf);
+	struct sim_snapshot snapshot;
+	snapshot.con_state = new CBMState(con_only, 1, sim_file_buf); /* one zone, as Control */
+	sim_file_buf.close();
+
+	std::stringstream act_buf;
+	snapshot.con_state->writeActState(act_buf);
+	snapshot.act_image = act_buf.str();
+	sim_snapshots[sim_file] = snapshot;
+	std::cout << "[INFO]: Loaded simulation '" << sim_file << "' into memory ("
+			  << snapshot.act_image.size() << " bytes of activity state per job).\n";
+	return true;
+}
+
+const struct sim_snapshot *SimServer::get_snapshot(std::string sim_file, std::string &err)
+{
+	if (!load_snapshot(sim_file, err)) return NULL;
+	std::lock_guard<std::mutex> lock(snapshot_mutex);
+	return &sim_snapshots[sim_file];
+}
+
+void SimServer::worker_loop()
+{
+	while (true)
+	{
+		sim_job *job;
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			queue_cv.wait(lock, [&]{ return !job_queue.empty() || stopping; });
+			if (job_queue.empty()) return; /* stopping and drained */
+			job = job_queue.front();
+			job_queue.pop_front();
+			num_running++;
+		}
+		run_job(job);
+		{
+			std::lock_guard<std::mutex> lock(queue_mutex);
+			num_running--;
+			job->done = true;
+		}
+		done_cv.notify_all();
+	}
+}
+
+void SimServer::run_job(sim_job *job)
+{
+	std::string err;
+	const struct sim_snapshot *snapshot = get_snapshot(job->p_cl.input_sim_file, err);
+	if (!snapshot)
+	{
+		job->failed  = true;
+		job->message = err;
+		return;
+	}
+
+	std::cout << "[INFO]: Starting job " << job->id << " ('" << job->p_cl.session_file << "').\n";
+	double start = omp_get_wtime();
+	mem_read_buf act_buf(snapshot->act_image.data(), snapshot->act_image.size());
+	std::iostream act_stream(&act_buf);
+	Control *control = NULL;
+	try
+	{
+		control = new Control(job->p_cl, job->s_file, snapshot->con_state, act_stream, "");
+		control->runSession(NULL);
+		if (control->health_check_failed)
+		{
+			job->failed  = true;
+			job->message = "numerical health check failed";
+		}
+		else if (!job->p_cl.output_sim_file.empty())
+		{
+			std::cout << "[INFO]: Saving simulation to file...\n";
+			control->save_sim_to_file(job->p_cl.output_sim_file);
+		}
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << "[ERROR]: Job " << job->id << " failed: " << e.what() << "\n";
+		job->failed  = true;
+		job->message = std::string("job failed: ") + e.what();
+	}
+	if (control) delete control;
+	job->run_time = omp_get_wtime() - start;
+	std::cout << "[INFO]: Job " << job->id << " took " << job->run_time << "s.\n";
+}
+
+std::string SimServer::submit_job(int client_fd, std::vector<std::string> &tokens)
+{
+	sim_job job = {};
+	/* parse_commandline_tokens expects the program name in front, like argv */
+	tokens[0] = "cbm_sim";
+	if (parse_commandline_tokens(tokens, job.p_cl) != 0)
+		return "error - malformed run options";
+	if (job.p_cl.session_file.empty() || !job.p_cl.build_file.empty() || !job.p_cl.daemon_socket.empty()
+		|| !job.p_cl.sweep_file.empty())
+		return "error - a job needs a session file and may not build, sweep or start a server";
+	if (validate_session_commandline(job.p_cl) != 0)
+		return "error - invalid run options";
+	if (job.p_cl.vis_mode != "TUI" || !job.p_cl.realtime_socket.empty())
+		return "error - jobs can only run in TUI mode, and not in real time";
+
+	try
+	{
+		tokenized_file t_file;
+		lexed_file l_file;
+		tokenize_file(job.p_cl.session_file, t_file);
+		lex_tokenized_file(t_file, l_file);
+		parse_lexed_sess_file(l_file, job.s_file);
+	}
+	catch (file_parse_error &e)
+	{
+		return std::string("error - session file: ") + e.what();
+	}
+	std::string err;
+	if (!load_snapshot(job.p_cl.input_sim_file, err))
+		return "error - " + err;
+
+	{
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		if (stopping) return "error - server is shutting down";
+		job.id = next_job_id++;
+		job_queue.push_back(&job);
+	}
+	queue_cv.notify_one();
+	send_line(client_fd, "queued " + std::to_string(job.id));
+
+	std::unique_lock<std::mutex> lock(queue_mutex);
+	done_cv.wait(lock, [&]{ return job.done; });
+	if (job.failed) return "error " + std::to_string(job.id) + " " + job.message;
+	return "done " + std::to_string(job.id) + " " + std::to_string(job.run_time);
+}
+
+std::string SimServer::status_line()
+{
+	std::lock_guard<std::mutex> queue_lock(queue_mutex);
+	std::lock_guard<std::mutex> snapshot_lock(snapshot_mutex);
+	return "status workers=" + std::to_string(num_workers)
+		 + " queued=" + std::to_string(job_queue.size())
+		 + " running=" + std::to_string(num_running)
+		 + " loaded=" + std::to_string(sim_snapshots.size());
+}
+
+void SimServer::handle_request(int client_fd, const std::string &line)
+{
+	std::istringstream line_buf(line);
+	std::vector<std::string> tokens;
+	std::string token;
+	while (line_buf >> token) tokens.push_back(token);
+	if (tokens.empty()) return;
+
+	std::string err;
+	if (tokens[0] == "run")
+	{
+		send_line(client_fd, submit_job(client_fd, tokens));
+	}
+	else if (tokens[0] == "load" && tokens.size() == 2)
+	{
+		std::string sim_file = INPUT_DATA_PATH + tokens[1];
+		if (load_snapshot(sim_file, err)) send_line(client_fd, "loaded " + sim_file);
+		else send_line(client_fd, "error - " + err);
+	}
+	else if (tokens[0] == "status")
+	{
+		send_line(client_fd, status_line());
+	}
+	else if (tokens[0] == "shutdown")
+	{
+		std::cout << "[INFO]: Shutdown requested. Finishing queued jobs...\n";
+		stopping = true;
+		shutdown(listen_fd, SHUT_RDWR); /* wakes the accept loop */
+		queue_cv.notify_all();
+		send_line(client_fd, "bye");
+	}
+	else
+	{
+		send_line(client_fd, "error - unknown request '" + tokens[0] + "'");
+	}
+}
+
+void SimServer::serve_client(uint64_t client_id, int client_fd)
+{
+	std::string pending;
+	char buf[4096];
+	while (true)
+	{
+		ssize_t n = recv(client_fd, buf, sizeof(buf), 0);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) break;
+		pending.append(buf, n);
+		size_t eol;
+		while ((eol = pending.find('\n')) != std::string::npos)
+		{
+			handle_request(client_fd, pending.substr(0, eol));
+			pending.erase(0, eol + 1);
+		}
+	}
+	if (!pending.empty()) handle_request(client_fd, pending);
+
+	std::lock_guard<std::mutex> lock(client_mutex);
+	client_fds.erase(client_id);
+	close(client_fd);
+	finished_clients.push_back(client_id);
+}
+
+void SimServer::reap_clients()
+{
+	std::vector<std::thread> finished;
+	{
+		std::lock_guard<std::mutex> lock(client_mutex);
+		for (uint64_t client_id : finished_clients)
+		{
+			finished.push_back(std::move(client_threads[client_id]));
+			client_threads.erase(client_id);
+		}
+		finished_clients.clear();
+	}
+	/* each is past its last use of client_mutex, if not quite returned yet */
+	for (auto &client : finished) client.join();
+}
+
+int SimServer::run()
+{
+	signal(SIGPIPE, SIG_IGN);
+
+	struct sockaddr_un addr = {};
+	addr.sun_family = AF_UNIX;
+	if (socket_path.size() >= sizeof(addr.sun_path))
+	{
+		std::cerr << "[ERROR]: Socket path '" << socket_path << "' is too long.\n";
+		return 1;
+	}
+	strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+	listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listen_fd < 0)
+	{
+		std::cerr << "[ERROR]: Could not create socket: " << strerror(errno) << "\n";
+		return 1;
+	}
+	unlink(socket_path.c_str());
+	if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0
+		|| listen(listen_fd, 16) < 0)
+	{
+		std::cerr << "[ERROR]: Could not listen on '" << socket_path << "': " << strerror(errno) << "\n";
+		return 1;
+	}
+
+	for (uint32_t i = 0; i < num_workers; i++)
+	{
+		workers.push_back(std::thread(&SimServer::worker_loop, this));
+	}
+	std::cout << "[INFO]: Simulation server listening on '" << socket_path
+			  << "' with " << num_workers << " worker(s).\n";
+
+	while (!stopping)
+	{
+		int client_fd = accept(listen_fd, NULL, NULL);
+		if (client_fd < 0)
+		{
+			if (stopping) break;
+			if (errno == EINTR) continue;
+			std::cerr << "[ERROR]: accept failed: " << strerror(errno) << "\n";
+			break;
+		}
+		reap_clients();
+		std::lock_guard<std::mutex> lock(client_mutex);
+		uint64_t client_id = next_client_id++;
+		client_fds[client_id] = client_fd;
+		client_threads[client_id] = std::thread(&SimServer::serve_client, this, client_id, client_fd);
+	}
+
+	stopping = true;
+	queue_cv.notify_all();
+	for (auto &worker : workers) worker.join();
+
+	/* wakes the clients still connected, which then close their own fds */
+	{
+		std::lock_guard<std::mutex> lock(client_mutex);
+		for (auto &entry : client_fds) shutdown(entry.second, SHUT_RDWR);
+	}
+	for (auto &entry : client_threads) entry.second.join();
+
+	close(listen_fd);
+	listen_fd = -1;
+	unlink(socket_path.c_str());
+	std::cout << "[INFO]: Simulation server stopped.\n";
+	return 0;
+}
+
+int run_sim_server(parsed_commandline &p_cl)
+{
+	SimServer server(p_cl);
+	return server.run();
+}
+
@@ -0,0 +1,119 @@
+/*
+ * File: sim_server.h
+ *
+ * Description:
+ *     Interface for the long-running simulation server ('daemon mode'). The
+ *     server reads every .sim file it is asked for once, into a CBMState it
+ *     keeps in memory, and accepts session jobs over a local unix socket. As
+ *     with sweep points (see sweep.h), each job shares the connectivity of its
+ *     simulation and starts from its own copy of the pristine activity state,
+ *     so repeated runs of the same rabbit neither touch the disk for the
+ *     simulation file nor read its connectivity again.
+ *
+ *     The protocol is line based. A client sends one request per line and gets
+ *     one or more reply lines back:
+ *
+ *         run <run-mode options>  -> 'queued <id>' then 'done <id> <secs>'
+ *                                    or 'error <id> <reason>'
+ *         load <sim file>         -> 'loaded <file>' or 'error <reason>'
+ *         status                  -> 'status workers=.. queued=.. running=.. loaded=..'
+ *         shutdown                -> 'bye'; queued jobs are finished first
+ *
+ *     Run-mode options are the same as on the command line (-s, -i, -o, -r,
+ *     -p, -w, -S and the plasticity flags), and outputs are written to disk
+ *     exactly as a normal TUI run would write them.
+ *
+ *     Every job carries its own parameter context (see simparams.h), so workers
+ *     run any jobs side by side, whatever their simulation and session files.
+ *     A job's options and session file are checked before it is queued, and a
+ *     job that fails anyway gets an error reply; neither stops the server.
+ */
+#ifndef SIM_SERVER_H_
+#define SIM_SERVER_H_
+
+#include <string>
+#include <map>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+#include "commandline.h"
+#include "file_parse.h"
+#include "cbmstate.h"
+
+struct sim_job
+{
+	uint64_t id;
+	parsed_commandline p_cl;
+	parsed_sess_file s_file;
+	bool done;
+	bool failed;
+	double run_time;
+	std::string message;
+};
+
+/* a loaded simulation: its connectivity, shared by its jobs, and its activity
+ * state as writeActState writes it, which every job reads its own copy of */
+struct sim_snapshot
+{
+	CBMState *con_state;
+	std::string act_image;
+};
+
+class SimServer
+{
+	public:
+		SimServer(parsed_commandline &p_cl);
+		~SimServer();
+
+		/* blocks until a client sends 'shutdown'. returns the exit status */
+		int run();
+
+	private:
+		std::string socket_path;
+		uint32_t num_workers;
+		int listen_fd = -1;
+		std::atomic<bool> stopping{false};
+
+		/* loaded simulations, keyed by full path */
+		std::mutex snapshot_mutex;
+		std::map<std::string, struct sim_snapshot> sim_snapshots;
+
+		std::mutex queue_mutex;
+		std::condition_variable queue_cv;
+		std::deque<sim_job *> job_queue;
+		uint64_t next_job_id = 0;
+		uint32_t num_running = 0;
+
+		std::condition_variable done_cv;
+
+		/* connected clients by id. a client that disconnects closes its fd and
+		 * leaves its id in finished_clients for the accept loop to join */
+		std::mutex client_mutex;
+		uint64_t next_client_id = 0;
+		std::map<uint64_t, std::thread> client_threads;
+		std::map<uint64_t, int> client_fds;
+		std::vector<uint64_t> finished_clients;
+		std::vector<std::thread> workers;
+
+		bool load_snapshot(std::string sim_file, std::string &err);
+		const struct sim_snapshot *get_snapshot(std::string sim_file, std::string &err);
+
+		void worker_loop();
+		void run_job(sim_job *job);
+
+		void serve_client(uint64_t client_id, int client_fd);
+		void reap_clients();
+		void handle_request(int client_fd, const std::string &line);
+		std::string submit_job(int client_fd, std::vector<std::string> &tokens);
+		std::string status_line();
+};
+
+int run_sim_server(parsed_commandline &p_cl);
+
+#endif /* SIM_SERVER_H_ */
+
@@ -0,0 +1,368 @@
+/*
+ * File: state_digest.cpp
+ *
+ * Description:
+ *     This file implements the function prototypes in state_digest.h
+ *
+ * Implementation Notes:
+ *     The hash follows the structure of xxHash64 (four independent lanes over
+ *     32-byte stripes, then a tail and an avalanche step) so that hashing the
+ *     ~1M-element GR arrays stays well under a millisecond. It is not meant to
+ *     be compatible with xxHash itself. Floats are hashed by their raw bits, so
+ *     e.g. -0.0f and 0.0f hash differently: exact mode really means bitwise.
+ *
+ *     Every sample first brings the activity states up to date, as saving does:
+ *     the GR variables live on the GPU and are copied back, as are the PFPC
+ *     weights. With a small step interval these copies dominate, which is the
+ *     reason the default is one sample per trial. Integer arrays are summed in
+ *     double, like floats, which is exact for any count a cell can reach.
+ */
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "state_digest.h"
+
+#define DIGEST_P1 0x9E3779B185EBCA87ULL
+#define DIGEST_P2 0xC2B2AE3D27D4EB4FULL
+#define DIGEST_P3 0x165667B19E3779F9ULL
+#define DIGEST_P4 0x85EBCA77C2B2AE63ULL
+#define DIGEST_P5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read_word(const uint8_t *p)
+{
+	uint64_t w;
+	memcpy(&w, p, sizeof(w));
+	return w;
+}
+
+static inline uint64_t lane_round(uint64_t acc, uint64_t w)
+{
+	acc += w * DIGEST_P2;
+	return rotl64(acc, 31) * DIGEST_P1;
+}
+
+static inline uint64_t merge_lane(uint64_t h, uint64_t acc)
+{
+	h ^= lane_round(0, acc);
+	return h * DIGEST_P1 + DIGEST_P4;
+}
+
+uint64_t digest_hash64(const void *data, uint64_t num_bytes, uint64_t seed)
+{
+	const uint8_t *p   = (const uint8_t *)data;
+	const uint8_t *end = p + num_bytes;
+	uint64_t h;
+
+	if (num_bytes >= 32)
+	{
+		uint64_t acc[4] = { seed + DIGEST_P1 + DIGEST_P2, seed + DIGEST_P2, seed, seed - DIGEST_P1 };
+		const uint8_t *stripe_end = end - 32;
+		do
+		{
+			acc[0] = lane_round(acc[0], read_word(p));
+			acc[1] = lane_round(acc[1], read_word(p + 8));
+			acc[2] = lane_round(acc[2], read_word(p + 16));
+			acc[3] = lane_round(acc[3], read_word(p + 24));
+			p += 32;
+		} while (p <= stripe_end);
+		h = rotl64(acc[0], 1) + rotl64(acc[1], 7) + rotl64(acc[2], 12) + rotl64(acc[3], 18);
+		for (int i = 0; i < 4; i++) h = merge_lane(h, acc[i]);
+	}
+	else h = seed + DIGEST_P5;
+
+	h += num_bytes;
+	for (; p + 8 <= end; p += 8)
+	{
+		h ^= lane_round(0, read_word(p));
+		h  = rotl64(h, 27) * DIGEST_P1 + DIGEST_P4;
+	}
+	for (; p < end; p++)
+	{
+		h ^= (*p) * DIGEST_P5;
+		h  = rotl64(h, 11) * DIGEST_P1;
+	}
+
+	h ^= h >> 33;
+	h *= DIGEST_P2;
+	h ^= h >> 29;
+	h *= DIGEST_P3;
+	h ^= h >> 32;
+	return h;
+}
+
+void digest_uint8_arr(const uint8_t *arr, uint64_t n, struct var_digest &d)
+{
+	d = {};
+	d.n    = n;
+	d.hash = digest_hash64(arr, n * sizeof(uint8_t));
+	if (n == 0) return;
+	uint64_t sum = 0;
+	uint8_t min = arr[0], max = arr[0];
+	for (uint64_t i = 0; i < n; i++)
+	{
+		sum += arr[i];
+		min  = std::min(min, arr[i]);
+		max  = std::max(max, arr[i]);
+	}
+	d.sum = sum;
+	d.min = min;
+	d.max = max;
+}
+
+template<typename T>
+static void digest_int_arr(const T *arr, uint64_t n, struct var_digest &d)
+{
+	d = {};
+	d.n    = n;
+	d.hash = digest_hash64(arr, n * sizeof(T));
+	if (n == 0) return;
+	T min = arr[0], max = arr[0];
+	for (uint64_t i = 0; i < n; i++)
+	{
+		d.sum += arr[i];
+		min    = std::min(min, arr[i]);
+		max    = std::max(max, arr[i]);
+	}
+	d.min = min;
+	d.max = max;
+}
+
+void digest_float_arr(const float *arr, uint64_t n, struct var_digest &d)
+{
+	d = {};
+	d.n    = n;
+	d.hash = digest_hash64(arr, n * sizeof(float));
+	bool seen_finite = false;
+	for (uint64_t i = 0; i < n; i++)
+	{
+		if (!std::isfinite(arr[i]))
+		{
+			d.nonfinite++;
+			continue;
+		}
+		d.sum += arr[i];
+		if (!seen_finite)
+		{
+			d.min = d.max = arr[i];
+			seen_finite = true;
+		}
+		else
+		{
+			d.min = std::min(d.min, (double)arr[i]);
+			d.max = std::max(d.max, (double)arr[i]);
+		}
+	}
+}
+
+StateDigest::StateDigest(std::string out_file_name, uint32_t every_n_steps,
+	std::string sess_file_name, std::string sim_file_name) : every_n_steps(every_n_steps)
+{
+	out_file_buf.open(out_file_name.c_str(), std::ios::out);
+	if (!out_file_buf.is_open())
+	{
+		std::cerr << "[IO_ERROR]: Could not open digest file '" << out_file_name << "'. No digests will be written.\n";
+		return;
+	}
+	out_file_buf << "# cbm_sim state digest\n";
+	out_file_buf << "# session " << sess_file_name << "\n";
+	out_file_buf << "# sim " << sim_file_name << "\n";
+	out_file_buf << "# every " << every_n_steps << "\n";
+	out_file_buf << "# step trial ts var n hash sum min max nonfinite\n";
+	out_file_buf << std::setprecision(17);
+	std::cout << "[INFO]: Writing state digests to '" << out_file_name << "'\n";
+}
+
+StateDigest::~StateDigest()
+{
+	if (out_file_buf.is_open()) out_file_buf.close();
+}
+
+void StateDigest::step(CBMSimCore *simCore, uint32_t num_zones, uint32_t trial, uint32_t ts, bool last_ts)
+{
+	bool on_interval = every_n_steps > 0 && (global_step + 1) % every_n_steps == 0;
+	if (out_file_buf.is_open() && (on_interval || last_ts)) sample(simCore, num_zones, trial, ts);
+	global_step++;
+}
+
+void StateDigest::write_var(uint32_t trial, uint32_t ts, const char *var_name, int zone, struct var_digest &d)
+{
+	out_file_buf << global_step << " " << trial << " " << ts << " " << var_name;
+	if (zone >= 0) out_file_buf << "." << zone;
+	out_file_buf << " " << d.n << " "
+				 << std::hex << std::setw(16) << std::setfill('0') << d.hash << std::dec << std::setfill(' ')
+				 << " " << d.sum << " " << d.min << " " << d.max << " " << d.nonfinite << "\n";
+}
+
+class StateDigest::StateArrayDigester : public StateVisitor
+{
+	public:
+		StateArrayDigester(StateDigest &digest, uint32_t trial, uint32_t ts, int zone)
+			: digest(digest), trial(trial), ts(ts), zone(zone) {}
+
+		void visit(const char *name, uint8_t *arr, uint64_t n) override
+		{
+			digest_uint8_arr(arr, n, d);
+			digest.write_var(trial, ts, name, zone, d);
+		}
+		void visit(const char *name, uint32_t *arr, uint64_t n) override
+		{
+			digest_int_arr(arr, n, d);
+			digest.write_var(trial, ts, name, zone, d);
+		}
+		void visit(const char *name, int32_t *arr, uint64_t n) override
+		{
+			digest_int_arr(arr, n, d);
+			digest.write_var(trial, ts, name, zone, d);
+		}
+		void visit(const char *name, uint64_t *arr, uint64_t n) override
+		{
+			digest_int_arr(arr, n, d);
+			digest.write_var(trial, ts, name, zone, d);
+		}
+		void visit(const char *name, float *arr, uint64_t n) override
+		{
+			digest_float_arr(arr, n, d);
+			digest.write_var(trial, ts, name, zone, d);
+		}
+
+	private:
+		StateDigest &digest;
+		uint32_t trial;
+		uint32_t ts;
+		int zone;
+		struct var_digest d;
+};
+
+void StateDigest::sample(CBMSimCore *simCore, uint32_t num_zones, uint32_t trial, uint32_t ts)
+{
+	struct var_digest d;
+	const sim_params &p = simCore->getParams();
+	CBMState *state = simCore->getState();
+
+	/* the MF spikes are the network's input rather than its state */
+	digest_uint8_arr(simCore->getInputNet()->exportAPMF(), p.num_mf, d);
+	write_var(trial, ts, "MF_AP", -1, d);
+
+	simCore->writeToState();
+	StateArrayDigester innet_digester(*this, trial, ts, -1);
+	state->getInnetActStateInternal()->visitState(innet_digester);
+	for (uint32_t z = 0; z < num_zones; z++)
+	{
+		StateArrayDigester zone_digester(*this, trial, ts, z);
+		state->getMZoneActStateInternal(z)->visitState(zone_digester);
+	}
+	out_file_buf.flush();
+}
+
+struct digest_record
+{
+	uint64_t step;
+	uint32_t trial;
+	uint32_t ts;
+	std::string var;
+	struct var_digest d;
+};
+
+static bool read_digest_record(std::ifstream &in_file, struct digest_record &rec)
+{
+	std::string line;
+	while (std::getline(in_file, line))
+	{
+		if (line.empty() || line[0] == '#') continue;
+		std::istringstream line_buf(line);
+		line_buf >> rec.step >> rec.trial >> rec.ts >> rec.var >> rec.d.n
+				 >> std::hex >> rec.d.hash >> std::dec
+				 >> rec.d.sum >> rec.d.min >> rec.d.max >> rec.d.nonfinite;
+		if (line_buf.fail()) continue;
+		return true;
+	}
+	return false;
+}
+
+static bool within_tolerance(double a, double b, double tolerance)
+{
+	if (a == b) return true;
+	return std::fabs(a - b) <= tolerance * std::max(1.0, std::max(std::fabs(a), std::fabs(b)));
+}
+
+static void print_record_pair(struct digest_record &a, struct digest_record &b)
+{
+	std::streamsize prev_precision = std::cout.precision(17);
+	std::cout << "[INFO]:     A: hash " << std::hex << a.d.hash << std::dec << " sum " << a.d.sum
+			  << " min " << a.d.min << " max " << a.d.max << " nonfinite " << a.d.nonfinite << "\n";
+	std::cout << "[INFO]:     B: hash " << std::hex << b.d.hash << std::dec << " sum " << b.d.sum
+			  << " min " << b.d.min << " max " << b.d.max << " nonfinite " << b.d.nonfinite << "\n";
+	std::cout.precision(prev_precision);
+}
+
+int compare_digest_files(std::string file_a, std::string file_b, double tolerance)
+{
+	std::ifstream in_a(file_a.c_str()), in_b(file_b.c_str());
+	if (!in_a.is_open() || !in_b.is_open())
+	{
+		std::cerr << "[IO_ERROR]: Could not open digest file '" << (in_a.is_open() ? file_b : file_a) << "'.\n";
+		return 2;
+	}
+	std::cout << "[INFO]: Comparing digests '" << file_a << "' and '" << file_b << "' ";
+	if (tolerance > 0) std::cout << "to a relative tolerance of " << tolerance << "...\n";
+	else std::cout << "exactly...\n";
+
+	struct digest_record a, b;
+	uint64_t num_records = 0, num_diverged = 0;
+	bool have_a, have_b;
+	while (true)
+	{
+		have_a = read_digest_record(in_a, a);
+		have_b = read_digest_record(in_b, b);
+		if (!have_a || !have_b) break;
+		if (a.step != b.step || a.var != b.var || a.d.n != b.d.n)
+		{
+			std::cerr << "[ERROR]: Digests were not sampled the same way: '" << a.var << "' at step " << a.step
+					  << " vs '" << b.var << "' at step " << b.step << ".\n";
+			return 2;
+		}
+		num_records++;
+
+		bool match;
+		if (tolerance > 0)
+		{
+			match = a.d.nonfinite == b.d.nonfinite
+				 && within_tolerance(a.d.sum, b.d.sum, tolerance)
+				 && within_tolerance(a.d.min, b.d.min, tolerance)
+				 && within_tolerance(a.d.max, b.d.max, tolerance);
+		}
+		else match = a.d.hash == b.d.hash;
+		if (match) continue;
+
+		if (num_diverged == 0)
+		{
+			std::cout << "[INFO]: First divergence at step " << a.step << " (trial " << a.trial + 1
+					  << ", ts " << a.ts << "), variable '" << a.var << "':\n";
+			print_record_pair(a, b);
+		}
+		num_diverged++;
+	}
+	if (have_a != have_b)
+	{
+		std::cout << "[INFO]: Digest '" << (have_a ? file_b : file_a) << "' ends early, after "
+				  << num_records << " records.\n";
+	}
+
+	if (num_diverged == 0 && have_a == have_b)
+	{
+		std::cout << "[INFO]: Digests agree on all " << num_records << " records.\n";
+		return 0;
+	}
+	std::cout << "[INFO]: " << num_diverged << " of " << num_records << " compared records diverge.\n";
+	return 1;
+}
+
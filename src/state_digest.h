@@ -0,0 +1,80 @@
+/*
+ * File: state_digest.h
+ *
+ * Description:
+ *     Interface for cheap state digests, used to check that an optimized engine
+ *     still produces the same simulation as a reference one. At the end of every
+ *     trial (and optionally every N time steps) each tracked variable -- the MF
+ *     spikes driving the network and every array of the activity state, exactly
+ *     those a saved simulation holds (see state_visitor.h) -- is reduced to a
+ *     64-bit hash of its raw bytes plus a few summary statistics, and one line
+ *     per variable is appended to a small text log:
+ *
+ *         step trial ts var n hash sum min max nonfinite
+ *
+ *     var is the state member's name, e.g. vSC or gPFBC, with '.<zone>' appended
+ *     for microzone variables.
+ *
+ *     Two logs are compared with compare_digest_files, which reports the first
+ *     step and variable at which the runs diverge. With a tolerance of 0 the
+ *     hashes must match exactly (bitwise reproducibility); with a tolerance > 0
+ *     only the statistics are compared, each to within that relative tolerance,
+ *     for engines that reorder floating point operations.
+ */
+#ifndef STATE_DIGEST_H_
+#define STATE_DIGEST_H_
+
+#include <string>
+#include <fstream>
+#include <cstdint>
+
+#include "cbmsimcore.h"
+
+struct var_digest
+{
+	uint64_t n;
+	uint64_t hash;
+	double sum;
+	double min;
+	double max;
+	uint64_t nonfinite;
+};
+
+/* streaming 64-bit hash over an arbitrary byte range. not cryptographic; it only
+ * has to make accidental collisions between two runs vanishingly unlikely */
+uint64_t digest_hash64(const void *data, uint64_t num_bytes, uint64_t seed = 0);
+
+void digest_uint8_arr(const uint8_t *arr, uint64_t n, struct var_digest &d);
+void digest_float_arr(const float *arr, uint64_t n, struct var_digest &d);
+
+class StateDigest
+{
+	public:
+		/* every_n_steps == 0 digests at the end of each trial only */
+		StateDigest(std::string out_file_name, uint32_t every_n_steps,
+			std::string sess_file_name, std::string sim_file_name);
+		~StateDigest();
+
+		/* called once per time step, after CBMSimCore::calcActivity */
+		void step(CBMSimCore *simCore, uint32_t num_zones, uint32_t trial, uint32_t ts, bool last_ts);
+
+	private:
+		std::fstream out_file_buf;
+		uint32_t every_n_steps;
+		uint64_t global_step = 0;
+
+		/* digests and writes every array of an activity state */
+		class StateArrayDigester;
+
+		/* zone < 0 for variables that are not per microzone */
+		void write_var(uint32_t trial, uint32_t ts, const char *var_name, int zone, struct var_digest &d);
+		void sample(CBMSimCore *simCore, uint32_t num_zones, uint32_t trial, uint32_t ts);
+};
+
+/* compares two digest logs and prints the first divergence. returns 0 if the
+ * logs agree, 1 if they diverge and 2 if either cannot be read or their layouts
+ * (steps and variables sampled) differ */
+int compare_digest_files(std::string file_a, std::string file_b, double tolerance);
+
+#endif /* STATE_DIGEST_H_ */
+
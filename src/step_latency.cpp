@@ -0,0 +1,175 @@
+/*
+ * File: step_latency.cpp
+ *
+ * Description:
+ *     This file implements the function prototypes in step_latency.h
+ *
+ * Implementation Notes:
+ *     Every call made from inside the step loop reads the clock once and does
+ *     a handful of relaxed atomic adds; nothing allocates or prints. Steps go
+ *     into the trial histograms only, which end_trial adds to the session ones
+ *     between trials, so a step pays for one histogram per part instead of two.
+ *
+ *     The boundary of trial t is recorded at the first step of trial t + 1, so
+ *     it is counted with trial t + 1. A session's last trial has no boundary.
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#include "roofline.h"
+#include "step_latency.h"
+
+const char *step_part_name(enum step_part part)
+{
+	switch (part)
+	{
+		case STEP_MF_INPUT: return "mf_input";
+		case STEP_CORE:     return "core";
+		case STEP_CHECKS:   return "checks";
+		case STEP_COLLECT:  return "collect";
+		case STEP_GUI:      return "gui";
+		case STEP_TOTAL:    return "step";
+		case STEP_BOUNDARY: return "boundary";
+		default:            return "unknown";
+	}
+}
+
+static void write_hist_header(std::ostream &out)
+{
+	out << std::left << std::setw(12) << "part" << std::right << std::setw(10) << "count"
+		<< std::setw(11) << "mean" << std::setw(11) << "p50" << std::setw(11) << "p99"
+		<< std::setw(11) << "p99.9" << std::setw(11) << "max" << "\n";
+}
+
+/* one row, in us */
+static void write_hist_row(std::ostream &out, const char *name, const LatencyHistogram &hist)
+{
+	out << std::left << std::setw(12) << name << std::right << std::setw(10) << hist.count()
+		<< std::setprecision(1)
+		<< std::setw(11) << hist.mean() * 1e-3
+		<< std::setw(11) << hist.percentile(50.0) * 1e-3
+		<< std::setw(11) << hist.percentile(99.0) * 1e-3
+		<< std::setw(11) << hist.percentile(99.9) * 1e-3
+		<< std::setw(11) << hist.max() * 1e-3 << "\n";
+}
+
+StepLatency::StepLatency(std::string report_file_name, bool per_trial, bool with_phases)
+	: report_file_name(report_file_name), per_trial(per_trial), with_phases(with_phases) {}
+
+void StepLatency::begin_step()
+{
+	step_start_ns = latency_now_ns();
+	mark_ns = step_start_ns;
+	if (in_boundary)
+	{
+		trial_parts[STEP_BOUNDARY].record(boundary_ns + (step_start_ns - boundary_mark));
+		in_boundary = false;
+	}
+}
+
+void StepLatency::mark(enum step_part part)
+{
+	uint64_t now = latency_now_ns();
+	trial_parts[part].record(now - mark_ns);
+	mark_ns = now;
+}
+
+void StepLatency::end_step(CBMSimCore *simCore)
+{
+	uint64_t now = latency_now_ns();
+	trial_parts[STEP_TOTAL].record(now - step_start_ns);
+	if (with_phases)
+	{
+		const double *phase_times = simCore->getStepPhaseTimes();
+		for (int i = 0; i < NUM_SIM_PHASES; i++)
+		{
+			trial_phases[i].record((uint64_t)(phase_times[i] * 1e9));
+		}
+	}
+	step_end_ns = now;
+}
+
+void StepLatency::end_trial(const std::string &trial_name)
+{
+	if (per_trial)
+	{
+		const LatencyHistogram &steps = trial_parts[STEP_TOTAL];
+		std::cout << "[INFO]: '" << trial_name << "' step latency (us): p50 " << std::fixed
+				  << std::setprecision(1) << steps.percentile(50.0) * 1e-3
+				  << ", p99 " << steps.percentile(99.0) * 1e-3
+				  << ", p99.9 " << steps.percentile(99.9) * 1e-3
+				  << ", max " << steps.max() * 1e-3 << "\n" << std::defaultfloat;
+	}
+	for (int i = 0; i < NUM_STEP_PARTS; i++)
+	{
+		session_parts[i].merge(trial_parts[i]);
+		trial_parts[i].reset();
+	}
+	if (with_phases)
+	{
+		for (int i = 0; i < NUM_SIM_PHASES; i++)
+		{
+			session_phases[i].merge(trial_phases[i]);
+			trial_phases[i].reset();
+		}
+	}
+	num_trials++;
+	in_boundary   = true;
+	boundary_ns   = 0;
+	boundary_mark = step_end_ns;
+}
+
+void StepLatency::pause_boundary()
+{
+	if (!in_boundary) return;
+	boundary_ns += latency_now_ns() - boundary_mark;
+}
+
+void StepLatency::resume_boundary()
+{
+	if (!in_boundary) return;
+	boundary_mark = latency_now_ns();
+}
+
+void StepLatency::write_report()
+{
+	if (session_parts[STEP_TOTAL].count() == 0)
+	{
+		std::cerr << "[ERROR]: No time steps were recorded, not writing latency report.\n";
+		return;
+	}
+
+	std::stringstream report;
+	report << std::fixed;
+	report << "# steps: " << session_parts[STEP_TOTAL].count() << " over " << num_trials
+		   << " trials, times in us\n";
+	write_hist_header(report);
+	for (int i = 0; i < NUM_STEP_PARTS; i++)
+	{
+		if (session_parts[i].count() == 0) continue;
+		write_hist_row(report, step_part_name((enum step_part)i), session_parts[i]);
+	}
+	if (with_phases)
+	{
+		report << "# phases of core, synchronized\n";
+		for (int i = 0; i < NUM_SIM_PHASES; i++)
+		{
+			write_hist_row(report, sim_phase_name((enum sim_phase)i), session_phases[i]);
+		}
+	}
+	std::cout << report.str();
+
+	std::fstream out_file_buf(report_file_name.c_str(), std::ios::out);
+	if (!out_file_buf.is_open())
+	{
+		std::cerr << "[IO_ERROR]: Could not open latency report file '" << report_file_name << "'.\n";
+	}
+	else
+	{
+		out_file_buf << report.str();
+		out_file_buf.close();
+		std::cout << "[INFO]: Latency report written to '" << report_file_name << "'.\n";
+	}
+}
@@ -0,0 +1,96 @@
+/*
+ * File: step_latency.h
+ *
+ * Description:
+ *     Interface for the step latency recorder, enabled with '-l, --latency FILE'.
+ *     Mean trial times hide the stalls that matter: an output flush, a gtk
+ *     event, a burst of first-touch page faults. The recorder times every time
+ *     step of Control::runSession, split into the parts below, and every gap
+ *     between trials, into HDR histograms (see latency_hist.h), and at the end
+ *     of the session prints and writes count, mean, p50, p99, p99.9 and max of
+ *     each:
+ *
+ *         mf_input  - US delivery, MF spike generation and upload
+ *         core      - CBMSimCore::calcActivity
+ *         checks    - state digest and health watchdog, when enabled
+ *         collect   - CS statistics, raster and PSTH collection
+ *         gui       - gtk event pumping, in GUI mode
+ *         step      - the whole step
+ *         boundary  - end of a trial's last step to the start of the next
+ *                     trial's first: per-trial saves and logging. Time spent
+ *                     paused in the GUI is left out
+ *
+ *     When phase timing is on as well ('-P'), the phases of calcActivity (enum
+ *     sim_phase) get histograms of their own. Their syncs slow the core down,
+ *     so the core's numbers are then only good for ranking.
+ *
+ *     With '--latency-trials' each trial's step latencies are also printed at
+ *     the end of the trial.
+ */
+#ifndef STEP_LATENCY_H_
+#define STEP_LATENCY_H_
+
+#include <string>
+#include <cstdint>
+
+#include "latency_hist.h"
+#include "cbmsimcore.h"
+
+enum step_part
+{
+	STEP_MF_INPUT,
+	STEP_CORE,
+	STEP_CHECKS,
+	STEP_COLLECT,
+	STEP_GUI,
+	STEP_TOTAL,
+	STEP_BOUNDARY,
+	NUM_STEP_PARTS
+};
+
+const char *step_part_name(enum step_part part);
+
+class StepLatency
+{
+	public:
+		StepLatency(std::string report_file_name, bool per_trial, bool with_phases);
+
+		/* called at the start of every step */
+		void begin_step();
+		/* attributes the time since the last mark (or the step's start) to part */
+		void mark(enum step_part part);
+		/* called at the end of every step, after its last mark */
+		void end_step(CBMSimCore *simCore);
+		/* called after a trial's last step. folds the trial into the session
+		 * totals and, if per_trial, prints its latencies */
+		void end_trial(const std::string &trial_name);
+		/* bracket time between trials that is not to count as boundary time */
+		void pause_boundary();
+		void resume_boundary();
+
+		/* prints the session's latencies and writes them to the report file */
+		void write_report();
+
+	private:
+		std::string report_file_name;
+		bool per_trial;
+		bool with_phases;
+
+		uint64_t step_start_ns = 0;
+		uint64_t mark_ns       = 0;
+		uint64_t step_end_ns   = 0;
+		/* boundary time counted so far and when it was last resumed */
+		bool in_boundary       = false;
+		uint64_t boundary_ns   = 0;
+		uint64_t boundary_mark = 0;
+		uint32_t num_trials    = 0;
+
+		/* steps are recorded into the trial histograms, which end_trial adds to
+		 * the session ones and clears */
+		LatencyHistogram trial_parts[NUM_STEP_PARTS];
+		LatencyHistogram trial_phases[NUM_SIM_PHASES];
+		LatencyHistogram session_parts[NUM_STEP_PARTS];
+		LatencyHistogram session_phases[NUM_SIM_PHASES];
+};
+
+#endif /* STEP_LATENCY_H_ */
@@ -0,0 +1,396 @@
+/*
+ * File: sweep.cpp
+ *
+ * Description:
+ *     This file implements the function prototypes in sweep.h
+ *
+ * Implementation Notes:
+ *     Connectivity only depends on connectivity params, which a sweep never
+ *     changes, so one CBMState read from the input simulation provides the
+ *     connectivity for every point. Its activity state is serialized once into
+ *     act_image, and each point reads its own copy from there. A point's
+ *     activity params come from populate_act_params on a copy of the parsed
+ *     session with the swept values substituted, so derived params are
+ *     recomputed just as if the values had been in the session file.
+ *
+ *     Workers claim points in order from an atomic counter. Each worker pins
+ *     itself to cores_per_worker of the cores this process may run on before
+ *     starting; the OpenMP threads of its points inherit that mask.
+ */
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <algorithm>
+#include <omp.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "control.h"
+#include "file_utility.h"
+#include "sfmt.h"
+#include "sweep.h"
+
+bool parse_sweep_file(std::string sweep_file, struct sweep_spec &spec, std::string &err)
+{
+	std::ifstream sweep_file_buf(sweep_file.c_str());
+	if (!sweep_file_buf.is_open())
+	{
+		err = "could not open sweep file '" + sweep_file + "'";
+		return false;
+	}
+	spec = {};
+	spec.mode = SWEEP_GRID;
+	std::string line, key;
+	uint32_t line_num = 0;
+	while (std::getline(sweep_file_buf, line))
+	{
+		line_num++;
+		line = line.substr(0, line.find('#'));
+		std::istringstream line_buf(line);
+		if (!(line_buf >> key)) continue;
+		std::string where = "line " + std::to_string(line_num) + " of '" + sweep_file + "'";
+		if (key == "mode")
+		{
+			std::string mode;
+			line_buf >> mode;
+			if (mode == "grid") spec.mode = SWEEP_GRID;
+			else if (mode == "random") spec.mode = SWEEP_RANDOM;
+			else if (mode == "lhs") spec.mode = SWEEP_LHS;
+			else
+			{
+				err = "unknown sweep mode '" + mode + "' on " + where;
+				return false;
+			}
+		}
+		else if (key == "samples") line_buf >> spec.num_samples;
+		else if (key == "seed") line_buf >> spec.seed;
+		else if (key == "param")
+		{
+			struct sweep_param param = {};
+			param.num_points = 1;
+			line_buf >> param.name >> param.min >> param.max;
+			if (line_buf.fail())
+			{
+				err = "expected 'param NAME MIN MAX [POINTS]' on " + where;
+				return false;
+			}
+			if (!(line_buf >> param.num_points)) param.num_points = 1;
+			spec.params.push_back(param);
+			continue;
+		}
+		else
+		{
+			err = "unknown key '" + key + "' on " + where;
+			return false;
+		}
+		if (line_buf.fail())
+		{
+			err = "missing or malformed value for '" + key + "' on " + where;
+			return false;
+		}
+	}
+	if (spec.params.empty())
+	{
+		err = "no params to sweep in '" + sweep_file + "'";
+		return false;
+	}
+	if (spec.mode != SWEEP_GRID && spec.num_samples == 0)
+	{
+		err = "random and lhs sweeps need a nonzero 'samples' in '" + sweep_file + "'";
+		return false;
+	}
+	for (auto &param : spec.params)
+	{
+		if (param.num_points == 0)
+		{
+			err = "param '" + param.name + "' has zero grid points in '" + sweep_file + "'";
+			return false;
+		}
+	}
+	return true;
+}
+
+void generate_sweep_points(struct sweep_spec &spec, std::vector<std::vector<float>> &points)
+{
+	uint32_t num_params = spec.params.size();
+	points.clear();
+	if (spec.mode == SWEEP_GRID)
+	{
+		uint32_t num_points = 1;
+		for (auto &param : spec.params) num_points *= param.num_points;
+		points.resize(num_points, std::vector<float>(num_params));
+		for (uint32_t i = 0; i < num_points; i++)
+		{
+			uint32_t rem = i;
+			for (int j = num_params - 1; j >= 0; j--)
+			{
+				struct sweep_param &param = spec.params[j];
+				uint32_t k = rem % param.num_points;
+				rem /= param.num_points;
+				points[i][j] = (param.num_points == 1) ? param.min
+					: param.min + k * (param.max - param.min) / (param.num_points - 1);
+			}
+		}
+		return;
+	}
+
+	CRandomSFMT0 randGen(spec.seed);
+	uint32_t n = spec.num_samples;
+	points.resize(n, std::vector<float>(num_params));
+	if (spec.mode == SWEEP_RANDOM)
+	{
+		for (uint32_t i = 0; i < n; i++)
+		{
+			for (uint32_t j = 0; j < num_params; j++)
+			{
+				struct sweep_param &param = spec.params[j];
+				points[i][j] = param.min + randGen.Random() * (param.max - param.min);
+			}
+		}
+		return;
+	}
+
+	/* latin hypercube: each param's range is cut into n strata and every
+	 * stratum is used by exactly one point, in a random order per param */
+	std::vector<uint32_t> strata(n);
+	for (uint32_t j = 0; j < num_params; j++)
+	{
+		struct sweep_param &param = spec.params[j];
+		for (uint32_t i = 0; i < n; i++) strata[i] = i;
+		for (uint32_t i = n - 1; i > 0; i--)
+		{
+			std::swap(strata[i], strata[randGen.IRandom(0, i)]);
+		}
+		for (uint32_t i = 0; i < n; i++)
+		{
+			points[i][j] = param.min + (strata[i] + randGen.Random()) / n * (param.max - param.min);
+		}
+	}
+}
+
+std::string tag_file_name(std::string file_name, std::string tag)
+{
+	size_t sep = file_name.find_last_of("\\/");
+	size_t dot = file_name.find_last_of(".");
+	if (dot == std::string::npos || (sep != std::string::npos && dot < sep)) return file_name + tag;
+	return file_name.substr(0, dot) + tag + file_name.substr(dot);
+}
+
+SweepRunner::SweepRunner(parsed_commandline &p_cl) : p_cl(p_cl)
+{
+	num_workers = std::stoi(p_cl.num_workers);
+	if (num_workers == 0) num_workers = 1;
+
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+	{
+		for (int i = 0; i < CPU_SETSIZE; i++)
+		{
+			if (CPU_ISSET(i, &allowed)) cores.push_back(i);
+		}
+	}
+	cores_per_worker = std::max<uint32_t>(1, cores.size() / num_workers);
+}
+
+SweepRunner::~SweepRunner()
+{
+	if (con_state) delete con_state;
+	if (results_file_buf.is_open()) results_file_buf.close();
+}
+
+bool SweepRunner::load()
+{
+	std::string err;
+	if (!parse_sweep_file(p_cl.sweep_file, spec, err))
+	{
+		std::cerr << "[IO_ERROR]: " << err << ". Exiting...\n";
+		return false;
+	}
+
+	tokenized_file t_file;
+	lexed_file l_file;
+	tokenize_file(p_cl.session_file, t_file);
+	lex_tokenized_file(t_file, l_file);
+	parse_lexed_sess_file(l_file, s_file);
+	auto &act_map = s_file.parsed_var_sections["activity"].param_map;
+	for (auto &param : spec.params)
+	{
+		if (act_map.find(param.name) == act_map.end())
+		{
+			std::cerr << "[IO_ERROR]: Swept param '" << param.name << "' is not an activity param of '"
+					  << p_cl.session_file << "'. Exiting...\n";
+			return false;
+		}
+	}
+
+	std::fstream sim_file_buf(p_cl.input_sim_file.c_str(), std::ios::in | std::ios::binary);
+	if (!sim_file_buf.is_open())
+	{
+		std::cerr << "[IO_ERROR]: Could not open simulation file '" << p_cl.input_sim_file << "'. Exiting...\n";
+		return false;
+	}
+	std::cout << "[INFO]: Loading shared connectivity from '" << p_cl.input_sim_file << "'...\n";
+	base_params.read_con_params(sim_file_buf);
+	base_params.populate_act_params(s_file);
+	con_state = new CBMState(base_params, 1, sim_file_buf); /* one zone, as Control */
+	sim_file_buf.close();
+
+	std::stringstream act_buf;
+	con_state->writeActState(act_buf);
+	act_image = act_buf.str();
+
+	generate_sweep_points(spec, points);
+
+	std::string results_file_name = OUTPUT_DATA_PATH + get_file_basename(p_cl.sweep_file) + "_results.txt";
+	results_file_buf.open(results_file_name.c_str(), std::ios::out);
+	if (!results_file_buf.is_open())
+	{
+		std::cerr << "[IO_ERROR]: Could not open sweep results file '" << results_file_name << "'. Exiting...\n";
+		return false;
+	}
+	results_file_buf << "# cbm_sim sweep results\n";
+	results_file_buf << "# session " << p_cl.session_file << "\n";
+	results_file_buf << "# sim " << p_cl.input_sim_file << "\n";
+	results_file_buf << "# point status secs";
+	for (auto &param : spec.params) results_file_buf << " " << param.name;
+	results_file_buf << "\n" << std::setprecision(9);
+	std::cout << "[INFO]: Streaming sweep results to '" << results_file_name << "'\n";
+	return true;
+}
+
+void SweepRunner::pin_worker(uint32_t worker_id)
+{
+	if (cores.empty()) return;
+	cpu_set_t worker_cores;
+	CPU_ZERO(&worker_cores);
+	for (uint32_t i = 0; i < cores_per_worker; i++)
+	{
+		CPU_SET(cores[(worker_id * cores_per_worker + i) % cores.size()], &worker_cores);
+	}
+	if (pthread_setaffinity_np(pthread_self(), sizeof(worker_cores), &worker_cores) != 0)
+	{
+		std::cerr << "[ERROR]: Could not pin sweep worker " << worker_id << " to its cores.\n";
+	}
+}
+
+void SweepRunner::worker_loop(uint32_t worker_id)
+{
+	pin_worker(worker_id);
+	omp_set_num_threads(cores_per_worker);
+	while (true)
+	{
+		uint32_t point = next_point++;
+		if (point >= points.size()) return;
+		run_point(point);
+	}
+}
+
+void SweepRunner::run_point(uint32_t point)
+{
+	std::string tag = "_p" + std::to_string(point);
+
+	parsed_sess_file point_s_file = s_file;
+	auto &act_map = point_s_file.parsed_var_sections["activity"].param_map;
+	for (uint32_t j = 0; j < spec.params.size(); j++)
+	{
+		std::ostringstream value_buf;
+		value_buf << std::setprecision(9) << points[point][j];
+		act_map[spec.params[j].name].value = value_buf.str();
+	}
+
+	parsed_commandline point_p_cl = p_cl;
+	for (auto &entry : point_p_cl.raster_files) entry.second = tag_file_name(entry.second, tag);
+	for (auto &entry : point_p_cl.psth_files) entry.second = tag_file_name(entry.second, tag);
+	for (auto &entry : point_p_cl.weights_files) entry.second = tag_file_name(entry.second, tag);
+	if (!point_p_cl.digest_file.empty())
+		point_p_cl.digest_file = tag_file_name(point_p_cl.digest_file, tag);
+	if (!point_p_cl.roofline_file.empty())
+		point_p_cl.roofline_file = tag_file_name(point_p_cl.roofline_file, tag);
+	if (!point_p_cl.latency_file.empty())
+		point_p_cl.latency_file = tag_file_name(point_p_cl.latency_file, tag);
+	if (!point_p_cl.weight_stats_file.empty())
+		point_p_cl.weight_stats_file = tag_file_name(point_p_cl.weight_stats_file, tag);
+	if (!point_p_cl.output_sim_file.empty())
+		point_p_cl.output_sim_file = tag_file_name(point_p_cl.output_sim_file, tag);
+
+	std::cout << "[INFO]: Starting sweep point " << point << ".\n";
+	double start = omp_get_wtime();
+	mem_read_buf act_buf(act_image.data(), act_image.size());
+	std::iostream act_stream(&act_buf);
+	Control *control = NULL;
+	bool healthy = false;
+	std::string error;
+	/* a point that throws must not take the other workers' points with it */
+	try
+	{
+		control = new Control(point_p_cl, point_s_file, con_state, act_stream, tag);
+		control->runSession(NULL);
+		healthy = !control->health_check_failed;
+		if (healthy && !point_p_cl.output_sim_file.empty())
+		{
+			control->save_sim_to_file(point_p_cl.output_sim_file);
+		}
+	}
+	catch (std::exception &e)
+	{
+		error = e.what();
+		if (error.empty()) error = "unknown error";
+	}
+	if (control) delete control;
+	report_point(point, healthy, omp_get_wtime() - start, error);
+}
+
+void SweepRunner::report_point(uint32_t point, bool healthy, double run_time, std::string error)
+{
+	std::lock_guard<std::mutex> lock(results_mutex);
+	const char *status = !error.empty() ? "failed" : (healthy ? "done" : "unhealthy");
+	if (!error.empty()) num_failed++;
+	else if (!healthy) num_unhealthy++;
+	results_file_buf << point << " " << status << " " << run_time;
+	for (float value : points[point]) results_file_buf << " " << value;
+	/* the message goes last, after a '#', so the columns stay whitespace separated */
+	if (!error.empty())
+	{
+		std::replace(error.begin(), error.end(), '\n', ' ');
+		results_file_buf << " # " << error;
+	}
+	results_file_buf << "\n";
+	results_file_buf.flush();
+	if (!error.empty())
+	{
+		std::cerr << "[ERROR]: Sweep point " << point << " failed after " << run_time << "s: " << error << "\n";
+	}
+	else
+	{
+		std::cout << "[INFO]: Sweep point " << point << " " << (healthy ? "done" : "failed its health check")
+				  << " after " << run_time << "s.\n";
+	}
+}
+
+int SweepRunner::run()
+{
+	if (!load()) return 1;
+	std::cout << "[INFO]: Sweeping " << points.size() << " points with " << num_workers
+			  << " worker(s) of " << cores_per_worker << " core(s) each.\n";
+	double start = omp_get_wtime();
+	std::vector<std::thread> workers;
+	for (uint32_t i = 0; i < num_workers; i++)
+	{
+		workers.push_back(std::thread(&SweepRunner::worker_loop, this, i));
+	}
+	for (auto &worker : workers) worker.join();
+	std::cout << "[INFO]: Sweep finished in " << (omp_get_wtime() - start) << "s; "
+			  << num_unhealthy << " of " << points.size() << " point(s) failed their health check, "
+			  << num_failed << " stopped on an error.\n";
+	if (num_failed > 0) return 2;
+	return (num_unhealthy > 0) ? 3 : 0;
+}
+
+int run_sweep(parsed_commandline &p_cl)
+{
+	SweepRunner sweep(p_cl);
+	return sweep.run();
+}
+
@@ -0,0 +1,114 @@
+/*
+ * File: sweep.h
+ *
+ * Description:
+ *     Interface for in-process parameter sweeps ('sweep mode'). A sweep runs
+ *     one session at many points of activity parameter space. The session file
+ *     is parsed and the input simulation read only once; the points share its
+ *     connectivity and each starts from its own copy of its activity state. A
+ *     fixed number of workers, each pinned to its own set of cores, run points
+ *     concurrently. One result line per point is streamed to
+ *     <sweep file>_results.txt as each point finishes.
+ *
+ *     A sweep file lists the swept parameters, which must be params of the
+ *     session's activity section, and how to sample them. '#' starts a comment:
+ *
+ *         mode lhs                      # grid, random or lhs (latin hypercube)
+ *         samples 64                    # number of points; random and lhs only
+ *         seed 7                        # random and lhs only, default 0
+ *         param gogrW 0.005 0.02 4      # name, min, max, [points per axis; grid only]
+ *         param gIncDirectMFtoGR 0.001 0.004 4
+ *
+ *     A grid sweep runs the cartesian product of its axes, the first param
+ *     varying slowest. Every point runs the session exactly as a TUI run would,
+ *     except that the names of the rasters, PSTHs, weights, digest, roofline,
+ *     output sim and watchdog files it writes are tagged with '_p<point>'.
+ *
+ *     A point's status is 'done', 'unhealthy' if it failed its numerical health
+ *     check, or 'failed' if it stopped on an error, in which case the error
+ *     follows its param values after a '#'. Either way the sweep carries on.
+ */
+#ifndef SWEEP_H_
+#define SWEEP_H_
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <fstream>
+#include <atomic>
+#include <cstdint>
+
+#include "commandline.h"
+#include "file_parse.h"
+#include "cbmstate.h"
+
+enum sweep_mode {SWEEP_GRID, SWEEP_RANDOM, SWEEP_LHS};
+
+struct sweep_param
+{
+	std::string name;
+	float min;
+	float max;
+	uint32_t num_points; /* grid only */
+};
+
+struct sweep_spec
+{
+	enum sweep_mode mode;
+	uint32_t num_samples;
+	int seed;
+	std::vector<struct sweep_param> params;
+};
+
+/* returns false and sets err if sweep_file cannot be read or is malformed */
+bool parse_sweep_file(std::string sweep_file, struct sweep_spec &spec, std::string &err);
+
+/* one vector of param values, ordered as spec.params, per point */
+void generate_sweep_points(struct sweep_spec &spec, std::vector<std::vector<float>> &points);
+
+/* inserts tag before the extension of file_name, or appends it if there is none */
+std::string tag_file_name(std::string file_name, std::string tag);
+
+class SweepRunner
+{
+	public:
+		SweepRunner(parsed_commandline &p_cl);
+		~SweepRunner();
+
+		/* runs every point. returns 0 if all points completed, 2 if any stopped
+		 * on an error (e.g. an allocation or file failure), else 3 if any failed
+		 * its numerical health check, and 1 if the sweep could not start */
+		int run();
+
+	private:
+		parsed_commandline p_cl;
+		uint32_t num_workers;
+		uint32_t cores_per_worker;
+		std::vector<int> cores;
+
+		struct sweep_spec spec;
+		std::vector<std::vector<float>> points;
+		parsed_sess_file s_file;
+
+		sim_params base_params;
+		CBMState *con_state = NULL;
+		std::string act_image;
+
+		std::atomic<uint32_t> next_point{0};
+		uint32_t num_unhealthy = 0;
+		uint32_t num_failed    = 0;
+		std::mutex results_mutex;
+		std::fstream results_file_buf;
+
+		bool load();
+		void pin_worker(uint32_t worker_id);
+		void worker_loop(uint32_t worker_id);
+		void run_point(uint32_t point);
+		/* error is empty unless the point stopped on an exception */
+		void report_point(uint32_t point, bool healthy, double run_time, std::string error);
+};
+
+int run_sweep(parsed_commandline &p_cl);
+
+#endif /* SWEEP_H_ */
+
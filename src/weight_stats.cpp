@@ -0,0 +1,165 @@
+/*
+ * File: weight_stats.cpp
+ *
+ * Description:
+ *     This file implements the function prototypes in weight_stats.h
+ *
+ * Implementation Notes:
+ *     summarize_weights makes one pass over the weights in chunks of
+ *     WSTATS_CHUNK. The moments, extrema and each weight's fine bin index are
+ *     computed in a vectorized loop over the chunk; only the bin increments,
+ *     which scatter, are left scalar. Clamping to [0, 1] before binning is
+ *     written max(0, w) first so that a NaN weight lands in bin 0 rather than
+ *     turning into an out of range index. Sums are kept in double, as a zone
+ *     holds a million PF-PC weights.
+ *
+ *     PCs and NCs are summarized in parallel, each into its own slot of units,
+ *     and merged into the zone's summary afterwards. The PF-PC weights live on
+ *     the GPU and are copied back through exportPFPCWeights, as for '-w'.
+ */
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "weight_stats.h"
+
+#define WSTATS_CHUNK 512
+#define WSTATS_FINE_PER_BIN (WSTATS_FINE_BINS / WSTATS_NUM_BINS)
+
+void summarize_weights(const float *w, uint64_t n, struct weight_summary &s)
+{
+	double sum = 0.0, sum_sq = 0.0;
+	float lo = INFINITY, hi = -INFINITY;
+	uint16_t bins[WSTATS_CHUNK];
+	memset(s.fine, 0, sizeof(s.fine));
+	for (uint64_t start = 0; start < n; start += WSTATS_CHUNK)
+	{
+		const float *chunk = w + start;
+		uint32_t len = (uint32_t)std::min((uint64_t)WSTATS_CHUNK, n - start);
+		#pragma omp simd reduction(+:sum,sum_sq) reduction(min:lo) reduction(max:hi)
+		for (uint32_t i = 0; i < len; i++)
+		{
+			float x = chunk[i];
+			sum    += x;
+			sum_sq += (double)x * x;
+			lo = std::min(lo, x);
+			hi = std::max(hi, x);
+			float c = std::min(std::max(0.0f, x), 1.0f);
+			bins[i] = (uint16_t)std::min((int)(c * WSTATS_FINE_BINS), WSTATS_FINE_BINS - 1);
+		}
+		for (uint32_t i = 0; i < len; i++) s.fine[bins[i]]++;
+	}
+	s.n      = n;
+	s.sum    = sum;
+	s.sum_sq = sum_sq;
+	s.min    = (n > 0) ? lo : 0.0;
+	s.max    = (n > 0) ? hi : 0.0;
+}
+
+void merge_weight_summary(struct weight_summary &into, const struct weight_summary &from)
+{
+	if (from.n == 0) return;
+	into.min = (into.n > 0) ? std::min(into.min, from.min) : from.min;
+	into.max = (into.n > 0) ? std::max(into.max, from.max) : from.max;
+	into.n      += from.n;
+	into.sum    += from.sum;
+	into.sum_sq += from.sum_sq;
+	for (uint32_t b = 0; b < WSTATS_FINE_BINS; b++) into.fine[b] += from.fine[b];
+}
+
+float weight_quantile(const struct weight_summary &s, double pct)
+{
+	if (s.n == 0) return 0.0;
+	uint64_t rank = (uint64_t)std::ceil(pct / 100.0 * s.n);
+	rank = std::min(std::max(rank, (uint64_t)1), s.n);
+	uint64_t seen = 0;
+	for (uint32_t b = 0; b < WSTATS_FINE_BINS; b++)
+	{
+		seen += s.fine[b];
+		if (seen >= rank)
+		{
+			float edge = (float)(b + 1) / WSTATS_FINE_BINS;
+			return std::min(std::max(edge, s.min), s.max);
+		}
+	}
+	return s.max;
+}
+
+WeightStats::WeightStats(std::string out_file_name, std::string sess_file_name, std::string sim_file_name)
+{
+	out_file_buf.open(out_file_name.c_str(), std::ios::out);
+	if (!out_file_buf.is_open())
+	{
+		std::cerr << "[IO_ERROR]: Could not open weight stats file '" << out_file_name << "'. No weight stats will be written.\n";
+		return;
+	}
+	out_file_buf << "# cbm_sim weight stats\n";
+	out_file_buf << "# session " << sess_file_name << "\n";
+	out_file_buf << "# sim " << sim_file_name << "\n";
+	out_file_buf << "# bins " << WSTATS_NUM_BINS << " over [0, 1]\n";
+	out_file_buf << "# trial zone var unit n mean var min p10 p50 p90 max h0 .. h" << WSTATS_NUM_BINS - 1 << "\n";
+	out_file_buf << std::setprecision(6);
+	std::cout << "[INFO]: Writing weight stats to '" << out_file_name << "'\n";
+}
+
+WeightStats::~WeightStats()
+{
+	if (out_file_buf.is_open()) out_file_buf.close();
+}
+
+void WeightStats::sample(CBMSimCore *simCore, uint32_t num_zones, uint32_t trial)
+{
+	if (!out_file_buf.is_open()) return;
+	const sim_params &p = simCore->getParams();
+	units.resize(std::max(p.num_pc, p.num_nc));
+	for (uint32_t z = 0; z < num_zones; z++)
+	{
+		MZone *zone = simCore->getMZoneList()[z];
+		summarize_zone(zone->exportPFPCWeights(), p.num_pc, p.num_p_pc_from_gr_to_pc, trial, z, "PFPC_W");
+		summarize_zone(zone->exportMFDCNWeights(), p.num_nc, p.num_p_nc_from_mf_to_nc, trial, z, "MFNC_W");
+	}
+	out_file_buf.flush();
+}
+
+void WeightStats::summarize_zone(const float *w, uint32_t num_units, uint32_t per_unit,
+	uint32_t trial, uint32_t zone, const char *var_name)
+{
+	#pragma omp parallel for
+	for (uint32_t u = 0; u < num_units; u++)
+	{
+		summarize_weights(w + (uint64_t)u * per_unit, per_unit, units[u]);
+	}
+	struct weight_summary zone_sum;
+	zone_sum.n = 0;
+	zone_sum.sum = zone_sum.sum_sq = 0.0;
+	zone_sum.min = zone_sum.max = 0.0;
+	memset(zone_sum.fine, 0, sizeof(zone_sum.fine));
+	for (uint32_t u = 0; u < num_units; u++)
+	{
+		write_summary(trial, zone, var_name, u, units[u]);
+		merge_weight_summary(zone_sum, units[u]);
+	}
+	write_summary(trial, zone, var_name, -1, zone_sum);
+}
+
+void WeightStats::write_summary(uint32_t trial, uint32_t zone, const char *var_name, int unit,
+	const struct weight_summary &s)
+{
+	double mean = (s.n > 0) ? s.sum / s.n : 0.0;
+	double var  = (s.n > 0) ? std::max(s.sum_sq / s.n - mean * mean, 0.0) : 0.0;
+	out_file_buf << trial << " " << zone << " " << var_name << " ";
+	if (unit < 0) out_file_buf << "all";
+	else out_file_buf << unit;
+	out_file_buf << " " << s.n << " " << mean << " " << var << " " << s.min
+				 << " " << weight_quantile(s, 10.0) << " " << weight_quantile(s, 50.0)
+				 << " " << weight_quantile(s, 90.0) << " " << s.max;
+	for (uint32_t b = 0; b < WSTATS_NUM_BINS; b++)
+	{
+		uint64_t count = 0;
+		for (uint32_t f = 0; f < WSTATS_FINE_PER_BIN; f++) count += s.fine[b * WSTATS_FINE_PER_BIN + f];
+		out_file_buf << " " << count;
+	}
+	out_file_buf << "\n";
+}
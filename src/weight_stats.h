@@ -0,0 +1,76 @@
+/*
+ * File: weight_stats.h
+ *
+ * Description:
+ *     Interface for weight distribution summaries, written with
+ *     '-W, --weight-stats FILE'. Watching learning through '-w' means dumping
+ *     every PF-PC and MF-NC weight every trial, megabytes per trial. Instead,
+ *     at the end of every trial the summarizer reduces the PF-PC weights onto
+ *     each PC and the MF-NC weights onto each NC, and each population of them
+ *     in each microzone, to a count, mean, variance, extrema, quantiles and a
+ *     coarse histogram, and appends one line per summary to a text log:
+ *
+ *         trial zone var unit n mean var min p10 p50 p90 max h0 .. h15
+ *
+ *     var is PFPC_W or MFNC_W, unit the PC or NC index or 'all' for the zone.
+ *     The histogram's WSTATS_NUM_BINS bins split [0, 1], the range plasticity
+ *     keeps the weights in; weights outside it count in the edge bins.
+ *     Quantiles are read off a finer histogram of WSTATS_FINE_BINS bins and
+ *     are good to 1 / WSTATS_FINE_BINS.
+ *
+ *     Full dumps with '-w' stay available; '-e, --weights-every N' thins them
+ *     to every N-th trial, and 0 turns them off.
+ */
+#ifndef WEIGHT_STATS_H_
+#define WEIGHT_STATS_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+#include "cbmsimcore.h"
+
+#define WSTATS_FINE_BINS 1024
+#define WSTATS_NUM_BINS  16
+
+struct weight_summary
+{
+	uint64_t n;
+	double sum;
+	double sum_sq;
+	float min;
+	float max;
+	uint32_t fine[WSTATS_FINE_BINS];
+};
+
+/* fills s for the n weights in w */
+void summarize_weights(const float *w, uint64_t n, struct weight_summary &s);
+
+/* adds from into into, as if their weights had been summarized together */
+void merge_weight_summary(struct weight_summary &into, const struct weight_summary &from);
+
+/* the upper edge of the fine bin holding the pct-th percentile, within [min, max] */
+float weight_quantile(const struct weight_summary &s, double pct);
+
+class WeightStats
+{
+	public:
+		WeightStats(std::string out_file_name, std::string sess_file_name, std::string sim_file_name);
+		~WeightStats();
+
+		/* called at the end of every trial */
+		void sample(CBMSimCore *simCore, uint32_t num_zones, uint32_t trial);
+
+	private:
+		std::fstream out_file_buf;
+		/* one per PC or NC, reused across zones and trials */
+		std::vector<struct weight_summary> units;
+
+		void summarize_zone(const float *w, uint32_t num_units, uint32_t per_unit,
+			uint32_t trial, uint32_t zone, const char *var_name);
+		void write_summary(uint32_t trial, uint32_t zone, const char *var_name, int unit,
+			const struct weight_summary &s);
+};
+
+#endif /* WEIGHT_STATS_H_ */
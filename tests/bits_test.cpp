@@ -0,0 +1,244 @@
+/*
+ * File: bits_test.cpp
+ *
+ * Description:
+ *     Checks every routine of src/cxx_tools/bits.cpp against a bit-at-a-time
+ *     scalar reference, over lengths around every word and vector width so
+ *     that each loop's ragged tail is exercised, including 2D packing with
+ *     cols % 8 != 0. 'make test' builds this file once per bits.cpp path
+ *     (AVX2 and SSE2 movemask, BMI2 pext/pdep, SWAR) and runs each build.
+ *     A build whose instructions the host lacks is skipped.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "bits.h"
+
+#ifndef BITS_TEST_VARIANT
+#define BITS_TEST_VARIANT "default"
+#endif
+
+static int num_failed = 0;
+
+#define CHECK(cond, ...) \
+	do \
+	{ \
+		if (!(cond)) \
+		{ \
+			fprintf(stderr, "[ERROR]: %s:%d: ", __FILE__, __LINE__); \
+			fprintf(stderr, __VA_ARGS__); \
+			fprintf(stderr, "\n"); \
+			num_failed++; \
+		} \
+	} while (0)
+
+/* the reference: one bit at a time, as bits.cpp did before vectorizing */
+static void ref_pack(const uint8_t *in, uint64_t len, uint8_t *out)
+{
+	memset(out, 0, packed_byte_len(len));
+	for (uint64_t i = 0; i < len; i++)
+	{
+		if (in[i]) out[i / 8] |= 1 << (i % 8);
+	}
+}
+
+static int ref_bit(const uint8_t *packed, uint64_t i)
+{
+	return (packed[i / 8] >> (i % 8)) & 1;
+}
+
+static uint32_t rng_state = 12345;
+
+static uint32_t next_rand()
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+/* mostly zeros, as spikes are, with arbitrary non-zero values for the ones */
+static void fill_spikes(uint8_t *arr, uint64_t len, uint32_t one_in)
+{
+	for (uint64_t i = 0; i < len; i++)
+	{
+		arr[i] = (next_rand() % one_in == 0) ? (uint8_t)(1 + next_rand() % 255) : 0;
+	}
+}
+
+static void test_pack_unpack()
+{
+	for (uint64_t len = 0; len <= 200; len++)
+	{
+		std::vector<uint8_t> in(len + 1), ref(packed_byte_len(len) + 1), got(packed_byte_len(len) + 1, 0xAA);
+		fill_spikes(in.data(), len, 3);
+		ref_pack(in.data(), len, ref.data());
+		pack_byte_array(in.data(), len, got.data());
+		CHECK(memcmp(ref.data(), got.data(), packed_byte_len(len)) == 0, "pack_byte_array, len %lu", len);
+
+		std::vector<uint8_t> unpacked(len + 1, 0xAA);
+		unpack_byte_array(got.data(), unpacked.data(), len);
+		bool ok = unpacked[len] == 0xAA;
+		for (uint64_t i = 0; i < len; i++) ok = ok && unpacked[i] == (in[i] != 0);
+		CHECK(ok, "unpack_byte_array, len %lu", len);
+	}
+}
+
+static void test_pack_2d()
+{
+	const uint64_t col_counts[] = { 1, 7, 8, 9, 15, 17, 63, 65, 100, 129 };
+	for (uint64_t cols : col_counts)
+	{
+		const uint64_t rows = 13, offset = 3;
+		const uint64_t stride = (cols + 7) / 8;
+		std::vector<uint8_t> data(rows * cols);
+		std::vector<uint8_t *> row_ptrs(rows);
+		fill_spikes(data.data(), data.size(), 4);
+		for (uint64_t r = 0; r < rows; r++) row_ptrs[r] = data.data() + r * cols;
+
+		std::vector<uint8_t> got(offset + rows * stride + 1, 0xAA);
+		pack_2d_byte_array(row_ptrs.data(), rows, cols, got.data(), offset);
+		std::vector<uint8_t> ref(stride);
+		bool ok = got[0] == 0xAA && got[offset + rows * stride] == 0xAA;
+		for (uint64_t r = 0; r < rows; r++)
+		{
+			ref_pack(row_ptrs[r], cols, ref.data());
+			ok = ok && memcmp(ref.data(), got.data() + offset + r * stride, stride) == 0;
+		}
+		CHECK(ok, "pack_2d_byte_array, cols %lu", cols);
+	}
+}
+
+static void test_transpose()
+{
+	for (int n = 0; n < 100; n++)
+	{
+		uint64_t block = ((uint64_t)next_rand() << 32) | next_rand();
+		uint64_t t = transpose_8x8(block);
+		bool ok = true;
+		for (int r = 0; r < 8; r++)
+			for (int c = 0; c < 8; c++)
+				ok = ok && ((block >> (r * 8 + c)) & 1) == ((t >> (c * 8 + r)) & 1);
+		CHECK(ok, "transpose_8x8");
+	}
+
+	uint64_t block[BITS_PER_WORD], orig[BITS_PER_WORD];
+	for (int r = 0; r < BITS_PER_WORD; r++) orig[r] = block[r] = ((uint64_t)next_rand() << 32) | next_rand();
+	transpose_64x64(block);
+	bool ok = true;
+	for (int r = 0; r < BITS_PER_WORD; r++)
+		for (int c = 0; c < BITS_PER_WORD; c++)
+			ok = ok && ((orig[r] >> c) & 1) == ((block[c] >> r) & 1);
+	CHECK(ok, "transpose_64x64");
+
+	const uint64_t sizes[] = { 1, 5, 8, 63, 64, 65, 100, 130 };
+	for (uint64_t rows : sizes)
+	{
+		for (uint64_t cols : sizes)
+		{
+			uint64_t src_stride = packed_byte_len(cols), dst_stride = packed_byte_len(rows);
+			std::vector<uint8_t> src(rows * src_stride), dst(cols * dst_stride + 1, 0xAA);
+			for (uint64_t r = 0; r < rows; r++)
+			{
+				std::vector<uint8_t> row(cols);
+				fill_spikes(row.data(), cols, 2);
+				ref_pack(row.data(), cols, src.data() + r * src_stride);
+			}
+			transpose_packed_bits(src.data(), rows, cols, dst.data());
+			ok = dst[cols * dst_stride] == 0xAA;
+			for (uint64_t r = 0; r < rows; r++)
+				for (uint64_t c = 0; c < cols; c++)
+					ok = ok && ref_bit(src.data() + r * src_stride, c) == ref_bit(dst.data() + c * dst_stride, r);
+			CHECK(ok, "transpose_packed_bits, %lu x %lu", rows, cols);
+		}
+	}
+}
+
+static void test_counts()
+{
+	for (uint64_t len = 0; len <= 100; len++)
+	{
+		std::vector<uint8_t> arr(len + 1);
+		fill_spikes(arr.data(), len, 3);
+		arr[len] = 0xFF;
+		uint64_t ref_nonzero = 0, ref_bits = 0;
+		for (uint64_t i = 0; i < len; i++)
+		{
+			ref_nonzero += arr[i] != 0;
+			for (int b = 0; b < 8; b++) ref_bits += (arr[i] >> b) & 1;
+		}
+		CHECK(count_nonzero_bytes(arr.data(), len) == ref_nonzero, "count_nonzero_bytes, len %lu", len);
+		CHECK(popcount_bytes(arr.data(), len) == ref_bits, "popcount_bytes, len %lu", len);
+	}
+}
+
+static void test_row_ops()
+{
+	const uint64_t row_lens[] = { 0, 1, 7, 8, 9, 31, 64, 67 };
+	for (uint64_t row_bytes : row_lens)
+	{
+		const uint64_t num_rows = 5;
+		std::vector<std::vector<uint8_t>> rows(num_rows, std::vector<uint8_t>(row_bytes + 1));
+		std::vector<const uint8_t *> row_ptrs(num_rows);
+		for (uint64_t r = 0; r < num_rows; r++)
+		{
+			for (uint64_t i = 0; i < row_bytes; i++) rows[r][i] = (uint8_t)next_rand();
+			row_ptrs[r] = rows[r].data();
+		}
+		std::vector<uint8_t> or_out(row_bytes + 1, 0xAA), and_out(row_bytes + 1, 0x55);
+		or_packed_rows(row_ptrs.data(), num_rows, row_bytes, or_out.data());
+		and_packed_rows(row_ptrs.data(), num_rows, row_bytes, and_out.data());
+		bool ok = or_out[row_bytes] == 0xAA && and_out[row_bytes] == 0x55;
+		for (uint64_t i = 0; i < row_bytes; i++)
+		{
+			uint8_t ref_or = 0, ref_and = 0xFF;
+			for (uint64_t r = 0; r < num_rows; r++)
+			{
+				ref_or  |= rows[r][i];
+				ref_and &= rows[r][i];
+			}
+			ok = ok && or_out[i] == ref_or && and_out[i] == ref_and;
+		}
+		CHECK(ok, "or/and_packed_rows, row_bytes %lu", row_bytes);
+
+		/* out aliasing rows[0] */
+		std::vector<uint8_t> first = rows[0];
+		or_packed_rows(row_ptrs.data(), num_rows, row_bytes, rows[0].data());
+		ok = true;
+		for (uint64_t i = 0; i < row_bytes; i++) ok = ok && rows[0][i] == or_out[i];
+		CHECK(ok, "or_packed_rows in place, row_bytes %lu", row_bytes);
+		rows[0] = first;
+	}
+}
+
+int main()
+{
+#if defined(__AVX2__)
+	if (!__builtin_cpu_supports("avx2"))
+	{
+		printf("[INFO]: bits_test (%s): host has no AVX2, skipped.\n", BITS_TEST_VARIANT);
+		return 0;
+	}
+#endif
+#if defined(__BMI2__)
+	if (!__builtin_cpu_supports("bmi2"))
+	{
+		printf("[INFO]: bits_test (%s): host has no BMI2, skipped.\n", BITS_TEST_VARIANT);
+		return 0;
+	}
+#endif
+	test_pack_unpack();
+	test_pack_2d();
+	test_transpose();
+	test_counts();
+	test_row_ops();
+	if (num_failed > 0)
+	{
+		printf("[ERROR]: bits_test (%s): %d check(s) failed.\n", BITS_TEST_VARIANT, num_failed);
+		return 1;
+	}
+	printf("[INFO]: bits_test (%s): all checks passed.\n", BITS_TEST_VARIANT);
+	return 0;
+}